@@ -0,0 +1,46 @@
+/**
+ * bitband.h - Cortex-M4 bit-band aliases for peripheral and SRAM bits
+ *
+ * The STM32F401 gives every bit of the peripheral space (0x40000000) and of
+ * SRAM1 (0x20000000) a word of its own in the bit-band regions at
+ * 0x42000000 and 0x22000000:
+ *
+ *   alias = bb_base + (byte_offset * 32) + (bit * 4)
+ *
+ * A load from the alias returns the bit as 0 or 1. A store writes bit 0 of
+ * the value into the bit with a read-modify-write done by the bus matrix in
+ * one locked transfer, so an interrupt cannot split it the way it can split
+ * ldr/orr/str of `GPIOA->ODR |= (1U << 5)`.
+ *
+ *   BB_PERIPH(GPIOA->ODR, 5) = 1;        set PA5, one store
+ *   BB_PERIPH(I2C1->CR1, 8) = 1;         generate START
+ *   while (!BB_PERIPH(ADC1->SR, 1)) {}   wait for EOC
+ *   BB_SRAM(flags, 3) = 1;               set bit 3 of a SRAM flag word
+ *   BB_FLAG(map, 40) = 0;                clear flag 40 of a uint32_t map[]
+ *
+ * For registers the alias address is a constant the compiler folds. For a
+ * variable it follows from a link-time address and costs a subtract and a
+ * shift; in a loop, take BB_SRAM_ADDR() once.
+ *
+ * Do not clear rc_w0 status flags (TIM->SR, USART->SR) through the alias:
+ * a flag the hardware sets during the read-modify-write is written back as
+ * 0 and lost. Write ~flag to the register instead.
+ */
+
+#ifndef BITBAND_H
+#define BITBAND_H
+
+#include "stm32f4xx.h"
+
+#define BB_PERIPH_ADDR(reg, bit) \
+    (PERIPH_BB_BASE + (((uint32_t)(uintptr_t)&(reg) - PERIPH_BASE) << 5) + ((uint32_t)(bit) << 2))
+#define BB_SRAM_ADDR(var, bit) \
+    (SRAM1_BB_BASE + (((uint32_t)(uintptr_t)&(var) - SRAM1_BASE) << 5) + ((uint32_t)(bit) << 2))
+
+#define BB_PERIPH(reg, bit)  (*(volatile uint32_t *)(uintptr_t)BB_PERIPH_ADDR(reg, bit))
+#define BB_SRAM(var, bit)    (*(volatile uint32_t *)(uintptr_t)BB_SRAM_ADDR(var, bit))
+
+/* Flag n of a uint32_t bitmap array */
+#define BB_FLAG(map, n)      BB_SRAM((map)[(n) >> 5], (n) & 31U)
+
+#endif /* BITBAND_H */
@@ -0,0 +1,244 @@
+/**
+ * main.c - Bit-band access to GPIO bits and SRAM flags (STM32F401RE)
+ *
+ * 1) Benchmark: DWT->CYCCNT cycles for one set + clear of PA5 and of a bit
+ *    in a SRAM flag word, each done as read-modify-write, through the
+ *    bit-band alias, and (PA5 only) through BSRR for reference.
+ *
+ * 2) ISR race test: SysTick interrupts at 10 kHz toggle PA6 and post a
+ *    tick flag in a shared SRAM word while main() toggles PA5 and a flag
+ *    of its own in the same words and consumes the tick flags. A PA6 level
+ *    the ISR no longer finds in ODR, or a tick flag that was neither
+ *    consumed nor still pending, was overwritten by main(). Run once with
+ *    read-modify-write and once with bit-band stores.
+ *
+ * Results are printed over USART2 at 9600 baud. On the host simulator:
+ *   PA5 read-modify-write : 1200      (x100 cycles)
+ *   PA5 bit-band          : 600
+ *   read-modify-write: 1000 ticks, PA6 lost 334, flags lost 0
+ *   bit-band         : 1000 ticks, PA6 lost 0, flags lost 0
+ * The simulator only takes interrupts at register accesses and __NOP(),
+ * so the SRAM flag race and the SRAM timings only show on the board.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PA5 = LD2, toggled by main()
+ *   - PA6 = toggled by SysTick_Handler()
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "bitband.h"
+
+#define BENCH_LOOPS   1000
+#define RACE_TICKS    1000          // 100 ms at 10 kHz
+
+#define EV_MAIN       0             // flag bits in events
+#define EV_TICK       1
+
+void USART2_init(void);
+void GPIO_init(void);
+void DWT_init(void);
+void benchmark(void);
+void race_test(int use_bitband);
+int  USART2_write(int ch);
+
+/* Shared with SysTick_Handler */
+volatile uint32_t events;
+volatile int      use_bb;
+volatile uint32_t ticks, merged, pa6_lost;
+uint32_t          pa6_level;
+
+int main(void)
+{
+    USART2_init();
+    GPIO_init();
+    DWT_init();
+
+    benchmark();
+    race_test(0);
+    race_test(1);
+
+    while (1) {}
+}
+
+/**
+ * Cycles per set + clear pair, loop overhead subtracted
+ */
+void benchmark(void)
+{
+    uint32_t t0, empty, rmw, bb, bsrr, ram_rmw, ram_bb;
+    int i;
+
+    t0 = DWT->CYCCNT;
+    for (i = 0; i < BENCH_LOOPS; i++) __asm__ volatile ("");
+    empty = DWT->CYCCNT - t0;
+
+    t0 = DWT->CYCCNT;
+    for (i = 0; i < BENCH_LOOPS; i++) {
+        GPIOA->ODR |=  (1U << 5);
+        GPIOA->ODR &= ~(1U << 5);
+    }
+    rmw = DWT->CYCCNT - t0 - empty;
+
+    t0 = DWT->CYCCNT;
+    for (i = 0; i < BENCH_LOOPS; i++) {
+        BB_PERIPH(GPIOA->ODR, 5) = 1;
+        BB_PERIPH(GPIOA->ODR, 5) = 0;
+    }
+    bb = DWT->CYCCNT - t0 - empty;
+
+    t0 = DWT->CYCCNT;
+    for (i = 0; i < BENCH_LOOPS; i++) {
+        GPIOA->BSRR = (1U << 5);
+        GPIOA->BSRR = (1U << 21);
+    }
+    bsrr = DWT->CYCCNT - t0 - empty;
+
+    t0 = DWT->CYCCNT;
+    for (i = 0; i < BENCH_LOOPS; i++) {
+        events |=  (1U << EV_MAIN);
+        events &= ~(1U << EV_MAIN);
+    }
+    ram_rmw = DWT->CYCCNT - t0 - empty;
+
+    t0 = DWT->CYCCNT;
+    for (i = 0; i < BENCH_LOOPS; i++) {
+        BB_SRAM(events, EV_MAIN) = 1;
+        BB_SRAM(events, EV_MAIN) = 0;
+    }
+    ram_bb = DWT->CYCCNT - t0 - empty;
+
+    printf("cycles per set + clear (x100, %d loops)\r\n", BENCH_LOOPS);
+    printf("  PA5 read-modify-write : %lu\r\n", (unsigned long)(rmw * 100UL / BENCH_LOOPS));
+    printf("  PA5 bit-band          : %lu\r\n", (unsigned long)(bb * 100UL / BENCH_LOOPS));
+    printf("  PA5 BSRR              : %lu\r\n", (unsigned long)(bsrr * 100UL / BENCH_LOOPS));
+    printf("  SRAM read-modify-write: %lu\r\n", (unsigned long)(ram_rmw * 100UL / BENCH_LOOPS));
+    printf("  SRAM bit-band         : %lu\r\n", (unsigned long)(ram_bb * 100UL / BENCH_LOOPS));
+}
+
+/**
+ * Toggle PA5 and the EV_MAIN flag and consume EV_TICK while SysTick runs
+ * for RACE_TICKS interrupts.
+ */
+void race_test(int use_bitband)
+{
+    uint32_t pa5 = 0, seen = 0, flags_lost;
+
+    ticks = merged = pa6_lost = 0;
+    pa6_level = (GPIOA->ODR >> 6) & 1U;
+    events = 0;
+    use_bb = use_bitband;
+
+    SysTick->LOAD = 1600 - 1;     // 10 kHz
+    SysTick->VAL  = 0;
+    SysTick->CTRL = 7;            // enable, interrupt, processor clock
+
+    while (ticks < RACE_TICKS)
+    {
+        pa5 ^= 1U;
+        if (use_bitband) {
+            BB_PERIPH(GPIOA->ODR, 5) = pa5;
+            BB_SRAM(events, EV_MAIN) = pa5;
+            if (BB_SRAM(events, EV_TICK)) {
+                BB_SRAM(events, EV_TICK) = 0;
+                seen++;
+            }
+        } else {
+            GPIOA->ODR = (GPIOA->ODR & ~(1U << 5)) | (pa5 << 5);
+            events = (events & ~(1U << EV_MAIN)) | (pa5 << EV_MAIN);
+            if (events & (1U << EV_TICK)) {
+                events &= ~(1U << EV_TICK);
+                seen++;
+            }
+        }
+    }
+    SysTick->CTRL = 0;
+
+    /* Every tick was consumed, merged into the next one or is pending */
+    flags_lost = ticks - seen - merged - ((events >> EV_TICK) & 1U);
+
+    printf("%s: %lu ticks, PA6 lost %lu, flags lost %lu\r\n",
+           use_bitband ? "bit-band         " : "read-modify-write",
+           (unsigned long)ticks, (unsigned long)pa6_lost, (unsigned long)flags_lost);
+}
+
+/**
+ * 10 kHz tick: check that the last PA6 level is still in ODR, toggle it,
+ * and post EV_TICK. A tick flag still pending from the previous tick is
+ * counted as merged, not lost.
+ */
+void SysTick_Handler(void)
+{
+    if (((GPIOA->ODR >> 6) & 1U) != pa6_level)
+        pa6_lost++;
+    pa6_level ^= 1U;
+
+    if (events & (1U << EV_TICK))
+        merged++;
+
+    if (use_bb) {
+        BB_PERIPH(GPIOA->ODR, 6) = pa6_level;
+        BB_SRAM(events, EV_TICK) = 1;
+    } else {
+        GPIOA->ODR = (GPIOA->ODR & ~(1U << 6)) | (pa6_level << 6);
+        events |= (1U << EV_TICK);
+    }
+    ticks++;
+}
+
+/**
+ * PA5 and PA6 as outputs
+ */
+void GPIO_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);         // GPIOA clock
+    GPIOA->MODER &= ~0x00003C00;       // clear PA5, PA6
+    GPIOA->MODER |=  0x00001400;       // PA5, PA6 as outputs
+}
+
+/**
+ * Start the DWT cycle counter
+ */
+void DWT_init(void)
+{
+    CoreDebug->DEMCR |= (1U << 24);    // TRCENA
+    DWT->CYCCNT = 0;
+    DWT->CTRL  |= 1U;                  // CYCCNTENA
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
@@ -0,0 +1,162 @@
+/**
+ * exti_dispatch.c - EXTI edge events with timestamps and deferred handlers
+ *
+ * Dispatch table:
+ *   handlers[16] and port_of[16] (port index, as written to SYSCFG_EXTICR)
+ *   are all the per-line state there is.
+ *
+ * Interrupts:
+ *   EXTI0..EXTI4 each own one line; EXTI9_5 and EXTI15_10 share five and
+ *   six. All of them call service() with the lines they own. service()
+ *   reads TIM5->CNT first, so every event of one interrupt gets the same
+ *   entry stamp, then takes the pending lines from PR and peels them off
+ *   highest first with CLZ: one instruction per event instead of a scan
+ *   over the lines of the vector.
+ *
+ * Queue:
+ *   A 32-entry ring written only by the interrupts (head) and read only by
+ *   exti_dispatch() (tail). Each index has a single writer and the entry is
+ *   complete before head moves past it, so neither side locks out the
+ *   other. An event that finds the ring full is counted in exti_dropped.
+ */
+
+#include "exti_dispatch.h"
+
+#define QUEUE_SIZE   32                 // power of two
+
+volatile uint32_t exti_dropped;
+
+static exti_handler handlers[16];
+static uint8_t      port_of[16];
+
+static struct exti_event queue[QUEUE_SIZE];
+static volatile uint32_t head, tail;    // free-running; index with & (QUEUE_SIZE - 1)
+
+/**
+ * TIM5 as a free-running 32-bit cycle counter for the stamps
+ */
+void exti_init(void)
+{
+    RCC->APB1ENR |= (1U << 3);          // TIM5 clock
+    RCC->APB2ENR |= (1U << 14);         // SYSCFG clock
+
+    TIM5->PSC = 0;                      // 16 MHz
+    TIM5->ARR = 0xFFFFFFFF;
+    TIM5->CNT = 0;
+    TIM5->CR1 = 1;                      // CEN
+}
+
+static IRQn_Type vector_of(unsigned pin)
+{
+    if (pin < 5U)
+        return (IRQn_Type)(EXTI0_IRQn + (int)pin);
+    return pin < 10U ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
+
+/**
+ * Route pin of port to its EXTI line and call fn for the selected edges.
+ * Returns -1 if the line is already taken by another port's pin.
+ */
+int exti_attach(GPIO_TypeDef *port, unsigned pin, unsigned flags, exti_handler fn)
+{
+    uint32_t idx = ((uint32_t)port - GPIOA_BASE) / 0x400U;
+    uint32_t bit = 1U << pin;
+
+    if (pin > 15U || (handlers[pin] && port_of[pin] != idx))
+        return -1;
+
+    RCC->AHB1ENR |= 1U << idx;          // port clock
+    port->MODER &= ~(3U << (pin * 2));  // input
+    port->PUPDR &= ~(3U << (pin * 2));
+    if (flags & EXTI_PULLUP)
+        port->PUPDR |= 1U << (pin * 2);
+
+    EXTI->IMR &= ~bit;
+    handlers[pin] = fn;
+    port_of[pin] = (uint8_t)idx;
+
+    SYSCFG->EXTICR[pin >> 2] &= ~(0xFU << ((pin & 3U) * 4));
+    SYSCFG->EXTICR[pin >> 2] |= idx << ((pin & 3U) * 4);
+
+    if (flags & EXTI_RISING)  EXTI->RTSR |= bit; else EXTI->RTSR &= ~bit;
+    if (flags & EXTI_FALLING) EXTI->FTSR |= bit; else EXTI->FTSR &= ~bit;
+
+    EXTI->PR = bit;                     // drop an edge from before
+    EXTI->IMR |= bit;
+    NVIC_EnableIRQ(vector_of(pin));
+    return 0;
+}
+
+/**
+ * Stop events from a line; events already queued are still dispatched
+ */
+void exti_detach(unsigned pin)
+{
+    if (pin > 15U)
+        return;
+    EXTI->IMR &= ~(1U << pin);
+    handlers[pin] = 0;
+}
+
+/**
+ * 1 while events are queued; call with interrupts disabled before __WFI()
+ */
+int exti_pending(void)
+{
+    return tail != head;
+}
+
+/**
+ * Run the handlers of all queued events; returns how many there were
+ */
+int exti_dispatch(void)
+{
+    struct exti_event ev;
+    exti_handler fn;
+    int n = 0;
+
+    while (tail != head) {
+        ev = queue[tail & (QUEUE_SIZE - 1U)];
+        tail = tail + 1U;
+        fn = handlers[ev.line];
+        if (fn)
+            fn(&ev);
+        n++;
+    }
+    return n;
+}
+
+static inline void service(uint32_t lines)
+{
+    uint32_t stamp = TIM5->CNT;
+    uint32_t pending = EXTI->PR & lines;
+    struct exti_event *ev;
+    unsigned line;
+    GPIO_TypeDef *port;
+
+    EXTI->PR = pending;
+    while (pending) {
+        line = 31U - __CLZ(pending);
+        pending &= ~(1U << line);
+
+        if (head - tail == QUEUE_SIZE) {
+            exti_dropped++;
+            continue;
+        }
+        port = (GPIO_TypeDef *)(GPIOA_BASE + 0x400U * port_of[line]);
+        ev = &queue[head & (QUEUE_SIZE - 1U)];
+        ev->stamp = stamp;
+        ev->line  = (uint8_t)line;
+        ev->level = (uint8_t)((port->IDR >> line) & 1U);
+        __DMB();                        // entry written before it is published
+        head = head + 1U;
+    }
+}
+
+void EXTI0_IRQHandler(void)     { service(1U << 0); }
+void EXTI1_IRQHandler(void)     { service(1U << 1); }
+void EXTI2_IRQHandler(void)     { service(1U << 2); }
+void EXTI3_IRQHandler(void)     { service(1U << 3); }
+void EXTI4_IRQHandler(void)     { service(1U << 4); }
+void EXTI9_5_IRQHandler(void)   { service(0x03E0U); }
+void EXTI15_10_IRQHandler(void) { service(0xFC00U); }
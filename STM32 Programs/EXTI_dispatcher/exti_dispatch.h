@@ -0,0 +1,55 @@
+/**
+ * exti_dispatch.h - EXTI edge events with timestamps and deferred handlers
+ *
+ * Each of the 16 EXTI lines can have one handler. The interrupt handlers
+ * only stamp the event with TIM5->CNT, clear PR and queue it; the
+ * handlers run later from exti_dispatch() in main(), with the stamp and
+ * the pin level read in the interrupt.
+ *
+ *   exti_init();
+ *   exti_attach(GPIOC, 13, EXTI_FALLING, on_button);
+ *   while (1) {
+ *       exti_dispatch();
+ *       __disable_irq();
+ *       if (!exti_pending())
+ *           __WFI();                   // an interrupt still wakes it
+ *       __enable_irq();                // and is taken here
+ *   }
+ *
+ * Checking the queue with interrupts disabled closes the gap between the
+ * last check and __WFI(): an edge queued there would otherwise wait for
+ * the next interrupt, a second away with the 1 Hz SQW.
+ *
+ * Stamps count 16 MHz cycles (TIM5, 32 bits, wraps after 268 s), so
+ * differences of stamps are exact even across a wrap.
+ */
+
+#ifndef EXTI_DISPATCH_H
+#define EXTI_DISPATCH_H
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+#define EXTI_RISING   1U
+#define EXTI_FALLING  2U
+#define EXTI_BOTH     3U
+#define EXTI_PULLUP   4U                // also enable the pin's pull-up
+
+struct exti_event
+{
+    uint32_t stamp;                     // TIM5->CNT at interrupt entry
+    uint8_t  line;                      // EXTI line = pin number
+    uint8_t  level;                     // pin level read in the interrupt
+};
+
+typedef void (*exti_handler)(const struct exti_event *ev);
+
+void     exti_init(void);
+int      exti_attach(GPIO_TypeDef *port, unsigned pin, unsigned flags, exti_handler fn);
+void     exti_detach(unsigned pin);
+int      exti_dispatch(void);
+int      exti_pending(void);
+
+extern volatile uint32_t exti_dropped;  // events lost to a full queue
+
+#endif /* EXTI_DISPATCH_H */
@@ -0,0 +1,176 @@
+/**
+ * main.c - DS1337 1 Hz output and user button through the EXTI dispatcher
+ *
+ * The DS1337 is told to output its 1 Hz square wave (as in
+ * One_byte_tranfer_I2C), whose falling edges come in on PB4 / EXTI4.
+ * B1 on PC13 comes in on the shared EXTI15_10 vector. Both handlers run
+ * from exti_dispatch() in main(), which sleeps in between, and print over
+ * USART2 at 9600 baud:
+ *
+ *   SQW  3.000000 s  period 16000000 cycles
+ *   B1   3.250112 s  pressed
+ *
+ * The period comes from the interrupt-entry stamps, so it shows the RTC's
+ * rate against the 16 MHz clock regardless of when main() got to it.
+ *
+ * Pins:
+ *   - PB4 = DS1337 SQW/INTA (open drain, internal pull-up)
+ *   - PC13 = B1 user button (active low)
+ *   - PB8 = I2C1_SCL, PB9 = I2C1_SDA
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "exti_dispatch.h"
+
+#define SLAVE_ADDR 0x68  /* 1101 000 (DS1337 I2C Address) */
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void I2C1_init(void);
+int  I2C1_byteWrite(uint8_t saddr, uint8_t maddr, uint8_t data);
+
+static void on_sqw(const struct exti_event *ev);
+static void on_button(const struct exti_event *ev);
+
+int main(void)
+{
+    USART2_init();
+    I2C1_init();
+    exti_init();
+
+    /* SQW runs at 32.768 kHz out of reset; switch it to 1 Hz first */
+    I2C1_byteWrite(SLAVE_ADDR, 0x0E, 0x00);
+
+    exti_attach(GPIOB, 4, EXTI_FALLING | EXTI_PULLUP, on_sqw);
+    exti_attach(GPIOC, 13, EXTI_FALLING, on_button);
+
+    while (1)
+    {
+        exti_dispatch();
+        __disable_irq();
+        if (!exti_pending())
+            __WFI();                    // woken by an interrupt even with PRIMASK set
+        __enable_irq();
+    }
+}
+
+static void print_time(const char *what, uint32_t stamp)
+{
+    printf("%-4s %lu.%06lu s  ", what, (unsigned long)(stamp / 16000000U),
+           (unsigned long)(stamp % 16000000U / 16U));
+}
+
+/**
+ * Falling edge of the 1 Hz wave: the seconds register has just counted
+ */
+static void on_sqw(const struct exti_event *ev)
+{
+    static uint32_t last;
+    static int seen;
+
+    print_time("SQW", ev->stamp);
+    if (seen)
+        printf("period %lu cycles\r\n", (unsigned long)(ev->stamp - last));
+    else
+        printf("first edge\r\n");
+    last = ev->stamp;
+    seen = 1;
+}
+
+static void on_button(const struct exti_event *ev)
+{
+    print_time("B1", ev->stamp);
+    printf("pressed\r\n");
+}
+
+/**
+ * Initialize I2C1 (PB8 = SCL, PB9 = SDA)
+ */
+void I2C1_init(void)
+{
+    RCC->AHB1ENR |= (1U << 1);   // Enable GPIOB clock
+    RCC->APB1ENR |= (1U << 21);  // Enable I2C1 clock
+
+    GPIOB->AFR[1] &= ~((0xF << 0) | (0xF << 4));  // Clear AF
+    GPIOB->AFR[1] |= ((4 << 0) | (4 << 4));       // Set PB8, PB9 to AF4 (I2C1)
+
+    GPIOB->MODER &= ~((3U << 16) | (3U << 18));  // Clear PB8, PB9 mode
+    GPIOB->MODER |=  ((2U << 16) | (2U << 18));  // Set to Alternate Function mode
+
+    GPIOB->OTYPER |=  (1U << 8) | (1U << 9);   // Open-Drain mode
+    GPIOB->PUPDR  &= ~((3U << 16) | (3U << 18));  // Clear pull-up/pull-down
+    GPIOB->PUPDR  |=  ((1U << 16) | (1U << 18));  // Enable pull-up resistors
+
+    I2C1->CR1 |= (1U << 15);  // Software Reset
+    I2C1->CR1 &= ~(1U << 15); // Release from Reset
+
+    I2C1->CR2 = (16U << 0);  // Peripheral Clock = 16 MHz
+    I2C1->CCR = 80U;         // 100 kHz Clock
+    I2C1->TRISE = 17U;       // Maximum Rise Time
+    I2C1->CR1 |= (1U << 0);  // Enable I2C1
+}
+
+/**
+ * Write a byte to a DS1337 register
+ */
+int I2C1_byteWrite(uint8_t saddr, uint8_t maddr, uint8_t data)
+{
+    volatile int tmp;
+
+    while (I2C1->SR2 & (1U << 1));     // Wait until the bus is not busy
+
+    I2C1->CR1 |= (1U << 8);            // Start Generation
+    while (!(I2C1->SR1 & (1U << 0)));  // Wait for Start flag
+
+    I2C1->DR = (saddr << 1);           // Address + Write (LSB = 0)
+    while (!(I2C1->SR1 & (1U << 1)));  // Wait for Address flag
+    tmp = I2C1->SR2;                   // Clear Address flag
+
+    while (!(I2C1->SR1 & (1U << 7)));  // Wait until Data Register Empty
+    I2C1->DR = maddr;                  // Send Register Address
+
+    while (!(I2C1->SR1 & (1U << 7)));  // Wait until Data Register Empty
+    I2C1->DR = data;                   // Send Data Byte
+
+    while (!(I2C1->SR1 & (1U << 2)));  // Wait for Byte Transfer to Finish
+
+    I2C1->CR1 |= (1U << 9);            // Generate Stop Condition
+
+    return 0;
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
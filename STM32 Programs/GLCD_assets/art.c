@@ -0,0 +1,218 @@
+/**
+ * art.c - Generated by tools/assetc.c from art/assets.txt, do not edit
+ */
+
+#include "art.h"
+
+/* font_5x7: 475 bytes stored, 475 uncompressed */
+static const uint8_t font_5x7_data[475] =
+{
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5F, 0x00, 0x00, 0x00, 0x07,
+    0x00, 0x07, 0x00, 0x14, 0x7F, 0x14, 0x7F, 0x14, 0x24, 0x2A, 0x7F, 0x2A,
+    0x12, 0x23, 0x13, 0x08, 0x64, 0x62, 0x36, 0x49, 0x55, 0x22, 0x50, 0x00,
+    0x05, 0x03, 0x00, 0x00, 0x00, 0x1C, 0x22, 0x41, 0x00, 0x00, 0x41, 0x22,
+    0x1C, 0x00, 0x14, 0x08, 0x3E, 0x08, 0x14, 0x08, 0x08, 0x3E, 0x08, 0x08,
+    0x00, 0x50, 0x30, 0x00, 0x00, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x60,
+    0x60, 0x00, 0x00, 0x20, 0x10, 0x08, 0x04, 0x02, 0x3E, 0x51, 0x49, 0x45,
+    0x3E, 0x00, 0x42, 0x7F, 0x40, 0x00, 0x42, 0x61, 0x51, 0x49, 0x46, 0x21,
+    0x41, 0x45, 0x4B, 0x31, 0x18, 0x14, 0x12, 0x7F, 0x10, 0x27, 0x45, 0x45,
+    0x45, 0x39, 0x3C, 0x4A, 0x49, 0x49, 0x30, 0x01, 0x71, 0x09, 0x05, 0x03,
+    0x36, 0x49, 0x49, 0x49, 0x36, 0x06, 0x49, 0x49, 0x29, 0x1E, 0x00, 0x36,
+    0x36, 0x00, 0x00, 0x00, 0x56, 0x36, 0x00, 0x00, 0x08, 0x14, 0x22, 0x41,
+    0x00, 0x14, 0x14, 0x14, 0x14, 0x14, 0x00, 0x41, 0x22, 0x14, 0x08, 0x02,
+    0x01, 0x51, 0x09, 0x06, 0x32, 0x49, 0x79, 0x41, 0x3E, 0x7E, 0x11, 0x11,
+    0x11, 0x7E, 0x7F, 0x49, 0x49, 0x49, 0x36, 0x3E, 0x41, 0x41, 0x41, 0x22,
+    0x7F, 0x41, 0x41, 0x22, 0x1C, 0x7F, 0x49, 0x49, 0x49, 0x41, 0x7F, 0x09,
+    0x09, 0x09, 0x01, 0x3E, 0x41, 0x49, 0x49, 0x7A, 0x7F, 0x08, 0x08, 0x08,
+    0x7F, 0x00, 0x41, 0x7F, 0x41, 0x00, 0x20, 0x40, 0x41, 0x3F, 0x01, 0x7F,
+    0x08, 0x14, 0x22, 0x41, 0x7F, 0x40, 0x40, 0x40, 0x40, 0x7F, 0x02, 0x0C,
+    0x02, 0x7F, 0x7F, 0x04, 0x08, 0x10, 0x7F, 0x3E, 0x41, 0x41, 0x41, 0x3E,
+    0x7F, 0x09, 0x09, 0x09, 0x06, 0x3E, 0x41, 0x51, 0x21, 0x5E, 0x7F, 0x09,
+    0x19, 0x29, 0x46, 0x46, 0x49, 0x49, 0x49, 0x31, 0x01, 0x01, 0x7F, 0x01,
+    0x01, 0x3F, 0x40, 0x40, 0x40, 0x3F, 0x1F, 0x20, 0x40, 0x20, 0x1F, 0x3F,
+    0x40, 0x38, 0x40, 0x3F, 0x63, 0x14, 0x08, 0x14, 0x63, 0x07, 0x08, 0x70,
+    0x08, 0x07, 0x61, 0x51, 0x49, 0x45, 0x43, 0x00, 0x7F, 0x41, 0x41, 0x00,
+    0x02, 0x04, 0x08, 0x10, 0x20, 0x00, 0x41, 0x41, 0x7F, 0x00, 0x04, 0x02,
+    0x01, 0x02, 0x04, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x01, 0x02, 0x04,
+    0x00, 0x20, 0x54, 0x54, 0x54, 0x78, 0x7F, 0x48, 0x44, 0x44, 0x38, 0x38,
+    0x44, 0x44, 0x44, 0x20, 0x38, 0x44, 0x44, 0x48, 0x7F, 0x38, 0x54, 0x54,
+    0x54, 0x18, 0x08, 0x7E, 0x09, 0x01, 0x02, 0x0C, 0x52, 0x52, 0x52, 0x3E,
+    0x7F, 0x08, 0x04, 0x04, 0x78, 0x00, 0x44, 0x7D, 0x40, 0x00, 0x20, 0x40,
+    0x44, 0x3D, 0x00, 0x7F, 0x10, 0x28, 0x44, 0x00, 0x00, 0x41, 0x7F, 0x40,
+    0x00, 0x7C, 0x04, 0x18, 0x04, 0x78, 0x7C, 0x08, 0x04, 0x04, 0x78, 0x38,
+    0x44, 0x44, 0x44, 0x38, 0x7C, 0x14, 0x14, 0x14, 0x08, 0x08, 0x14, 0x14,
+    0x18, 0x7C, 0x7C, 0x08, 0x04, 0x04, 0x08, 0x48, 0x54, 0x54, 0x54, 0x20,
+    0x04, 0x3F, 0x44, 0x40, 0x20, 0x3C, 0x40, 0x40, 0x20, 0x7C, 0x1C, 0x20,
+    0x40, 0x20, 0x1C, 0x3C, 0x40, 0x30, 0x40, 0x3C, 0x44, 0x28, 0x10, 0x28,
+    0x44, 0x0C, 0x50, 0x50, 0x50, 0x3C, 0x44, 0x64, 0x54, 0x4C, 0x44, 0x00,
+    0x08, 0x36, 0x41, 0x00, 0x00, 0x00, 0x7F, 0x00, 0x00, 0x00, 0x41, 0x36,
+    0x08, 0x00, 0x10, 0x08, 0x08, 0x10, 0x08,
+};
+
+const struct zfont art_font_5x7 = { font_5x7_data, 0, 0x20, 95, 5, 8, 1, ASSET_STORED };
+
+/* font_prop: 611 bytes stored, 611 uncompressed */
+static const uint8_t font_prop_data[421] =
+{
+    0x00, 0x00, 0x5F, 0x07, 0x00, 0x07, 0x14, 0x7F, 0x14, 0x7F, 0x14, 0x24,
+    0x2A, 0x7F, 0x2A, 0x12, 0x23, 0x13, 0x08, 0x64, 0x62, 0x36, 0x49, 0x55,
+    0x22, 0x50, 0x05, 0x03, 0x1C, 0x22, 0x41, 0x41, 0x22, 0x1C, 0x14, 0x08,
+    0x3E, 0x08, 0x14, 0x08, 0x08, 0x3E, 0x08, 0x08, 0x50, 0x30, 0x08, 0x08,
+    0x08, 0x08, 0x08, 0x60, 0x60, 0x20, 0x10, 0x08, 0x04, 0x02, 0x3E, 0x51,
+    0x49, 0x45, 0x3E, 0x42, 0x7F, 0x40, 0x42, 0x61, 0x51, 0x49, 0x46, 0x21,
+    0x41, 0x45, 0x4B, 0x31, 0x18, 0x14, 0x12, 0x7F, 0x10, 0x27, 0x45, 0x45,
+    0x45, 0x39, 0x3C, 0x4A, 0x49, 0x49, 0x30, 0x01, 0x71, 0x09, 0x05, 0x03,
+    0x36, 0x49, 0x49, 0x49, 0x36, 0x06, 0x49, 0x49, 0x29, 0x1E, 0x36, 0x36,
+    0x56, 0x36, 0x08, 0x14, 0x22, 0x41, 0x14, 0x14, 0x14, 0x14, 0x14, 0x41,
+    0x22, 0x14, 0x08, 0x02, 0x01, 0x51, 0x09, 0x06, 0x32, 0x49, 0x79, 0x41,
+    0x3E, 0x7E, 0x11, 0x11, 0x11, 0x7E, 0x7F, 0x49, 0x49, 0x49, 0x36, 0x3E,
+    0x41, 0x41, 0x41, 0x22, 0x7F, 0x41, 0x41, 0x22, 0x1C, 0x7F, 0x49, 0x49,
+    0x49, 0x41, 0x7F, 0x09, 0x09, 0x09, 0x01, 0x3E, 0x41, 0x49, 0x49, 0x7A,
+    0x7F, 0x08, 0x08, 0x08, 0x7F, 0x41, 0x7F, 0x41, 0x20, 0x40, 0x41, 0x3F,
+    0x01, 0x7F, 0x08, 0x14, 0x22, 0x41, 0x7F, 0x40, 0x40, 0x40, 0x40, 0x7F,
+    0x02, 0x0C, 0x02, 0x7F, 0x7F, 0x04, 0x08, 0x10, 0x7F, 0x3E, 0x41, 0x41,
+    0x41, 0x3E, 0x7F, 0x09, 0x09, 0x09, 0x06, 0x3E, 0x41, 0x51, 0x21, 0x5E,
+    0x7F, 0x09, 0x19, 0x29, 0x46, 0x46, 0x49, 0x49, 0x49, 0x31, 0x01, 0x01,
+    0x7F, 0x01, 0x01, 0x3F, 0x40, 0x40, 0x40, 0x3F, 0x1F, 0x20, 0x40, 0x20,
+    0x1F, 0x3F, 0x40, 0x38, 0x40, 0x3F, 0x63, 0x14, 0x08, 0x14, 0x63, 0x07,
+    0x08, 0x70, 0x08, 0x07, 0x61, 0x51, 0x49, 0x45, 0x43, 0x7F, 0x41, 0x41,
+    0x02, 0x04, 0x08, 0x10, 0x20, 0x41, 0x41, 0x7F, 0x04, 0x02, 0x01, 0x02,
+    0x04, 0x40, 0x40, 0x40, 0x40, 0x40, 0x01, 0x02, 0x04, 0x20, 0x54, 0x54,
+    0x54, 0x78, 0x7F, 0x48, 0x44, 0x44, 0x38, 0x38, 0x44, 0x44, 0x44, 0x20,
+    0x38, 0x44, 0x44, 0x48, 0x7F, 0x38, 0x54, 0x54, 0x54, 0x18, 0x08, 0x7E,
+    0x09, 0x01, 0x02, 0x0C, 0x52, 0x52, 0x52, 0x3E, 0x7F, 0x08, 0x04, 0x04,
+    0x78, 0x44, 0x7D, 0x40, 0x20, 0x40, 0x44, 0x3D, 0x7F, 0x10, 0x28, 0x44,
+    0x41, 0x7F, 0x40, 0x7C, 0x04, 0x18, 0x04, 0x78, 0x7C, 0x08, 0x04, 0x04,
+    0x78, 0x38, 0x44, 0x44, 0x44, 0x38, 0x7C, 0x14, 0x14, 0x14, 0x08, 0x08,
+    0x14, 0x14, 0x18, 0x7C, 0x7C, 0x08, 0x04, 0x04, 0x08, 0x48, 0x54, 0x54,
+    0x54, 0x20, 0x04, 0x3F, 0x44, 0x40, 0x20, 0x3C, 0x40, 0x40, 0x20, 0x7C,
+    0x1C, 0x20, 0x40, 0x20, 0x1C, 0x3C, 0x40, 0x30, 0x40, 0x3C, 0x44, 0x28,
+    0x10, 0x28, 0x44, 0x0C, 0x50, 0x50, 0x50, 0x3C, 0x44, 0x64, 0x54, 0x4C,
+    0x44, 0x08, 0x36, 0x41, 0x7F, 0x41, 0x36, 0x08, 0x10, 0x08, 0x08, 0x10,
+    0x08,
+};
+
+static const uint16_t font_prop_index[95] =
+{
+    0x0002, 0x0021, 0x0033, 0x0065, 0x00B5, 0x0105, 0x0155, 0x01A2, 0x01C3, 0x01F3, 0x0225, 0x0275,
+    0x02C2, 0x02E5, 0x0332, 0x0355, 0x03A5, 0x03F3, 0x0425, 0x0475, 0x04C5, 0x0515, 0x0565, 0x05B5,
+    0x0605, 0x0655, 0x06A2, 0x06C2, 0x06E4, 0x0725, 0x0774, 0x07B5, 0x0805, 0x0855, 0x08A5, 0x08F5,
+    0x0945, 0x0995, 0x09E5, 0x0A35, 0x0A85, 0x0AD3, 0x0B05, 0x0B55, 0x0BA5, 0x0BF5, 0x0C45, 0x0C95,
+    0x0CE5, 0x0D35, 0x0D85, 0x0DD5, 0x0E25, 0x0E75, 0x0EC5, 0x0F15, 0x0F65, 0x0FB5, 0x1005, 0x1053,
+    0x1085, 0x10D3, 0x1105, 0x1155, 0x11A3, 0x11D5, 0x1225, 0x1275, 0x12C5, 0x1315, 0x1365, 0x13B5,
+    0x1405, 0x1453, 0x1484, 0x14C4, 0x1503, 0x1535, 0x1585, 0x15D5, 0x1625, 0x1675, 0x16C5, 0x1715,
+    0x1765, 0x17B5, 0x1805, 0x1855, 0x18A5, 0x18F5, 0x1945, 0x1993, 0x19C1, 0x19D3, 0x1A05,
+};
+
+const struct zfont art_font_prop = { font_prop_data, font_prop_index, 0x20, 95, 0, 8, 1, ASSET_STORED };
+
+/* digits: 201 bytes packed, 415 uncompressed */
+static const uint8_t digits_data[173] =
+{
+    0x87, 0xC6, 0x18, 0x87, 0x87, 0xC2, 0xF0, 0x91, 0x02, 0xFE, 0xFE, 0xFF,
+    0xC4, 0x07, 0x05, 0xFF, 0xFE, 0xFE, 0xFF, 0xFF, 0xFF, 0x85, 0xC1, 0xFF,
+    0x02, 0x7F, 0x7F, 0xFF, 0xC4, 0xE0, 0x02, 0xFF, 0x7F, 0x7F, 0xC1, 0xFE,
+    0xC1, 0xFF, 0xC1, 0x7F, 0x81, 0xC5, 0x07, 0xE0, 0x1B, 0x02, 0xF0, 0xF0,
+    0xF8, 0xC4, 0x18, 0x05, 0x1F, 0x0F, 0x0F, 0x7F, 0x7F, 0xFF, 0xC5, 0xE0,
+    0x81, 0xC5, 0x07, 0xE0, 0x2F, 0xC5, 0x18, 0xC1, 0xFF, 0xC5, 0xE0, 0xE0,
+    0x27, 0xC1, 0xFE, 0x85, 0xC1, 0xFE, 0x02, 0x0F, 0x0F, 0x1F, 0xC4, 0x18,
+    0xC1, 0xFF, 0x88, 0xC1, 0x7F, 0xE0, 0x4F, 0xC5, 0x07, 0x81, 0xE0, 0x0E,
+    0xC4, 0x18, 0x02, 0xF8, 0xF0, 0xF0, 0x81, 0xC5, 0xE0, 0xE0, 0x49, 0xE0,
+    0x61, 0xC5, 0x07, 0x81, 0xC1, 0xFF, 0xC4, 0x18, 0xE0, 0x10, 0xE0, 0x5C,
+    0xC4, 0xE0, 0xE0, 0x5A, 0xC5, 0x07, 0xE0, 0x6E, 0x86, 0xC1, 0xFF, 0x86,
+    0xC1, 0x7F, 0xE0, 0x7C, 0xC4, 0x07, 0xE6, 0x7A, 0xC4, 0x18, 0xC1, 0xFF,
+    0xE0, 0x76, 0xC4, 0xE0, 0xE0, 0x74, 0xE0, 0x8C, 0xC4, 0x07, 0xE0, 0x8A,
+    0xE0, 0x4C, 0xC4, 0x18, 0xC1, 0xFF, 0x81, 0xC5, 0xE0, 0xE0, 0x85, 0xC2,
+    0xC0, 0xC2, 0x83, 0xC2, 0x07,
+};
+
+static const uint16_t digits_index[14] =
+{
+    0x0008, 0x0044, 0x0076, 0x008C, 0x0223, 0x028C, 0x03DA, 0x049C, 0x059C, 0x06BC, 0x07CA, 0x086C,
+    0x096C, 0x0A74,
+};
+
+const struct zfont art_digits = { digits_data, digits_index, 0x2D, 14, 0, 24, 2, 0 };
+
+/* splash: 304 bytes packed, 504 uncompressed */
+static const uint8_t splash_data[304] =
+{
+    0x00, 0xFE, 0xC3, 0x01, 0x01, 0xF1, 0xF1, 0xC4, 0x01, 0x01, 0xF1, 0xF1,
+    0xE2, 0x08, 0xC4, 0x01, 0x05, 0xF1, 0xF1, 0x01, 0x01, 0xC1, 0xC1, 0xC4,
+    0x31, 0x01, 0xC1, 0xC1, 0xE2, 0x18, 0xC8, 0x01, 0x01, 0xF1, 0xF1, 0xC6,
+    0x31, 0xE2, 0x11, 0xC4, 0x31, 0x01, 0xC1, 0xC1, 0xC5, 0x01, 0x01, 0xFE,
+    0xFF, 0x84, 0x09, 0xFF, 0xFF, 0x03, 0x03, 0x0C, 0x0C, 0x30, 0x30, 0xFF,
+    0xFF, 0x81, 0x01, 0xFF, 0xFF, 0x85, 0x01, 0xFF, 0xFF, 0x81, 0x01, 0xFF,
+    0xFF, 0x85, 0x01, 0xC0, 0xC0, 0x81, 0x01, 0xFF, 0xFF, 0x89, 0x01, 0xFF,
+    0xFF, 0xC4, 0x0C, 0x83, 0x01, 0xFF, 0xFF, 0x85, 0x01, 0xFF, 0xFF, 0x86,
+    0x01, 0xFF, 0xFF, 0x82, 0x22, 0x80, 0x40, 0x43, 0x43, 0x40, 0x00, 0x40,
+    0x40, 0xC0, 0x40, 0x43, 0x03, 0xC0, 0x80, 0x00, 0x80, 0xC3, 0x03, 0x43,
+    0x43, 0x43, 0xC3, 0x40, 0x00, 0x80, 0x40, 0x40, 0x40, 0x83, 0x03, 0xC3,
+    0x43, 0x43, 0x43, 0x40, 0x82, 0x09, 0x83, 0xC3, 0x03, 0x03, 0x83, 0x43,
+    0x43, 0x43, 0x83, 0x03, 0xE2, 0x20, 0x00, 0x03, 0xE4, 0x15, 0x06, 0x83,
+    0x03, 0xC0, 0x40, 0x40, 0x40, 0x43, 0xC3, 0x03, 0x88, 0x01, 0xFF, 0xFF,
+    0x82, 0x04, 0x11, 0x12, 0x12, 0x12, 0x0C, 0x82, 0x00, 0x1F, 0x82, 0x15,
+    0x1F, 0x00, 0x03, 0x00, 0x1F, 0x00, 0x08, 0x10, 0x11, 0x12, 0x0C, 0x00,
+    0x10, 0x18, 0x14, 0x12, 0x11, 0x00, 0x1F, 0x02, 0x02, 0x02, 0x81, 0x0A,
+    0x06, 0x05, 0x04, 0x1F, 0x04, 0x00, 0x0F, 0x14, 0x12, 0x11, 0x0F, 0x81,
+    0x02, 0x10, 0x1F, 0x10, 0x81, 0x0A, 0x1F, 0x02, 0x06, 0x0A, 0x11, 0x00,
+    0x1F, 0x12, 0x12, 0x12, 0x10, 0x8D, 0x01, 0xFF, 0xFF, 0x82, 0x02, 0x41,
+    0x81, 0x81, 0xCC, 0x01, 0x08, 0x81, 0x81, 0x41, 0x21, 0x21, 0x11, 0x11,
+    0x09, 0x09, 0xC4, 0x05, 0x08, 0x09, 0x09, 0x11, 0x11, 0x21, 0x21, 0x41,
+    0x81, 0x81, 0xCC, 0x01, 0xEC, 0x16, 0xC4, 0x05, 0xE6, 0x0E, 0x82, 0x01,
+    0xFF, 0x7F, 0xC4, 0x80, 0x03, 0x81, 0x81, 0x82, 0x82, 0xC4, 0x84, 0x03,
+    0x82, 0x82, 0x81, 0x81, 0xD6, 0x80, 0xE2, 0x0C, 0xC4, 0x84, 0xE2, 0x09,
+    0xD6, 0x80, 0x00, 0x7F,
+};
+
+const struct asset art_splash = { splash_data, 84, 48, 0 };
+
+/* battery: 32 bytes stored, 32 uncompressed */
+static const uint8_t battery_data[32] =
+{
+    0xF0, 0x10, 0xD0, 0xD0, 0xD0, 0x10, 0xD0, 0xD0, 0xD0, 0x10, 0xD0, 0xD0,
+    0xD0, 0xF0, 0xC0, 0xC0, 0x0F, 0x08, 0x0B, 0x0B, 0x0B, 0x08, 0x0B, 0x0B,
+    0x0B, 0x08, 0x0B, 0x0B, 0x0B, 0x0F, 0x03, 0x03,
+};
+
+const struct asset art_battery = { battery_data, 16, 16, ASSET_STORED };
+
+/* signal: 18 bytes packed, 32 uncompressed */
+static const uint8_t signal_data[18] =
+{
+    0x88, 0xC1, 0xC0, 0x80, 0xC1, 0xF8, 0x80, 0xC1, 0x70, 0x80, 0xC1, 0x7E,
+    0x80, 0xC1, 0x7F, 0x80, 0xC1, 0x7F,
+};
+
+const struct asset art_signal = { signal_data, 16, 16, 0 };
+
+/* thermo: 19 bytes packed, 32 uncompressed */
+static const uint8_t thermo_data[19] =
+{
+    0x85, 0x06, 0xFE, 0xE2, 0xE2, 0xFE, 0x00, 0xA8, 0xA8, 0x86, 0x06, 0x38,
+    0x7C, 0xFF, 0xFF, 0xFF, 0x7F, 0x38, 0x84,
+};
+
+const struct asset art_thermo = { thermo_data, 16, 16, 0 };
+
+/* clock: 31 bytes packed, 32 uncompressed */
+static const uint8_t clock_data[31] =
+{
+    0x14, 0xE0, 0x18, 0x04, 0x02, 0x02, 0x01, 0x01, 0xF9, 0x81, 0x81, 0x82,
+    0x02, 0x04, 0x18, 0xE0, 0x00, 0x03, 0x0C, 0x10, 0x20, 0x20, 0xC3, 0x40,
+    0x05, 0x20, 0x20, 0x10, 0x0C, 0x03, 0x00,
+};
+
+const struct asset art_clock = { clock_data, 16, 16, 0 };
+
+const struct art_stat art_stats[ART_COUNT] =
+{
+    { "font_5x7", 0, &art_font_5x7, 475, 475, 475, 0x9999E2C7U },
+    { "font_prop", 0, &art_font_prop, 421, 611, 611, 0x6C8FF97CU },
+    { "digits", 0, &art_digits, 387, 415, 201, 0x54974D80U },
+    { "splash", &art_splash, 0, 504, 504, 304, 0x0051EF59U },
+    { "battery", &art_battery, 0, 32, 32, 32, 0xD54CCD1BU },
+    { "signal", &art_signal, 0, 32, 32, 18, 0x71B5B141U },
+    { "thermo", &art_thermo, 0, 32, 32, 19, 0xAC108119U },
+    { "clock", &art_clock, 0, 32, 32, 31, 0xC546D8A3U },
+};
@@ -0,0 +1,34 @@
+/**
+ * art.h - Generated by tools/assetc.c from art/assets.txt, do not edit
+ */
+
+#ifndef ART_H
+#define ART_H
+
+#include "asset.h"
+
+extern const struct zfont art_font_5x7;
+extern const struct zfont art_font_prop;
+extern const struct zfont art_digits;
+extern const struct asset art_splash;
+extern const struct asset art_battery;
+extern const struct asset art_signal;
+extern const struct asset art_thermo;
+extern const struct asset art_clock;
+
+struct art_stat
+{
+    const char         *name;
+    const struct asset *bitmap;
+    const struct zfont *font;
+    uint16_t            raw;        // column bytes
+    uint16_t            plain;      // flash they take uncompressed, index included
+    uint16_t            flash;      // flash they take as built
+    uint32_t            crc;        // CRC-32 of the column bytes
+};
+
+#define ART_COUNT  8
+
+extern const struct art_stat art_stats[ART_COUNT];
+
+#endif /* ART_H */
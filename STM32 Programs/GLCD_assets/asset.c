@@ -0,0 +1,192 @@
+/**
+ * asset.c - Compressed bitmaps and fonts, decoded straight into the
+ *           PCD8544 framebuffer
+ *
+ * asset_span() turns one token into a run: a pointer to bytes in flash
+ * (literals, or earlier compressed bytes for a copy) or a repeated value.
+ * draw() walks the runs with the position in the image, bank k and
+ * column c, and blits each byte like gfx_blit(): widened to 16 bits,
+ * shifted by y % 8 and written into one or two banks. Zero runs change
+ * nothing unless the image is copied opaquely, so with GFX_SET, _CLEAR
+ * and _XOR they only move the position; most of an icon's background is
+ * skipped that way.
+ */
+
+#include "stm32f4xx.h"
+#include "glcd_fb.h"
+#include "gfx.h"
+#include "asset.h"
+
+const uint8_t *asset_span(const uint8_t *p, const uint8_t **src, uint8_t *fill, int *n)
+{
+    uint8_t t = *p;
+
+    if (t < 0x80U) {                    // literal
+        *n = t + 1;
+        *src = p + 1;
+        return p + 1 + *n;
+    }
+    *src = 0;
+    if (t < 0xC0U) {                    // zeros
+        *n = (t & 0x3F) + 1;
+        *fill = 0;
+        return p + 1;
+    }
+    if (t < 0xE0U) {                    // fill
+        *n = (t & 0x1F) + 2;
+        *fill = p[1];
+        return p + 2;
+    }
+    *n = ((t >> 1) & 0x0F) + 3;         // copy
+    *src = p - ((((t & 1U) << 8) | p[1]) + 1);
+    return p + 2;
+}
+
+/* Where bank k of an image at row y lands: banks b0 and b0 + 1, shift s */
+struct place
+{
+    int      b0, s;
+    uint8_t  vm;                        // rows of the image in this bank
+    uint16_t m;                         // the same, shifted
+};
+
+static void place(struct place *pl, int y, int k, int h)
+{
+    pl->b0 = ((y + 8 * k + 8) >> 3) - 1;    // -1 above the screen
+    pl->s  = (y + 8 * k + 8) & 7;
+    pl->vm = (uint8_t)(8 * k + 8 > h ? 0xFFU >> (8 * k + 8 - h) : 0xFFU);
+    pl->m  = (uint16_t)(pl->vm << pl->s);
+}
+
+/**
+ * Image of w x h pixels at (x, y): a token stream, or w * banks plain
+ * bytes when stored
+ */
+static void draw(const uint8_t *p, int stored, int x, int y, int w, int h, unsigned op)
+{
+    const uint8_t *src;
+    struct place pl;
+    int total = w * ((h + 7) >> 3), i = 0, k = 0, c = 0, n, cx, lo, hi;
+    uint16_t v;
+    uint8_t fill = 0;
+
+    if (w <= 0 || x >= GLCD_WIDTH || y >= GLCD_HEIGHT || x + w <= 0 || y + h <= 0)
+        return;
+    place(&pl, y, 0, h);
+    while (i < total) {
+        if (stored) {
+            src = p;
+            n = total;
+        } else {
+            p = asset_span(p, &src, &fill, &n);
+        }
+        if (!src && !fill && op != GFX_COPY) {     // zeros: only move on
+            i += n;
+            c += n;
+            if (c >= w) {
+                k = i / w;
+                c = i - k * w;
+                place(&pl, y, k, h);
+            }
+            continue;
+        }
+        i += n;
+        while (n--) {
+            v = (uint16_t)(((src ? *src++ : fill) & pl.vm) << pl.s);
+            cx = x + c;
+            if ((unsigned)cx < GLCD_WIDTH) {
+                lo = (unsigned)pl.b0 < GLCD_BANKS;
+                hi = pl.s && (unsigned)(pl.b0 + 1) < GLCD_BANKS;
+                if (op == GFX_COPY) {
+                    if (lo)
+                        glcd_fb[pl.b0][cx] = (uint8_t)((glcd_fb[pl.b0][cx] & ~pl.m) | v);
+                    if (hi)
+                        glcd_fb[pl.b0 + 1][cx] = (uint8_t)((glcd_fb[pl.b0 + 1][cx] & ~(pl.m >> 8)) | (v >> 8));
+                } else if (op == GFX_SET) {
+                    if (lo)
+                        glcd_fb[pl.b0][cx] |= (uint8_t)v;
+                    if (hi)
+                        glcd_fb[pl.b0 + 1][cx] |= (uint8_t)(v >> 8);
+                } else if (op == GFX_XOR) {
+                    if (lo)
+                        glcd_fb[pl.b0][cx] ^= (uint8_t)v;
+                    if (hi)
+                        glcd_fb[pl.b0 + 1][cx] ^= (uint8_t)(v >> 8);
+                } else {
+                    if (lo)
+                        glcd_fb[pl.b0][cx] &= (uint8_t)~v;
+                    if (hi)
+                        glcd_fb[pl.b0 + 1][cx] &= (uint8_t)~(v >> 8);
+                }
+            }
+            if (++c == w) {
+                c = 0;
+                place(&pl, y, ++k, h);
+            }
+        }
+    }
+}
+
+void asset_draw(const struct asset *a, int x, int y, unsigned op)
+{
+    draw(a->data, a->flags & ASSET_STORED, x, y, a->w, a->h, op);
+    glcd_fb_mark(x, y, x + a->w - 1, y + a->h - 1);
+}
+
+const uint8_t *zfont_glyph(const struct zfont *f, char c, int *w)
+{
+    unsigned i = (uint8_t)c - f->first;
+
+    if (i >= f->count)
+        i = (unsigned)('?' - f->first) < f->count ? (unsigned)('?' - f->first) : 0U;
+    if (f->index) {
+        *w = f->index[i] & 0x0FU;
+        return f->data + (f->index[i] >> 4);
+    }
+    *w = f->width;
+    return f->data + i * f->width * ((f->height + 7) >> 3);
+}
+
+/**
+ * Draw one glyph without marking it dirty; returns the advance
+ */
+static int blit(const struct zfont *f, int x, int y, char c, unsigned op)
+{
+    int w;
+    const uint8_t *p = zfont_glyph(f, c, &w);
+
+    draw(p, f->flags & ASSET_STORED, x, y, w, f->height, op);
+    if (op == GFX_COPY && f->spacing)
+        gfx_fill(x + w, y, x + w + f->spacing - 1, y + f->height - 1, GFX_CLEAR);
+    return w + f->spacing;
+}
+
+int zfont_putc(const struct zfont *f, int x, int y, char c, unsigned op)
+{
+    int adv = blit(f, x, y, c, op);
+
+    glcd_fb_mark(x, y, x + adv - 1, y + f->height - 1);
+    return adv;
+}
+
+int zfont_puts(const struct zfont *f, int x, int y, const char *s, unsigned op)
+{
+    int x0 = x;
+
+    while (*s && x < GLCD_WIDTH)
+        x += blit(f, x, y, *s++, op);
+    if (x > x0)
+        glcd_fb_mark(x0, y, x - 1, y + f->height - 1);
+    return x + zfont_width(f, s);
+}
+
+int zfont_width(const struct zfont *f, const char *s)
+{
+    int w, n = 0;
+
+    while (*s) {
+        zfont_glyph(f, *s++, &w);
+        n += w + f->spacing;
+    }
+    return n;
+}
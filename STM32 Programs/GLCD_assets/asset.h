@@ -0,0 +1,68 @@
+/**
+ * asset.h - Compressed bitmaps and fonts, decoded straight into the
+ *           PCD8544 framebuffer
+ *
+ * Assets are made on the host by tools/assetc.c from the PBM images in
+ * art/ (see art/assets.txt) and compiled in as art.c / art.h. The data is
+ * the framebuffer's own layout, (h + 7) / 8 banks of w column bytes, as
+ * a stream of tokens:
+ *
+ *   0nnnnnnn             n + 1 literal bytes follow (1..128)
+ *   10nnnnnn             n + 1 zero bytes (1..64)
+ *   110nnnnn v           n + 2 copies of v (2..33)
+ *   111nnnnd dddddddd    n + 3 bytes (3..18) copied from the stream itself,
+ *                        d + 1 bytes before this token (1..512)
+ *
+ * Copies point back into the compressed bytes in flash, not into the
+ * output, so the decoder keeps no window and no output buffer: every
+ * token is a run of one value or a run of bytes already in flash, and
+ * the runs go straight into framebuffer columns. An asset that does not
+ * shrink is stored as plain column bytes (ASSET_STORED).
+ *
+ * A font keeps one stream per glyph, found through an index of offset
+ * and width as in font.c, so any character decodes on its own; copies
+ * may still reach into the glyphs before it. Fixed-width fonts that are
+ * stored need no index.
+ *
+ *   asset_draw(&art_splash, 0, 0, GFX_COPY);
+ *   x = zfont_puts(&art_digits, 2, 20, "12:45", GFX_SET);
+ */
+
+#ifndef ASSET_H
+#define ASSET_H
+
+#include <stdint.h>
+
+#define ASSET_STORED  1U                // data is plain column bytes
+
+struct asset
+{
+    const uint8_t *data;
+    uint8_t        w, h;
+    uint8_t        flags;
+};
+
+struct zfont
+{
+    const uint8_t  *data;
+    const uint16_t *index;              // offset << 4 | width, NULL when stored fixed width
+    uint8_t         first, count;       // characters covered
+    uint8_t         width;              // columns per glyph when fixed
+    uint8_t         height;             // rows, 8 per bank
+    uint8_t         spacing;            // blank columns after each glyph
+    uint8_t         flags;
+};
+
+/*
+ * One token: *n output bytes, either *n bytes from *src or *n copies of
+ * *fill (*src = 0). Returns the next token.
+ */
+const uint8_t *asset_span(const uint8_t *p, const uint8_t **src, uint8_t *fill, int *n);
+
+void asset_draw(const struct asset *a, int x, int y, unsigned op);     // GFX_SET, _CLEAR, _XOR, _COPY
+int  zfont_putc(const struct zfont *f, int x, int y, char c, unsigned op);  // returns the advance
+int  zfont_puts(const struct zfont *f, int x, int y, const char *s, unsigned op);  // returns the end x
+int  zfont_width(const struct zfont *f, const char *s);
+const uint8_t *zfont_glyph(const struct zfont *f, char c, int *width);    // stream of c
+
+#endif /* ASSET_H */
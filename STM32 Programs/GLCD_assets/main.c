@@ -0,0 +1,307 @@
+/**
+ * main.c - Compressed bitmaps and fonts on the PCD8544, checked, sized
+ *          and timed (STM32F401RE)
+ *
+ * The UI asset set in art/ (two 5x7 fonts, 12x24 clock digits, an 84x48
+ * splash and four 16x16 icons) is compressed by tools/assetc.c into
+ * art.c. At start every asset is decoded token by token with
+ * asset_span() and its CRC-32 compared with the generator's, and drawn
+ * PLACES times at random positions with a random operation over a random
+ * background, compared with gfx_blit() of the decoded bytes. The flash
+ * each asset takes is listed against its plain column bytes, and drawing
+ * straight from flash into the framebuffer is timed with the DWT cycle
+ * counter. The results go out over USART2 at 9600 baud. On the host
+ * simulator:
+ *   asset      raw  plain  flash  saved  crc bad
+ *   font_5x7   475    475    475     0%  ok  0  stored
+ *   font_prop  421    611    611     0%  ok  0  stored
+ *   digits     387    415    201    51%  ok  0
+ *   splash     504    504    304    39%  ok  0
+ *   battery     32     32     32     0%  ok  0  stored
+ *   signal      32     32     18    43%  ok  0
+ *   thermo      32     32     19    40%  ok  0
+ *   clock       32     32     31     3%  ok  0
+ *   total     1915   2133   1691    20%
+ *   splash copy :    504 bytes,      3 cyc, - kB/s
+ *   icons set   :    128 bytes,      3 cyc, - kB/s
+ *   digits set  :    129 bytes,      3 cyc, - kB/s
+ * The 5x7 glyphs are too small for runs to pay, so those fonts stay
+ * stored, as do icons that would not shrink; "plain" counts a stored
+ * font's index the way font.c keeps it.
+ * The simulator does not charge computation, so the timings there show
+ * only the DWT read; run on the board for the decode rate. Afterwards the
+ * splash is shown for two seconds, then a clock screen with the large
+ * digits and the icons is redrawn every 100 ms.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PA5 = SPI1_SCK, PA7 = SPI1_MOSI (AF5), PA8 = GLCD CE
+ *   - PB6 = GLCD D/C, PB10 = GLCD RST
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include <string.h>
+#include "glcd_fb.h"
+#include "gfx.h"
+#include "asset.h"
+#include "art.h"
+
+#define PLACES  100                     // random placements checked per asset
+#define RUNS    16                      // timed draws of each kind
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void delayMs(int n);
+
+static uint8_t plain[512];              // one asset unpacked, for checking only
+static uint16_t glyph_at[96];           // where each glyph starts in plain[]
+static uint8_t background[GLCD_BANKS][GLCD_WIDTH];
+static uint8_t result[GLCD_BANKS][GLCD_WIDTH];
+static uint32_t seed = 12345;
+
+static int rnd(int lo, int hi)
+{
+    seed = seed * 1664525U + 1013904223U;
+    return lo + (int)((seed >> 8) % (uint32_t)(hi - lo + 1));
+}
+
+static uint32_t crc32(const uint8_t *p, int n)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+    int k;
+
+    while (n--) {
+        crc ^= *p++;
+        for (k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+    }
+    return ~crc;
+}
+
+/**
+ * n column bytes decoded from p into out, one run at a time
+ */
+static void unpack(const uint8_t *p, int stored, uint8_t *out, int n)
+{
+    const uint8_t *src;
+    uint8_t fill;
+    int len;
+
+    if (stored) {
+        memcpy(out, p, n);
+        return;
+    }
+    while (n > 0) {
+        p = asset_span(p, &src, &fill, &len);
+        n -= len;
+        while (len--)
+            *out++ = src ? *src++ : fill;
+    }
+}
+
+/**
+ * One random placement of s drawn by asset.c and by gfx_blit() from the
+ * unpacked bytes; returns 1 when they differ
+ */
+static int place_differs(const struct art_stat *s)
+{
+    const struct zfont *f = s->font;
+    int i, w, x = rnd(-20, 90), y = rnd(-24, 50);
+    unsigned op = (unsigned)rnd(0, 3);
+    char c;
+
+    for (i = 0; i < GLCD_BYTES; i++)
+        (&background[0][0])[i] = (uint8_t)rnd(0, 255);
+    memcpy(glcd_fb, background, sizeof(background));
+    if (s->bitmap) {
+        asset_draw(s->bitmap, x, y, op);
+        memcpy(result, glcd_fb, sizeof(result));
+        memcpy(glcd_fb, background, sizeof(background));
+        gfx_blit(x, y, s->bitmap->w, s->bitmap->h, plain, op);
+    } else {
+        c = (char)(f->first + rnd(0, f->count - 1));
+        zfont_putc(f, x, y, c, op);
+        memcpy(result, glcd_fb, sizeof(result));
+        memcpy(glcd_fb, background, sizeof(background));
+        zfont_glyph(f, c, &w);
+        gfx_blit(x, y, w, f->height, plain + glyph_at[c - f->first], op);
+        if (op == GFX_COPY && f->spacing)
+            gfx_fill(x + w, y, x + w + f->spacing - 1, y + f->height - 1, GFX_CLEAR);
+    }
+    return memcmp(result, glcd_fb, sizeof(result)) != 0;
+}
+
+static void check(const struct art_stat *s)
+{
+    const uint8_t *p;
+    int stored, i, w, n = 0, bad = 0;
+
+    if (s->bitmap) {
+        stored = s->bitmap->flags & ASSET_STORED;
+        n = s->bitmap->w * ((s->bitmap->h + 7) >> 3);
+        unpack(s->bitmap->data, stored, plain, n);
+    } else {
+        stored = s->font->flags & ASSET_STORED;
+        for (i = 0; i < s->font->count; i++) {
+            p = zfont_glyph(s->font, (char)(s->font->first + i), &w);
+            glyph_at[i] = (uint16_t)n;
+            unpack(p, stored, plain + n, w * ((s->font->height + 7) >> 3));
+            n += w * ((s->font->height + 7) >> 3);
+        }
+    }
+    for (i = 0; i < PLACES; i++)
+        bad += place_differs(s);
+    printf("%-9s %4u   %4u   %4u   %3u%%  %s %d%s\r\n", s->name,
+           (unsigned)s->raw, (unsigned)s->plain, (unsigned)s->flash,
+           (unsigned)((s->plain - s->flash) * 100U / s->plain),
+           crc32(plain, n) == s->crc ? "ok " : "BAD", bad, stored ? "  stored" : "");
+}
+
+static void sizes(void)
+{
+    unsigned raw = 0, plain = 0, flash = 0;
+    int i;
+
+    printf("asset      raw  plain  flash  saved  crc bad\r\n");
+    for (i = 0; i < ART_COUNT; i++) {
+        check(&art_stats[i]);
+        raw += art_stats[i].raw;
+        plain += art_stats[i].plain;
+        flash += art_stats[i].flash;
+    }
+    printf("total     %4u   %4u   %4u   %3u%%\r\n", raw, plain, flash,
+           (plain - flash) * 100U / plain);
+}
+
+static void draw_icons(int y)
+{
+    asset_draw(&art_battery, 0, y, GFX_SET);
+    asset_draw(&art_signal, 22, y, GFX_SET);
+    asset_draw(&art_thermo, 45, y, GFX_SET);
+    asset_draw(&art_clock, 68, y, GFX_SET);
+}
+
+/**
+ * Average cycles of RUNS draws of one kind; bytes is what one draw decodes
+ */
+static void timed(const char *name, int kind, unsigned bytes)
+{
+    uint32_t t0, cycles = 0;
+    int n;
+
+    for (n = 0; n < RUNS; n++) {
+        glcd_fb_clear();
+        t0 = DWT->CYCCNT;
+        if (kind == 0)
+            asset_draw(&art_splash, 0, 0, GFX_COPY);
+        else if (kind == 1)
+            draw_icons(3);                      // across a bank boundary
+        else
+            zfont_puts(&art_digits, 5, 12, "12:45", GFX_SET);
+        cycles += DWT->CYCCNT - t0;
+    }
+    cycles /= RUNS;
+    printf("%-12s: %6u bytes, %6lu cyc, ", name, bytes, (unsigned long)cycles);
+    if (cycles < bytes)                         // only the DWT read was counted
+        printf("- kB/s\r\n");
+    else
+        printf("%lu kB/s\r\n", (unsigned long)((uint64_t)bytes * 16000000U / cycles / 1000U));
+}
+
+/* Column bytes decoded for s, spacing excluded */
+static unsigned text_bytes(const struct zfont *f, const char *s)
+{
+    return (unsigned)(zfont_width(f, s) - f->spacing * (int)strlen(s)) * ((f->height + 7U) >> 3);
+}
+
+static void draw_clock(unsigned n)
+{
+    char text[8];
+    unsigned t = 12 * 60 + 45 + n / 10;         // a minute every second
+
+    glcd_fb_clear();
+    asset_draw(&art_battery, 0, 0, GFX_SET);
+    asset_draw(&art_signal, 18, 0, GFX_SET);
+    asset_draw(&art_thermo, 44, 0, GFX_SET);
+    sprintf(text, "%uC", 21 + n / 50 % 3);
+    zfont_puts(&art_font_prop, 61, 5, text, GFX_SET);
+    gfx_hline(0, 83, 17, GFX_SET);
+    asset_draw(&art_clock, 0, 26, GFX_SET);
+    sprintf(text, "%02u:%02u", t / 60 % 24, t % 60);
+    zfont_puts(&art_digits, 83 - zfont_width(&art_digits, text), 22, text, GFX_SET);
+}
+
+int main(void)
+{
+    unsigned n = 0;
+
+    USART2_init();
+    glcd_fb_init(GLCD_SPI_DIV4);
+    CoreDebug->DEMCR |= (1U << 24);     // TRCENA
+    DWT->CTRL |= 1U;                    // CYCCNTENA
+
+    sizes();
+    timed("splash copy", 0, art_splash.w * ((art_splash.h + 7U) >> 3));
+    timed("icons set", 1, 4U * 32U);
+    timed("digits set", 2, text_bytes(&art_digits, "12:45"));
+
+    glcd_fb_clear();
+    asset_draw(&art_splash, 0, 0, GFX_COPY);
+    glcd_fb_update(0, 0);
+    delayMs(2000);
+
+    while (1)
+    {
+        draw_clock(n++);
+        glcd_fb_update(0, 0);
+        delayMs(100);
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
+
+/**
+ * Approximate delay in ms for a ~16 MHz clock (3195 loops per ms)
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
@@ -0,0 +1,511 @@
+/**
+ * assetc.c - Build-time generator for the GLCD_assets program (host)
+ *
+ * Reads a manifest of PBM images and writes art.c and art.h: each image
+ * as column bytes in the PCD8544 layout, compressed into the token
+ * format described in asset.h, or stored plain when that is smaller.
+ * Every stream is decoded again and compared before anything is written,
+ * and a size table goes to stdout.
+ *
+ *   cc -O2 -o assetc tools/assetc.c
+ *   ./assetc art/assets.txt .
+ *
+ * Manifest lines, file names relative to the manifest:
+ *   bitmap NAME FILE
+ *   font   NAME FILE FIRST COUNT CELL SPACING fixed|prop
+ * A font sheet holds COUNT glyphs of CELL columns side by side, from
+ * character FIRST on. prop trims the empty columns on both sides of each
+ * glyph; an empty glyph keeps half a cell.
+ *
+ * The encoder is greedy. At each byte it takes the longest of a zero run,
+ * a run of one value and a copy of up to COPY_MAX bytes found in the
+ * last DIST_MAX bytes already written, if that saves at least a byte
+ * over literals; a pending literal run counts as one more byte, as it
+ * will need a new header after the token.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define MAX_ASSETS   32
+#define MAX_GLYPHS   128
+#define MAX_BYTES    8192
+
+#define LIT_MAX      128
+#define ZERO_MAX     64
+#define FILL_MAX     33
+#define COPY_MIN     3
+#define COPY_MAX     18
+#define DIST_MAX     512
+
+struct image
+{
+    int      w, h;
+    uint8_t *px;                        // one byte per pixel, row by row
+};
+
+struct asset
+{
+    char     name[32];
+    int      font, prop, first, count, cell, spacing;
+    int      w, h;                      // bitmap size, or glyph height
+    int      stored;
+    int      widths[MAX_GLYPHS];
+    int      start[MAX_GLYPHS];         // glyph offsets in raw[]
+    int      index[MAX_GLYPHS];         // glyph offsets in out[]
+    uint8_t  raw[MAX_BYTES];            // column bytes, glyph after glyph
+    int      raw_len;
+    uint8_t  out[MAX_BYTES];            // what goes into flash
+    int      out_len;
+    int      plain;                     // raw_len plus the index it needs
+    int      flash;                     // out_len plus the index
+    uint32_t crc;
+};
+
+static struct asset assets[MAX_ASSETS];
+static int n_assets;
+
+static void fail(const char *what, const char *arg)
+{
+    fprintf(stderr, "assetc: %s%s%s\n", what, arg ? ": " : "", arg ? arg : "");
+    exit(1);
+}
+
+/* ---------------- input ---------------- */
+
+static void skip_space(FILE *f)
+{
+    int ch;
+
+    while ((ch = fgetc(f)) != EOF) {
+        if (ch == '#') {
+            while (ch != '\n' && ch != EOF)
+                ch = fgetc(f);
+        } else if (ch > ' ') {
+            ungetc(ch, f);
+            return;
+        }
+    }
+}
+
+/**
+ * Plain (P1) PBM, 1 = black = lit pixel
+ */
+static void read_pbm(const char *path, struct image *img)
+{
+    FILE *f = fopen(path, "r");
+    char magic[3] = { 0 };
+    int ch, i = 0;
+
+    if (!f)
+        fail("cannot open", path);
+    skip_space(f);
+    if (fread(magic, 1, 2, f) != 2 || strcmp(magic, "P1"))
+        fail("not a plain PBM (P1)", path);
+    skip_space(f);
+    if (fscanf(f, "%d", &img->w) != 1)
+        fail("bad width", path);
+    skip_space(f);
+    if (fscanf(f, "%d", &img->h) != 1 || img->w <= 0 || img->h <= 0)
+        fail("bad height", path);
+    img->px = malloc((size_t)img->w * img->h);
+    while (i < img->w * img->h) {
+        skip_space(f);
+        ch = fgetc(f);
+        if (ch != '0' && ch != '1')
+            fail("bad pixel data", path);
+        img->px[i++] = (uint8_t)(ch == '1');
+    }
+    fclose(f);
+}
+
+/**
+ * Columns x0..x0 + w - 1 as (h + 7) / 8 banks of w bytes, bit 0 on top
+ */
+static int columns(const struct image *img, int x0, int w, uint8_t *out)
+{
+    int k, x, r, y, n = 0;
+    uint8_t v;
+
+    for (k = 0; k < (img->h + 7) / 8; k++) {
+        for (x = x0; x < x0 + w; x++) {
+            v = 0;
+            for (r = 0; r < 8; r++) {
+                y = 8 * k + r;
+                if (y < img->h && img->px[y * img->w + x])
+                    v |= (uint8_t)(1U << r);
+            }
+            out[n++] = v;
+        }
+    }
+    return n;
+}
+
+static int column_empty(const struct image *img, int x)
+{
+    int y;
+
+    for (y = 0; y < img->h; y++)
+        if (img->px[y * img->w + x])
+            return 0;
+    return 1;
+}
+
+/* ---------------- encoder ---------------- */
+
+static void flush_literal(struct asset *a, const uint8_t *lit, int *n)
+{
+    if (*n) {
+        a->out[a->out_len++] = (uint8_t)(*n - 1);
+        memcpy(a->out + a->out_len, lit, (size_t)*n);
+        a->out_len += *n;
+        *n = 0;
+    }
+}
+
+/**
+ * Longest copy of d[0..max) from out[] ending before a token at pos
+ */
+static int find_copy(const struct asset *a, int pos, const uint8_t *d, int max, int *dist)
+{
+    int s, l, best = 0;
+
+    if (max > COPY_MAX)
+        max = COPY_MAX;
+    for (s = pos - DIST_MAX > 0 ? pos - DIST_MAX : 0; s < a->out_len; s++) {
+        for (l = 0; l < max && s + l < a->out_len && a->out[s + l] == d[l]; l++) {}
+        if (l > best) {
+            best = l;
+            *dist = pos - s;
+        }
+    }
+    return best;
+}
+
+/**
+ * Append the tokens of d[0..n) to a->out
+ */
+static void encode(struct asset *a, const uint8_t *d, int n)
+{
+    uint8_t lit[LIT_MAX];
+    int i = 0, nlit = 0, z, f, c, dist = 0, pos, extra;
+
+    while (i < n) {
+        for (z = 0; i + z < n && d[i + z] == 0 && z < ZERO_MAX; z++) {}
+        for (f = 1; i + f < n && d[i + f] == d[i] && f < FILL_MAX; f++) {}
+        pos = a->out_len + (nlit ? nlit + 1 : 0);
+        c = find_copy(a, pos, d + i, n - i, &dist);
+        extra = nlit ? 1 : 0;
+
+        if (z > 0 && z - 1 >= extra && z >= c && z >= f) {
+            flush_literal(a, lit, &nlit);
+            a->out[a->out_len++] = (uint8_t)(0x80U | (z - 1));
+            i += z;
+        } else if (f >= 3 + extra && f >= c) {
+            flush_literal(a, lit, &nlit);
+            a->out[a->out_len++] = (uint8_t)(0xC0U | (f - 2));
+            a->out[a->out_len++] = d[i];
+            i += f;
+        } else if (c >= COPY_MIN + extra) {
+            flush_literal(a, lit, &nlit);
+            a->out[a->out_len++] = (uint8_t)(0xE0U | ((c - 3) << 1) | ((dist - 1) >> 8));
+            a->out[a->out_len++] = (uint8_t)(dist - 1);
+            i += c;
+        } else {
+            lit[nlit++] = d[i++];
+            if (nlit == LIT_MAX)
+                flush_literal(a, lit, &nlit);
+        }
+        if (a->out_len > MAX_BYTES - LIT_MAX - 4)
+            fail("asset too large", a->name);
+    }
+    flush_literal(a, lit, &nlit);
+}
+
+/**
+ * The decoder of asset.c, into a buffer; returns the token bytes used
+ */
+static int decode(const uint8_t *p, uint8_t *out, int n)
+{
+    const uint8_t *p0 = p, *src;
+    int i = 0, len, k;
+    uint8_t t, fill = 0;
+
+    while (i < n) {
+        t = *p;
+        src = 0;
+        if (t < 0x80U) {
+            len = t + 1;
+            src = p + 1;
+            p += 1 + len;
+        } else if (t < 0xC0U) {
+            len = (t & 0x3F) + 1;
+            fill = 0;
+            p += 1;
+        } else if (t < 0xE0U) {
+            len = (t & 0x1F) + 2;
+            fill = p[1];
+            p += 2;
+        } else {
+            len = ((t >> 1) & 0x0F) + 3;
+            src = p - ((((t & 1U) << 8) | p[1]) + 1);
+            p += 2;
+        }
+        for (k = 0; k < len && i < n; k++)
+            out[i++] = src ? src[k] : fill;
+        if (k < len)
+            return -1;                  // ran past the end of the image
+    }
+    return (int)(p - p0);
+}
+
+static uint32_t crc32(const uint8_t *p, int n)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+    int k;
+
+    while (n--) {
+        crc ^= *p++;
+        for (k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+    }
+    return ~crc;
+}
+
+/* ---------------- assets ---------------- */
+
+static void pack(struct asset *a)
+{
+    uint8_t check[MAX_BYTES];
+    int g, banks = (a->h + 7) / 8, len, used;
+
+    if (!a->font) {
+        a->plain = a->raw_len;
+        encode(a, a->raw, a->raw_len);
+        if (decode(a->out, check, a->raw_len) != a->out_len || memcmp(check, a->raw, a->raw_len))
+            fail("round trip failed", a->name);
+        a->flash = a->out_len;
+        if (a->out_len >= a->raw_len) {
+            a->stored = 1;
+            memcpy(a->out, a->raw, (size_t)a->raw_len);
+            a->out_len = a->flash = a->raw_len;
+        }
+        return;
+    }
+
+    for (g = 0; g < a->count; g++) {
+        len = a->widths[g] * banks;
+        a->index[g] = a->out_len;
+        encode(a, a->raw + a->start[g], len);
+        used = decode(a->out + a->index[g], check, len);
+        if (used != a->out_len - a->index[g] || memcmp(check, a->raw + a->start[g], (size_t)len))
+            fail("round trip failed", a->name);
+    }
+    a->flash = a->out_len + 2 * a->count;
+
+    /* Stored fixed-width glyphs are found by arithmetic, without an index */
+    a->plain = a->raw_len + (a->prop ? 2 * a->count : 0);
+    if (a->plain <= a->flash) {
+        a->stored = 1;
+        memcpy(a->out, a->raw, (size_t)a->raw_len);
+        a->out_len = a->raw_len;
+        for (g = 0; g < a->count; g++)
+            a->index[g] = a->start[g];
+        a->flash = a->plain;
+    }
+}
+
+static void load(struct asset *a, const char *path)
+{
+    struct image img;
+    int g, x0, x1;
+
+    read_pbm(path, &img);
+    a->h = img.h;
+    if (!a->font) {
+        if (img.w > 255 || img.h > 255)
+            fail("bitmap larger than 255 pixels", path);
+        a->w = img.w;
+        a->raw_len = columns(&img, 0, img.w, a->raw);
+    } else {
+        if (a->count > MAX_GLYPHS || a->count * a->cell != img.w)
+            fail("sheet width is not COUNT * CELL", path);
+        for (g = 0; g < a->count; g++) {
+            x0 = g * a->cell;
+            x1 = x0 + a->cell;
+            if (a->prop) {
+                while (x0 < x1 && column_empty(&img, x0))
+                    x0++;
+                while (x1 > x0 && column_empty(&img, x1 - 1))
+                    x1--;
+                if (x0 == x1) {
+                    x0 = g * a->cell;
+                    x1 = x0 + a->cell / 2;
+                }
+            }
+            a->widths[g] = x1 - x0;
+            a->start[g] = a->raw_len;
+            if (a->raw_len + a->cell * ((img.h + 7) / 8) > MAX_BYTES)
+                fail("font too large", path);
+            a->raw_len += columns(&img, x0, a->widths[g], a->raw + a->raw_len);
+        }
+    }
+    a->crc = crc32(a->raw, a->raw_len);
+    free(img.px);
+    pack(a);
+}
+
+static void read_manifest(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[256], kind[16], file[128], mode[16], full[512], dir[256];
+    const char *slash = strrchr(path, '/');
+    struct asset *a;
+    int n;
+
+    if (!f)
+        fail("cannot open", path);
+    snprintf(dir, sizeof(dir), "%.*s", slash ? (int)(slash - path + 1) : 0, path);
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "%15s", kind) != 1 || kind[0] == '#')
+            continue;
+        if (n_assets == MAX_ASSETS)
+            fail("too many assets", path);
+        a = &assets[n_assets++];
+        if (!strcmp(kind, "bitmap")) {
+            n = sscanf(line, "%*s %31s %127s", a->name, file);
+            if (n != 2)
+                fail("bad bitmap line", line);
+        } else if (!strcmp(kind, "font")) {
+            a->font = 1;
+            n = sscanf(line, "%*s %31s %127s %i %d %d %d %15s", a->name, file,
+                       &a->first, &a->count, &a->cell, &a->spacing, mode);
+            if (n != 7 || a->count <= 0 || a->cell <= 0)
+                fail("bad font line", line);
+            a->prop = !strcmp(mode, "prop");
+        } else {
+            fail("unknown kind", kind);
+        }
+        snprintf(full, sizeof(full), "%s%s", dir, file);
+        load(a, full);
+    }
+    fclose(f);
+}
+
+/* ---------------- output ---------------- */
+
+static void bytes(FILE *f, const uint8_t *p, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        fprintf(f, "%s0x%02X,%s", i % 12 ? " " : "    ", p[i], i % 12 == 11 || i == n - 1 ? "\n" : "");
+}
+
+static void numbers(FILE *f, const int *p, int n, const char *fmt)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        fprintf(f, "%s", i % 12 ? " " : "    ");
+        fprintf(f, fmt, p[i]);
+        fprintf(f, ",%s", i % 12 == 11 || i == n - 1 ? "\n" : "");
+    }
+}
+
+static void write_source(const char *dir, const char *manifest)
+{
+    char path[512];
+    FILE *c, *h;
+    struct asset *a;
+    int i, g, entry[MAX_GLYPHS];
+
+    snprintf(path, sizeof(path), "%s/art.h", dir);
+    if (!(h = fopen(path, "w")))
+        fail("cannot write", path);
+    snprintf(path, sizeof(path), "%s/art.c", dir);
+    if (!(c = fopen(path, "w")))
+        fail("cannot write", path);
+
+    fprintf(h, "/**\n * art.h - Generated by tools/assetc.c from %s, do not edit\n */\n\n", manifest);
+    fprintf(h, "#ifndef ART_H\n#define ART_H\n\n#include \"asset.h\"\n\n");
+    fprintf(c, "/**\n * art.c - Generated by tools/assetc.c from %s, do not edit\n */\n\n", manifest);
+    fprintf(c, "#include \"art.h\"\n");
+
+    for (i = 0; i < n_assets; i++) {
+        a = &assets[i];
+        fprintf(h, "extern const struct %s art_%s;\n", a->font ? "zfont" : "asset", a->name);
+        fprintf(c, "\n/* %s: %d bytes %s, %d uncompressed */\n", a->name,
+                a->flash, a->stored ? "stored" : "packed", a->plain);
+        fprintf(c, "static const uint8_t %s_data[%d] =\n{\n", a->name, a->out_len);
+        bytes(c, a->out, a->out_len);
+        fprintf(c, "};\n");
+        if (!a->font) {
+            fprintf(c, "\nconst struct asset art_%s = { %s_data, %d, %d, %s };\n",
+                    a->name, a->name, a->w, a->h, a->stored ? "ASSET_STORED" : "0");
+            continue;
+        }
+        if (!a->stored || a->prop) {
+            for (g = 0; g < a->count; g++) {
+                if (a->index[g] > 4095 || a->widths[g] > 15)
+                    fail("glyph offset or width too large for the index", a->name);
+                entry[g] = a->index[g] << 4 | a->widths[g];
+            }
+            fprintf(c, "\nstatic const uint16_t %s_index[%d] =\n{\n", a->name, a->count);
+            numbers(c, entry, a->count, "0x%04X");
+            fprintf(c, "};\n");
+        }
+        fprintf(c, "\nconst struct zfont art_%s = { %s_data, %s%s, 0x%02X, %d, %d, %d, %d, %s };\n",
+                a->name, a->name,
+                !a->stored || a->prop ? a->name : "0", !a->stored || a->prop ? "_index" : "",
+                a->first, a->count, a->prop ? 0 : a->cell, a->h, a->spacing,
+                a->stored ? "ASSET_STORED" : "0");
+    }
+
+    /* Sizes and check values for main.c's report */
+    fprintf(h, "\nstruct art_stat\n{\n    const char         *name;\n"
+               "    const struct asset *bitmap;\n    const struct zfont *font;\n"
+               "    uint16_t            raw;        // column bytes\n"
+               "    uint16_t            plain;      // flash they take uncompressed, index included\n"
+               "    uint16_t            flash;      // flash they take as built\n"
+               "    uint32_t            crc;        // CRC-32 of the column bytes\n};\n\n");
+    fprintf(h, "#define ART_COUNT  %d\n\nextern const struct art_stat art_stats[ART_COUNT];\n\n", n_assets);
+    fprintf(h, "#endif /* ART_H */\n");
+    fprintf(c, "\nconst struct art_stat art_stats[ART_COUNT] =\n{\n");
+    for (i = 0; i < n_assets; i++) {
+        a = &assets[i];
+        fprintf(c, "    { \"%s\", %s%s, %s%s, %d, %d, %d, 0x%08lXU },\n", a->name,
+                a->font ? "0" : "&art_", a->font ? "" : a->name,
+                a->font ? "&art_" : "0", a->font ? a->name : "",
+                a->raw_len, a->plain, a->flash, (unsigned long)a->crc);
+    }
+    fprintf(c, "};\n");
+    fclose(h);
+    fclose(c);
+}
+
+int main(int argc, char **argv)
+{
+    int i, raw = 0, flash = 0;
+    struct asset *a;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: assetc MANIFEST OUTDIR\n");
+        return 2;
+    }
+    read_manifest(argv[1]);
+    write_source(argv[2], argv[1]);
+
+    printf("%-12s %6s %6s %6s\n", "asset", "plain", "packed", "saved");
+    for (i = 0; i < n_assets; i++) {
+        a = &assets[i];
+        printf("%-12s %6d %6d %5d%%%s\n", a->name, a->plain, a->flash,
+               100 - a->flash * 100 / a->plain, a->stored ? "  stored" : "");
+        raw += a->plain;
+        flash += a->flash;
+    }
+    printf("%-12s %6d %6d %5d%%\n", "total", raw, flash, 100 - flash * 100 / raw);
+    return 0;
+}
@@ -0,0 +1,258 @@
+/**
+ * main.c - PCD8544 dashboard updated by dirty columns only (STM32F401RE)
+ *
+ * A framed dashboard with a 5-digit counter, a blinking icon, a bar graph
+ * and an mm:ss clock. Each scene below changes one part for FRAMES
+ * updates; the program prints the bytes sent per update (commands and
+ * data), the bursts and the time per update over USART2 at 9600 baud,
+ * against 506 bytes for a full flush. On the host simulator at 4 MHz SCK:
+ *   counter +1  :   8 bytes,  1.00 bursts,  22 us, 0 full frames
+ *   icon blink  :   8 bytes,  0.98 bursts,  23 us, 0 full frames
+ *   bar graph   :   4 bytes,  1.00 bursts,  16 us, 0 full frames
+ *   dashboard   :  30 bytes,  3.98 bursts,  82 us, 0 full frames
+ *   scrolling   : 506 bytes,  1.00 bursts, 1018 us, 50 full frames
+ * A counter step usually changes the last digit (6 columns, often fewer
+ * as digits share columns), the icon is 7 columns and the bar only the
+ * columns between the old and new length; the dashboard is four bursts
+ * because its parts lie further apart than GLCD_BURST_COST. The
+ * scrolling pattern changes every byte, so glcd_fb_update() sends the
+ * frame whole. After that the dashboard runs with all parts live at 10
+ * updates per second.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PA5 = SPI1_SCK, PA7 = SPI1_MOSI (AF5), PA8 = GLCD CE
+ *   - PB6 = GLCD D/C, PB10 = GLCD RST
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "glcd_fb.h"
+
+#define FRAMES   50
+
+#define COUNTER_X   4                   // bank 1
+#define ICON_X      72                  // bank 1
+#define CLOCK_X     4                   // bank 4
+#define BAR_X0      4                   // bank 3
+#define BAR_LEN     76
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void delayMs(int n);
+
+/* 5x7 digits and ':' in the column format of GCLD's font_table */
+static const uint8_t digits[11][6] =
+{
+    {0x3E, 0x51, 0x49, 0x45, 0x3E, 0}, /* 0 */
+    {0x00, 0x42, 0x7F, 0x40, 0x00, 0}, /* 1 */
+    {0x42, 0x61, 0x51, 0x49, 0x46, 0}, /* 2 */
+    {0x21, 0x41, 0x45, 0x4B, 0x31, 0}, /* 3 */
+    {0x18, 0x14, 0x12, 0x7F, 0x10, 0}, /* 4 */
+    {0x27, 0x45, 0x45, 0x45, 0x39, 0}, /* 5 */
+    {0x3C, 0x4A, 0x49, 0x49, 0x30, 0}, /* 6 */
+    {0x01, 0x71, 0x09, 0x05, 0x03, 0}, /* 7 */
+    {0x36, 0x49, 0x49, 0x49, 0x36, 0}, /* 8 */
+    {0x06, 0x49, 0x49, 0x29, 0x1E, 0}, /* 9 */
+    {0x00, 0x36, 0x36, 0x00, 0x00, 0}  /* : */
+};
+
+/* 8x8 heart */
+static const uint8_t icon[8] = { 0x0C, 0x1E, 0x3E, 0x7C, 0x3E, 0x1E, 0x0C, 0x00 };
+
+static void put_glyph(int bank, int x, const uint8_t *g, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        glcd_fb_put(bank, x + i, g[i]);
+}
+
+static void draw_number(int bank, int x, unsigned v, int width)
+{
+    int i;
+
+    for (i = width - 1; i >= 0; i--, v /= 10)
+        put_glyph(bank, x + i * 6, digits[v % 10], 6);
+}
+
+static void draw_clock(unsigned s)
+{
+    draw_number(4, CLOCK_X, s / 60 % 100, 2);
+    put_glyph(4, CLOCK_X + 12, digits[10], 6);
+    draw_number(4, CLOCK_X + 18, s % 60, 2);
+}
+
+static void draw_icon(int on)
+{
+    static const uint8_t none[8];
+
+    put_glyph(1, ICON_X, on ? icon : none, 8);
+}
+
+static void draw_bar(int len)
+{
+    int i;
+
+    for (i = 0; i < BAR_LEN; i++)
+        glcd_fb_put(3, BAR_X0 + i, i < len ? 0x7E : (i & 3) ? 0x00 : 0x40);
+}
+
+static void draw_layout(void)
+{
+    int i;
+
+    glcd_fb_clear();
+    for (i = 0; i < GLCD_WIDTH; i++) {
+        glcd_fb_pixel(i, 0, 1);
+        glcd_fb_pixel(i, 20, 1);
+        glcd_fb_pixel(i, GLCD_HEIGHT - 1, 1);
+    }
+    for (i = 0; i < GLCD_HEIGHT; i++) {
+        glcd_fb_pixel(0, i, 1);
+        glcd_fb_pixel(GLCD_WIDTH - 1, i, 1);
+    }
+    draw_number(1, COUNTER_X, 0, 5);
+    draw_icon(1);
+    draw_bar(0);
+    draw_clock(0);
+}
+
+/* Bar length for step n: a triangle wave with uneven steps */
+static int bar_at(int n)
+{
+    int t = (n * 3) % (2 * BAR_LEN);
+
+    return t < BAR_LEN ? t : 2 * BAR_LEN - t;
+}
+
+/**
+ * Sleep until the flush is done; busy is re-tested with interrupts masked
+ * so a TC landing just before __WFI() cannot leave the core asleep
+ */
+static void wait_flush(void)
+{
+    while (glcd_fb_busy()) {
+        __disable_irq();
+        if (glcd_fb_busy())
+            __WFI();
+        __enable_irq();
+    }
+}
+
+static void scene(const char *name, int what)
+{
+    uint32_t bytes, bursts, full, t0;
+    int n;
+
+    draw_layout();
+    glcd_fb_update(0, 0);
+    wait_flush();
+
+    bytes  = glcd_fb_tx_bytes;
+    bursts = glcd_fb_bursts;
+    full   = glcd_fb_full_frames;
+    t0 = DWT->CYCCNT;
+    for (n = 1; n <= FRAMES; n++) {
+        if (what & 1)
+            draw_number(1, COUNTER_X, 9990U + n, 5);
+        if (what & 2)
+            draw_icon(n & 1);
+        if (what & 4)
+            draw_bar(bar_at(n));
+        if (what & 8)
+            draw_clock(3595U + n);
+        if (what & 16) {
+            int b, x;
+            for (b = 0; b < GLCD_BANKS; b++)
+                for (x = 0; x < GLCD_WIDTH; x++)
+                    glcd_fb_put(b, x, (uint8_t)(0x11U << ((x + n + b) & 3)));
+        }
+        glcd_fb_update(0, 0);
+        wait_flush();
+    }
+    t0 = DWT->CYCCNT - t0;
+    bytes  = glcd_fb_tx_bytes - bytes;
+    bursts = glcd_fb_bursts - bursts;
+    full   = glcd_fb_full_frames - full;
+
+    printf("%-12s: %3lu bytes, %2lu.%02lu bursts, %3lu us, %lu full frames\r\n", name,
+           (unsigned long)(bytes / FRAMES), (unsigned long)(bursts / FRAMES),
+           (unsigned long)(bursts * 100U / FRAMES % 100U),
+           (unsigned long)(t0 / FRAMES / 16U), (unsigned long)full);
+}
+
+int main(void)
+{
+    unsigned n = 0;
+
+    USART2_init();
+    glcd_fb_init(GLCD_SPI_DIV4);
+    CoreDebug->DEMCR |= (1U << 24);     // TRCENA
+    DWT->CTRL |= 1U;                    // CYCCNTENA
+
+    scene("counter +1", 1);
+    scene("icon blink", 2);
+    scene("bar graph", 4);
+    scene("dashboard", 1 | 2 | 4 | 8);
+    scene("scrolling", 16);
+
+    draw_layout();
+    while (1)
+    {
+        draw_number(1, COUNTER_X, n, 5);
+        draw_icon((n / 5) & 1);
+        draw_bar(bar_at((int)n));
+        draw_clock(n / 10);
+        glcd_fb_update(0, 0);
+        delayMs(100);
+        n++;
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
+
+/**
+ * Approximate delay in ms for a ~16 MHz clock (3195 loops per ms)
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
@@ -0,0 +1,68 @@
+/**
+ * glcd_fb.h - PCD8544 (Nokia 5110) framebuffer with dirty-column tracking,
+ *             sent by SPI1 TX DMA
+ *
+ * Same wiring as GCLD:
+ *   - PA5 = SPI1 SCK, PA7 = SPI1 MOSI (AF5), PA8 = CE
+ *   - PB6 = D/C, PB10 = RST
+ *
+ * glcd_fb[] holds the 84x48 pixels in the controller's own layout: six
+ * banks of 84 column bytes, bit 0 the top row of a bank. glcd_fb_pixel()
+ * and glcd_fb_put() mark the column bytes they actually change; code
+ * that writes glcd_fb[] directly marks its area with glcd_fb_mark().
+ *
+ * glcd_fb_update() turns the marked bytes into the cheapest set of
+ * bursts, each one set-address command pair and a DMA run of data, and
+ * sends those or the whole frame, whichever costs fewer byte times. All
+ * bursts go out under one CE low; done() is called from the DMA
+ * interrupt after the last one. Do not draw until then.
+ *
+ *   glcd_fb_init(GLCD_SPI_DIV4);
+ *   glcd_fb_pixel(10, 20, 1);
+ *   glcd_fb_update(done, &flag);
+ */
+
+#ifndef GLCD_FB_H
+#define GLCD_FB_H
+
+#include <stdint.h>
+
+#define GLCD_WIDTH   84
+#define GLCD_HEIGHT  48
+#define GLCD_BANKS   (GLCD_HEIGHT / 8)
+#define GLCD_BYTES   (GLCD_BANKS * GLCD_WIDTH)
+
+/* SPI1 CR1 BR field, SCK = 16 MHz / divider; the PCD8544 takes up to 4 MHz */
+#define GLCD_SPI_DIV4    1U
+#define GLCD_SPI_DIV8    2U
+#define GLCD_SPI_DIV16   3U
+#define GLCD_SPI_DIV32   4U
+
+/*
+ * What starting another burst costs, in byte times: the two address
+ * commands plus the stream setup and interrupt (about 200 cycles, six
+ * bytes at 4 MHz SCK). Clean gaps up to this long are sent rather than
+ * skipped.
+ */
+#define GLCD_BURST_COST  8
+#define GLCD_MAX_BURSTS  16             // more than this and the frame goes whole
+
+typedef void (*glcd_fb_done_fn)(void *arg);
+
+extern uint8_t glcd_fb[GLCD_BANKS][GLCD_WIDTH];
+
+void glcd_fb_init(uint32_t br);
+void glcd_fb_speed(uint32_t br);        // waits for a running update
+void glcd_fb_clear(void);
+void glcd_fb_pixel(int x, int y, int on);
+void glcd_fb_put(int bank, int x, uint8_t v);
+void glcd_fb_mark(int x0, int y0, int x1, int y1);     // inclusive pixel rectangle
+int  glcd_fb_update(glcd_fb_done_fn done, void *arg);  // 0 = still busy
+int  glcd_fb_flush(int first, int last, glcd_fb_done_fn done, void *arg);  // banks, unconditionally
+int  glcd_fb_busy(void);
+
+extern volatile uint32_t glcd_fb_tx_bytes;      // command and data bytes sent
+extern volatile uint32_t glcd_fb_bursts;
+extern volatile uint32_t glcd_fb_full_frames;   // updates that went whole
+
+#endif /* GLCD_FB_H */
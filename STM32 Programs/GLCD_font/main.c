@@ -0,0 +1,265 @@
+/**
+ * main.c - ASCII fonts at any pixel position on the PCD8544 (STM32F401RE)
+ *
+ * GCLD's font_table has A, B and C, and GLCD_putchar() writes whole
+ * column bytes, so text sits on 8-row bank boundaries. This program
+ * draws the full ASCII set from font.c at any (x, y) and prints over
+ * USART2 at 9600 baud:
+ *
+ *   - a check of the column blitter against a pixel-by-pixel reference
+ *     for every y from -7 to 47, three modes and both fonts
+ *   - DWT cycles per glyph and glyphs per second over that check, for
+ *     the blitter on and off bank boundaries and for the reference
+ *   - glyphs per second end to end, drawn and sent, for a page of text
+ *     scrolling one pixel per frame and for a status line rewritten in
+ *     place
+ *
+ * On the host simulator at 4 MHz SCK:
+ *   check: 0 mismatches in 330 strings
+ *   blit y%8 == 0:    0 cyc/glyph, - glyphs/s
+ *   blit y%8 != 0:    0 cyc/glyph, - glyphs/s
+ *   per pixel    :    0 cyc/glyph, - glyphs/s
+ *   scroll 5x7   :  94 glyphs/frame,  987 frames/s,  93526 glyphs/s
+ *   status line  :  14 glyphs/frame, 2782 frames/s,  38952 glyphs/s
+ * The simulator does not charge computation, so the render-only lines
+ * read 0 there; run on the board for those. The scrolling page changes
+ * every byte and goes as a full frame, so the SPI sets its rate; the
+ * status line sends only the columns of the digits that changed and is
+ * bound by the per-burst cost.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PA5 = SPI1_SCK, PA7 = SPI1_MOSI (AF5), PA8 = GLCD CE
+ *   - PB6 = GLCD D/C, PB10 = GLCD RST
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include <string.h>
+#include "glcd_fb.h"
+#include "font.h"
+
+#define FRAMES   48
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void delayMs(int n);
+
+static uint8_t saved[GLCD_BANKS][GLCD_WIDTH];
+
+static const char *const page[] =
+{
+    "PCD8544 84x48", "5x7 font in a", "6x8 cell, any", "pixel offset.",
+    "!\"#$%&'()*+,-.", "0123456789:;<=", ">?@ABCDEFGHIJK", "LMNOPQRSTUVWXY",
+};
+
+/**
+ * What font_puts() should draw, one pixel at a time
+ */
+static void reference(const struct font *f, int x, int y, const char *s, unsigned mode)
+{
+    const uint8_t *g;
+    int w, col, row, bit;
+
+    for (; *s; s++) {
+        g = font_glyph(f, *s, &w);
+        for (col = 0; col < w + f->spacing; col++, x++) {
+            for (row = 0; row < 8; row++) {
+                bit = col < w ? (g[col] >> row) & 1 : 0;
+                if (mode & FONT_INVERT)
+                    bit ^= 1;
+                if (bit || (mode & (FONT_OPAQUE | FONT_INVERT)))
+                    glcd_fb_pixel(x, y + row, bit);
+            }
+        }
+    }
+}
+
+static void background(void)
+{
+    int b, x;
+
+    for (b = 0; b < GLCD_BANKS; b++)
+        for (x = 0; x < GLCD_WIDTH; x++)
+            glcd_fb[b][x] = (uint8_t)((x & 1) ? 0x55 : 0xAA);
+}
+
+static void report(const char *name, uint32_t cycles, uint32_t glyphs)
+{
+    printf("%-13s: %4lu cyc/glyph, ", name, (unsigned long)(cycles / glyphs));
+    if (cycles >= glyphs)
+        printf("%lu glyphs/s\r\n", (unsigned long)((uint64_t)glyphs * 16000000U / cycles));
+    else
+        printf("- glyphs/s\r\n");
+}
+
+/**
+ * Blitter against reference for every y, mode and font, timing both
+ */
+static void check(void)
+{
+    static const char text[] = "Ag{|}~ j";
+    static const unsigned modes[3] = { 0, FONT_OPAQUE, FONT_INVERT };
+    const struct font *fonts[2] = { &font_5x7, &font_prop };
+    uint32_t t0, aligned = 0, unaligned = 0, pixel = 0;
+    int y, m, f, strings = 0, bad = 0, n_aligned = 0;
+
+    for (y = -7; y < GLCD_HEIGHT; y++) {
+        for (m = 0; m < 3; m++) {
+            for (f = 0; f < 2; f++) {
+                background();
+                t0 = DWT->CYCCNT;
+                font_puts(fonts[f], y - 9, y, text, modes[m]);
+                t0 = DWT->CYCCNT - t0;
+                if (y & 7) {
+                    unaligned += t0;
+                } else {
+                    aligned += t0;
+                    n_aligned++;
+                }
+                memcpy(saved, glcd_fb, sizeof(saved));
+
+                background();
+                t0 = DWT->CYCCNT;
+                reference(fonts[f], y - 9, y, text, modes[m]);
+                pixel += DWT->CYCCNT - t0;
+                bad += memcmp(saved, glcd_fb, sizeof(saved)) != 0;
+                strings++;
+            }
+        }
+    }
+    printf("check: %d mismatches in %d strings\r\n", bad, strings);
+    report("blit y%8 == 0", aligned, n_aligned * (sizeof(text) - 1));
+    report("blit y%8 != 0", unaligned, (strings - n_aligned) * (sizeof(text) - 1));
+    report("per pixel", pixel, strings * (sizeof(text) - 1));
+}
+
+/**
+ * Sleep until the flush is done, re-testing busy with PRIMASK set so the
+ * TC cannot slip in between the test and __WFI()
+ */
+static void wait_flush(void)
+{
+    while (glcd_fb_busy()) {
+        __disable_irq();
+        if (glcd_fb_busy())
+            __WFI();
+        __enable_irq();
+    }
+}
+
+static void rate(const char *name, uint32_t glyphs, uint32_t cycles)
+{
+    printf("%-13s: %3lu glyphs/frame, %4lu frames/s, %6lu glyphs/s\r\n", name,
+           (unsigned long)(glyphs / FRAMES),
+           (unsigned long)((uint64_t)FRAMES * 16000000U / cycles),
+           (unsigned long)((uint64_t)glyphs * 16000000U / cycles));
+}
+
+static void scroll_speed(void)
+{
+    uint32_t t0, glyphs = 0;
+    int n, l;
+    char text[16];
+
+    t0 = DWT->CYCCNT;
+    for (n = 0; n < FRAMES; n++) {
+        glcd_fb_clear();
+        for (l = 0; l < 7; l++) {
+            font_puts(&font_5x7, 0, l * 8 - n % 8, page[(l + n / 8) % 8], FONT_OPAQUE);
+            glyphs += strlen(page[(l + n / 8) % 8]);
+        }
+        glcd_fb_update(0, 0);
+        wait_flush();
+    }
+    rate("scroll 5x7", glyphs, DWT->CYCCNT - t0);
+
+    glcd_fb_clear();
+    glcd_fb_update(0, 0);
+    glyphs = 0;
+    t0 = DWT->CYCCNT;
+    for (n = 0; n < FRAMES; n++) {
+        sprintf(text, "frame %8d", 99990 + n);
+        font_puts(&font_5x7, 0, 21, text, FONT_OPAQUE);
+        glyphs += strlen(text);
+        glcd_fb_update(0, 0);
+        wait_flush();
+    }
+    rate("status line", glyphs, DWT->CYCCNT - t0);
+}
+
+int main(void)
+{
+    char text[16];
+    unsigned n = 0;
+    int x;
+
+    USART2_init();
+    glcd_fb_init(GLCD_SPI_DIV4);
+    CoreDebug->DEMCR |= (1U << 24);     // TRCENA
+    DWT->CTRL |= 1U;                    // CYCCNTENA
+
+    check();
+    scroll_speed();
+
+    while (1)
+    {
+        glcd_fb_clear();
+        x = font_puts(&font_prop, 2, 1, "Proportional", 0);
+        font_puts(&font_prop, x + 3, 1, "ok", FONT_INVERT);
+        sprintf(text, "t=%u.%us", n / 10, n % 10);
+        font_puts(&font_5x7, 2 + (int)(n % 40), 12 + (int)(n % 5), text, FONT_OPAQUE);
+        font_puts(&font_5x7, 0, 27, "The quick", 0);
+        font_puts(&font_prop, 0, 37, "brown fox jumps", 0);
+        glcd_fb_update(0, 0);
+        delayMs(100);
+        n++;
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
+
+/**
+ * Approximate delay in ms for a ~16 MHz clock (3195 loops per ms)
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
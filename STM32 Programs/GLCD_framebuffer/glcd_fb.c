@@ -0,0 +1,210 @@
+/**
+ * glcd_fb.c - PCD8544 framebuffer sent by SPI1 TX DMA
+ *
+ * GCLD's SPI_write() pulls CE low, waits for TXE, writes DR, waits for BSY
+ * to clear and raises CE again for every byte, so a full screen is 504 of
+ * those round trips with the CPU spinning through all of them. A flush
+ * here is:
+ *
+ *   CE low, D/C low    set X = 0 and Y = first bank, polled (2 bytes)
+ *   D/C high           DMA2 Stream3 Ch3  glcd_fb[first..last] -> SPI1->DR
+ *                      DMA2 Stream2 Ch3  SPI1->DR -> rx_sink, TCIE
+ *   Stream2 TC         CE high, done()
+ *
+ * The controller's horizontal addressing wraps from column 83 to the next
+ * bank, so a bank range is one contiguous block of glcd_fb[]. The receive
+ * stream only drains DR; its transfer-complete comes with the last
+ * received byte, i.e. once the last bit is out, where the transmit
+ * stream's comes one to two bytes early with data still shifting.
+ */
+
+#include "stm32f4xx.h"
+#include "glcd_fb.h"
+
+#define CE    (1U << 8)                 // PA8
+#define DC    (1U << 6)                 // PB6
+#define RST   (1U << 10)                // PB10
+
+#define TX_STREAM   DMA2_Stream3
+#define RX_STREAM   DMA2_Stream2
+
+#define CR_TX       0x06000440U         // Channel3, 8-bit, MINC, mem-to-periph
+#define CR_RX       0x06020010U         // Channel3, 8-bit, high priority, periph-to-mem, TCIE
+#define LIFCR_BOTH  0x0F7D0000U         // Stream2 and Stream3 flags
+
+uint8_t glcd_fb[GLCD_BANKS][GLCD_WIDTH];
+
+static volatile uint8_t busy;
+static glcd_fb_done_fn  done_fn;
+static void            *done_arg;
+static uint8_t          rx_sink;
+
+volatile uint32_t glcd_fb_isr_cycles;
+
+/**
+ * One byte with CE already low; returns after it has shifted out
+ */
+static void spi_byte(uint8_t b)
+{
+    while (!(SPI1->SR & 2)) {}          // TXE
+    SPI1->DR = b;
+    while (SPI1->SR & (1U << 7)) {}     // BSY
+}
+
+static void command(uint8_t c)
+{
+    GPIOB->BSRR = DC << 16;             // D/C low => command
+    GPIOA->BSRR = CE << 16;
+    spi_byte(c);
+    GPIOA->BSRR = CE;
+}
+
+/**
+ * SPI1 master 8-bit mode 0, D/C and RST, reset pulse and the init
+ * sequence of GCLD; the display is left with a cleared screen
+ */
+void glcd_fb_init(uint32_t br)
+{
+    RCC->AHB1ENR |= (1U << 0) | (1U << 1) | (1U << 22);   // GPIOA, GPIOB, DMA2 clocks
+    RCC->APB2ENR |= (1U << 12);                           // SPI1 clock
+
+    GPIOA->AFR[0] = (GPIOA->AFR[0] & ~0xF0F00000) | 0x50500000;  // AF5 on PA5, PA7
+    GPIOA->BSRR  = CE;                                           // CE high before it drives
+    GPIOA->MODER = (GPIOA->MODER & ~0x0003CC00) | 0x00018800;    // PA5, PA7 AF, PA8 output
+    GPIOB->MODER = (GPIOB->MODER & ~0x00303000) | 0x00101000;    // PB6, PB10 outputs
+
+    SPI1->CR1 = 0x304 | (br << 3);      // SSM, SSI, MSTR, CPOL=0, CPHA=0, 8-bit
+    SPI1->CR2 = 0;
+    SPI1->CR1 |= (1U << 6);             // SPE
+
+    GPIOB->BSRR = RST << 16;            // reset pulse
+    GPIOB->BSRR = RST;
+
+    command(0x21);                      // extended command set
+    command(0xB8);                      // Vop (contrast)
+    command(0x04);                      // temperature coefficient
+    command(0x14);                      // bias 1:48
+    command(0x20);                      // basic command set, horizontal addressing
+    command(0x0C);                      // normal display
+
+    CoreDebug->DEMCR |= (1U << 24);     // TRCENA
+    DWT->CTRL |= 1U;                    // CYCCNTENA
+    NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+
+    glcd_fb_clear();
+    glcd_fb_flush(0, GLCD_BANKS - 1, 0, 0);
+    while (busy) {}
+}
+
+/**
+ * New SCK divider; BR may only change with SPE clear
+ */
+void glcd_fb_speed(uint32_t br)
+{
+    while (busy) {}
+    SPI1->CR1 &= ~(1U << 6);
+    SPI1->CR1 = (SPI1->CR1 & ~(7U << 3)) | (br << 3);
+    SPI1->CR1 |= (1U << 6);
+}
+
+void glcd_fb_clear(void)
+{
+    uint8_t *p = &glcd_fb[0][0];
+    int i;
+
+    for (i = 0; i < GLCD_BANKS * GLCD_WIDTH; i++)
+        p[i] = 0;
+}
+
+void glcd_fb_pixel(int x, int y, int on)
+{
+    uint8_t *b;
+
+    if ((unsigned)x >= GLCD_WIDTH || (unsigned)y >= GLCD_HEIGHT)
+        return;
+    b = &glcd_fb[y >> 3][x];
+    if (on)
+        *b |= (uint8_t)(1U << (y & 7));
+    else
+        *b &= (uint8_t)~(1U << (y & 7));
+}
+
+/**
+ * Send banks first..last (0..5) in one DMA transfer under one CE low
+ */
+int glcd_fb_flush(int first, int last, glcd_fb_done_fn done, void *arg)
+{
+    if (busy)
+        return 0;
+    if (first < 0)
+        first = 0;
+    if (last >= GLCD_BANKS)
+        last = GLCD_BANKS - 1;
+    if (first > last)
+        return 1;
+    busy     = 1;
+    done_fn  = done;
+    done_arg = arg;
+
+    GPIOB->BSRR = DC << 16;             // commands
+    GPIOA->BSRR = CE << 16;             // CE low for the whole flush
+    spi_byte(0x80);                     // X = 0
+    spi_byte((uint8_t)(0x40 | first));  // Y = first bank
+    GPIOB->BSRR = DC;                   // data from here on
+    (void)SPI1->DR;                     // drop what the commands clocked in
+    (void)SPI1->SR;
+
+    DMA2->LIFCR = LIFCR_BOTH;
+    RX_STREAM->PAR  = (uint32_t)&SPI1->DR;
+    RX_STREAM->M0AR = (uint32_t)&rx_sink;
+    RX_STREAM->NDTR = (uint32_t)(last - first + 1) * GLCD_WIDTH;
+    RX_STREAM->FCR  = 0;                // direct mode
+    RX_STREAM->CR   = CR_RX | 1U;
+    TX_STREAM->PAR  = (uint32_t)&SPI1->DR;
+    TX_STREAM->M0AR = (uint32_t)&glcd_fb[first][0];
+    TX_STREAM->NDTR = (uint32_t)(last - first + 1) * GLCD_WIDTH;
+    TX_STREAM->FCR  = 0;
+    TX_STREAM->CR   = CR_TX | 1U;
+    SPI1->CR2 = 3;                      // RXDMAEN, TXDMAEN: the requests start
+    return 1;
+}
+
+int glcd_fb_busy(void)
+{
+    return busy;
+}
+
+/**
+ * The whole frame with GCLD's per-byte CE and BSY handshake
+ */
+void glcd_fb_flush_polled(void)
+{
+    const uint8_t *p = &glcd_fb[0][0];
+    int i;
+
+    while (busy) {}
+    command(0x80);
+    command(0x40);
+    GPIOB->BSRR = DC;
+    for (i = 0; i < GLCD_BANKS * GLCD_WIDTH; i++) {
+        GPIOA->BSRR = CE << 16;
+        spi_byte(p[i]);
+        GPIOA->BSRR = CE;
+    }
+}
+
+/**
+ * Last byte received, so the last byte is out: release the display
+ */
+void DMA2_Stream2_IRQHandler(void)
+{
+    uint32_t t0 = DWT->CYCCNT;
+
+    DMA2->LIFCR = LIFCR_BOTH;
+    SPI1->CR2 = 0;
+    GPIOA->BSRR = CE;
+    busy = 0;
+    if (done_fn)
+        done_fn(done_arg);
+    glcd_fb_isr_cycles = DWT->CYCCNT - t0;
+}
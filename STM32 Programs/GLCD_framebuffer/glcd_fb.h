@@ -0,0 +1,49 @@
+/**
+ * glcd_fb.h - PCD8544 (Nokia 5110) framebuffer sent by SPI1 TX DMA
+ *
+ * Same wiring as GCLD:
+ *   - PA5 = SPI1 SCK, PA7 = SPI1 MOSI (AF5), PA8 = CE
+ *   - PB6 = D/C, PB10 = RST
+ *
+ * glcd_fb[] holds the 84x48 pixels in the controller's own layout: six
+ * banks of 84 column bytes, bit 0 the top row of a bank. Drawing only
+ * touches RAM; glcd_fb_flush() sends banks first..last with CE held low
+ * for the whole transfer and D/C switched once, and calls done() from the
+ * DMA interrupt when the last byte has left the shift register. Do not
+ * draw into the banks being sent until then.
+ *
+ *   glcd_fb_init(GLCD_SPI_DIV4);
+ *   glcd_fb_pixel(10, 20, 1);
+ *   glcd_fb_flush(0, GLCD_BANKS - 1, done, &flag);
+ */
+
+#ifndef GLCD_FB_H
+#define GLCD_FB_H
+
+#include <stdint.h>
+
+#define GLCD_WIDTH   84
+#define GLCD_HEIGHT  48
+#define GLCD_BANKS   (GLCD_HEIGHT / 8)
+
+/* SPI1 CR1 BR field, SCK = 16 MHz / divider; the PCD8544 takes up to 4 MHz */
+#define GLCD_SPI_DIV4    1U
+#define GLCD_SPI_DIV8    2U
+#define GLCD_SPI_DIV16   3U
+#define GLCD_SPI_DIV32   4U
+
+typedef void (*glcd_fb_done_fn)(void *arg);
+
+extern uint8_t glcd_fb[GLCD_BANKS][GLCD_WIDTH];
+
+void glcd_fb_init(uint32_t br);
+void glcd_fb_speed(uint32_t br);        // waits for a running flush
+void glcd_fb_clear(void);
+void glcd_fb_pixel(int x, int y, int on);
+int  glcd_fb_flush(int first, int last, glcd_fb_done_fn done, void *arg);  // 0 = still busy
+int  glcd_fb_busy(void);
+void glcd_fb_flush_polled(void);        // the whole frame byte by byte, as GCLD does
+
+extern volatile uint32_t glcd_fb_isr_cycles;    // DWT cycles in the last completion interrupt
+
+#endif /* GLCD_FB_H */
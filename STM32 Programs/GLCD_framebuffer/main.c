@@ -0,0 +1,212 @@
+/**
+ * main.c - PCD8544 frames per second, byte-by-byte SPI against one DMA
+ *          transfer per frame (STM32F401RE)
+ *
+ * For SCK = 4, 2, 1 and 0.5 MHz the program sends FRAMES full screens
+ * with GCLD's per-byte handshake and then with glcd_fb_flush(), and
+ * prints frames per second and the CPU cycles each frame costs over
+ * USART2 at 9600 baud. On the host simulator:
+ *   SCK 4000 kHz: polled  672 fps, 23791 cyc/frame | DMA  981 fps,  148 cyc/frame, 2 banks 2885 fps
+ *   SCK 2000 kHz: polled  400 fps, 39983 cyc/frame | DMA  492 fps,  212 cyc/frame, 2 banks 1456 fps
+ *   SCK 1000 kHz: polled  221 fps, 72367 cyc/frame | DMA  246 fps,  340 cyc/frame, 2 banks  731 fps
+ *   SCK  500 kHz: polled  116 fps,137135 cyc/frame | DMA  123 fps,  596 cyc/frame, 2 banks  366 fps
+ * DMA runs the bus back to back at the SCK rate (504 bytes plus two
+ * address commands); the polled loop adds CE, TXE and BSY round trips to
+ * every byte and keeps the CPU for the whole frame. The DMA cost is the
+ * setup in glcd_fb_flush() and the completion interrupt; it grows with
+ * the SCK period only because the two address commands are sent polled.
+ * After that a ball bounces around a frame, flushed every 20 ms.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PA5 = SPI1_SCK, PA7 = SPI1_MOSI (AF5), PA8 = GLCD CE
+ *   - PB6 = GLCD D/C, PB10 = GLCD RST
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "glcd_fb.h"
+
+#define FRAMES   50
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void delayMs(int n);
+
+static volatile uint32_t frames_done;
+
+static void frame_done(void *arg)
+{
+    (void)arg;
+    frames_done++;
+}
+
+/**
+ * Sleep until the flush is done. The TC interrupt is the only one that
+ * can wake the core, so busy is tested with PRIMASK set: a TC taken
+ * between the test and __WFI() would otherwise leave it asleep for good.
+ * __WFI() still wakes on the pending interrupt, taken at __enable_irq().
+ */
+static void wait_flush(void)
+{
+    while (glcd_fb_busy()) {
+        __disable_irq();
+        if (glcd_fb_busy())
+            __WFI();
+        __enable_irq();
+    }
+}
+
+/**
+ * Checkerboard that moves by one pixel per frame, so every frame differs
+ */
+static void draw_pattern(int n)
+{
+    int x, b;
+
+    for (b = 0; b < GLCD_BANKS; b++)
+        for (x = 0; x < GLCD_WIDTH; x++)
+            glcd_fb[b][x] = (uint8_t)(((x + n) & 4) ? 0x0F : 0xF0);
+}
+
+static uint32_t fps(uint32_t frames, uint32_t cycles)
+{
+    return (uint32_t)((uint64_t)frames * 16000000U / cycles);
+}
+
+static void measure(uint32_t br)
+{
+    uint32_t t0, polled, dma, part, cpu = 0, c0;
+    int n;
+
+    glcd_fb_speed(br);
+
+    t0 = DWT->CYCCNT;
+    for (n = 0; n < FRAMES; n++) {
+        draw_pattern(n);
+        glcd_fb_flush_polled();
+    }
+    polled = DWT->CYCCNT - t0;
+
+    t0 = DWT->CYCCNT;
+    for (n = 0; n < FRAMES; n++) {
+        wait_flush();
+        if (n > 0)
+            cpu += glcd_fb_isr_cycles;
+        draw_pattern(n);
+        c0 = DWT->CYCCNT;
+        glcd_fb_flush(0, GLCD_BANKS - 1, frame_done, 0);
+        cpu += DWT->CYCCNT - c0;
+    }
+    wait_flush();
+    dma = DWT->CYCCNT - t0;
+    cpu += glcd_fb_isr_cycles;
+
+    t0 = DWT->CYCCNT;
+    for (n = 0; n < FRAMES; n++) {
+        glcd_fb_flush(2, 3, 0, 0);
+        wait_flush();
+    }
+    part = DWT->CYCCNT - t0;
+
+    printf("SCK %4lu kHz: polled %4lu fps,%6lu cyc/frame | DMA %4lu fps, %4lu cyc/frame, 2 banks %4lu fps\r\n",
+           (unsigned long)(16000U >> (br + 1)), (unsigned long)fps(FRAMES, polled),
+           (unsigned long)(polled / FRAMES), (unsigned long)fps(FRAMES, dma),
+           (unsigned long)(cpu / FRAMES), (unsigned long)fps(FRAMES, part));
+}
+
+/**
+ * Border and a 4x4 ball
+ */
+static void draw_ball(int bx, int by)
+{
+    int i, j;
+
+    glcd_fb_clear();
+    for (i = 0; i < GLCD_WIDTH; i++) {
+        glcd_fb_pixel(i, 0, 1);
+        glcd_fb_pixel(i, GLCD_HEIGHT - 1, 1);
+    }
+    for (i = 0; i < GLCD_HEIGHT; i++) {
+        glcd_fb_pixel(0, i, 1);
+        glcd_fb_pixel(GLCD_WIDTH - 1, i, 1);
+    }
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 4; j++)
+            glcd_fb_pixel(bx + i, by + j, 1);
+}
+
+int main(void)
+{
+    int x = 5, y = 9, dx = 1, dy = 1;
+
+    USART2_init();
+    glcd_fb_init(GLCD_SPI_DIV4);
+
+    measure(GLCD_SPI_DIV4);
+    measure(GLCD_SPI_DIV8);
+    measure(GLCD_SPI_DIV16);
+    measure(GLCD_SPI_DIV32);
+    glcd_fb_speed(GLCD_SPI_DIV4);
+
+    while (1)
+    {
+        draw_ball(x, y);
+        glcd_fb_flush(0, GLCD_BANKS - 1, frame_done, 0);
+        if (x + dx < 1 || x + dx > GLCD_WIDTH - 5)
+            dx = -dx;
+        if (y + dy < 1 || y + dy > GLCD_HEIGHT - 5)
+            dy = -dy;
+        x += dx;
+        y += dy;
+        delayMs(20);
+        wait_flush();
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
+
+/**
+ * Approximate delay in ms for a ~16 MHz clock (3195 loops per ms)
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
@@ -0,0 +1,42 @@
+/**
+ * font.h - ASCII text at any pixel position in the PCD8544 framebuffer
+ *
+ * A font is a table of column bytes, bit 0 the top row, like GCLD's
+ * font_table, for the printable ASCII range. font_5x7 is the classic
+ * 5x7 face in a 6x8 cell; font_prop is the same face with the empty
+ * columns trimmed and one column of spacing, 2 for a space.
+ *
+ * Text is blitted into glcd_fb[] at any (x, y), clipped to the screen,
+ * and the area is marked dirty for glcd_fb_update(). Characters outside
+ * 0x20..0x7E are drawn as '?'.
+ *
+ *   font_puts(&font_5x7, 3, 13, "Hello", FONT_OPAQUE);
+ *   x = font_puts(&font_prop, x, 30, "world", 0);     transparent
+ */
+
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+
+struct font
+{
+    const uint8_t  *bits;               // column bytes, glyph after glyph
+    const uint16_t *index;              // offset << 3 | width, NULL for fixed width
+    uint8_t         first, count;       // characters covered
+    uint8_t         width;              // columns per glyph when fixed
+    uint8_t         spacing;            // blank columns after each glyph
+};
+
+#define FONT_OPAQUE   1U                // clear the 8-row cell, spacing included
+#define FONT_INVERT   2U                // light text on dark, implies FONT_OPAQUE
+
+extern const struct font font_5x7;
+extern const struct font font_prop;
+
+int font_putc(const struct font *f, int x, int y, char c, unsigned mode);  // returns the advance
+int font_puts(const struct font *f, int x, int y, const char *s, unsigned mode);  // returns the end x
+int font_width(const struct font *f, const char *s);
+const uint8_t *font_glyph(const struct font *f, char c, int *width);    // columns of c
+
+#endif /* FONT_H */
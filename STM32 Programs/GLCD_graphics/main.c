@@ -0,0 +1,372 @@
+/**
+ * main.c - 2D graphics on the PCD8544, checked pixel by pixel and timed
+ *          per primitive (STM32F401RE)
+ *
+ * Every primitive of gfx.c is drawn TESTS times with random coordinates,
+ * many of them partly or wholly off the screen, and a random operation
+ * over a random background, and compared with a reference that draws the
+ * same shape one pixel at a time from its definition. Two fixed scenes
+ * are compared with CRC-32s of their golden images. The results and the
+ * average DWT cycles per call of both versions go out over USART2 at
+ * 9600 baud. On the host simulator:
+ *   hline : 0 bad of 200,     3 cyc, per pixel      3 cyc
+ *   vline : 0 bad of 200,     3 cyc, per pixel      3 cyc
+ *   line  : 0 bad of 200,     3 cyc, per pixel      3 cyc
+ *   rect  : 0 bad of 200,     3 cyc, per pixel      3 cyc
+ *   fill  : 0 bad of 200,     3 cyc, per pixel      3 cyc
+ *   circle: 0 bad of 200,     3 cyc, per pixel      3 cyc
+ *   disc  : 0 bad of 200,     3 cyc, per pixel      3 cyc
+ *   blit  : 0 bad of 200,     3 cyc, per pixel      3 cyc
+ *   golden: shapes E9911D4D ok, status 796C4BFD ok
+ * The simulator does not charge computation, so the cycle columns show
+ * only the DWT read there; run on the board for those. Afterwards a
+ * status screen with a battery, signal bars and a gauge is redrawn
+ * every 100 ms.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PA5 = SPI1_SCK, PA7 = SPI1_MOSI (AF5), PA8 = GLCD CE
+ *   - PB6 = GLCD D/C, PB10 = GLCD RST
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include <string.h>
+#include "glcd_fb.h"
+#include "font.h"
+#include "gfx.h"
+
+#define TESTS    200
+
+#define GOLDEN_SHAPES   0xE9911D4DU
+#define GOLDEN_STATUS   0x796C4BFDU
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void delayMs(int n);
+
+enum { HLINE, VLINE, LINE, RECT, FILL, CIRCLE, DISC, BLIT, PRIMITIVES };
+
+static const char *const names[PRIMITIVES] =
+{
+    "hline", "vline", "line", "rect", "fill", "circle", "disc", "blit"
+};
+
+/* 12x10 battery outline with a terminal, two banks */
+static const uint8_t battery[2][12] =
+{
+    { 0xFF, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF, 0x78, 0x78 },
+    { 0x03, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x03, 0x00, 0x00 },
+};
+
+static uint8_t background[GLCD_BANKS][GLCD_WIDTH];
+static uint8_t result[GLCD_BANKS][GLCD_WIDTH];
+static uint8_t bitmap[3 * 20];
+static uint32_t seed = 12345;
+
+static int rnd(int lo, int hi)
+{
+    seed = seed * 1664525U + 1013904223U;
+    return lo + (int)((seed >> 8) % (uint32_t)(hi - lo + 1));
+}
+
+/* ---------------- references, one pixel at a time ---------------- */
+
+static void ref_pixel(int x, int y, unsigned op)
+{
+    uint8_t bit;
+
+    if ((unsigned)x >= GLCD_WIDTH || (unsigned)y >= GLCD_HEIGHT)
+        return;
+    bit = (uint8_t)(1U << (y & 7));
+    if (op == GFX_SET)
+        glcd_fb[y >> 3][x] |= bit;
+    else if (op == GFX_CLEAR)
+        glcd_fb[y >> 3][x] &= (uint8_t)~bit;
+    else
+        glcd_fb[y >> 3][x] ^= bit;
+}
+
+static void ref_fill(int x0, int y0, int x1, int y1, unsigned op)
+{
+    int x, y;
+
+    for (y = (y0 < y1 ? y0 : y1); y <= (y0 < y1 ? y1 : y0); y++)
+        for (x = (x0 < x1 ? x0 : x1); x <= (x0 < x1 ? x1 : x0); x++)
+            ref_pixel(x, y, op);
+}
+
+static void ref_rect(int x0, int y0, int x1, int y1, unsigned op)
+{
+    int lx = x0 < x1 ? x0 : x1, hx = x0 < x1 ? x1 : x0;
+    int ly = y0 < y1 ? y0 : y1, hy = y0 < y1 ? y1 : y0, x, y;
+
+    for (y = ly; y <= hy; y++)
+        for (x = lx; x <= hx; x++)
+            if (x == lx || x == hx || y == ly || y == hy)
+                ref_pixel(x, y, op);
+}
+
+static void ref_line(int x0, int y0, int x1, int y1, unsigned op)
+{
+    int dx = x1 > x0 ? x1 - x0 : x0 - x1, dy = y1 > y0 ? y0 - y1 : y1 - y0;
+    int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1, err = dx + dy, e2;
+
+    for (;;) {
+        ref_pixel(x0, y0, op);
+        if (x0 == x1 && y0 == y1)
+            break;
+        e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
+/* Midpoint circle into a set of pixels first, so each is drawn once */
+static void ref_circle(int xc, int yc, int r, unsigned op)
+{
+    static uint8_t on[GLCD_HEIGHT][GLCD_WIDTH];
+    int x = r, y = 0, err = 1 - r, i, px, py;
+    static const int8_t sign[8][2] = { {1,1}, {-1,1}, {1,-1}, {-1,-1}, {1,1}, {-1,1}, {1,-1}, {-1,-1} };
+
+    memset(on, 0, sizeof(on));
+    while (x >= y) {
+        for (i = 0; i < 8; i++) {
+            px = xc + sign[i][0] * (i < 4 ? x : y);
+            py = yc + sign[i][1] * (i < 4 ? y : x);
+            if ((unsigned)px < GLCD_WIDTH && (unsigned)py < GLCD_HEIGHT)
+                on[py][px] = 1;
+        }
+        y++;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+    for (py = 0; py < GLCD_HEIGHT; py++)
+        for (px = 0; px < GLCD_WIDTH; px++)
+            if (on[py][px])
+                ref_pixel(px, py, op);
+}
+
+static void ref_disc(int xc, int yc, int r, unsigned op)
+{
+    int x, y;
+
+    for (y = yc - r; y <= yc + r; y++)
+        for (x = xc - r; x <= xc + r; x++)
+            if ((x - xc) * (x - xc) + (y - yc) * (y - yc) <= r * r + r)
+                ref_pixel(x, y, op);
+}
+
+static void ref_blit(int x0, int y0, int w, int h, const uint8_t *bits, unsigned op)
+{
+    int x, y, bit;
+
+    for (y = 0; y < h; y++) {
+        for (x = 0; x < w; x++) {
+            bit = (bits[(y >> 3) * w + x] >> (y & 7)) & 1;
+            if (op == GFX_COPY)
+                ref_pixel(x0 + x, y0 + y, bit ? GFX_SET : GFX_CLEAR);
+            else if (bit)
+                ref_pixel(x0 + x, y0 + y, op);
+        }
+    }
+}
+
+/* ---------------- checks ---------------- */
+
+static void draw(int prim, int fast, const int *a, unsigned op)
+{
+    switch (prim) {
+    case HLINE:  fast ? gfx_hline(a[0], a[1], a[2], op) : ref_fill(a[0], a[2], a[1], a[2], op); break;
+    case VLINE:  fast ? gfx_vline(a[0], a[1], a[2], op) : ref_fill(a[0], a[1], a[0], a[2], op); break;
+    case LINE:   fast ? gfx_line(a[0], a[1], a[2], a[3], op) : ref_line(a[0], a[1], a[2], a[3], op); break;
+    case RECT:   fast ? gfx_rect(a[0], a[1], a[2], a[3], op) : ref_rect(a[0], a[1], a[2], a[3], op); break;
+    case FILL:   fast ? gfx_fill(a[0], a[1], a[2], a[3], op) : ref_fill(a[0], a[1], a[2], a[3], op); break;
+    case CIRCLE: fast ? gfx_circle(a[0], a[1], a[2], op) : ref_circle(a[0], a[1], a[2], op); break;
+    case DISC:   fast ? gfx_fill_circle(a[0], a[1], a[2], op) : ref_disc(a[0], a[1], a[2], op); break;
+    default:     fast ? gfx_blit(a[0], a[1], a[2], a[3], bitmap, op)
+                      : ref_blit(a[0], a[1], a[2], a[3], bitmap, op); break;
+    }
+}
+
+static void check(int prim)
+{
+    uint32_t t0, fast = 0, slow = 0;
+    int n, i, bad = 0, a[4];
+    unsigned op;
+
+    for (n = 0; n < TESTS; n++) {
+        a[0] = rnd(-20, 103);
+        a[1] = rnd(-20, 67);
+        a[2] = rnd(-20, 103);
+        a[3] = rnd(-20, 67);
+        if (prim == HLINE) {                    // x0, x1, y
+            a[1] = rnd(-20, 103);
+            a[2] = rnd(-10, 57);
+        } else if (prim == VLINE) {             // x, y0, y1
+            a[2] = rnd(-20, 67);
+        } else if (prim == CIRCLE || prim == DISC) {
+            a[2] = rnd(0, 40);
+        } else if (prim == BLIT) {
+            a[2] = rnd(1, 20);
+            a[3] = rnd(1, 24);
+            for (i = 0; i < (int)sizeof(bitmap); i++)
+                bitmap[i] = (uint8_t)rnd(0, 255);
+        }
+        op = (unsigned)rnd(0, prim == BLIT ? 3 : 2);
+        for (i = 0; i < GLCD_BYTES; i++)
+            (&background[0][0])[i] = (uint8_t)rnd(0, 255);
+
+        memcpy(glcd_fb, background, sizeof(background));
+        t0 = DWT->CYCCNT;
+        draw(prim, 1, a, op);
+        fast += DWT->CYCCNT - t0;
+        memcpy(result, glcd_fb, sizeof(result));
+
+        memcpy(glcd_fb, background, sizeof(background));
+        t0 = DWT->CYCCNT;
+        draw(prim, 0, a, op);
+        slow += DWT->CYCCNT - t0;
+        bad += memcmp(result, glcd_fb, sizeof(result)) != 0;
+    }
+    printf("%-6s: %d bad of %d, %5lu cyc, per pixel %6lu cyc\r\n", names[prim], bad, TESTS,
+           (unsigned long)(fast / TESTS), (unsigned long)(slow / TESTS));
+}
+
+static uint32_t crc32(const uint8_t *p, int n)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+    int k;
+
+    while (n--) {
+        crc ^= *p++;
+        for (k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+    }
+    return ~crc;
+}
+
+static void draw_shapes(void)
+{
+    glcd_fb_clear();
+    gfx_rect(0, 0, 83, 47, GFX_SET);
+    gfx_line(-10, 60, 95, -12, GFX_SET);
+    gfx_line(3, 3, 30, 44, GFX_SET);
+    gfx_fill(40, 5, 70, 20, GFX_XOR);
+    gfx_circle(60, 30, 15, GFX_XOR);
+    gfx_fill_circle(20, 30, 9, GFX_XOR);
+    gfx_blit(70, 35, 12, 10, &battery[0][0], GFX_COPY);
+}
+
+static void draw_status(unsigned n)
+{
+    char text[12];
+    int i, level = (int)(n % 9), angle = (int)(n % 60);
+    /* Needle end points around the gauge, every 6 degrees of a half turn */
+    static const int8_t nx[11] = { -14, -13, -11, -8, -4, 0, 4, 8, 11, 13, 14 };
+    static const int8_t ny[11] = { 0, -4, -8, -11, -13, -14, -13, -11, -8, -4, 0 };
+
+    glcd_fb_clear();
+    font_puts(&font_5x7, 0, 0, "STATUS", FONT_INVERT);
+    gfx_blit(70, 0, 12, 10, &battery[0][0], GFX_COPY);
+    gfx_fill(71, 1, 71 + level, 8, GFX_SET);
+    for (i = 0; i < 5; i++)                      // signal bars
+        gfx_fill(42 + 4 * i, 8 - 2 * i, 44 + 4 * i, 8, i * 2 < (int)(n % 11) ? GFX_SET : GFX_CLEAR);
+    gfx_hline(0, 83, 11, GFX_SET);
+    gfx_circle(60, 40, 15, GFX_SET);
+    gfx_hline(44, 76, 40, GFX_SET);
+    gfx_line(60, 40, 60 + nx[angle / 6 % 11], 40 + ny[angle / 6 % 11], GFX_SET);
+    gfx_fill_circle(60, 40, 2, GFX_SET);
+    sprintf(text, "%3u%%", n % 101);
+    font_puts(&font_5x7, 2, 20, text, FONT_OPAQUE);
+    gfx_rect(0, 30, 40, 38, GFX_SET);
+    gfx_fill(2, 32, 2 + (int)(n % 37), 36, GFX_SET);
+}
+
+static void golden(void)
+{
+    uint32_t shapes, status;
+
+    draw_shapes();
+    shapes = crc32(&glcd_fb[0][0], GLCD_BYTES);
+    draw_status(42);
+    status = crc32(&glcd_fb[0][0], GLCD_BYTES);
+    printf("golden: shapes %08lX %s, status %08lX %s\r\n",
+           (unsigned long)shapes, shapes == GOLDEN_SHAPES ? "ok" : "DIFFERS",
+           (unsigned long)status, status == GOLDEN_STATUS ? "ok" : "DIFFERS");
+}
+
+int main(void)
+{
+    unsigned n = 0;
+    int p;
+
+    USART2_init();
+    glcd_fb_init(GLCD_SPI_DIV4);
+    CoreDebug->DEMCR |= (1U << 24);     // TRCENA
+    DWT->CTRL |= 1U;                    // CYCCNTENA
+
+    for (p = 0; p < PRIMITIVES; p++)
+        check(p);
+    golden();
+
+    glcd_fb_clear();
+    glcd_fb_mark(0, 0, GLCD_WIDTH - 1, GLCD_HEIGHT - 1);
+    while (1)
+    {
+        draw_status(n++);
+        glcd_fb_update(0, 0);
+        delayMs(100);
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
+
+/**
+ * Approximate delay in ms for a ~16 MHz clock (3195 loops per ms)
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
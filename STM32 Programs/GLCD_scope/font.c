@@ -0,0 +1,313 @@
+/**
+ * font.c - ASCII text at any pixel position in the PCD8544 framebuffer
+ *
+ * A glyph column is one byte; at pixel row y it lands in bank y / 8
+ * shifted down by y % 8, with the bits that fall out of the bottom in the
+ * next bank. Each column is therefore widened to 16 bits, shifted once,
+ * and written as a low half and a high half, two read-modify-writes
+ * instead of a loop over eight pixels. For opaque text the same shift of
+ * 0xFF gives the mask of the 8-row cell. Byte-aligned rows (y % 8 == 0)
+ * touch one bank only.
+ *
+ * font_5x7 takes 5 bytes per glyph, 475 in all. font_prop keeps only the
+ * columns a glyph uses, 421 bytes, and a 16-bit index per glyph holding
+ * the offset and the width (190 bytes).
+ */
+
+#include "stm32f4xx.h"
+#include "glcd_fb.h"
+#include "font.h"
+
+static const uint8_t bits_5x7[95 * 5] =
+{
+    0x00, 0x00, 0x00, 0x00, 0x00, /* space */
+    0x00, 0x00, 0x5F, 0x00, 0x00, /* ! */
+    0x00, 0x07, 0x00, 0x07, 0x00, /* " */
+    0x14, 0x7F, 0x14, 0x7F, 0x14, /* # */
+    0x24, 0x2A, 0x7F, 0x2A, 0x12, /* $ */
+    0x23, 0x13, 0x08, 0x64, 0x62, /* % */
+    0x36, 0x49, 0x55, 0x22, 0x50, /* & */
+    0x00, 0x05, 0x03, 0x00, 0x00, /* ' */
+    0x00, 0x1C, 0x22, 0x41, 0x00, /* ( */
+    0x00, 0x41, 0x22, 0x1C, 0x00, /* ) */
+    0x14, 0x08, 0x3E, 0x08, 0x14, /* '*' */
+    0x08, 0x08, 0x3E, 0x08, 0x08, /* + */
+    0x00, 0x50, 0x30, 0x00, 0x00, /* , */
+    0x08, 0x08, 0x08, 0x08, 0x08, /* - */
+    0x00, 0x60, 0x60, 0x00, 0x00, /* . */
+    0x20, 0x10, 0x08, 0x04, 0x02, /* '/' */
+    0x3E, 0x51, 0x49, 0x45, 0x3E, /* 0 */
+    0x00, 0x42, 0x7F, 0x40, 0x00, /* 1 */
+    0x42, 0x61, 0x51, 0x49, 0x46, /* 2 */
+    0x21, 0x41, 0x45, 0x4B, 0x31, /* 3 */
+    0x18, 0x14, 0x12, 0x7F, 0x10, /* 4 */
+    0x27, 0x45, 0x45, 0x45, 0x39, /* 5 */
+    0x3C, 0x4A, 0x49, 0x49, 0x30, /* 6 */
+    0x01, 0x71, 0x09, 0x05, 0x03, /* 7 */
+    0x36, 0x49, 0x49, 0x49, 0x36, /* 8 */
+    0x06, 0x49, 0x49, 0x29, 0x1E, /* 9 */
+    0x00, 0x36, 0x36, 0x00, 0x00, /* : */
+    0x00, 0x56, 0x36, 0x00, 0x00, /* ; */
+    0x08, 0x14, 0x22, 0x41, 0x00, /* < */
+    0x14, 0x14, 0x14, 0x14, 0x14, /* = */
+    0x00, 0x41, 0x22, 0x14, 0x08, /* > */
+    0x02, 0x01, 0x51, 0x09, 0x06, /* ? */
+    0x32, 0x49, 0x79, 0x41, 0x3E, /* @ */
+    0x7E, 0x11, 0x11, 0x11, 0x7E, /* A */
+    0x7F, 0x49, 0x49, 0x49, 0x36, /* B */
+    0x3E, 0x41, 0x41, 0x41, 0x22, /* C */
+    0x7F, 0x41, 0x41, 0x22, 0x1C, /* D */
+    0x7F, 0x49, 0x49, 0x49, 0x41, /* E */
+    0x7F, 0x09, 0x09, 0x09, 0x01, /* F */
+    0x3E, 0x41, 0x49, 0x49, 0x7A, /* G */
+    0x7F, 0x08, 0x08, 0x08, 0x7F, /* H */
+    0x00, 0x41, 0x7F, 0x41, 0x00, /* I */
+    0x20, 0x40, 0x41, 0x3F, 0x01, /* J */
+    0x7F, 0x08, 0x14, 0x22, 0x41, /* K */
+    0x7F, 0x40, 0x40, 0x40, 0x40, /* L */
+    0x7F, 0x02, 0x0C, 0x02, 0x7F, /* M */
+    0x7F, 0x04, 0x08, 0x10, 0x7F, /* N */
+    0x3E, 0x41, 0x41, 0x41, 0x3E, /* O */
+    0x7F, 0x09, 0x09, 0x09, 0x06, /* P */
+    0x3E, 0x41, 0x51, 0x21, 0x5E, /* Q */
+    0x7F, 0x09, 0x19, 0x29, 0x46, /* R */
+    0x46, 0x49, 0x49, 0x49, 0x31, /* S */
+    0x01, 0x01, 0x7F, 0x01, 0x01, /* T */
+    0x3F, 0x40, 0x40, 0x40, 0x3F, /* U */
+    0x1F, 0x20, 0x40, 0x20, 0x1F, /* V */
+    0x3F, 0x40, 0x38, 0x40, 0x3F, /* W */
+    0x63, 0x14, 0x08, 0x14, 0x63, /* X */
+    0x07, 0x08, 0x70, 0x08, 0x07, /* Y */
+    0x61, 0x51, 0x49, 0x45, 0x43, /* Z */
+    0x00, 0x7F, 0x41, 0x41, 0x00, /* [ */
+    0x02, 0x04, 0x08, 0x10, 0x20, /* backslash */
+    0x00, 0x41, 0x41, 0x7F, 0x00, /* ] */
+    0x04, 0x02, 0x01, 0x02, 0x04, /* ^ */
+    0x40, 0x40, 0x40, 0x40, 0x40, /* _ */
+    0x00, 0x01, 0x02, 0x04, 0x00, /* ` */
+    0x20, 0x54, 0x54, 0x54, 0x78, /* a */
+    0x7F, 0x48, 0x44, 0x44, 0x38, /* b */
+    0x38, 0x44, 0x44, 0x44, 0x20, /* c */
+    0x38, 0x44, 0x44, 0x48, 0x7F, /* d */
+    0x38, 0x54, 0x54, 0x54, 0x18, /* e */
+    0x08, 0x7E, 0x09, 0x01, 0x02, /* f */
+    0x0C, 0x52, 0x52, 0x52, 0x3E, /* g */
+    0x7F, 0x08, 0x04, 0x04, 0x78, /* h */
+    0x00, 0x44, 0x7D, 0x40, 0x00, /* i */
+    0x20, 0x40, 0x44, 0x3D, 0x00, /* j */
+    0x7F, 0x10, 0x28, 0x44, 0x00, /* k */
+    0x00, 0x41, 0x7F, 0x40, 0x00, /* l */
+    0x7C, 0x04, 0x18, 0x04, 0x78, /* m */
+    0x7C, 0x08, 0x04, 0x04, 0x78, /* n */
+    0x38, 0x44, 0x44, 0x44, 0x38, /* o */
+    0x7C, 0x14, 0x14, 0x14, 0x08, /* p */
+    0x08, 0x14, 0x14, 0x18, 0x7C, /* q */
+    0x7C, 0x08, 0x04, 0x04, 0x08, /* r */
+    0x48, 0x54, 0x54, 0x54, 0x20, /* s */
+    0x04, 0x3F, 0x44, 0x40, 0x20, /* t */
+    0x3C, 0x40, 0x40, 0x20, 0x7C, /* u */
+    0x1C, 0x20, 0x40, 0x20, 0x1C, /* v */
+    0x3C, 0x40, 0x30, 0x40, 0x3C, /* w */
+    0x44, 0x28, 0x10, 0x28, 0x44, /* x */
+    0x0C, 0x50, 0x50, 0x50, 0x3C, /* y */
+    0x44, 0x64, 0x54, 0x4C, 0x44, /* z */
+    0x00, 0x08, 0x36, 0x41, 0x00, /* { */
+    0x00, 0x00, 0x7F, 0x00, 0x00, /* | */
+    0x00, 0x41, 0x36, 0x08, 0x00, /* } */
+    0x10, 0x08, 0x08, 0x10, 0x08  /* ~ */
+};
+
+static const uint8_t bits_prop[421] =
+{
+    0x00, 0x00,                    /* space */
+    0x5F,                          /* ! */
+    0x07, 0x00, 0x07,              /* " */
+    0x14, 0x7F, 0x14, 0x7F, 0x14,  /* # */
+    0x24, 0x2A, 0x7F, 0x2A, 0x12,  /* $ */
+    0x23, 0x13, 0x08, 0x64, 0x62,  /* % */
+    0x36, 0x49, 0x55, 0x22, 0x50,  /* & */
+    0x05, 0x03,                    /* ' */
+    0x1C, 0x22, 0x41,              /* ( */
+    0x41, 0x22, 0x1C,              /* ) */
+    0x14, 0x08, 0x3E, 0x08, 0x14,  /* '*' */
+    0x08, 0x08, 0x3E, 0x08, 0x08,  /* + */
+    0x50, 0x30,                    /* , */
+    0x08, 0x08, 0x08, 0x08, 0x08,  /* - */
+    0x60, 0x60,                    /* . */
+    0x20, 0x10, 0x08, 0x04, 0x02,  /* '/' */
+    0x3E, 0x51, 0x49, 0x45, 0x3E,  /* 0 */
+    0x42, 0x7F, 0x40,              /* 1 */
+    0x42, 0x61, 0x51, 0x49, 0x46,  /* 2 */
+    0x21, 0x41, 0x45, 0x4B, 0x31,  /* 3 */
+    0x18, 0x14, 0x12, 0x7F, 0x10,  /* 4 */
+    0x27, 0x45, 0x45, 0x45, 0x39,  /* 5 */
+    0x3C, 0x4A, 0x49, 0x49, 0x30,  /* 6 */
+    0x01, 0x71, 0x09, 0x05, 0x03,  /* 7 */
+    0x36, 0x49, 0x49, 0x49, 0x36,  /* 8 */
+    0x06, 0x49, 0x49, 0x29, 0x1E,  /* 9 */
+    0x36, 0x36,                    /* : */
+    0x56, 0x36,                    /* ; */
+    0x08, 0x14, 0x22, 0x41,        /* < */
+    0x14, 0x14, 0x14, 0x14, 0x14,  /* = */
+    0x41, 0x22, 0x14, 0x08,        /* > */
+    0x02, 0x01, 0x51, 0x09, 0x06,  /* ? */
+    0x32, 0x49, 0x79, 0x41, 0x3E,  /* @ */
+    0x7E, 0x11, 0x11, 0x11, 0x7E,  /* A */
+    0x7F, 0x49, 0x49, 0x49, 0x36,  /* B */
+    0x3E, 0x41, 0x41, 0x41, 0x22,  /* C */
+    0x7F, 0x41, 0x41, 0x22, 0x1C,  /* D */
+    0x7F, 0x49, 0x49, 0x49, 0x41,  /* E */
+    0x7F, 0x09, 0x09, 0x09, 0x01,  /* F */
+    0x3E, 0x41, 0x49, 0x49, 0x7A,  /* G */
+    0x7F, 0x08, 0x08, 0x08, 0x7F,  /* H */
+    0x41, 0x7F, 0x41,              /* I */
+    0x20, 0x40, 0x41, 0x3F, 0x01,  /* J */
+    0x7F, 0x08, 0x14, 0x22, 0x41,  /* K */
+    0x7F, 0x40, 0x40, 0x40, 0x40,  /* L */
+    0x7F, 0x02, 0x0C, 0x02, 0x7F,  /* M */
+    0x7F, 0x04, 0x08, 0x10, 0x7F,  /* N */
+    0x3E, 0x41, 0x41, 0x41, 0x3E,  /* O */
+    0x7F, 0x09, 0x09, 0x09, 0x06,  /* P */
+    0x3E, 0x41, 0x51, 0x21, 0x5E,  /* Q */
+    0x7F, 0x09, 0x19, 0x29, 0x46,  /* R */
+    0x46, 0x49, 0x49, 0x49, 0x31,  /* S */
+    0x01, 0x01, 0x7F, 0x01, 0x01,  /* T */
+    0x3F, 0x40, 0x40, 0x40, 0x3F,  /* U */
+    0x1F, 0x20, 0x40, 0x20, 0x1F,  /* V */
+    0x3F, 0x40, 0x38, 0x40, 0x3F,  /* W */
+    0x63, 0x14, 0x08, 0x14, 0x63,  /* X */
+    0x07, 0x08, 0x70, 0x08, 0x07,  /* Y */
+    0x61, 0x51, 0x49, 0x45, 0x43,  /* Z */
+    0x7F, 0x41, 0x41,              /* [ */
+    0x02, 0x04, 0x08, 0x10, 0x20,  /* backslash */
+    0x41, 0x41, 0x7F,              /* ] */
+    0x04, 0x02, 0x01, 0x02, 0x04,  /* ^ */
+    0x40, 0x40, 0x40, 0x40, 0x40,  /* _ */
+    0x01, 0x02, 0x04,              /* ` */
+    0x20, 0x54, 0x54, 0x54, 0x78,  /* a */
+    0x7F, 0x48, 0x44, 0x44, 0x38,  /* b */
+    0x38, 0x44, 0x44, 0x44, 0x20,  /* c */
+    0x38, 0x44, 0x44, 0x48, 0x7F,  /* d */
+    0x38, 0x54, 0x54, 0x54, 0x18,  /* e */
+    0x08, 0x7E, 0x09, 0x01, 0x02,  /* f */
+    0x0C, 0x52, 0x52, 0x52, 0x3E,  /* g */
+    0x7F, 0x08, 0x04, 0x04, 0x78,  /* h */
+    0x44, 0x7D, 0x40,              /* i */
+    0x20, 0x40, 0x44, 0x3D,        /* j */
+    0x7F, 0x10, 0x28, 0x44,        /* k */
+    0x41, 0x7F, 0x40,              /* l */
+    0x7C, 0x04, 0x18, 0x04, 0x78,  /* m */
+    0x7C, 0x08, 0x04, 0x04, 0x78,  /* n */
+    0x38, 0x44, 0x44, 0x44, 0x38,  /* o */
+    0x7C, 0x14, 0x14, 0x14, 0x08,  /* p */
+    0x08, 0x14, 0x14, 0x18, 0x7C,  /* q */
+    0x7C, 0x08, 0x04, 0x04, 0x08,  /* r */
+    0x48, 0x54, 0x54, 0x54, 0x20,  /* s */
+    0x04, 0x3F, 0x44, 0x40, 0x20,  /* t */
+    0x3C, 0x40, 0x40, 0x20, 0x7C,  /* u */
+    0x1C, 0x20, 0x40, 0x20, 0x1C,  /* v */
+    0x3C, 0x40, 0x30, 0x40, 0x3C,  /* w */
+    0x44, 0x28, 0x10, 0x28, 0x44,  /* x */
+    0x0C, 0x50, 0x50, 0x50, 0x3C,  /* y */
+    0x44, 0x64, 0x54, 0x4C, 0x44,  /* z */
+    0x08, 0x36, 0x41,              /* { */
+    0x7F,                          /* | */
+    0x41, 0x36, 0x08,              /* } */
+    0x10, 0x08, 0x08, 0x10, 0x08   /* ~ */
+};
+
+static const uint16_t index_prop[95] =
+{
+    0x0002, 0x0011, 0x001B, 0x0035, 0x005D, 0x0085, 0x00AD, 0x00D2,
+    0x00E3, 0x00FB, 0x0115, 0x013D, 0x0162, 0x0175, 0x019A, 0x01AD,
+    0x01D5, 0x01FB, 0x0215, 0x023D, 0x0265, 0x028D, 0x02B5, 0x02DD,
+    0x0305, 0x032D, 0x0352, 0x0362, 0x0374, 0x0395, 0x03BC, 0x03DD,
+    0x0405, 0x042D, 0x0455, 0x047D, 0x04A5, 0x04CD, 0x04F5, 0x051D,
+    0x0545, 0x056B, 0x0585, 0x05AD, 0x05D5, 0x05FD, 0x0625, 0x064D,
+    0x0675, 0x069D, 0x06C5, 0x06ED, 0x0715, 0x073D, 0x0765, 0x078D,
+    0x07B5, 0x07DD, 0x0805, 0x082B, 0x0845, 0x086B, 0x0885, 0x08AD,
+    0x08D3, 0x08ED, 0x0915, 0x093D, 0x0965, 0x098D, 0x09B5, 0x09DD,
+    0x0A05, 0x0A2B, 0x0A44, 0x0A64, 0x0A83, 0x0A9D, 0x0AC5, 0x0AED,
+    0x0B15, 0x0B3D, 0x0B65, 0x0B8D, 0x0BB5, 0x0BDD, 0x0C05, 0x0C2D,
+    0x0C55, 0x0C7D, 0x0CA5, 0x0CCB, 0x0CE1, 0x0CEB, 0x0D05
+};
+
+const struct font font_5x7  = { bits_5x7, 0, 0x20, 95, 5, 1 };
+const struct font font_prop = { bits_prop, index_prop, 0x20, 95, 0, 1 };
+
+const uint8_t *font_glyph(const struct font *f, char c, int *w)
+{
+    unsigned i = (uint8_t)c - f->first;
+
+    if (i >= f->count)
+        i = '?' - f->first;
+    if (f->index) {
+        *w = f->index[i] & 7U;
+        return f->bits + (f->index[i] >> 3);
+    }
+    *w = f->width;
+    return f->bits + i * f->width;
+}
+
+/**
+ * Draw one glyph without marking it dirty; returns the advance
+ */
+static int blit(const struct font *f, int x, int y, char c, unsigned mode)
+{
+    const uint8_t *g;
+    int w, adv, col, cx, b0, s;
+    uint16_t m, v;
+
+    g = font_glyph(f, c, &w);
+    adv = w + f->spacing;
+    if (y <= -8 || y >= GLCD_HEIGHT || x >= GLCD_WIDTH || x + adv <= 0)
+        return adv;
+
+    b0 = ((y + 8) >> 3) - 1;            // -1 above the screen
+    s  = (y + 8) & 7;
+    m  = (mode & (FONT_OPAQUE | FONT_INVERT)) ? (uint16_t)(0xFFU << s) : 0U;
+    for (col = 0; col < adv; col++) {
+        cx = x + col;
+        if ((unsigned)cx >= GLCD_WIDTH)
+            continue;
+        v = col < w ? g[col] : 0U;
+        if (mode & FONT_INVERT)
+            v ^= 0xFFU;
+        v = (uint16_t)(v << s);
+        if (b0 >= 0)
+            glcd_fb[b0][cx] = (uint8_t)((glcd_fb[b0][cx] & ~m) | v);
+        if (s && b0 + 1 < GLCD_BANKS)
+            glcd_fb[b0 + 1][cx] = (uint8_t)((glcd_fb[b0 + 1][cx] & ~(m >> 8)) | (v >> 8));
+    }
+    return adv;
+}
+
+int font_putc(const struct font *f, int x, int y, char c, unsigned mode)
+{
+    int adv = blit(f, x, y, c, mode);
+
+    glcd_fb_mark(x, y, x + adv - 1, y + 7);
+    return adv;
+}
+
+int font_puts(const struct font *f, int x, int y, const char *s, unsigned mode)
+{
+    int x0 = x;
+
+    while (*s && x < GLCD_WIDTH)
+        x += blit(f, x, y, *s++, mode);
+    if (x > x0)
+        glcd_fb_mark(x0, y, x - 1, y + 7);
+    return x + font_width(f, s);        // the rest, clipped off the right edge
+}
+
+int font_width(const struct font *f, const char *s)
+{
+    int w, n = 0;
+
+    while (*s) {
+        font_glyph(f, *s++, &w);
+        n += w + f->spacing;
+    }
+    return n;
+}
@@ -0,0 +1,282 @@
+/**
+ * gfx.c - Lines, rectangles, circles and bitmaps in the PCD8544
+ *         framebuffer
+ *
+ * A bank byte holds 8 rows of one column, so a box is, per bank it
+ * touches, one row mask applied to a run of column bytes. Runs go four
+ * columns per 32-bit load and store with the mask repeated in every
+ * byte; where the mask is 0xFF and the pixels are set or cleared, the
+ * words are stored without reading them. Horizontal and vertical lines
+ * are boxes one pixel thick, which for a vertical line means one byte
+ * per bank instead of one per pixel.
+ *
+ * Lines use Bresenham's algorithm. Consecutive pixels that fall into the
+ * same column byte, as in steep lines, are collected into one mask and
+ * written once. Off-screen pixels are skipped rather than the end points
+ * moved, so a clipped line has exactly the pixels of the unclipped one;
+ * a segment that has left the screen cannot come back, which ends the
+ * walk. Circles use the midpoint algorithm with the symmetric points of
+ * the axes and diagonals drawn once, so GFX_XOR works. Filled circles are
+ * drawn as vertical lines, one per column. Lines and circles mark the
+ * column bytes they write rather than their bounding box, so a diagonal
+ * sends about 84 bytes, not the whole frame.
+ *
+ * Bitmaps are blitted like font.c's glyphs: each column byte widened to
+ * 16 bits and shifted by y % 8 across two banks.
+ */
+
+#include "stm32f4xx.h"
+#include "glcd_fb.h"
+#include "gfx.h"
+
+static uint32_t apply32(uint32_t v, uint32_t m, unsigned op)
+{
+    if (op == GFX_SET)
+        return v | m;
+    if (op == GFX_CLEAR)
+        return v & ~m;
+    return v ^ m;
+}
+
+/**
+ * Row mask m on one column byte, marked dirty; already clipped
+ */
+static void put(int x, int bank, uint32_t m, unsigned op)
+{
+    glcd_fb[bank][x] = (uint8_t)apply32(glcd_fb[bank][x], m, op);
+    glcd_fb_mark(x, bank << 3, x, bank << 3);
+}
+
+/**
+ * Row mask m on glcd_fb[bank][x0..x1], already clipped
+ */
+static void span(int bank, int x0, int x1, uint8_t m, unsigned op)
+{
+    uint8_t *p = &glcd_fb[bank][x0], *end = &glcd_fb[bank][x1] + 1;
+    uint32_t m32 = m * 0x01010101U, *w;
+
+    for (; p < end && ((uint32_t)(uintptr_t)p & 3U); p++)
+        *p = (uint8_t)apply32(*p, m, op);
+    if (m == 0xFFU && op != GFX_XOR) {
+        uint32_t v = op == GFX_SET ? 0xFFFFFFFFU : 0U;
+        for (w = (uint32_t *)p; (uint8_t *)(w + 1) <= end; w++)
+            *w = v;
+    } else {
+        for (w = (uint32_t *)p; (uint8_t *)(w + 1) <= end; w++)
+            *w = apply32(*w, m32, op);
+    }
+    for (p = (uint8_t *)w; p < end; p++)
+        *p = (uint8_t)apply32(*p, m, op);
+}
+
+static void order(int *a, int *b)
+{
+    if (*a > *b) {
+        int t = *a;
+        *a = *b;
+        *b = t;
+    }
+}
+
+void gfx_fill(int x0, int y0, int x1, int y1, unsigned op)
+{
+    int b, b0, b1;
+    uint8_t m;
+
+    order(&x0, &x1);
+    order(&y0, &y1);
+    if (x1 < 0 || y1 < 0 || x0 >= GLCD_WIDTH || y0 >= GLCD_HEIGHT)
+        return;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= GLCD_WIDTH) x1 = GLCD_WIDTH - 1;
+    if (y1 >= GLCD_HEIGHT) y1 = GLCD_HEIGHT - 1;
+
+    b0 = y0 >> 3;
+    b1 = y1 >> 3;
+    for (b = b0; b <= b1; b++) {
+        m = 0xFFU;
+        if (b == b0)
+            m &= (uint8_t)(0xFFU << (y0 & 7));
+        if (b == b1)
+            m &= (uint8_t)(0xFFU >> (7 - (y1 & 7)));
+        span(b, x0, x1, m, op);
+    }
+    glcd_fb_mark(x0, y0, x1, y1);
+}
+
+void gfx_hline(int x0, int x1, int y, unsigned op)
+{
+    gfx_fill(x0, y, x1, y, op);
+}
+
+void gfx_vline(int x, int y0, int y1, unsigned op)
+{
+    gfx_fill(x, y0, x, y1, op);
+}
+
+void gfx_pixel(int x, int y, unsigned op)
+{
+    uint8_t *p;
+
+    if ((unsigned)x >= GLCD_WIDTH || (unsigned)y >= GLCD_HEIGHT)
+        return;
+    p = &glcd_fb[y >> 3][x];
+    *p = (uint8_t)apply32(*p, 1U << (y & 7), op);
+    glcd_fb_mark(x, y, x, y);
+}
+
+void gfx_rect(int x0, int y0, int x1, int y1, unsigned op)
+{
+    order(&x0, &x1);
+    order(&y0, &y1);
+    gfx_hline(x0, x1, y0, op);
+    if (y1 != y0)
+        gfx_hline(x0, x1, y1, op);
+    if (y1 - y0 > 1) {
+        gfx_vline(x0, y0 + 1, y1 - 1, op);
+        if (x1 != x0)
+            gfx_vline(x1, y0 + 1, y1 - 1, op);
+    }
+}
+
+void gfx_line(int x0, int y0, int x1, int y1, unsigned op)
+{
+    int dx, dy, sx, sy, err, e2, inside = 0, cx = -1, cb = -1;
+    int lx = x0 < x1 ? x0 : x1, hx = x0 < x1 ? x1 : x0;
+    int ly = y0 < y1 ? y0 : y1, hy = y0 < y1 ? y1 : y0;
+    uint32_t m = 0;
+
+    if (y0 == y1) {
+        gfx_hline(x0, x1, y0, op);
+        return;
+    }
+    if (x0 == x1) {
+        gfx_vline(x0, y0, y1, op);
+        return;
+    }
+    if (hx < 0 || hy < 0 || lx >= GLCD_WIDTH || ly >= GLCD_HEIGHT)
+        return;
+
+    dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    dy = y1 > y0 ? y0 - y1 : y1 - y0;   // -|dy|
+    sx = x0 < x1 ? 1 : -1;
+    sy = y0 < y1 ? 1 : -1;
+    err = dx + dy;
+    for (;;) {
+        if ((unsigned)x0 < GLCD_WIDTH && (unsigned)y0 < GLCD_HEIGHT) {
+            inside = 1;
+            if (x0 != cx || (y0 >> 3) != cb) {
+                if (m)
+                    put(cx, cb, m, op);
+                cx = x0;
+                cb = y0 >> 3;
+                m = 0;
+            }
+            m |= 1U << (y0 & 7);
+        } else if (inside) {
+            break;
+        }
+        if (x0 == x1 && y0 == y1)
+            break;
+        e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+    if (m)
+        put(cx, cb, m, op);
+}
+
+/**
+ * (xc +- a, yc +- b), each distinct point once
+ */
+static void plot4(int xc, int yc, int a, int b, unsigned op)
+{
+    int x, y;
+
+    for (x = xc - a; x <= xc + a; x += a ? 2 * a : 1)
+        for (y = yc - b; y <= yc + b; y += b ? 2 * b : 1)
+            if ((unsigned)x < GLCD_WIDTH && (unsigned)y < GLCD_HEIGHT)
+                put(x, y >> 3, 1U << (y & 7), op);
+}
+
+void gfx_circle(int xc, int yc, int r, unsigned op)
+{
+    int x = r, y = 0, err = 1 - r;
+
+    if (r < 0 || xc + r < 0 || yc + r < 0 || xc - r >= GLCD_WIDTH || yc - r >= GLCD_HEIGHT)
+        return;
+    while (x >= y) {
+        plot4(xc, yc, x, y, op);
+        if (x != y)
+            plot4(xc, yc, y, x, op);
+        y++;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+void gfx_fill_circle(int xc, int yc, int r, unsigned op)
+{
+    int dx, h = 0, lim = r * r + r;
+
+    if (r < 0)
+        return;
+    /* Column half-heights shrink as |dx| grows: walk outwards from the middle */
+    while ((h + 1) * (h + 1) <= lim)
+        h++;
+    for (dx = 0; dx <= r; dx++) {
+        while (dx * dx + h * h > lim)
+            h--;
+        gfx_vline(xc + dx, yc - h, yc + h, op);
+        if (dx)
+            gfx_vline(xc - dx, yc - h, yc + h, op);
+    }
+}
+
+void gfx_blit(int x, int y, int w, int h, const uint8_t *bits, unsigned op)
+{
+    int banks = (h + 7) >> 3, k, c, cx, yy, b0, s;
+    uint16_t v, m;
+    uint8_t vm;
+
+    if (w <= 0 || h <= 0 || x >= GLCD_WIDTH || y >= GLCD_HEIGHT || x + w <= 0 || y + h <= 0)
+        return;
+    for (k = 0; k < banks; k++) {
+        yy = y + 8 * k;
+        if (yy <= -8 || yy >= GLCD_HEIGHT)
+            continue;
+        b0 = ((yy + 8) >> 3) - 1;       // -1 above the screen
+        s  = (yy + 8) & 7;
+        vm = (uint8_t)(k == banks - 1 ? 0xFFU >> ((8 - (h & 7)) & 7) : 0xFFU);
+        m  = (uint16_t)(vm << s);
+        for (c = 0; c < w; c++) {
+            cx = x + c;
+            if ((unsigned)cx >= GLCD_WIDTH)
+                continue;
+            v = (uint16_t)((bits[k * w + c] & vm) << s);
+            if (op == GFX_COPY) {
+                if (b0 >= 0)
+                    glcd_fb[b0][cx] = (uint8_t)((glcd_fb[b0][cx] & ~m) | v);
+                if (s && b0 + 1 < GLCD_BANKS)
+                    glcd_fb[b0 + 1][cx] = (uint8_t)((glcd_fb[b0 + 1][cx] & ~(m >> 8)) | (v >> 8));
+            } else {
+                if (b0 >= 0)
+                    glcd_fb[b0][cx] = (uint8_t)apply32(glcd_fb[b0][cx], v & 0xFFU, op);
+                if (s && b0 + 1 < GLCD_BANKS)
+                    glcd_fb[b0 + 1][cx] = (uint8_t)apply32(glcd_fb[b0 + 1][cx], v >> 8, op);
+            }
+        }
+    }
+    glcd_fb_mark(x, y, x + w - 1, y + h - 1);
+}
@@ -0,0 +1,41 @@
+/**
+ * gfx.h - Lines, rectangles, circles and bitmaps in the PCD8544
+ *         framebuffer
+ *
+ * Coordinates are pixels, x 0..83 and y 0..47, corners inclusive and in
+ * either order; anything outside the screen is clipped. Every primitive
+ * marks what it drew for glcd_fb_update().
+ *
+ * op says what a drawn pixel does: GFX_SET lights it, GFX_CLEAR darkens
+ * it, GFX_XOR inverts it. gfx_blit() also takes GFX_COPY, where the
+ * bitmap's dark pixels darken the screen as well. Bitmaps use the
+ * framebuffer's own layout: (h + 7) / 8 banks of w column bytes, bit 0
+ * the top row.
+ *
+ *   gfx_rect(0, 0, 83, 47, GFX_SET);
+ *   gfx_line(5, 40, 78, 8, GFX_SET);
+ *   gfx_fill(10, 10, 29, 19, GFX_XOR);
+ *   gfx_circle(60, 24, 12, GFX_SET);
+ */
+
+#ifndef GFX_H
+#define GFX_H
+
+#include <stdint.h>
+
+#define GFX_CLEAR   0U
+#define GFX_SET     1U
+#define GFX_XOR     2U
+#define GFX_COPY    3U                  // gfx_blit() only
+
+void gfx_pixel(int x, int y, unsigned op);
+void gfx_hline(int x0, int x1, int y, unsigned op);
+void gfx_vline(int x, int y0, int y1, unsigned op);
+void gfx_line(int x0, int y0, int x1, int y1, unsigned op);
+void gfx_rect(int x0, int y0, int x1, int y1, unsigned op);
+void gfx_fill(int x0, int y0, int x1, int y1, unsigned op);
+void gfx_circle(int xc, int yc, int r, unsigned op);
+void gfx_fill_circle(int xc, int yc, int r, unsigned op);    // x^2 + y^2 <= r^2 + r
+void gfx_blit(int x, int y, int w, int h, const uint8_t *bits, unsigned op);
+
+#endif /* GFX_H */
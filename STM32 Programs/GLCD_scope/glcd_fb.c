@@ -0,0 +1,324 @@
+/**
+ * glcd_fb.c - PCD8544 framebuffer with dirty-column tracking, sent by
+ *             SPI1 TX DMA
+ *
+ * Every column byte of the frame has a dirty bit, three words per bank.
+ * The controller's horizontal addressing wraps from column 83 to the next
+ * bank, so the frame is one 504-byte address space and the dirty bits are
+ * scanned as one: a run of dirty bytes becomes a burst, and a clean gap
+ * of at most GLCD_BURST_COST bytes between two runs is sent along rather
+ * than paying for another burst. No other split is cheaper under that
+ * cost. If the bursts add up to more than a full flush, or there are
+ * more than GLCD_MAX_BURSTS of them, the whole frame goes instead.
+ *
+ * A burst is:
+ *
+ *   D/C low            set X and Y, polled (2 bytes)
+ *   D/C high           DMA2 Stream3 Ch3  glcd_fb + start -> SPI1->DR
+ *                      DMA2 Stream2 Ch3  SPI1->DR -> rx_sink, TCIE
+ *   Stream2 TC         next burst, or CE high and done()
+ *
+ * CE stays low from the first burst to the end of the last. The address
+ * commands of a following burst are sent from the interrupt, 64 cycles
+ * at 4 MHz SCK.
+ */
+
+#include "stm32f4xx.h"
+#include "glcd_fb.h"
+
+#define CE    (1U << 8)                 // PA8
+#define DC    (1U << 6)                 // PB6
+#define RST   (1U << 10)                // PB10
+
+#define TX_STREAM   DMA2_Stream3
+#define RX_STREAM   DMA2_Stream2
+
+#define CR_TX       0x06000440U         // Channel3, 8-bit, MINC, mem-to-periph
+#define CR_RX       0x06020010U         // Channel3, 8-bit, high priority, periph-to-mem, TCIE
+#define LIFCR_BOTH  0x0F7D0000U         // Stream2 and Stream3 flags
+
+struct burst
+{
+    uint16_t start;                     // bank * 84 + x
+    uint16_t len;
+};
+
+uint8_t glcd_fb[GLCD_BANKS][GLCD_WIDTH] __ALIGNED(4);   // word stores in gfx.c
+
+static uint32_t dirty[GLCD_BANKS][3];  // bit x of bank b: dirty[b][x >> 5] bit x & 31
+
+static struct burst     plan[GLCD_MAX_BURSTS];
+static int              plan_len, plan_next;
+static volatile uint8_t busy;
+static glcd_fb_done_fn  done_fn;
+static void            *done_arg;
+static uint8_t          rx_sink;
+
+volatile uint32_t glcd_fb_tx_bytes;
+volatile uint32_t glcd_fb_bursts;
+volatile uint32_t glcd_fb_full_frames;
+
+/**
+ * One byte with CE already low; returns after it has shifted out
+ */
+static void spi_byte(uint8_t b)
+{
+    while (!(SPI1->SR & 2)) {}          // TXE
+    SPI1->DR = b;
+    while (SPI1->SR & (1U << 7)) {}     // BSY
+}
+
+static void command(uint8_t c)
+{
+    GPIOB->BSRR = DC << 16;             // D/C low => command
+    GPIOA->BSRR = CE << 16;
+    spi_byte(c);
+    GPIOA->BSRR = CE;
+}
+
+static void mark_span(int bank, int x0, int x1)
+{
+    int x;
+
+    for (x = x0; x <= x1; x++)
+        dirty[bank][x >> 5] |= 1U << (x & 31);
+}
+
+/**
+ * SPI1 master 8-bit mode 0, D/C and RST, reset pulse and the init
+ * sequence of GCLD; the display is left with a cleared screen
+ */
+void glcd_fb_init(uint32_t br)
+{
+    RCC->AHB1ENR |= (1U << 0) | (1U << 1) | (1U << 22);   // GPIOA, GPIOB, DMA2 clocks
+    RCC->APB2ENR |= (1U << 12);                           // SPI1 clock
+
+    GPIOA->AFR[0] = (GPIOA->AFR[0] & ~0xF0F00000) | 0x50500000;  // AF5 on PA5, PA7
+    GPIOA->BSRR  = CE;                                           // CE high before it drives
+    GPIOA->MODER = (GPIOA->MODER & ~0x0003CC00) | 0x00018800;    // PA5, PA7 AF, PA8 output
+    GPIOB->MODER = (GPIOB->MODER & ~0x00303000) | 0x00101000;    // PB6, PB10 outputs
+
+    SPI1->CR1 = 0x304 | (br << 3);      // SSM, SSI, MSTR, CPOL=0, CPHA=0, 8-bit
+    SPI1->CR2 = 0;
+    SPI1->CR1 |= (1U << 6);             // SPE
+
+    GPIOB->BSRR = RST << 16;            // reset pulse
+    GPIOB->BSRR = RST;
+
+    command(0x21);                      // extended command set
+    command(0xB8);                      // Vop (contrast)
+    command(0x04);                      // temperature coefficient
+    command(0x14);                      // bias 1:48
+    command(0x20);                      // basic command set, horizontal addressing
+    command(0x0C);                      // normal display
+
+    NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+
+    glcd_fb_clear();
+    glcd_fb_flush(0, GLCD_BANKS - 1, 0, 0);
+    while (busy) {}
+}
+
+/**
+ * New SCK divider; BR may only change with SPE clear
+ */
+void glcd_fb_speed(uint32_t br)
+{
+    while (busy) {}
+    SPI1->CR1 &= ~(1U << 6);
+    SPI1->CR1 = (SPI1->CR1 & ~(7U << 3)) | (br << 3);
+    SPI1->CR1 |= (1U << 6);
+}
+
+void glcd_fb_clear(void)
+{
+    int b, x;
+
+    for (b = 0; b < GLCD_BANKS; b++)
+        for (x = 0; x < GLCD_WIDTH; x++)
+            glcd_fb_put(b, x, 0);
+}
+
+void glcd_fb_put(int bank, int x, uint8_t v)
+{
+    if (glcd_fb[bank][x] != v) {
+        glcd_fb[bank][x] = v;
+        dirty[bank][x >> 5] |= 1U << (x & 31);
+    }
+}
+
+void glcd_fb_pixel(int x, int y, int on)
+{
+    uint8_t v;
+
+    if ((unsigned)x >= GLCD_WIDTH || (unsigned)y >= GLCD_HEIGHT)
+        return;
+    v = glcd_fb[y >> 3][x];
+    if (on)
+        v |= (uint8_t)(1U << (y & 7));
+    else
+        v &= (uint8_t)~(1U << (y & 7));
+    glcd_fb_put(y >> 3, x, v);
+}
+
+void glcd_fb_mark(int x0, int y0, int x1, int y1)
+{
+    int b;
+
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= GLCD_WIDTH) x1 = GLCD_WIDTH - 1;
+    if (y1 >= GLCD_HEIGHT) y1 = GLCD_HEIGHT - 1;
+    for (b = y0 >> 3; b <= y1 >> 3; b++)
+        mark_span(b, x0, x1);
+}
+
+/**
+ * Address commands and the DMA run of plan[plan_next], CE already low
+ */
+static void start_burst(void)
+{
+    const struct burst *p = &plan[plan_next++];
+
+    GPIOB->BSRR = DC << 16;             // commands
+    spi_byte((uint8_t)(0x80 | p->start % GLCD_WIDTH));  // X
+    spi_byte((uint8_t)(0x40 | p->start / GLCD_WIDTH));  // Y
+    GPIOB->BSRR = DC;                   // data
+    (void)SPI1->DR;                     // drop what the commands clocked in
+    (void)SPI1->SR;
+    glcd_fb_tx_bytes += 2U + p->len;
+    glcd_fb_bursts++;
+
+    DMA2->LIFCR = LIFCR_BOTH;
+    RX_STREAM->PAR  = (uint32_t)&SPI1->DR;
+    RX_STREAM->M0AR = (uint32_t)&rx_sink;
+    RX_STREAM->NDTR = p->len;
+    RX_STREAM->FCR  = 0;                // direct mode
+    RX_STREAM->CR   = CR_RX | 1U;
+    TX_STREAM->PAR  = (uint32_t)&SPI1->DR;
+    TX_STREAM->M0AR = (uint32_t)(&glcd_fb[0][0] + p->start);
+    TX_STREAM->NDTR = p->len;
+    TX_STREAM->FCR  = 0;
+    TX_STREAM->CR   = CR_TX | 1U;
+    SPI1->CR2 = 3;                      // RXDMAEN, TXDMAEN: the requests start
+}
+
+static void run(glcd_fb_done_fn done, void *arg)
+{
+    busy      = 1;
+    done_fn   = done;
+    done_arg  = arg;
+    plan_next = 0;
+    GPIOA->BSRR = CE << 16;             // CE low for all bursts
+    start_burst();
+}
+
+/**
+ * Scan the dirty bits into bursts, merging runs across gaps of up to
+ * GLCD_BURST_COST clean bytes. Returns the cost in byte times, or -1 if
+ * the plan does not fit.
+ */
+static int build_plan(void)
+{
+    int b, w, cost = 0;
+    uint32_t bits;
+
+    plan_len = 0;
+    for (b = 0; b < GLCD_BANKS; b++) {
+        for (w = 0; w < 3; w++) {
+            bits = dirty[b][w];
+            while (bits) {
+                int i = b * GLCD_WIDTH + w * 32 + __CLZ(__RBIT(bits));
+                struct burst *last = plan_len ? &plan[plan_len - 1] : 0;
+
+                bits &= bits - 1U;
+                if (last && i - (last->start + last->len) <= GLCD_BURST_COST) {
+                    cost += i - (last->start + last->len) + 1;
+                    last->len = (uint16_t)(i - last->start + 1);
+                } else if (plan_len == GLCD_MAX_BURSTS) {
+                    return -1;
+                } else {
+                    plan[plan_len].start = (uint16_t)i;
+                    plan[plan_len].len = 1;
+                    plan_len++;
+                    cost += GLCD_BURST_COST + 1;
+                }
+            }
+        }
+    }
+    return cost;
+}
+
+/**
+ * Send what changed since the last update, or the whole frame if that is
+ * cheaper
+ */
+int glcd_fb_update(glcd_fb_done_fn done, void *arg)
+{
+    int cost, b;
+
+    if (busy)
+        return 0;
+    cost = build_plan();
+    if (cost < 0 || cost >= GLCD_BURST_COST + GLCD_BYTES) {
+        plan[0].start = 0;
+        plan[0].len = GLCD_BYTES;
+        plan_len = 1;
+        glcd_fb_full_frames++;
+    } else if (plan_len == 0) {
+        if (done)
+            done(arg);
+        return 1;
+    }
+    for (b = 0; b < GLCD_BANKS; b++)
+        dirty[b][0] = dirty[b][1] = dirty[b][2] = 0;
+    run(done, arg);
+    return 1;
+}
+
+/**
+ * Send banks first..last (0..5) whatever is marked, in one burst
+ */
+int glcd_fb_flush(int first, int last, glcd_fb_done_fn done, void *arg)
+{
+    int b;
+
+    if (busy)
+        return 0;
+    if (first < 0)
+        first = 0;
+    if (last >= GLCD_BANKS)
+        last = GLCD_BANKS - 1;
+    if (first > last)
+        return 1;
+    for (b = first; b <= last; b++)
+        dirty[b][0] = dirty[b][1] = dirty[b][2] = 0;
+    plan[0].start = (uint16_t)(first * GLCD_WIDTH);
+    plan[0].len = (uint16_t)((last - first + 1) * GLCD_WIDTH);
+    plan_len = 1;
+    run(done, arg);
+    return 1;
+}
+
+int glcd_fb_busy(void)
+{
+    return busy;
+}
+
+/**
+ * Last byte of a burst received, so it is out: next burst or release the
+ * display
+ */
+void DMA2_Stream2_IRQHandler(void)
+{
+    DMA2->LIFCR = LIFCR_BOTH;
+    SPI1->CR2 = 0;
+    if (plan_next < plan_len) {
+        start_burst();
+        return;
+    }
+    GPIOA->BSRR = CE;
+    busy = 0;
+    if (done_fn)
+        done_fn(done_arg);
+}
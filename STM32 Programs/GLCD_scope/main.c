@@ -0,0 +1,152 @@
+/**
+ * main.c - Oscilloscope on the PCD8544 fed by the ADC DMA stream
+ *          (STM32F401RE)
+ *
+ * ADC_DMA captures 64 samples at 1 kHz and then prints them as text at
+ * 9600 baud for seconds. Here scope.c samples PA0 at 12.5 kHz without a
+ * gap and finds a rising edge through mid-scale in every half-buffer.
+ * Each triggered trace, 33.6 ms in 84 columns of 5 samples, is drawn as
+ * the min..max span per column over a dotted graticule and flushed by SPI
+ * DMA; the CPU sleeps in between. Every 5 s a report goes out over USART2
+ * at 9600 baud. On the host simulator with its default 50 Hz input:
+ *   5038 ms: 122 frames, 24 fps, 122 triggered, 0 stale
+ *     127 edges in 124 halves, 0 overruns, CPU 0.0%
+ *   5015 ms: 123 frames, 24 fps, 123 triggered, 1 stale
+ *     127 edges in 124 halves, 0 overruns, CPU 0.0%
+ * The simulator does not charge computation, so the CPU share there
+ * counts only register accesses; run on the board for the real figure.
+ * Frames are lost only while the report line is printed.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PA0 = ADC1 channel 0 (analog)
+ *   - PA5 = SPI1_SCK, PA7 = SPI1_MOSI (AF5), PA8 = GLCD CE
+ *   - PB6 = GLCD D/C, PB10 = GLCD RST
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "glcd_fb.h"
+#include "font.h"
+#include "gfx.h"
+#include "scope.h"
+
+#define LEVEL       128                 // trigger at 1.65 V
+#define HYSTERESIS  8
+#define WINDOW      (5U * 16000000U)    // cycles between reports
+
+void USART2_init(void);
+int  USART2_write(int ch);
+
+static uint8_t lo[SCOPE_COLUMNS], hi[SCOPE_COLUMNS];
+
+/* 0..255 to row 47..0 */
+static int row(uint8_t v)
+{
+    return GLCD_HEIGHT - 1 - ((v * 3) >> 4);
+}
+
+static void draw(int kind, unsigned fps)
+{
+    char text[8];
+    int x, y;
+
+    glcd_fb_clear();
+    for (x = 0; x < GLCD_WIDTH; x += 3)          // centre line
+        glcd_fb_pixel(x, GLCD_HEIGHT / 2, 1);
+    for (x = 21; x < GLCD_WIDTH; x += 21)        // 8.4 ms divisions
+        for (y = 0; y < GLCD_HEIGHT; y += 3)
+            glcd_fb_pixel(x, y, 1);
+    gfx_hline(0, 2, row(LEVEL), GFX_SET);        // trigger level
+    for (x = 0; x < SCOPE_COLUMNS; x++)
+        gfx_vline(x, row(hi[x]), row(lo[x]), GFX_SET);
+
+    sprintf(text, "%ufps", fps);
+    font_puts(&font_prop, 0, 0, kind == 1 ? "TRIG" : "AUTO", FONT_INVERT);
+    font_puts(&font_prop, GLCD_WIDTH - font_width(&font_prop, text), 0, text, FONT_OPAQUE);
+    glcd_fb_update(0, 0);
+}
+
+int main(void)
+{
+    uint32_t t0, start, busy = 0, isr0 = 0, halves0 = 0, trig0 = 0;
+    unsigned frames = 0, triggered = 0, stale = 0, fps = 0;
+    int kind;
+
+    USART2_init();
+    glcd_fb_init(GLCD_SPI_DIV4);
+    scope_init(SCOPE_RATE, LEVEL, HYSTERESIS);
+    start = DWT->CYCCNT;
+
+    while (1)
+    {
+        while (!scope_ready())
+            __WFI();
+
+        t0 = DWT->CYCCNT;
+        kind = scope_trace(lo, hi);
+        if (kind) {
+            while (glcd_fb_busy()) {}           // the previous frame is still going out
+            draw(kind, fps);
+            frames++;
+            triggered += kind == 1;
+        } else {
+            stale++;
+        }
+        busy += DWT->CYCCNT - t0;
+
+        if (DWT->CYCCNT - start >= WINDOW) {
+            t0 = DWT->CYCCNT - start;
+            fps = (unsigned)((uint64_t)frames * 16000000U / t0);
+            printf("%lu ms: %u frames, %u fps, %u triggered, %u stale\r\n",
+                   (unsigned long)(t0 / 16000U), frames, fps, triggered, stale);
+            printf("  %lu edges in %lu halves, %lu overruns, CPU %lu.%lu%%\r\n",
+                   (unsigned long)(scope_triggers - trig0), (unsigned long)(scope_halves - halves0),
+                   (unsigned long)scope_overruns,
+                   (unsigned long)((uint64_t)(busy + scope_isr_cycles - isr0) * 100U / t0),
+                   (unsigned long)((uint64_t)(busy + scope_isr_cycles - isr0) * 1000U / t0 % 10U));
+            frames = triggered = stale = 0;
+            busy = 0;
+            isr0 = scope_isr_cycles;
+            halves0 = scope_halves;
+            trig0 = scope_triggers;
+            start = DWT->CYCCNT;
+        }
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
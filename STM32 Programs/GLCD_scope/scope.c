@@ -0,0 +1,220 @@
+/**
+ * scope.c - Continuous ADC capture with an edge trigger (STM32F401RE)
+ *
+ * Capture:
+ *   TIM2 runs at the sample rate and its compare 2 event starts ADC1 on
+ *   PA0 (EXTSEL = TIM2_CC2, rising edge), 8-bit. With DMA and DDS set the
+ *   ADC requests DMA2 Stream0 Channel 0 after every conversion, forever;
+ *   the stream is circular over ring[] and raises HT and TC at the two
+ *   half boundaries.
+ *
+ * Trigger:
+ *   Samples are numbered from scope_init(), so positions are absolute and
+ *   survive the ring wrapping; SCOPE_SAMPLES divides 2^32, so they survive
+ *   the counter wrapping as well. At each boundary the ISR walks from
+ *   where it stopped to the end of the half just filled, at most one half
+ *   back. A trigger whose trace is already complete becomes the ready
+ *   trace; otherwise it waits for the next boundary, which completes it
+ *   because SCOPE_TRACE is shorter than a half.
+ *
+ * Timing:
+ *   A waiting trace starts at least HALF - SCOPE_TRACE samples (7.4 ms)
+ *   into the half that is overwritten next, so the DMA reaches it that
+ *   much after the boundary that made it ready. scope_trace() copies
+ *   only the column minima and maxima and then checks from NDTR that the
+ *   DMA did not get there first.
+ */
+
+#include "stm32f4xx.h"
+#include "scope.h"
+
+#define HALF          (SCOPE_SAMPLES / 2)
+#define RING(n)       ((n) & (SCOPE_SAMPLES - 1U))
+
+#define CR_EN         (1U << 0)
+#define LISR_TEIF0    (1U << 3)
+#define LISR_HTIF0    (1U << 4)
+#define LISR_TCIF0    (1U << 5)
+#define LIFCR_ALL0    0x0000003DU       // FEIF0, DMEIF0, TEIF0, HTIF0, TCIF0
+
+volatile uint32_t scope_halves;
+volatile uint32_t scope_triggers;
+volatile uint32_t scope_overruns;
+volatile uint32_t scope_isr_cycles;
+
+static uint8_t  ring[SCOPE_SAMPLES];
+static uint8_t  trig_level, trig_hyst;
+static int      armed;
+static int      quiet;                  // halves since the last trace was offered
+static uint32_t pos;                    // next sample to search
+static uint32_t wait_at;
+static int      waiting;
+static volatile uint32_t ready_at;
+static volatile int      ready;         // 0, 1 triggered, 2 auto
+
+/**
+ * Clocks, ADC, sample timer and the circular stream; sampling starts here
+ */
+void scope_init(uint32_t rate_hz, uint8_t level, uint8_t hysteresis)
+{
+    uint32_t ticks = 16000000U / rate_hz;    // 16 MHz TIM2 clock
+
+    trig_level = level;
+    trig_hyst  = hysteresis;
+
+    RCC->AHB1ENR |= (1U << 0) | (1U << 22);  // GPIOA, DMA2 clocks
+    RCC->APB1ENR |= (1U << 0);               // TIM2 clock
+    RCC->APB2ENR |= (1U << 8);               // ADC1 clock
+    GPIOA->MODER |= (3U << 0);               // PA0 analog
+
+    CoreDebug->DEMCR |= (1U << 24);          // TRCENA
+    DWT->CTRL |= 1U;                         // CYCCNTENA
+
+    TIM2->CR1   = 0;
+    TIM2->PSC   = 0;
+    TIM2->ARR   = ticks - 1U;
+    TIM2->CCR2  = ticks / 2U - 1U;
+    TIM2->CCMR1 = 0x6800;                    // CH2 PWM1, preload
+    TIM2->CCER  = 0x10;                      // CH2 enable
+    TIM2->CNT   = 0;
+
+    ADC1->CR1  = 0x02000000;                 // 8-bit
+    ADC1->SQR3 = 0;                          // channel 0 only
+    ADC1->CR2  = 0x13000000;                 // EXTEN rising, EXTSEL TIM2_CC2
+    ADC1->CR2 |= (1U << 8) | (1U << 9);      // DMA, DDS: a request after every conversion
+    ADC1->CR2 |= (1U << 0);                  // ADON
+
+    DMA2_Stream0->CR &= ~CR_EN;
+    while (DMA2_Stream0->CR & CR_EN) {}
+    DMA2->LIFCR = LIFCR_ALL0;
+    DMA2_Stream0->PAR  = (uint32_t)&ADC1->DR;
+    DMA2_Stream0->M0AR = (uint32_t)ring;
+    DMA2_Stream0->NDTR = SCOPE_SAMPLES;
+    DMA2_Stream0->FCR  = 0;                  // direct mode
+    DMA2_Stream0->CR   = 0x00000000;         // Channel0: ADC1
+    DMA2_Stream0->CR  |= 0x00000500;         // 8-bit, MINC, CIRC, periph-to-mem
+    DMA2_Stream0->CR  |= 0x1C;               // TCIE, HTIE, TEIE
+    DMA2_Stream0->CR  |= CR_EN;
+    NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+
+    TIM2->CR1 = 1;                           // CEN
+}
+
+/**
+ * 1 once a trace is complete in the ring
+ */
+int scope_ready(void)
+{
+    return ready != 0;
+}
+
+/**
+ * Samples the DMA has written since scope_init()
+ */
+static uint32_t written(void)
+{
+    uint32_t halves = scope_halves;
+    uint32_t next = RING(SCOPE_SAMPLES - DMA2_Stream0->NDTR);
+
+    return halves * HALF + RING(next - halves * HALF);
+}
+
+/**
+ * Column minima and maxima of the ready trace. Each column after the
+ * first also takes in the last sample of the one before, so steep edges
+ * join up. Returns the kind of trace, or 0 if none was ready or the DMA
+ * overwrote it while it was copied.
+ */
+int scope_trace(uint8_t lo[SCOPE_COLUMNS], uint8_t hi[SCOPE_COLUMNS])
+{
+    uint32_t start, n;
+    uint8_t v, mn, mx, prev;
+    int kind, c, k;
+
+    __disable_irq();
+    kind  = ready;
+    start = ready_at;
+    ready = 0;
+    __enable_irq();
+    if (!kind)
+        return 0;
+
+    n = start;
+    prev = ring[RING(n)];
+    for (c = 0; c < SCOPE_COLUMNS; c++) {
+        mn = mx = prev;
+        for (k = 0; k < SCOPE_DECIM; k++) {
+            v = ring[RING(n++)];
+            if (v < mn) mn = v;
+            if (v > mx) mx = v;
+        }
+        lo[c] = mn;
+        hi[c] = mx;
+        prev = v;
+    }
+    return written() - start > SCOPE_SAMPLES ? 0 : kind;
+}
+
+/**
+ * HT / TC: complete a waiting trace, search the half just filled
+ */
+void DMA2_Stream0_IRQHandler(void)
+{
+    uint32_t t0 = DWT->CYCCNT;
+    uint32_t isr = DMA2->LISR;
+    uint32_t end;
+    uint8_t v;
+
+    DMA2->LIFCR = isr & LIFCR_ALL0;
+
+    if (isr & LISR_TEIF0) {
+        TIM2->CR1 = 0;
+        return;
+    }
+    if (!(isr & (LISR_HTIF0 | LISR_TCIF0)))
+        return;
+    if ((isr & (LISR_HTIF0 | LISR_TCIF0)) == (LISR_HTIF0 | LISR_TCIF0)) {
+        scope_overruns++;                    // a whole half went by unsearched
+        scope_halves++;                      // count it, so the resync below sees it
+    }
+    scope_halves++;
+    end = scope_halves * HALF;
+
+    if (waiting && (int32_t)(end - wait_at) >= SCOPE_TRACE) {
+        ready_at = wait_at;
+        ready = 1;
+        waiting = 0;
+    }
+    if ((int32_t)(end - pos) > HALF) {       // fell behind: only the last half is whole
+        pos = end - HALF;
+        armed = 0;
+    }
+
+    while ((int32_t)(end - pos) > 0) {
+        v = ring[RING(pos)];
+        if (v + trig_hyst < trig_level) {
+            armed = 1;
+        } else if (armed && v >= trig_level) {
+            armed = 0;
+            quiet = 0;
+            scope_triggers++;
+            if ((int32_t)(end - pos) >= SCOPE_TRACE) {
+                ready_at = pos;
+                ready = 1;
+            } else {
+                wait_at = pos;
+                waiting = 1;
+            }
+            pos += SCOPE_TRACE;              // holdoff until this trace has passed
+            continue;
+        }
+        pos++;
+    }
+
+    if (!waiting && ++quiet > SCOPE_AUTO) {
+        ready_at = end - SCOPE_TRACE;
+        ready = 2;
+        quiet = 0;
+    }
+    scope_isr_cycles += DWT->CYCCNT - t0;
+}
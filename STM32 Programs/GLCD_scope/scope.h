@@ -0,0 +1,44 @@
+/**
+ * scope.h - Continuous ADC capture with an edge trigger, one trace at a
+ *           time (STM32F401RE)
+ *
+ * TIM2 compare 2 starts an 8-bit ADC1 conversion of PA0 at the sample
+ * rate and DMA2 Stream0 Channel 0 writes the results into a circular RAM
+ * buffer. The CPU is only involved at every half-transfer, where the half
+ * just filled is searched for the trigger: the signal rising through the
+ * level after it was below level - hysteresis.
+ *
+ * A trace is SCOPE_TRACE samples from the trigger on, reduced to the
+ * minimum and maximum of each of SCOPE_COLUMNS columns. After a trigger
+ * the search resumes once the trace has passed (holdoff). With no trigger
+ * for SCOPE_AUTO halves the latest samples are offered untriggered, so a
+ * flat or slow input still shows.
+ *
+ *   scope_init(SCOPE_RATE, 128, 8);    trigger rising through 1.65 V
+ *   while (!scope_ready()) __WFI();
+ *   if (scope_trace(lo, hi) > 0)      one column per display pixel
+ *       ...draw...
+ */
+
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include <stdint.h>
+
+#define SCOPE_SAMPLES   1024            // ring buffer, two halves of 512
+#define SCOPE_RATE      12500U          // Hz, 24.4 halves per second
+#define SCOPE_COLUMNS   84
+#define SCOPE_DECIM     5               // samples per column
+#define SCOPE_TRACE     (SCOPE_COLUMNS * SCOPE_DECIM)   // 33.6 ms at 12.5 kHz
+#define SCOPE_AUTO      4               // halves without a trigger before free running
+
+void scope_init(uint32_t rate_hz, uint8_t level, uint8_t hysteresis);
+int  scope_ready(void);
+int  scope_trace(uint8_t lo[SCOPE_COLUMNS], uint8_t hi[SCOPE_COLUMNS]);  // 1 triggered, 2 auto, 0 none or stale
+
+extern volatile uint32_t scope_halves;       // halves filled, overruns included
+extern volatile uint32_t scope_triggers;
+extern volatile uint32_t scope_overruns;     // halves not searched in time
+extern volatile uint32_t scope_isr_cycles;   // DWT cycles spent in the DMA interrupt
+
+#endif /* SCOPE_H */
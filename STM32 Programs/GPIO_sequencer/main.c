@@ -0,0 +1,76 @@
+/**
+ * main.c - Stepper motor driven by the DMA output sequencer (STM32F401RE)
+ *
+ * Same coils as Stepper Motor (PA7..PA4), but the step patterns are
+ * tables of BSRR words played by TIM1 + DMA2 at exactly 200 steps/s. Each
+ * word drives only PA7..PA4, so the rest of GPIOA is left alone, which
+ * `GPIOA->ODR = steps[i++ & 3]` does not do.
+ *
+ * main() only queues tables:
+ *   1 s full steps forward, 1 s full steps backward (swapped at a
+ *   half-transfer, no gap), 1 s half steps forward (reloaded at the end of
+ *   a pass), then one word that turns all coils off, and again.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PA7..PA4 = stepper coils
+ */
+
+#include "stm32f4xx.h"
+#include "sequencer.h"
+
+#define COILS     0x00F0U               // PA7..PA4
+#define STEP(b)   SEQ_OUT(COILS, b)
+
+static const uint32_t full_fwd[] = { STEP(0x90), STEP(0x30), STEP(0x60), STEP(0xC0) };
+static const uint32_t full_rev[] = { STEP(0xC0), STEP(0x60), STEP(0x30), STEP(0x90) };
+static const uint32_t half_fwd[] = { STEP(0x10), STEP(0x30), STEP(0x20), STEP(0x60),
+                                     STEP(0x40), STEP(0xC0), STEP(0x80), STEP(0x90) };
+static const uint32_t coils_off[] = { SEQ_CLR(COILS) };
+
+#define LEN(t)    (uint16_t)(sizeof(t) / sizeof((t)[0]))
+
+void delayMs(int n);
+
+int main(void)
+{
+    /* PA7..PA4 as outputs */
+    RCC->AHB1ENR |= (1U << 0);
+    GPIOA->MODER &= ~0x0000FF00;
+    GPIOA->MODER |=  0x00005500;
+
+    seq_init(200);
+
+    while (1)
+    {
+        seq_start(full_fwd, LEN(full_fwd), SEQ_LOOP);
+        delayMs(1000);
+
+        seq_queue(full_rev, LEN(full_rev), SEQ_LOOP);
+        delayMs(1000);
+
+        seq_queue(half_fwd, LEN(half_fwd), SEQ_LOOP);
+        delayMs(1000);
+
+        seq_queue(coils_off, LEN(coils_off), SEQ_ONESHOT);
+        while (seq_busy()) {}
+        delayMs(500);
+    }
+}
+
+/**
+ * Simple blocking delay:
+ * ~1 ms per 'n' at 16 MHz
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+    {
+        for (i = 0; i < 3195; i++)
+        {
+            __NOP();
+        }
+    }
+}
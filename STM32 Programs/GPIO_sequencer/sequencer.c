@@ -0,0 +1,215 @@
+/**
+ * sequencer.c - Timer-paced DMA output sequencer for GPIOA
+ *
+ * TIM1 runs free at the word rate with only its update DMA request
+ * enabled (UDE). DMA2 Stream5 Channel 6 moves one word from the table to
+ * GPIOA->BSRR per request:
+ *
+ *   SEQ_ONESHOT   normal mode, NDTR = len; the stream stops itself
+ *   SEQ_LOOP      double-buffer mode with M0AR = M1AR = table, which
+ *                 repeats the table like circular mode but lets the
+ *                 idle target address be rewritten while it runs
+ *
+ * Switching tables:
+ *   - loop to loop of the same length: at the half-transfer interrupt the
+ *     idle target is pointed at the new table, so the hardware takes it at
+ *     the next buffer boundary; at the following half-transfer the other
+ *     target follows. No word is missed or repeated.
+ *   - anything else: at the transfer-complete interrupt the stream is
+ *     reloaded. The next TIM1 request is a full period away, so the new
+ *     table starts on time as long as the interrupt is served within one
+ *     period.
+ *
+ * A one-shot is loaded with its transfer-complete interrupt already on:
+ * the stream clears EN by itself when it ends, so CR must not be
+ * rewritten while it plays (a stale EN = 1 would restart it), and a
+ * table queued behind it only has to be noted. A looping table runs with
+ * no interrupt enabled until something is queued; its EN only drops on a
+ * transfer error.
+ */
+
+#include "stm32f4xx.h"
+#include "sequencer.h"
+
+#define SEQ_STREAM   DMA2_Stream5
+
+#define CR_EN        (1U << 0)
+#define CR_TEIE      (1U << 2)
+#define CR_HTIE      (1U << 3)
+#define CR_TCIE      (1U << 4)
+#define CR_DBM       (1U << 18)
+#define CR_CT        (1U << 19)
+
+#define HISR_TEIF5   (1U << 9)
+#define HISR_HTIF5   (1U << 10)
+#define HISR_TCIF5   (1U << 11)
+#define HIFCR_ALL5   0x00000F40U   // FEIF5, DMEIF5, TEIF5, HTIF5, TCIF5
+
+volatile uint32_t seq_swaps;
+
+static uint16_t cur_len;
+static int      cur_mode;
+
+static const uint32_t *volatile next;
+static uint16_t                 next_len;
+static int                      next_mode;
+static volatile int             pending;
+
+/**
+ * Enable GPIOA, DMA2 and TIM1; TIM1 update events at rate_hz
+ */
+void seq_init(uint32_t rate_hz)
+{
+    uint32_t ticks = 16000000U / rate_hz;     // 16 MHz TIM1 clock
+    uint32_t psc = (ticks - 1U) / 65536U;
+
+    RCC->AHB1ENR |= (1U << 0) | (1U << 22);   // GPIOA, DMA2 clocks
+    RCC->APB2ENR |= (1U << 0);                // TIM1 clock
+
+    TIM1->PSC  = psc;
+    TIM1->ARR  = ticks / (psc + 1U) - 1U;
+    TIM1->CNT  = 0;
+    TIM1->DIER = (1U << 8);                   // UDE: DMA request on update
+    TIM1->CR1  = 1;                           // CEN
+
+    DMA2->HIFCR = HIFCR_ALL5;
+    NVIC_EnableIRQ(DMA2_Stream5_IRQn);
+}
+
+/**
+ * Reprogram Stream5 for a table; the first word goes out at the next
+ * TIM1 update
+ */
+static void load(const uint32_t *table, uint16_t len, int mode)
+{
+    uint32_t cr;
+
+    SEQ_STREAM->CR &= ~CR_EN;
+    while (SEQ_STREAM->CR & CR_EN) {}
+    DMA2->HIFCR = HIFCR_ALL5;
+
+    SEQ_STREAM->PAR  = (uint32_t)&GPIOA->BSRR;
+    SEQ_STREAM->M0AR = (uint32_t)table;
+    SEQ_STREAM->M1AR = (uint32_t)table;
+    SEQ_STREAM->NDTR = len;
+    SEQ_STREAM->FCR  = 0;                     // direct mode
+
+    cr  = 0x0C000000U;                        // Channel6: TIM1_UP
+    cr |= 0x00005440U;                        // 32-bit memory and peripheral, MINC, mem-to-periph
+    cr |= CR_TEIE;
+    if (mode == SEQ_LOOP)
+        cr |= CR_DBM;
+    else
+        cr |= CR_TCIE;                        // ignored unless a table is queued
+    SEQ_STREAM->CR = cr;
+    SEQ_STREAM->CR = cr | CR_EN;
+
+    cur_len = len;
+    cur_mode = mode;
+}
+
+/**
+ * Play a table now, dropping whatever was playing or queued
+ */
+void seq_start(const uint32_t *table, uint16_t len, int mode)
+{
+    __disable_irq();
+    pending = 0;
+    load(table, len, mode);
+    __enable_irq();
+}
+
+/**
+ * Play a table after the current one; see the top of the file for where
+ * the switch happens. Returns 0 if a table is already queued.
+ */
+int seq_queue(const uint32_t *table, uint16_t len, int mode)
+{
+    uint32_t cr;
+
+    __disable_irq();
+    if (pending) {
+        __enable_irq();
+        return 0;
+    }
+    cr = SEQ_STREAM->CR;
+    if (!(cr & CR_EN)) {
+        load(table, len, mode);
+        seq_swaps++;
+    } else {
+        next = table;
+        next_len = len;
+        next_mode = mode;
+        pending = 1;
+        // A one-shot has had TCIE on since load(): if it ends from here
+        // on, the interrupt taken after __enable_irq() loads the table
+        if (cur_mode == SEQ_LOOP && mode == SEQ_LOOP && len == cur_len && len >= 2U) {
+            DMA2->HIFCR = HISR_HTIF5;         // only a half-transfer from now on counts
+            SEQ_STREAM->CR = cr | CR_HTIE;
+        } else if (cur_mode == SEQ_LOOP) {
+            DMA2->HIFCR = HISR_TCIF5;         // set at every pass of the loop
+            SEQ_STREAM->CR = cr | CR_TCIE;
+        }
+    }
+    __enable_irq();
+    return 1;
+}
+
+/**
+ * Stop after the current word; the pins keep their levels
+ */
+void seq_stop(void)
+{
+    __disable_irq();
+    pending = 0;
+    SEQ_STREAM->CR &= ~(CR_EN | CR_HTIE | CR_TCIE);
+    while (SEQ_STREAM->CR & CR_EN) {}
+    __enable_irq();
+}
+
+/**
+ * 1 while a table is playing
+ */
+int seq_busy(void)
+{
+    return (SEQ_STREAM->CR & CR_EN) != 0;
+}
+
+/**
+ * Half-transfer: retarget the idle buffer of a looping table.
+ * Transfer-complete: reload the stream with the queued table.
+ */
+void DMA2_Stream5_IRQHandler(void)
+{
+    uint32_t isr = DMA2->HISR;
+    uint32_t cr = SEQ_STREAM->CR;
+    uint32_t active;
+
+    if (isr & HISR_TEIF5) {
+        DMA2->HIFCR = HIFCR_ALL5;             // bus error: the stream has stopped
+        pending = 0;
+        return;
+    }
+    DMA2->HIFCR = isr & (HISR_HTIF5 | HISR_TCIF5);
+
+    if ((isr & HISR_HTIF5) && (cr & CR_HTIE)) {
+        if (cr & CR_CT) {
+            active = SEQ_STREAM->M1AR;
+            SEQ_STREAM->M0AR = (uint32_t)next;
+        } else {
+            active = SEQ_STREAM->M0AR;
+            SEQ_STREAM->M1AR = (uint32_t)next;
+        }
+        if (active == (uint32_t)next) {       // both targets on the new table
+            SEQ_STREAM->CR = cr & ~CR_HTIE;
+            pending = 0;
+            seq_swaps++;
+        }
+    }
+
+    if ((isr & HISR_TCIF5) && (cr & CR_TCIE) && pending) {
+        load(next, next_len, next_mode);      // clears TCIE
+        pending = 0;
+        seq_swaps++;
+    }
+}
@@ -0,0 +1,40 @@
+/**
+ * sequencer.h - Timer-paced DMA output sequencer for GPIOA
+ *
+ * A table of 32-bit BSRR words is streamed to GPIOA->BSRR by DMA2 Stream5
+ * Channel 6 on every TIM1 update event, one word per period. Each word
+ * sets and resets any mix of the 16 pins in one bus write, so multi-pin
+ * patterns change at exact rates while the CPU does nothing.
+ *
+ *   seq_init(200);                          200 words per second
+ *   seq_start(steps, 4, SEQ_LOOP);          repeat a table
+ *   seq_queue(other, 4, SEQ_LOOP);          switch tables without a gap
+ *   seq_queue(park, 1, SEQ_ONESHOT);        play once, then stop
+ *   while (seq_busy()) {}
+ *
+ * Only GPIOA is driven: DMA1 cannot reach the AHB1 GPIO ports, and TIM1_UP
+ * is the DMA2 request that can.
+ */
+
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <stdint.h>
+
+#define SEQ_ONESHOT   0
+#define SEQ_LOOP      1
+
+/* BSRR words: set pins, reset pins, or drive the pins in mask to value */
+#define SEQ_SET(pins)            ((uint32_t)(pins) & 0xFFFFU)
+#define SEQ_CLR(pins)            (((uint32_t)(pins) & 0xFFFFU) << 16)
+#define SEQ_OUT(mask, value)     (SEQ_SET((mask) & (value)) | SEQ_CLR((mask) & ~(value)))
+
+void     seq_init(uint32_t rate_hz);
+void     seq_start(const uint32_t *table, uint16_t len, int mode);
+int      seq_queue(const uint32_t *table, uint16_t len, int mode);
+void     seq_stop(void);
+int      seq_busy(void);
+
+extern volatile uint32_t seq_swaps;   // tables taken over from the queue
+
+#endif /* SEQUENCER_H */
@@ -0,0 +1,174 @@
+/**
+ * keypad_dma.c - 4x4 keypad scanned by TIM1 and DMA2, no CPU per row
+ *
+ * TIM1 is the only F401 timer whose requests reach DMA2, and only DMA2
+ * can reach the GPIO ports:
+ *
+ *   CNT = 1          CC1 request: DMA2 Stream1 Channel 6,
+ *                    row_select[i] -> GPIOC->BSRR, circular over 4 words
+ *   CNT = ARR / 2    CC2 request: DMA2 Stream2 Channel 6,
+ *                    GPIOC->IDR -> samples[j], circular over 32 half-words
+ *
+ * row_select[] holds the row_low[] and row_high[] words of keypad_getkey()
+ * folded into one BSRR write each: release the other rows, drive this
+ * one low. With the rows open-drain a released row floats high, so no
+ * MODER rewrite is needed between rows.
+ *
+ * samples[] is two blocks of four frames of four rows. When a block is
+ * complete (HT: first half, TC: second half) it is reduced to two
+ * bitmaps: keys down in all four frames and keys down in any. A key goes
+ * down when it was down in all four frames, up when it was up in all
+ * four, so contact chatter shorter than a block never makes an event.
+ * A block equal to the previous one costs a compare and nothing else.
+ */
+
+#include "stm32f4xx.h"
+#include "keypad_dma.h"
+
+#define ROW_STREAM    DMA2_Stream1
+#define COL_STREAM    DMA2_Stream2
+
+#define LISR_TEIF2    (1U << 19)
+#define LISR_HTIF2    (1U << 20)
+#define LISR_TCIF2    (1U << 21)
+#define LIFCR_ALL12   0x003D0F40U      // all Stream1 and Stream2 flags
+
+#define FRAMES        4                // per block
+#define SAMPLES       (2 * FRAMES * 4)
+#define QUEUE_SIZE    32               // power of two
+
+/* BSRR words: release all rows, then drive one of them low */
+static const uint32_t row_select[4] = {
+    0x001000E0U,                       // PC4 low, PC5..PC7 released
+    0x002000D0U,                       // PC5 low
+    0x004000B0U,                       // PC6 low
+    0x00800070U                        // PC7 low
+};
+
+volatile uint32_t kpd_blocks;
+volatile uint32_t kpd_dropped;
+
+static volatile uint16_t samples[SAMPLES];    // GPIOC->IDR, written by DMA
+static uint16_t down;
+static uint32_t last_all, last_any = 0xFFFFFFFFU;
+
+static struct kpd_event queue[QUEUE_SIZE];
+static volatile uint32_t head, tail;          // free-running; index with & (QUEUE_SIZE - 1)
+
+/**
+ * Rows open-drain, columns with pull-ups, both streams running, TIM1 at
+ * 1 kHz
+ */
+void kpd_init(void)
+{
+    RCC->AHB1ENR |= (1U << 2) | (1U << 22);   // GPIOC, DMA2 clocks
+    RCC->APB2ENR |= (1U << 0);                // TIM1 clock
+
+    GPIOC->BSRR    = 0x000000F0;              // rows released
+    GPIOC->OTYPER |= 0x00F0;                  // PC4..PC7 open-drain
+    GPIOC->PUPDR   = (GPIOC->PUPDR & ~0x0000FFFF) | 0x00000055;   // pull-ups on PC0..PC3
+    GPIOC->MODER   = (GPIOC->MODER & ~0x0000FFFF) | 0x00005500;   // PC4..PC7 outputs
+
+    TIM1->CR1 = 0;
+    DMA2->LIFCR = LIFCR_ALL12;
+
+    ROW_STREAM->PAR  = (uint32_t)&GPIOC->BSRR;
+    ROW_STREAM->M0AR = (uint32_t)row_select;
+    ROW_STREAM->NDTR = 4;
+    ROW_STREAM->FCR  = 0;                     // direct mode
+    ROW_STREAM->CR   = 0x0C005540U;           // Channel6, 32-bit, MINC, CIRC, mem-to-periph
+    ROW_STREAM->CR  |= 1U;                    // EN
+
+    COL_STREAM->PAR  = (uint32_t)&GPIOC->IDR;
+    COL_STREAM->M0AR = (uint32_t)samples;
+    COL_STREAM->NDTR = SAMPLES;
+    COL_STREAM->FCR  = 0;
+    COL_STREAM->CR   = 0x0C002D18U;           // Channel6, 16-bit, MINC, CIRC, periph-to-mem, TCIE, HTIE
+    COL_STREAM->CR  |= 1U;
+    NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+
+    TIM1->PSC  = 16 - 1;                      // 1 MHz
+    TIM1->ARR  = 1000 - 1;                    // 1 kHz
+    TIM1->CCR1 = 1;
+    TIM1->CCR2 = 500;                         // half a tick after the row select
+    TIM1->DIER = (1U << 9) | (1U << 10);      // CC1DE, CC2DE
+    TIM1->EGR  = 1;                           // UG: load PSC
+    TIM1->CR1  = 1;                           // CEN
+}
+
+/**
+ * Next event, 1 if there was one
+ */
+int kpd_get(struct kpd_event *ev)
+{
+    if (tail == head)
+        return 0;
+    *ev = queue[tail & (QUEUE_SIZE - 1U)];
+    tail = tail + 1U;
+    return 1;
+}
+
+uint16_t kpd_down(void)
+{
+    return down;
+}
+
+static void push(unsigned key, unsigned type)
+{
+    struct kpd_event *ev;
+
+    if (head - tail == QUEUE_SIZE) {
+        kpd_dropped++;
+        return;
+    }
+    ev = &queue[head & (QUEUE_SIZE - 1U)];
+    ev->ms   = kpd_blocks * FRAMES * 4U;
+    ev->key  = (uint8_t)key;
+    ev->type = (uint8_t)type;
+    __DMB();                                  // entry written before it is published
+    head = head + 1U;
+}
+
+/**
+ * Reduce one block to keys down in all frames and in any frame, and queue
+ * what changed
+ */
+static void block(const volatile uint16_t *s)
+{
+    uint32_t all = 0xFFFFU, any = 0, frame;
+    uint16_t old = down, changed;
+    unsigned f, key;
+
+    for (f = 0; f < FRAMES; f++, s += 4) {
+        frame = (~s[0] & 0xFU) | ((~s[1] & 0xFU) << 4) | ((~s[2] & 0xFU) << 8) | ((~s[3] & 0xFU) << 12);
+        all &= frame;
+        any |= frame;
+    }
+    kpd_blocks++;
+    if (all == last_all && any == last_any)
+        return;
+    last_all = all;
+    last_any = any;
+
+    down = (uint16_t)((down | all) & any);
+    changed = down ^ old;
+    while (changed) {
+        key = 31U - __CLZ(changed);
+        changed &= ~(1U << key);
+        push(key + 1U, ((down >> key) & 1U) ? KPD_PRESS : KPD_RELEASE);
+    }
+}
+
+/**
+ * HT: the first block is complete, TC: the second
+ */
+void DMA2_Stream2_IRQHandler(void)
+{
+    uint32_t isr = DMA2->LISR;
+
+    DMA2->LIFCR = isr & (LISR_TEIF2 | LISR_HTIF2 | LISR_TCIF2);
+    if (isr & LISR_HTIF2)
+        block(&samples[0]);
+    if (isr & LISR_TCIF2)
+        block(&samples[SAMPLES / 2]);
+}
@@ -0,0 +1,43 @@
+/**
+ * keypad_dma.h - 4x4 keypad scanned by TIM1 and DMA2, no CPU per row
+ *
+ * Same keypad and key numbers (1..16) as Interacting with keyboard:
+ *   - PC0..PC3 = columns, inputs with pull-ups
+ *   - PC4..PC7 = rows, open-drain outputs
+ *
+ * TIM1 ticks at 1 kHz. At the start of every tick one DMA stream writes
+ * the next row-select word to GPIOC->BSRR, half a tick later a second
+ * stream copies GPIOC->IDR into a circular sample buffer. The CPU only
+ * looks at the buffer every 4 frames (16 ms), at the half-transfer and
+ * transfer-complete interrupts, and queues press and release events.
+ *
+ *   kpd_init();
+ *   while (1) {
+ *       while (kpd_get(&ev)) { ... }
+ *       __WFI();
+ *   }
+ */
+
+#ifndef KEYPAD_DMA_H
+#define KEYPAD_DMA_H
+
+#include <stdint.h>
+
+#define KPD_PRESS     0
+#define KPD_RELEASE   1
+
+struct kpd_event
+{
+    uint32_t ms;                        // end of the frames that showed it
+    uint8_t  key;                       // 1..16
+    uint8_t  type;                      // KPD_PRESS, KPD_RELEASE
+};
+
+void     kpd_init(void);
+int      kpd_get(struct kpd_event *ev);
+uint16_t kpd_down(void);                // debounced keys, bit n = key n + 1
+
+extern volatile uint32_t kpd_blocks;    // 4-frame blocks looked at
+extern volatile uint32_t kpd_dropped;   // events lost to a full queue
+
+#endif /* KEYPAD_DMA_H */
@@ -0,0 +1,89 @@
+/**
+ * main.c - Keypad events from the DMA-paced scanner (STM32F401RE)
+ *
+ * The rows are selected and the columns sampled by TIM1 + DMA2 at 1 kHz
+ * per row; the CPU wakes only every 16 ms to look at four frames at once.
+ * main() prints the press and release events over USART2 at 9600 baud
+ * and sleeps in __WFI() in between; after 4 s it prints how many blocks
+ * were looked at. On the host simulator with
+ *   --key 500:6:100:4 --key 1000:1:300 --key 1100:16:100
+ * it prints
+ *   528 ms: key 6 press          once, despite 4 ms of chatter
+ *   624 ms: key 6 release
+ *   1024 ms: key 1 press
+ *   1120 ms: key 16 press
+ *   1216 ms: key 16 release
+ *   1328 ms: key 1 release
+ *   4 s: 250 blocks, 0 events lost
+ * with one interrupt per block and no CPU access to GPIOC after kpd_init().
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PC0..PC3 = keypad columns, PC4..PC7 = keypad rows
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "keypad_dma.h"
+
+void USART2_init(void);
+int  USART2_write(int ch);
+
+int main(void)
+{
+    struct kpd_event ev;
+    int reported = 0;
+
+    USART2_init();
+    kpd_init();
+
+    while (1)
+    {
+        while (kpd_get(&ev))
+            printf("%lu ms: key %d %s\r\n", (unsigned long)ev.ms, ev.key,
+                   ev.type == KPD_PRESS ? "press" : "release");
+
+        if (!reported && kpd_blocks >= 250) {
+            reported = 1;
+            printf("4 s: %lu blocks, %lu events lost\r\n",
+                   (unsigned long)kpd_blocks, (unsigned long)kpd_dropped);
+        }
+        __WFI();
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
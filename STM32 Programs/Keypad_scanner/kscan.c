@@ -0,0 +1,194 @@
+/**
+ * kscan.c - Timer-driven 4x4 keypad scanner with debouncing, n-key
+ *           rollover, ghost detection and an event queue
+ *
+ * Scanning:
+ *   Each tick reads the columns of the row selected at the previous tick,
+ *   a full millisecond ago, so the lines have long settled, then selects
+ *   the next row: one IDR read and one BSRR write per tick. The rows are
+ *   open-drain, so a released row floats high and two keys in one column
+ *   cannot short a high row against a low one.
+ *
+ * Debouncing:
+ *   Every key has a 2-bit integrator that counts up while the key reads
+ *   down and down while it reads up, saturating at 3 and 0. The key
+ *   becomes pressed at 3 and released at 0, so a steady contact is taken
+ *   after three frames (12 ms) and chatter shorter than that is ignored.
+ *   The 16 integrators are two 16-bit bit planes, c1 and c0, updated for
+ *   all keys at once with a dozen logic operations per frame.
+ *
+ * Ghosting:
+ *   Without diodes, three keys at the corners of a rectangle make the
+ *   fourth corner read as pressed too. Any two rows sharing two or more
+ *   columns mark the frame as ambiguous; its new presses are dropped
+ *   (releases still pass) until the frame is clean.
+ *
+ * Repeat:
+ *   The last key pressed repeats 500 ms after the press, then every
+ *   100 ms, until it is released or another key is pressed.
+ *
+ * Queue:
+ *   A 32-entry ring with the ISR as the only writer of head and
+ *   kscan_get() as the only reader of tail, as in EXTI_dispatcher.
+ */
+
+#include "stm32f4xx.h"
+#include "kscan.h"
+
+#define COLS           0x000FU
+#define QUEUE_SIZE     32               // power of two
+#define REPEAT_DELAY   500              // ms
+#define REPEAT_PERIOD  100              // ms
+
+/* BSRR words: release all rows, then drive one of them low */
+static const uint32_t row_select[4] = {
+    0x001000E0U,                        // PC4 low, PC5..PC7 released
+    0x002000D0U,                        // PC5 low
+    0x004000B0U,                        // PC6 low
+    0x00800070U                         // PC7 low
+};
+
+volatile uint32_t kscan_ms;
+volatile uint32_t kscan_ghosts;
+volatile uint32_t kscan_dropped;
+volatile uint32_t kscan_isr_max;
+volatile uint32_t kscan_isr_total;
+
+static uint16_t raw;                    // last sample of every row
+static uint16_t down;                   // debounced state
+static uint16_t c1, c0;                 // integrator bit planes
+static unsigned row;
+static uint8_t  repeat_key;             // 0 = none
+static uint32_t repeat_at;
+
+static struct kscan_event queue[QUEUE_SIZE];
+static volatile uint32_t head, tail;    // free-running; index with & (QUEUE_SIZE - 1)
+
+/**
+ * Rows open-drain with row 0 selected, columns with pull-ups, TIM3
+ * interrupt at 1 kHz
+ */
+void kscan_init(void)
+{
+    RCC->AHB1ENR |= (1U << 2);          // GPIOC clock
+    RCC->APB1ENR |= (1U << 1);          // TIM3 clock
+
+    GPIOC->BSRR    = row_select[0];
+    GPIOC->OTYPER |= 0x00F0;            // PC4..PC7 open-drain
+    GPIOC->PUPDR   = (GPIOC->PUPDR & ~0x0000FFFF) | 0x00000055;   // pull-ups on PC0..PC3
+    GPIOC->MODER   = (GPIOC->MODER & ~0x0000FFFF) | 0x00005500;   // PC4..PC7 outputs
+
+    CoreDebug->DEMCR |= (1U << 24);     // TRCENA
+    DWT->CTRL |= 1U;                    // CYCCNTENA
+
+    TIM3->PSC  = 16 - 1;                // 1 MHz
+    TIM3->ARR  = 1000 - 1;              // 1 kHz
+    TIM3->DIER = 1;                     // UIE
+    TIM3->CR1  = 1;                     // CEN
+    NVIC_EnableIRQ(TIM3_IRQn);
+}
+
+/**
+ * Next event, 1 if there was one
+ */
+int kscan_get(struct kscan_event *ev)
+{
+    if (tail == head)
+        return 0;
+    *ev = queue[tail & (QUEUE_SIZE - 1U)];
+    tail = tail + 1U;
+    return 1;
+}
+
+uint16_t kscan_down(void)
+{
+    return down;
+}
+
+static void push(unsigned key, unsigned type)
+{
+    struct kscan_event *ev;
+
+    if (head - tail == QUEUE_SIZE) {
+        kscan_dropped++;
+        return;
+    }
+    ev = &queue[head & (QUEUE_SIZE - 1U)];
+    ev->ms   = kscan_ms;
+    ev->key  = (uint8_t)key;
+    ev->type = (uint8_t)type;
+    __DMB();                            // entry written before it is published
+    head = head + 1U;
+}
+
+/* Two rows with two or more columns in common */
+static int ghosted(uint16_t s)
+{
+    uint32_t r0 = s & 0xFU, r1 = (s >> 4) & 0xFU, r2 = (s >> 8) & 0xFU, r3 = s >> 12;
+    uint32_t x01 = r0 & r1, x02 = r0 & r2, x03 = r0 & r3;
+    uint32_t x12 = r1 & r2, x13 = r1 & r3, x23 = r2 & r3;
+
+    return ((x01 & (x01 - 1U)) | (x02 & (x02 - 1U)) | (x03 & (x03 - 1U)) |
+            (x12 & (x12 - 1U)) | (x13 & (x13 - 1U)) | (x23 & (x23 - 1U))) != 0;
+}
+
+/**
+ * A complete frame: integrate, then queue the keys that changed
+ */
+static void frame(void)
+{
+    uint16_t s = raw, up, dn, changed, old = down;
+    unsigned key;
+
+    if (ghosted(s)) {
+        s &= down;                      // releases only
+        kscan_ghosts++;
+    }
+
+    up = s & ~(c1 & c0);                /* count up, not yet at 3 */
+    dn = ~s & (c1 | c0);                /* count down, not yet at 0 */
+    c1 ^= (up & c0) | (dn & ~c0);
+    c0 ^= up | dn;
+    down = (down | (c1 & c0)) & (c1 | c0);
+
+    changed = down ^ old;
+    while (changed) {
+        key = 31U - __CLZ(changed);
+        changed &= ~(1U << key);
+        if ((down >> key) & 1U) {
+            push(key + 1U, KSCAN_PRESS);
+            repeat_key = (uint8_t)(key + 1U);
+            repeat_at = kscan_ms + REPEAT_DELAY;
+        } else {
+            push(key + 1U, KSCAN_RELEASE);
+            if (repeat_key == key + 1U)
+                repeat_key = 0;
+        }
+    }
+    if (repeat_key && (int32_t)(kscan_ms - repeat_at) >= 0) {
+        push(repeat_key, KSCAN_REPEAT);
+        repeat_at += REPEAT_PERIOD;
+    }
+}
+
+/**
+ * One row per tick; a frame after the last row
+ */
+void TIM3_IRQHandler(void)
+{
+    uint32_t t0 = DWT->CYCCNT, dt;
+    unsigned r = row, shift = r * 4U;
+
+    TIM3->SR = 0;
+    raw = (uint16_t)((raw & ~(COLS << shift)) | ((~GPIOC->IDR & COLS) << shift));
+    row = (r + 1U) & 3U;
+    GPIOC->BSRR = row_select[row];
+    kscan_ms++;
+    if (r == 3U)
+        frame();
+
+    dt = DWT->CYCCNT - t0;
+    kscan_isr_total += dt;
+    if (dt > kscan_isr_max)
+        kscan_isr_max = dt;
+}
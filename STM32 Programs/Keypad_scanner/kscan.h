@@ -0,0 +1,48 @@
+/**
+ * kscan.h - Timer-driven 4x4 keypad scanner with debouncing, n-key
+ *           rollover, ghost detection and an event queue
+ *
+ * Same keypad and key numbers (1..16) as Interacting with keyboard:
+ *   - PC0..PC3 = columns, inputs with pull-ups
+ *   - PC4..PC7 = rows, open-drain outputs
+ *
+ * TIM3 ticks at 1 kHz and handles one row per tick, so the whole matrix is
+ * sampled every 4 ms. Every key is debounced on its own, any number of
+ * keys can be down at once, and presses that would be indistinguishable
+ * from ghost keys are held back until the matrix is unambiguous again.
+ *
+ *   kscan_init();
+ *   while (1)
+ *       while (kscan_get(&ev))
+ *           printf("%lu ms: key %d %s\n", ev.ms, ev.key, names[ev.type]);
+ */
+
+#ifndef KSCAN_H
+#define KSCAN_H
+
+#include <stdint.h>
+
+#define KSCAN_PRESS     0
+#define KSCAN_RELEASE   1
+#define KSCAN_REPEAT    2
+
+struct kscan_event
+{
+    uint32_t ms;                        // scanner time of the event
+    uint8_t  key;                       // 1..16
+    uint8_t  type;                      // KSCAN_PRESS, _RELEASE, _REPEAT
+};
+
+void     kscan_init(void);
+int      kscan_get(struct kscan_event *ev);
+uint16_t kscan_down(void);              // debounced keys, bit n = key n + 1
+
+extern volatile uint32_t kscan_ms;      // ticks since kscan_init()
+extern volatile uint32_t kscan_ghosts;  // frames with presses held back
+extern volatile uint32_t kscan_dropped; // events lost to a full queue
+
+/* ISR cost, DWT cycles from handler entry to exit */
+extern volatile uint32_t kscan_isr_max;
+extern volatile uint32_t kscan_isr_total;
+
+#endif /* KSCAN_H */
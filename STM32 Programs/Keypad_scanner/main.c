@@ -0,0 +1,98 @@
+/**
+ * main.c - Keypad events from the timer-driven scanner (STM32F401RE)
+ *
+ * Prints every press, release and repeat from the scanner over USART2 at
+ * 9600 baud, and after 4 s the ghost frames, lost events and the cost of
+ * the TIM3 interrupt. On the host simulator with
+ *   --key 500:6:100:4        key 6 with 4 ms contact chatter
+ *   --key 1000:1:1000        held: repeats after 500 ms, then every 100 ms
+ *   --key 2500:1:400 --key 2550:2:300 --key 2600:5:100
+ *                            1, 2 and 5 make 6 a ghost: 5 is held back
+ * it prints
+ *   512 ms: key 6 press          once, despite the chatter
+ *   612 ms: key 6 release
+ *   1012 ms: key 1 press
+ *   1512 ms: key 1 repeat        ... every 100 ms up to 1912 ms
+ *   2012 ms: key 1 release
+ *   2512 ms: key 1 press
+ *   2564 ms: key 2 press
+ *   2864 ms: key 2 release
+ *   2912 ms: key 1 release
+ *   4 s: 25 ghost frames, 0 events lost, ISR 12 cycles avg, 12 max
+ * and neither key 5 nor its ghost 6 ever appears. The simulator charges
+ * only the four register accesses per tick; on the board the row update
+ * and, every fourth tick, the frame add a few dozen cycles, the same
+ * whatever the keys, plus a few per event queued.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PC0..PC3 = keypad columns, PC4..PC7 = keypad rows
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "kscan.h"
+
+void USART2_init(void);
+int  USART2_write(int ch);
+
+static const char *const names[] = { "press", "release", "repeat" };
+
+int main(void)
+{
+    struct kscan_event ev;
+    int reported = 0;
+
+    USART2_init();
+    kscan_init();
+
+    while (1)
+    {
+        while (kscan_get(&ev))
+            printf("%lu ms: key %d %s\r\n", (unsigned long)ev.ms, ev.key, names[ev.type]);
+
+        if (!reported && kscan_ms >= 4000) {
+            reported = 1;
+            printf("4 s: %lu ghost frames, %lu events lost, ISR %lu cycles avg, %lu max\r\n",
+                   (unsigned long)kscan_ghosts, (unsigned long)kscan_dropped,
+                   (unsigned long)(kscan_isr_total / kscan_ms), (unsigned long)kscan_isr_max);
+        }
+        __WFI();
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
@@ -0,0 +1,186 @@
+/**
+ * keypad.c - Interrupt-driven 4x4 keypad, scanned only while a key is down
+ *
+ * The rows are open-drain: a row released by BSRR floats high through the
+ * column pull-ups, so selecting a row is one BSRR write instead of the
+ * MODER rewrites of keypad_getkey(), and two pressed keys can never short
+ * a high row against a low one.
+ *
+ * A new key is queued with the DWT cycle count taken when the interrupt
+ * that found it was entered, so keypad_get() callers can tell how long it
+ * waited.
+ */
+
+#include "stm32f4xx.h"
+#include "keypad.h"
+
+#define COLS        0x000FU
+#define ROWS_LOW    0x00F00000U      // BSRR: all rows low
+#define QUEUE_LEN   8
+
+/* BSRR words: release all rows, then drive one of them low */
+static const uint32_t row_select[4] = {
+    0x001000E0U,                     // PC4 low, PC5..PC7 released
+    0x002000D0U,                     // PC5 low
+    0x004000B0U,                     // PC6 low
+    0x00800070U                      // PC7 low
+};
+
+volatile uint32_t keypad_scans;
+volatile uint32_t keypad_lost;
+
+static uint16_t          down;       // keys down, bit n = key n + 1
+static uint16_t          up_once;    // keys of down that were up at the last scan
+static volatile uint8_t  q_key[QUEUE_LEN];
+static volatile uint32_t q_stamp[QUEUE_LEN];
+static volatile uint32_t q_head, q_tail;
+
+/**
+ * Rows open-drain and low, columns with pull-ups and falling-edge EXTI,
+ * TIM2 ready to tick at scan_hz
+ */
+void keypad_init(uint32_t scan_hz)
+{
+    RCC->AHB1ENR |= (1U << 2);       // GPIOC clock
+    RCC->APB1ENR |= (1U << 0);       // TIM2 clock
+    RCC->APB2ENR |= (1U << 14);      // SYSCFG clock
+
+    GPIOC->BSRR    = ROWS_LOW;
+    GPIOC->OTYPER |= 0x00F0;         // PC4..PC7 open-drain
+    GPIOC->PUPDR   = (GPIOC->PUPDR & ~0x0000FFFF) | 0x00000055;   // pull-ups on PC0..PC3
+    GPIOC->MODER   = (GPIOC->MODER & ~0x0000FFFF) | 0x00005500;   // PC4..PC7 outputs
+
+    CoreDebug->DEMCR |= (1U << 24);  // TRCENA
+    DWT->CTRL |= 1U;                 // CYCCNTENA
+
+    TIM2->PSC  = 16 - 1;             // 1 MHz
+    TIM2->ARR  = 1000000U / scan_hz - 1U;
+    TIM2->DIER = 1;                  // UIE
+    NVIC_EnableIRQ(TIM2_IRQn);
+
+    SYSCFG->EXTICR[0] = 0x2222;      // EXTI0..3 from port C
+    EXTI->FTSR |= COLS;
+    EXTI->PR    = COLS;
+    EXTI->IMR  |= COLS;
+    NVIC_EnableIRQ(EXTI0_IRQn);
+    NVIC_EnableIRQ(EXTI1_IRQn);
+    NVIC_EnableIRQ(EXTI2_IRQn);
+    NVIC_EnableIRQ(EXTI3_IRQn);
+}
+
+/**
+ * Next key pressed (1..16), or 0; *stamp gets DWT->CYCCNT at the entry
+ * of the interrupt that saw it go down
+ */
+int keypad_get(uint32_t *stamp)
+{
+    uint32_t t = q_tail;
+    int key;
+
+    if (t == q_head)
+        return 0;
+    key = q_key[t % QUEUE_LEN];
+    *stamp = q_stamp[t % QUEUE_LEN];
+    q_tail = t + 1;
+    return key;
+}
+
+/**
+ * 1 while keys are queued; call with interrupts disabled before __WFI()
+ */
+int keypad_pending(void)
+{
+    return q_tail != q_head;
+}
+
+/**
+ * One pass over the four rows; the rows are left low for edge detection.
+ * Returns the keys down.
+ */
+static uint16_t scan(void)
+{
+    uint16_t keys = 0;
+    int row;
+
+    for (row = 0; row < 4; row++) {
+        GPIOC->BSRR = row_select[row];
+        __NOP(); __NOP();             // let the column settle
+        keys |= (uint16_t)((~GPIOC->IDR & COLS) << (row * 4));
+    }
+    GPIOC->BSRR = ROWS_LOW;
+    keypad_scans++;
+    return keys;
+}
+
+/**
+ * Scan and queue the keys that went down since the last scan. A key only
+ * counts as released when two scans in a row find it up, so contact
+ * chatter after a release is not taken for a new press. Returns the keys
+ * still down.
+ */
+static uint16_t update(uint32_t stamp)
+{
+    uint16_t keys = scan(), pressed = keys & ~down;
+    uint16_t up = down & ~keys, gone = up & up_once;
+    uint32_t h = q_head;
+    int n;
+
+    up_once = up & ~gone;
+    down = (down & ~gone) | keys;
+    for (n = 0; pressed; n++, pressed >>= 1) {
+        if (!(pressed & 1U))
+            continue;
+        if (h - q_tail == QUEUE_LEN) {
+            keypad_lost++;
+            continue;
+        }
+        q_key[h % QUEUE_LEN] = (uint8_t)(n + 1);
+        q_stamp[h % QUEUE_LEN] = stamp;
+        h++;
+    }
+    q_head = h;
+    return down;
+}
+
+/**
+ * A column went low: stop listening for edges, scan, and rescan from
+ * TIM2 until all keys are up
+ */
+static void on_column(void)
+{
+    uint32_t stamp = DWT->CYCCNT;
+
+    EXTI->IMR &= ~COLS;
+    EXTI->PR = COLS;
+    update(stamp);
+    TIM2->CNT = 0;
+    TIM2->SR  = 0;
+    TIM2->CR1 = 1;                   // CEN
+}
+
+void EXTI0_IRQHandler(void) { on_column(); }
+void EXTI1_IRQHandler(void) { on_column(); }
+void EXTI2_IRQHandler(void) { on_column(); }
+void EXTI3_IRQHandler(void) { on_column(); }
+
+/**
+ * Rescan; with every key released (up at two scans in a row, one scan
+ * interval of debounce), go back to waiting for an edge. A key pressed
+ * between the scan and unmasking EXTI leaves a column low without an
+ * edge, so the columns are checked once more after unmasking.
+ */
+void TIM2_IRQHandler(void)
+{
+    uint32_t stamp = DWT->CYCCNT, cols;
+
+    TIM2->SR = 0;
+    if (update(stamp))
+        return;
+
+    TIM2->CR1 = 0;
+    EXTI->PR  = COLS;
+    EXTI->IMR |= COLS;
+    cols = ~GPIOC->IDR & COLS;
+    if (cols)
+        EXTI->SWIER = cols;
+}
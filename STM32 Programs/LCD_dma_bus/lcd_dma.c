@@ -0,0 +1,230 @@
+/**
+ * lcd_dma.c - HD44780 writes played out by TIM1 and DMA2, no CPU per bus
+ *             cycle
+ *
+ * Every TIM1 period (42 us, over the 41 us a data write takes) carries one
+ * bus write, as four DMA requests at 16 MHz timer ticks:
+ *
+ *   CNT = 0    UP   DMA2 Stream5 Ch6  data[i] -> GPIOC->BSRR   D0..D7
+ *   CNT = 2    CC1  DMA2 Stream1 Ch6  rs[i]   -> GPIOB->BSRR   RS
+ *   CNT = 4    CC2  DMA2 Stream2 Ch6  EN high -> GPIOB->BSRR
+ *   CNT = 10   CC3  DMA2 Stream6 Ch6  EN low  -> GPIOB->BSRR   latch
+ *
+ * giving 125 ns RS setup (40 ns needed), a 375 ns EN pulse (230 ns) and
+ * 625 ns data setup (80 ns); data and RS then hold until the next period.
+ * data[] and rs[] are compiled per string, the EN words are constants read
+ * without memory increment. All four streams count the same NDTR down and
+ * stop by themselves; the Stream6 transfer-complete interrupt is the end of
+ * the string, where the next queued string is armed before the following
+ * update, or TIM1 stops.
+ *
+ * Starting from idle, CNT is set past CC3, so the first request of a
+ * string is an update and the streams stay in step. Clear and return home
+ * (1.52 ms) do not fit the fixed period and are only sent by
+ * lcd_dma_init().
+ */
+
+#include "stm32f4xx.h"
+#include "lcd_dma.h"
+
+#define RS   0x20U                      // PB5
+#define RW   0x40U                      // PB6
+#define EN   0x80U                      // PB7
+
+#define PERIOD_TICKS   (42 * 16)        // 42 us at 16 MHz
+#define CC_RS          2
+#define CC_EN_HIGH     4
+#define CC_EN_LOW      10
+
+#define DATA_STREAM    DMA2_Stream5
+#define RS_STREAM      DMA2_Stream1
+#define ENH_STREAM     DMA2_Stream2
+#define ENL_STREAM     DMA2_Stream6
+
+#define CR_TABLE       0x0C005440U      // Channel6, 32-bit, MINC, mem-to-periph
+#define CR_CONST       0x0C005040U      // Channel6, 32-bit, mem-to-periph
+#define CR_CONST_TC    0x0C005050U      // ... + TCIE
+#define IFCR_ALL       0x003D0F40U      // Stream1+2 (LIFCR), Stream5+6 (HIFCR)
+
+struct job
+{
+    uint32_t        data[LCD_DMA_MAX_CHARS + 1];   // GPIOC->BSRR words
+    uint32_t        rs[LCD_DMA_MAX_CHARS + 1];     // GPIOB->BSRR words
+    uint32_t        n;
+    lcd_dma_done_fn done;
+    void           *arg;
+};
+
+static const uint32_t en_high = EN;
+static const uint32_t en_low  = EN << 16;
+
+static struct job jobs[LCD_DMA_QUEUE];
+static volatile uint32_t head, tail;    // free-running; index with & (LCD_DMA_QUEUE - 1)
+static volatile uint8_t  running;       // TIM1 enabled
+
+volatile uint32_t lcd_dma_bytes;
+volatile uint32_t lcd_dma_isr_max;
+volatile uint32_t lcd_dma_isr_total;
+
+static void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
+
+/**
+ * One bus write by the CPU, for the init sequence only
+ */
+static void write(uint32_t rs, uint8_t byte)
+{
+    GPIOC->BSRR = byte | ((uint32_t)(uint8_t)~byte << 16);
+    GPIOB->BSRR = rs ? RS : RS << 16;
+    GPIOB->BSRR = EN;
+    __NOP(); __NOP(); __NOP(); __NOP();  // PW_EH >= 230 ns
+    GPIOB->BSRR = EN << 16;
+}
+
+static void stream_start(DMA_Stream_TypeDef *s, const uint32_t *src, volatile uint32_t *bsrr,
+                         uint32_t n, uint32_t cr)
+{
+    s->PAR  = (uint32_t)bsrr;
+    s->M0AR = (uint32_t)src;
+    s->NDTR = n;
+    s->FCR  = 0;                        // direct mode
+    s->CR   = cr;
+    s->CR   = cr | 1U;                  // EN
+}
+
+/**
+ * Arm the four streams for the string at tail
+ */
+static void start(struct job *j)
+{
+    DMA2->LIFCR = IFCR_ALL;
+    DMA2->HIFCR = IFCR_ALL;
+    stream_start(DATA_STREAM, j->data, &GPIOC->BSRR, j->n, CR_TABLE);
+    stream_start(RS_STREAM, j->rs, &GPIOB->BSRR, j->n, CR_TABLE);
+    stream_start(ENH_STREAM, &en_high, &GPIOB->BSRR, j->n, CR_CONST);
+    stream_start(ENL_STREAM, &en_low, &GPIOB->BSRR, j->n, CR_CONST_TC);
+}
+
+/**
+ * Ports, the 8-bit init sequence by delays, TIM1 requests and the Stream6
+ * interrupt; TIM1 only runs while there is something to send
+ */
+void lcd_dma_init(void)
+{
+    RCC->AHB1ENR |= (1U << 1) | (1U << 2) | (1U << 22);  // GPIOB, GPIOC, DMA2 clocks
+    RCC->APB2ENR |= (1U << 0);                           // TIM1 clock
+
+    GPIOB->BSRR  = (EN | RW) << 16;                      // EN and R/W low
+    GPIOB->MODER = (GPIOB->MODER & ~0x0000FC00) | 0x00005400;    // PB5..PB7 outputs
+    GPIOC->MODER = (GPIOC->MODER & ~0x0000FFFF) | 0x00005555;    // PC0..PC7 outputs
+
+    delayMs(30);
+    write(0, 0x30);                     // function set, 8-bit
+    delayMs(10);
+    write(0, 0x30);
+    delayMs(1);
+    write(0, 0x30);
+    delayMs(1);
+    write(0, 0x38);                     // 8-bit, 2 lines, 5x7
+    delayMs(1);
+    write(0, 0x06);                     // increment, no shift
+    delayMs(1);
+    write(0, 0x0C);                     // display on, no cursor
+    delayMs(1);
+    write(0, 0x01);                     // clear
+    delayMs(2);
+
+    CoreDebug->DEMCR |= (1U << 24);     // TRCENA
+    DWT->CTRL |= 1U;                    // CYCCNTENA
+
+    TIM1->CR1  = 0;
+    TIM1->PSC  = 0;                     // 16 MHz
+    TIM1->ARR  = PERIOD_TICKS - 1;
+    TIM1->CCR1 = CC_RS;
+    TIM1->CCR2 = CC_EN_HIGH;
+    TIM1->CCR3 = CC_EN_LOW;
+    TIM1->EGR  = 1;                     // UG: load PSC
+    TIM1->SR   = 0;
+    TIM1->DIER = (1U << 8) | (1U << 9) | (1U << 10) | (1U << 11);  // UDE, CC1DE..CC3DE
+    NVIC_EnableIRQ(DMA2_Stream6_IRQn);
+}
+
+/**
+ * Compile s into the next free slot and start TIM1 if it is idle.
+ * Returns 0 if the queue is full.
+ */
+int lcd_dma_puts(uint8_t addr, const char *s, lcd_dma_done_fn done, void *arg)
+{
+    struct job *j;
+    uint32_t n = 0, rs_data = RS, h = head;
+    uint8_t c;
+
+    if (h - tail == LCD_DMA_QUEUE)
+        return 0;
+    j = &jobs[h & (LCD_DMA_QUEUE - 1U)];
+
+    if (addr != LCD_DMA_HERE) {
+        c = (uint8_t)(0x80U | addr);    // set DDRAM address
+        j->data[n] = c | ((uint32_t)(uint8_t)~c << 16);
+        j->rs[n++] = RS << 16;
+    }
+    while (*s && n < sizeof(j->data) / sizeof(j->data[0])) {
+        c = (uint8_t)*s++;
+        j->data[n] = c | ((uint32_t)(uint8_t)~c << 16);
+        j->rs[n++] = rs_data;
+    }
+    if (n == 0)
+        return 1;
+    j->n    = n;
+    j->done = done;
+    j->arg  = arg;
+
+    __DMB();                            // slot written before it is published
+    __disable_irq();
+    head = h + 1U;
+    if (!running) {
+        running = 1;
+        start(j);
+        TIM1->CNT = CC_EN_LOW + 1;      // first request is the next update
+        TIM1->CR1 = 1;                  // CEN
+    }
+    __enable_irq();
+    return 1;
+}
+
+int lcd_dma_busy(void)
+{
+    return running;
+}
+
+/**
+ * The last EN falling edge of a string: report it, arm the next one
+ */
+void DMA2_Stream6_IRQHandler(void)
+{
+    uint32_t t0 = DWT->CYCCNT, dt;
+    struct job *j = &jobs[tail & (LCD_DMA_QUEUE - 1U)];
+
+    DMA2->HIFCR = 0x003D0000U;          // Stream6 flags
+    lcd_dma_bytes += j->n;
+    tail = tail + 1U;
+    if (j->done)
+        j->done(j->arg);
+
+    if (tail != head) {
+        start(&jobs[tail & (LCD_DMA_QUEUE - 1U)]);   // well before the next update
+    } else {
+        TIM1->CR1 = 0;
+        running = 0;
+    }
+
+    dt = DWT->CYCCNT - t0;
+    lcd_dma_isr_total += dt;
+    if (dt > lcd_dma_isr_max)
+        lcd_dma_isr_max = dt;
+}
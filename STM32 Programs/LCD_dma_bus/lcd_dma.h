@@ -0,0 +1,40 @@
+/**
+ * lcd_dma.h - HD44780 writes played out by TIM1 and DMA2, no CPU per bus
+ *             cycle
+ *
+ * Same wiring as LCD 8bit mode, R/W held low:
+ *   - PC0..PC7 = LCD D0..D7
+ *   - PB5 = RS, PB6 = R/W (low), PB7 = EN
+ *
+ * lcd_dma_puts() compiles a string, with an optional set-DDRAM-address
+ * command in front, into GPIO BSRR words and queues it; TIM1 requests pace
+ * four DMA2 streams that write those words to the ports, one byte per
+ * 42 us period. The callback runs from the DMA interrupt once the last
+ * byte has been latched.
+ *
+ *   lcd_dma_init();
+ *   lcd_dma_puts(0x00, "Hello", NULL, NULL);         line 1, column 0
+ *   lcd_dma_puts(0x40, "world", done, &flag);        line 2
+ *   lcd_dma_puts(LCD_DMA_HERE, "!", NULL, NULL);     where the cursor is
+ */
+
+#ifndef LCD_DMA_H
+#define LCD_DMA_H
+
+#include <stdint.h>
+
+#define LCD_DMA_HERE        0xFFU       // no set-address command
+#define LCD_DMA_MAX_CHARS   40          // per string, longer ones are cut
+#define LCD_DMA_QUEUE       4           // strings queued, power of two
+
+typedef void (*lcd_dma_done_fn)(void *arg);
+
+void lcd_dma_init(void);
+int  lcd_dma_puts(uint8_t addr, const char *s, lcd_dma_done_fn done, void *arg);  // 0 = queue full
+int  lcd_dma_busy(void);                // strings queued or being sent
+
+extern volatile uint32_t lcd_dma_bytes;     // bus writes completed
+extern volatile uint32_t lcd_dma_isr_max;   // DWT cycles per completion interrupt
+extern volatile uint32_t lcd_dma_isr_total;
+
+#endif /* LCD_DMA_H */
@@ -0,0 +1,232 @@
+/**
+ * lcd_fb.c - HD44780 character LCD behind a RAM framebuffer, flushed in
+ *            the background by a timer interrupt
+ *
+ * Two copies of the screen are kept: fb[] is what the application wants,
+ * shown[] is what the LCD holds. A frame is one pass of the TIM4 ISR over
+ * the cells in display order; every tick it finds the next cell where the
+ * two differ and does exactly one bus write:
+ *
+ *   - the address counter already points at the cell: write the character
+ *     (RS = 1); the counter moves on to the next cell by itself
+ *   - otherwise: set DDRAM address (0x80 | addr); the character follows
+ *     on the next tick
+ *
+ * so a run of n changed cells costs n + 1 writes and a screen that did not
+ * change costs none. The pass ends on a tick that finds no difference; if
+ * lcd_fb_flush() was called again meanwhile the next pass starts right
+ * away, otherwise the timer stops.
+ *
+ * Timing:
+ *   Without busy-flag reads the controller gets a fixed 50 us per write,
+ *   over the 37 us (+4 us address update) a write or a set-address command
+ *   takes. Clear and home (1.52 ms) are only sent by lcd_fb_init(). The
+ *   EN pulse is stretched to 250 ns with four NOPs and RS is set one store
+ *   ahead of EN for the 40 ns address setup time.
+ *
+ * DDRAM layout:
+ *   Row r starts at (r & 1) * 0x40 + (r >> 1) * cols, so rows 3 and 4 of a
+ *   20x4 module sit at 0x14 and 0x54, right after rows 1 and 2. The cells
+ *   are stored, and scanned, in DDRAM order (rows 1, 3, 2, 4), and the
+ *   address counter wraps from 0x27 to 0x40, so a complete 20x4 redraw is
+ *   a single run of 80 characters.
+ */
+
+#include "stm32f4xx.h"
+#include "lcd_fb.h"
+
+#define RS   0x20U                      // PB5
+#define RW   0x40U                      // PB6
+#define EN   0x80U                      // PB7
+
+#define NO_ADDR   0xFFU                 // address counter unknown
+
+volatile uint32_t lcd_fb_frames;
+volatile struct lcd_fb_stats lcd_fb_last;
+volatile uint32_t lcd_fb_isr_max;
+
+static char     fb[LCD_FB_MAX_ROWS * LCD_FB_MAX_COLS];
+static char     shown[LCD_FB_MAX_ROWS * LCD_FB_MAX_COLS];
+static uint8_t  addr[LCD_FB_MAX_ROWS * LCD_FB_MAX_COLS];    // DDRAM address of each cell
+static uint8_t  row_start[LCD_FB_MAX_ROWS];                 // first cell of each row
+static unsigned ncols, nrows, ncells;
+
+static unsigned pos;                    // next cell the pass looks at
+static uint8_t  ac = NO_ADDR;           // controller's address counter
+static volatile uint8_t running;        // TIM4 enabled
+static volatile uint8_t again;          // lcd_fb_flush() during a pass
+static struct lcd_fb_stats frame;       // the pass in progress
+
+static void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
+
+/**
+ * One bus write, RS = rs
+ */
+static void write(uint32_t rs, uint8_t byte)
+{
+    GPIOC->BSRR = byte | ((uint32_t)(uint8_t)~byte << 16);   // D0..D7
+    GPIOB->BSRR = rs ? RS : RS << 16;
+    GPIOB->BSRR = EN;
+    __NOP(); __NOP(); __NOP(); __NOP();  // PW_EH >= 230 ns
+    GPIOB->BSRR = EN << 16;             // latched on the falling edge
+}
+
+/**
+ * Ports, the 8-bit init sequence by timing, the address table and TIM4 at
+ * one tick per 50 us (not started until there is something to send)
+ */
+void lcd_fb_init(unsigned cols, unsigned rows)
+{
+    unsigned r, i, line;
+
+    if (cols > LCD_FB_MAX_COLS)
+        cols = LCD_FB_MAX_COLS;
+    if (rows > LCD_FB_MAX_ROWS)
+        rows = LCD_FB_MAX_ROWS;
+    ncols  = cols;
+    nrows  = rows;
+    ncells = cols * rows;
+    line   = cols * ((rows + 1U) / 2U);     // cells per DDRAM line
+    for (r = 0; r < rows; r++)
+        row_start[r] = (uint8_t)((r & 1U) * line + (r >> 1) * cols);
+    for (i = 0; i < ncells; i++) {
+        addr[i] = (uint8_t)((i / line) * 0x40U + i % line);
+        fb[i] = shown[i] = ' ';
+    }
+
+    RCC->AHB1ENR |= (1U << 1) | (1U << 2);  // GPIOB, GPIOC clocks
+    RCC->APB1ENR |= (1U << 2);              // TIM4 clock
+
+    GPIOB->BSRR   = (EN | RW) << 16;        // EN and R/W low
+    GPIOB->MODER  = (GPIOB->MODER & ~0x0000FC00) | 0x00005400;   // PB5..PB7 outputs
+    GPIOC->MODER  = (GPIOC->MODER & ~0x0000FFFF) | 0x00005555;   // PC0..PC7 outputs
+
+    delayMs(30);
+    write(0, 0x30);                     // function set, 8-bit
+    delayMs(10);
+    write(0, 0x30);
+    delayMs(1);
+    write(0, 0x30);
+    delayMs(1);
+    write(0, 0x38);                     // 8-bit, 2 lines (4-line modules too), 5x7
+    delayMs(1);
+    write(0, 0x06);                     // increment, no shift
+    delayMs(1);
+    write(0, 0x0C);                     // display on, no cursor
+    delayMs(1);
+    write(0, 0x01);                     // clear: matches shown[]
+    delayMs(2);
+    ac = 0x00;                          // clear homes the address counter
+
+    CoreDebug->DEMCR |= (1U << 24);     // TRCENA
+    DWT->CTRL |= 1U;                    // CYCCNTENA
+
+    TIM4->PSC  = 16 - 1;                // 1 MHz
+    TIM4->ARR  = 50 - 1;                // 50 us per bus write
+    TIM4->DIER = 1;                     // UIE
+    NVIC_EnableIRQ(TIM4_IRQn);
+}
+
+void lcd_fb_putc(unsigned row, unsigned col, char c)
+{
+    if (col < ncols && row < nrows)
+        fb[row_start[row] + col] = c;
+}
+
+void lcd_fb_puts(unsigned row, unsigned col, const char *s)
+{
+    for (; *s && col < ncols; s++, col++)
+        lcd_fb_putc(row, col, *s);
+}
+
+void lcd_fb_clear(void)
+{
+    unsigned i;
+
+    for (i = 0; i < ncells; i++)
+        fb[i] = ' ';
+}
+
+/**
+ * Ask for the current framebuffer to be sent; starts TIM4 if it is idle
+ */
+void lcd_fb_flush(void)
+{
+    __disable_irq();
+    if (running) {
+        again = 1;                      // cells behind the pass are caught next time
+    } else {
+        running = 1;
+        pos = 0;
+        TIM4->CNT = 0;
+        TIM4->CR1 = 1;                  // CEN
+    }
+    __enable_irq();
+}
+
+int lcd_fb_busy(void)
+{
+    return running;
+}
+
+/**
+ * One bus write per tick, or the end of the pass
+ */
+void TIM4_IRQHandler(void)
+{
+    uint32_t t0 = DWT->CYCCNT, dt;
+    unsigned i = pos;
+
+    TIM4->SR = 0;
+    frame.ticks++;
+
+    while (i < ncells && fb[i] == shown[i])
+        i++;
+
+    if (i < ncells) {
+        if (addr[i] == ac) {
+            char c = fb[i];
+            write(1, (uint8_t)c);
+            shown[i] = c;
+            ac = (ac == 0x27U) ? 0x40U : (uint8_t)(ac + 1U);
+            frame.data++;
+            i++;
+        } else {
+            write(0, (uint8_t)(0x80U | addr[i]));
+            ac = addr[i];
+            frame.commands++;
+        }
+        pos = i;
+    } else {
+        /* Pass complete: publish its cost, then go again or stop */
+        dt = DWT->CYCCNT - t0;
+        frame.cycles += dt;
+        lcd_fb_last.commands = frame.commands;
+        lcd_fb_last.data     = frame.data;
+        lcd_fb_last.ticks    = frame.ticks;
+        lcd_fb_last.cycles   = frame.cycles;
+        frame.commands = frame.data = frame.ticks = frame.cycles = 0;
+        lcd_fb_frames++;
+        pos = 0;
+        if (again) {
+            again = 0;
+        } else {
+            TIM4->CR1 = 0;
+            running = 0;
+        }
+        if (dt > lcd_fb_isr_max)
+            lcd_fb_isr_max = dt;
+        return;
+    }
+
+    dt = DWT->CYCCNT - t0;
+    frame.cycles += dt;
+    if (dt > lcd_fb_isr_max)
+        lcd_fb_isr_max = dt;
+}
@@ -0,0 +1,50 @@
+/**
+ * lcd_fb.h - HD44780 character LCD behind a RAM framebuffer, flushed in
+ *            the background by a timer interrupt
+ *
+ * Same wiring as LCD 8bit mode, except that R/W stays low:
+ *   - PC0..PC7 = LCD D0..D7
+ *   - PB5 = RS, PB6 = R/W (held low), PB7 = EN
+ *
+ * The application writes characters into RAM and asks for a frame with
+ * lcd_fb_flush(). TIM4 then sends the cells that differ from what the LCD
+ * already shows, one bus write per 50 us tick, and stops once the screen
+ * matches. Runs of changed cells go out back to back on the controller's
+ * address counter; a set-DDRAM-address command is only sent in front of a
+ * cell the counter does not already point at.
+ *
+ *   lcd_fb_init(16, 2);                  or 20, 4
+ *   lcd_fb_puts(0, 0, "Temp");
+ *   lcd_fb_putc(1, 15, '*');
+ *   lcd_fb_flush();                      returns at once
+ */
+
+#ifndef LCD_FB_H
+#define LCD_FB_H
+
+#include <stdint.h>
+
+#define LCD_FB_MAX_COLS   20
+#define LCD_FB_MAX_ROWS   4
+
+/* Cost of the last complete frame */
+struct lcd_fb_stats
+{
+    uint32_t commands;                  // set-DDRAM-address writes
+    uint32_t data;                      // character writes
+    uint32_t ticks;                     // TIM4 interrupts
+    uint32_t cycles;                    // DWT cycles spent in them
+};
+
+void lcd_fb_init(unsigned cols, unsigned rows);
+void lcd_fb_putc(unsigned row, unsigned col, char c);
+void lcd_fb_puts(unsigned row, unsigned col, const char *s);   // clipped at the row end
+void lcd_fb_clear(void);
+void lcd_fb_flush(void);
+int  lcd_fb_busy(void);                 // a frame is being sent
+
+extern volatile uint32_t lcd_fb_frames;
+extern volatile struct lcd_fb_stats lcd_fb_last;
+extern volatile uint32_t lcd_fb_isr_max;
+
+#endif /* LCD_FB_H */
@@ -0,0 +1,144 @@
+/**
+ * main.c - Clock and frame counter on an HD44780 framebuffer (STM32F401RE)
+ *
+ * LCD 8bit mode writes every character synchronously: LCD_data() turns
+ * PC0..PC7 into inputs, spins on the busy flag and only then writes. Here
+ * main() writes a tenths-of-a-second clock and a frame counter into RAM
+ * every 100 ms and calls lcd_fb_flush(); TIM4 sends only the cells that
+ * changed, while main() goes on.
+ *
+ * The cost of the first frame (the whole layout) and, once a second, the
+ * average over the frames since then are printed over USART2 at 9600 baud,
+ * next to what redrawing every cell would take (one address command per
+ * row plus one write per cell). On the host simulator, 16x2:
+ *   first frame: 3 commands + 20 data = 23 writes, 24 ticks, 880 cycles
+ *   2 s: 10 frames, 2.1 commands + 2.2 data per frame (full redraw 34),
+ *        169 cycles per frame, ISR max 38
+ * With LCD_COLS 20, LCD_ROWS 4 (simulator --lcd 20x4) the third row is a
+ * caption and the fourth a bouncing marker:
+ *   2 s: 10 frames, 3.1 commands + 4.2 data per frame (full redraw 84),
+ *        283 cycles per frame, ISR max 38
+ * Each frame costs about 7 writes of 50 us instead of 34 or 84 writes with
+ * a busy-flag poll in front of each. The simulator charges only the
+ * register accesses; on the board the scan over unchanged cells adds a
+ * few cycles per cell, still a fraction of one busy-flag poll.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PC0..PC7 = LCD D0..D7
+ *   - PB5 = LCD RS, PB6 = LCD R/W (low), PB7 = LCD EN
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "lcd_fb.h"
+
+#define LCD_COLS   16                   // 20 for a 20x4 module
+#define LCD_ROWS   2                    // 4
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void delayMs(int n);
+
+int main(void)
+{
+    unsigned tenths = 0, frames = 0, marker = 0;
+    uint32_t commands = 0, data = 0, cycles = 0;
+    char line[LCD_FB_MAX_COLS + 1];
+
+    USART2_init();
+    lcd_fb_init(LCD_COLS, LCD_ROWS);
+
+    lcd_fb_puts(0, 0, "Uptime");
+    lcd_fb_puts(1, 0, "Frames");
+    if (LCD_ROWS > 2)
+        lcd_fb_puts(2, 0, "HD44780 framebuffer");
+
+    while (1)
+    {
+        sprintf(line, "%02u:%02u.%u", tenths / 600, tenths / 10 % 60, tenths % 10);
+        lcd_fb_puts(0, LCD_COLS - 7, line);
+        sprintf(line, "%6u", tenths);
+        lcd_fb_puts(1, LCD_COLS - 6, line);
+        if (LCD_ROWS > 3) {
+            lcd_fb_putc(3, marker, ' ');
+            marker = (tenths / LCD_COLS) & 1U ? LCD_COLS - 1 - tenths % LCD_COLS : tenths % LCD_COLS;
+            lcd_fb_putc(3, marker, '*');
+        }
+        lcd_fb_flush();
+
+        delayMs(100);                   // the frame is long done by now
+        tenths++;
+
+        if (tenths == 1) {
+            printf("first frame: %lu commands + %lu data = %lu writes, %lu ticks, %lu cycles\r\n",
+                   (unsigned long)lcd_fb_last.commands, (unsigned long)lcd_fb_last.data,
+                   (unsigned long)(lcd_fb_last.commands + lcd_fb_last.data),
+                   (unsigned long)lcd_fb_last.ticks, (unsigned long)lcd_fb_last.cycles);
+            continue;
+        }
+        commands += lcd_fb_last.commands;
+        data     += lcd_fb_last.data;
+        cycles   += lcd_fb_last.cycles;
+        frames++;
+
+        if (tenths % 10 == 0) {
+            printf("%u s: %u frames, %lu.%lu commands + %lu.%lu data per frame (full redraw %u), "
+                   "%lu cycles per frame, ISR max %lu\r\n",
+                   tenths / 10, frames,
+                   (unsigned long)(commands / frames), (unsigned long)(commands * 10 / frames % 10),
+                   (unsigned long)(data / frames), (unsigned long)(data * 10 / frames % 10),
+                   LCD_ROWS + LCD_ROWS * LCD_COLS,
+                   (unsigned long)(cycles / frames), (unsigned long)lcd_fb_isr_max);
+            commands = data = cycles = 0;
+            frames = 0;
+        }
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
+
+/**
+ * Approximate delay in ms for a ~16 MHz clock (3195 loops per ms)
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
@@ -0,0 +1,179 @@
+/**
+ * glyph.c - HD44780 CGRAM as an 8-slot LRU cache of custom characters,
+ *           with horizontal bar graphs and sparklines built on it
+ *
+ * Lookup:
+ *   FNV-1a over the 8 row bytes is the key; a slot whose hash matches is
+ *   confirmed against its stored bitmap, so a collision costs a reload,
+ *   never a wrong glyph. Eight slots are searched linearly.
+ *
+ * Replacement:
+ *   Every hit or load stamps the slot with a running counter and with the
+ *   current frame number. The victim is an empty slot, else the one with
+ *   the oldest stamp among those not used in this frame. A load is one
+ *   set-CGRAM-address command and eight data writes.
+ *
+ * Bar graph:
+ *   Full cells are the ROM block 0xFF, empty cells a space; only the one
+ *   partly filled cell needs a glyph, one of four (1..4 columns lit), so
+ *   a moving bar keeps reusing the same four slots.
+ *
+ * Sparkline:
+ *   Five samples per cell. The caller scrolls a whole cell at a time, so
+ *   after a scroll every cell but the newest shows a bitmap that is
+ *   already loaded: only the cell receiving samples misses.
+ */
+
+#include "stm32f4xx.h"
+#include "lcd_timed.h"
+#include "glyph.h"
+
+struct slot
+{
+    uint32_t hash;
+    uint32_t stamp;                     // LRU order
+    uint32_t frame;                     // last frame that used the slot
+    uint8_t  bits[8];
+    uint8_t  valid;
+};
+
+static struct slot slots[GLYPH_SLOTS];
+static uint32_t    now, frame_no = 1;
+
+uint32_t glyph_requests;
+uint32_t glyph_misses;
+uint32_t glyph_cgram_writes;
+uint32_t glyph_overflows;
+
+static uint32_t hash8(const uint8_t bits[8])
+{
+    uint32_t h = 2166136261U;
+    int i;
+
+    for (i = 0; i < 8; i++)
+        h = (h ^ bits[i]) * 16777619U;
+    return h;
+}
+
+static int same(const uint8_t *a, const uint8_t *b)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+        if (a[i] != b[i])
+            return 0;
+    return 1;
+}
+
+void glyph_init(void)
+{
+    int i;
+
+    for (i = 0; i < GLYPH_SLOTS; i++)
+        slots[i].valid = 0;
+    frame_no++;
+}
+
+/**
+ * Start of a screen update: slots from earlier frames may be replaced
+ */
+void glyph_frame(void)
+{
+    frame_no++;
+}
+
+int glyph_get(const uint8_t bits[8])
+{
+    uint32_t h = hash8(bits);
+    struct slot *s, *victim = 0;
+    int i, r;
+
+    glyph_requests++;
+    now++;
+    for (i = 0; i < GLYPH_SLOTS; i++) {
+        s = &slots[i];
+        if (s->valid && s->hash == h && same(s->bits, bits)) {
+            s->stamp = now;
+            s->frame = frame_no;
+            return GLYPH_CODE0 + i;
+        }
+    }
+
+    for (i = 0; i < GLYPH_SLOTS; i++) {
+        s = &slots[i];
+        if (!s->valid) {
+            victim = s;
+            break;
+        }
+        if (s->frame != frame_no && (!victim || (int32_t)(s->stamp - victim->stamp) < 0))
+            victim = s;
+    }
+    if (!victim) {
+        glyph_overflows++;
+        return -1;
+    }
+
+    i = (int)(victim - slots);
+    LCD_command((unsigned char)(0x40U | (i << 3)));  // set CGRAM address
+    for (r = 0; r < 8; r++) {
+        victim->bits[r] = bits[r];
+        LCD_data((char)bits[r]);
+    }
+    victim->hash  = h;
+    victim->stamp = now;
+    victim->frame = frame_no;
+    victim->valid = 1;
+    glyph_misses++;
+    glyph_cgram_writes += 9;
+    return GLYPH_CODE0 + i;
+}
+
+void glyph_bar(char *out, unsigned cells, unsigned value, unsigned full)
+{
+    uint32_t lit = full ? (uint32_t)value * cells * 5U / full : 0;
+    uint8_t bits[8];
+    unsigned i;
+    int code, r;
+
+    if (lit > cells * 5U)
+        lit = cells * 5U;
+    for (i = 0; i < cells; i++, lit = lit > 5U ? lit - 5U : 0) {
+        if (lit >= 5U) {
+            out[i] = (char)0xFF;        // ROM full block
+        } else if (lit == 0) {
+            out[i] = ' ';
+        } else {
+            for (r = 0; r < 8; r++)
+                bits[r] = (uint8_t)((0x1FU << (5U - lit)) & 0x1FU);
+            code = glyph_get(bits);
+            out[i] = code < 0 ? '|' : (char)code;
+        }
+    }
+    out[cells] = '\0';
+}
+
+void glyph_spark(char *out, const uint8_t *heights, unsigned n)
+{
+    unsigned cells = (n + 4U) / 5U, c, x, k;
+    uint8_t bits[8], any, h;
+    int code, r;
+
+    for (c = 0; c < cells; c++) {
+        any = 0;
+        for (r = 0; r < 8; r++)
+            bits[r] = 0;
+        for (x = 0; x < 5U && (k = c * 5U + x) < n; x++) {
+            h = heights[k] > 8U ? 8U : heights[k];
+            for (r = 8 - h; r < 8; r++)
+                bits[r] |= (uint8_t)(0x10U >> x);
+            any |= h;
+        }
+        if (!any) {
+            out[c] = ' ';
+            continue;
+        }
+        code = glyph_get(bits);
+        out[c] = code < 0 ? '?' : (char)code;
+    }
+    out[cells] = '\0';
+}
@@ -0,0 +1,44 @@
+/**
+ * glyph.h - HD44780 CGRAM as an 8-slot LRU cache of custom characters,
+ *           with horizontal bar graphs and sparklines built on it
+ *
+ * A glyph is 8 rows of 5 pixels (bit 4 = left column). glyph_get() hashes
+ * the bitmap and returns the character code of the slot already holding
+ * it, or loads it into the least recently used slot first. Slots used
+ * since the last glyph_frame() are never replaced, so everything drawn in
+ * one screen update stays correct; if a frame needs more than 8 different
+ * glyphs, glyph_get() returns -1.
+ *
+ * Loading a slot leaves the controller's address counter in CGRAM: build
+ * a line first, then set the DDRAM address and write it.
+ *
+ *   glyph_frame();
+ *   glyph_bar(line, 7, mv, 3300);        7 cells, 35 steps
+ *   LCD_command(0x80);
+ *   LCD_puts(line);
+ */
+
+#ifndef GLYPH_H
+#define GLYPH_H
+
+#include <stdint.h>
+
+#define GLYPH_SLOTS   8
+#define GLYPH_CODE0   8                 // CGRAM codes 8..15, never a string end
+
+void glyph_init(void);
+void glyph_frame(void);
+int  glyph_get(const uint8_t bits[8]);  // character code, -1 if all slots are in use
+
+/* Bar of 'cells' characters, value / full of its 5 * cells columns lit */
+void glyph_bar(char *out, unsigned cells, unsigned value, unsigned full);
+
+/* One pixel column per sample, heights 0..8 (more is drawn as 8), 5 per cell */
+void glyph_spark(char *out, const uint8_t *heights, unsigned n);
+
+extern uint32_t glyph_requests;         // glyph_get() calls
+extern uint32_t glyph_misses;           // slots loaded
+extern uint32_t glyph_cgram_writes;     // bus writes spent loading them (9 per miss)
+extern uint32_t glyph_overflows;        // requests with no slot left
+
+#endif /* GLYPH_H */
@@ -0,0 +1,39 @@
+/**
+ * lcd_timed.h - HD44780 8-bit driver that waits on the busy flag or on a
+ *               table of execution times
+ *
+ * Same wiring as LCD 8bit mode:
+ *   - PC0..PC7 = LCD D0..D7
+ *   - PB5 = RS, PB6 = R/W, PB7 = EN
+ *
+ * LCD_BUSY_FLAG polls BF before every write, as LCD_ready() does. LCD_TIMED
+ * never reads the controller: every write is followed by the execution
+ * time of its instruction, taken from a table, and the next write waits
+ * for that point on TIM2's microsecond counter. R/W stays low in that mode
+ * (the pin can be tied to GND) and PC0..PC7 stay outputs.
+ *
+ *   LCD_init(LCD_TIMED);
+ *   LCD_command(0x80);                   set DDRAM address 0
+ *   LCD_puts("Hello");
+ *   if (LCD_idle()) ...                  a write now would not wait
+ */
+
+#ifndef LCD_TIMED_H
+#define LCD_TIMED_H
+
+#include <stdint.h>
+
+#define LCD_BUSY_FLAG   0
+#define LCD_TIMED       1
+
+void LCD_init(int mode);
+void LCD_command(unsigned char cmd);
+void LCD_data(char data);
+void LCD_puts(const char *s);
+int  LCD_idle(void);
+uint32_t LCD_us(void);                  // TIM2, 1 MHz, free-running
+
+extern volatile uint32_t lcd_polls;     // busy-flag reads (LCD_BUSY_FLAG)
+extern volatile uint32_t lcd_wait_us;   // time spent waiting (LCD_TIMED)
+
+#endif /* LCD_TIMED_H */
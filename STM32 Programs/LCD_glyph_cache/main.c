@@ -0,0 +1,168 @@
+/**
+ * main.c - Live bar graph and sparkline from CGRAM glyphs (STM32F401RE)
+ *
+ * Every 50 ms PA0 (ADC1 channel 0) and the temperature sensor are read
+ * and the 16x2 LCD is redrawn:
+ *
+ *   ADC 1.65V ####:      voltage and a 7-cell bar, 35 steps
+ *   .:+#+:.:+ T 30.0C    last 35 samples of PA0 as a sparkline
+ *
+ * All custom characters come from the glyph cache. Every 5 s the cache
+ * statistics are printed over USART2 at 9600 baud, against a driver that
+ * redefines each custom character it shows in every frame. On the host
+ * simulator with a slow sine on PA0 (--adc 0=1650:1500:0.5):
+ *   5 s: 100 frames, 681 glyphs, 163 loaded, 1467 CGRAM writes instead
+ *        of 6129 (77% avoided), 0 overflows
+ *   5 s: 100 frames, 785 glyphs, 172 loaded, 1548 CGRAM writes instead
+ *        of 7065 (79% avoided), 0 overflows
+ * About 1.7 loads per frame: the bar's partial cell and the sparkline
+ * cell taking samples. The scroll by a whole cell only moves bitmaps that
+ * are already loaded, and repeated shapes share one slot.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PC0..PC7 = LCD D0..D7
+ *   - PB5 = LCD RS, PB6 = LCD R/W (low), PB7 = LCD EN
+ *   - PA0 = ADC1_IN0
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "lcd_timed.h"
+#include "glyph.h"
+
+#define SAMPLES   35                    // 7 sparkline cells
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void delayMs(int n);
+void ADC1_init(void);
+uint32_t ADC1_read(uint32_t ch);
+
+int main(void)
+{
+    uint8_t hist[SAMPLES];
+    unsigned n = 0, frames = 0;
+    uint32_t mv, req0 = 0, miss0 = 0, writes0 = 0;
+    int32_t t10;
+    char line[2][17];
+
+    USART2_init();
+    ADC1_init();
+    LCD_init(LCD_TIMED);
+    glyph_init();
+
+    while (1)
+    {
+        mv  = ADC1_read(0) * 3300U / 4095U;
+        t10 = ((int32_t)(ADC1_read(18) * 3300U / 4095U) - 760) * 4 + 250;   // 2.5 mV/degC, 0.76 V at 25
+
+        /* Scroll by a whole cell once the last one is full */
+        if (n == SAMPLES) {
+            for (n = 0; n < SAMPLES - 5; n++)
+                hist[n] = hist[n + 5];
+        }
+        hist[n++] = (uint8_t)(1U + mv * 7U / 3300U);
+
+        glyph_frame();
+        sprintf(line[0], "ADC %lu.%02luV", (unsigned long)(mv / 1000U), (unsigned long)(mv % 1000U / 10U));
+        glyph_bar(&line[0][9], 7, mv, 3300);
+        glyph_spark(line[1], hist, n);
+        sprintf(&line[1][(n + 4U) / 5U], "%*s T %2ld.%ldC", 7 - (int)((n + 4U) / 5U), "",
+                (long)(t10 / 10), (long)(t10 < 0 ? -t10 % 10 : t10 % 10));
+
+        LCD_command(0x80);
+        LCD_puts(line[0]);
+        LCD_command(0xC0);
+        LCD_puts(line[1]);
+
+        if (++frames == 100) {
+            uint32_t req = glyph_requests - req0, miss = glyph_misses - miss0;
+            uint32_t writes = glyph_cgram_writes - writes0;
+
+            printf("5 s: %u frames, %lu glyphs, %lu loaded, %lu CGRAM writes instead of %lu "
+                   "(%lu%% avoided), %lu overflows\r\n",
+                   frames, (unsigned long)req, (unsigned long)miss, (unsigned long)writes,
+                   (unsigned long)(req * 9U), (unsigned long)(100U - writes * 100U / (req * 9U)),
+                   (unsigned long)glyph_overflows);
+            req0 = glyph_requests;
+            miss0 = glyph_misses;
+            writes0 = glyph_cgram_writes;
+            frames = 0;
+        }
+        delayMs(50);
+    }
+}
+
+/**
+ * PA0 analog, temperature sensor on, ADC1 software triggered
+ */
+void ADC1_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);      // GPIOA clock
+    RCC->APB2ENR |= (1U << 8);      // ADC1 clock
+    GPIOA->MODER |= 3U;             // PA0 analog
+
+    ADC->CCR |= (1U << 23);         // TSVREFE: temperature sensor on
+    ADC1->SMPR1 = (3U << 24);       // channel 18: 56 cycles (10 us min)
+    ADC1->SQR1 = 0;                 // one conversion
+    ADC1->CR2 = 1;                  // ADON
+}
+
+/**
+ * One conversion of channel ch
+ */
+uint32_t ADC1_read(uint32_t ch)
+{
+    ADC1->SQR3 = ch;
+    ADC1->CR2 |= (1U << 30);        // SWSTART
+    while (!(ADC1->SR & (1U << 1))) {}   // EOC
+    return ADC1->DR;
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
+
+/**
+ * Approximate delay in ms for a ~16 MHz clock (3195 loops per ms)
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
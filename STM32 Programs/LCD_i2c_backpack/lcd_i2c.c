@@ -0,0 +1,225 @@
+/**
+ * lcd_i2c.c - HD44780 16x2 through a PCF8574 backpack on I2C1, whole
+ *             strings per I2C burst by DMA
+ *
+ * Packing:
+ *   Each LCD byte is two nibbles, each written as EN high with the nibble
+ *   and RS, then EN low with the same bits (the LCD latches on the
+ *   falling edge): four PCF8574 bytes per character. When RS changes, one
+ *   extra byte with EN low sets it up first, so it never changes together
+ *   with a rising EN.
+ *
+ * Timing:
+ *   The I2C bus is the clock. A byte takes nine SCL periods, 90 us at
+ *   100 kHz and 23.6 us at 381 kHz (CCR = 14, the nearest to 400 kHz with
+ *   a 16 MHz PCLK1); the next character's first EN fall comes two bytes
+ *   after the last one, 47 us later, past the 41 us the LCD needs. Clear
+ *   and home (1.52 ms) are only sent by lcd_i2c_init(), with a delay.
+ *
+ * Burst:
+ *   START and the address go out from the I2C1 event interrupt (SB, ADDR);
+ *   after ADDR, TXE requests DMA1 Stream7 Channel 1 to feed DR until the
+ *   buffer is empty, and BTF, set once the last byte has left, ends the
+ *   transaction with STOP.
+ */
+
+#include "stm32f4xx.h"
+#include "lcd_i2c.h"
+
+#define P_RS   0x01U
+#define P_EN   0x04U
+#define P_BL   0x08U                    // backlight always on
+
+#define TX_STREAM   DMA1_Stream7
+#define TX_CR       0x02000440U         // Channel1, 8-bit, MINC, mem-to-periph
+
+static uint8_t buf[(1 + LCD_I2C_MAX_CHARS) * 4 + 2];
+static uint32_t len;
+static volatile uint8_t running;
+
+volatile uint32_t lcd_i2c_bytes;
+volatile uint32_t lcd_i2c_transactions;
+
+static void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
+
+/**
+ * I2C1 on PB8 (SCL) / PB9 (SDA), 100 kHz standard or 381 kHz fast mode
+ */
+static void I2C1_init(uint32_t khz)
+{
+    RCC->AHB1ENR |= (1U << 1) | (1U << 21);     // GPIOB, DMA1 clocks
+    RCC->APB1ENR |= (1U << 21);                 // I2C1 clock
+
+    GPIOB->AFR[1] &= ~((0xFU << 0) | (0xFU << 4));
+    GPIOB->AFR[1] |=  ((4U << 0) | (4U << 4));  // PB8, PB9 AF4 (I2C1)
+    GPIOB->MODER  &= ~((3U << 16) | (3U << 18));
+    GPIOB->MODER  |=  ((2U << 16) | (2U << 18));
+    GPIOB->OTYPER |=  (1U << 8) | (1U << 9);    // open-drain
+    GPIOB->PUPDR  &= ~((3U << 16) | (3U << 18));
+    GPIOB->PUPDR  |=  ((1U << 16) | (1U << 18));// pull-ups
+
+    I2C1->CR1 = (1U << 15);             // software reset
+    I2C1->CR1 = 0;
+    I2C1->CR2 = 16U;                    // PCLK1 = 16 MHz
+    if (khz > 100) {
+        I2C1->CCR   = (1U << 15) | 14U; // fast mode, Tlow:Thigh 2:1, 381 kHz
+        I2C1->TRISE = 6U;               // 300 ns
+    } else {
+        I2C1->CCR   = 80U;              // 100 kHz
+        I2C1->TRISE = 17U;              // 1000 ns
+    }
+    I2C1->CR1 = 1U;                     // PE
+}
+
+/**
+ * One single-byte write transaction, polled
+ */
+static void I2C1_byteWrite(uint8_t saddr, uint8_t data)
+{
+    volatile int tmp;
+
+    while (I2C1->SR2 & (1U << 1)) {}    // bus not busy
+    I2C1->CR1 |= (1U << 8);             // START
+    while (!(I2C1->SR1 & (1U << 0))) {} // SB
+    I2C1->DR = (uint8_t)(saddr << 1);
+    while (!(I2C1->SR1 & (1U << 1))) {} // ADDR
+    tmp = I2C1->SR2;
+    (void)tmp;
+    I2C1->DR = data;
+    while (!(I2C1->SR1 & (1U << 2))) {} // BTF
+    I2C1->CR1 |= (1U << 9);             // STOP
+    lcd_i2c_bytes++;
+    lcd_i2c_transactions++;
+}
+
+/**
+ * PCF8574 bytes for one LCD byte; rs_now tracks RS across calls
+ */
+static uint32_t pack(uint8_t *out, uint8_t byte, uint8_t rs, uint8_t *rs_now)
+{
+    uint8_t hi = (uint8_t)((byte & 0xF0U) | P_BL | rs);
+    uint8_t lo = (uint8_t)((byte << 4) | P_BL | rs);
+    uint32_t n = 0;
+
+    if (rs != *rs_now) {
+        out[n++] = (uint8_t)(P_BL | rs);    // RS set up with EN low
+        *rs_now = rs;
+    }
+    out[n++] = hi | P_EN;
+    out[n++] = hi;                      // falling EN latches D7..D4
+    out[n++] = lo | P_EN;
+    out[n++] = lo;                      // D3..D0
+    return n;
+}
+
+static uint8_t rs_state;                // RS as last sent to the backpack
+
+static uint32_t compile(uint8_t addr, const char *s)
+{
+    uint32_t n = 0, chars = 0;
+
+    n += pack(&buf[n], (uint8_t)(0x80U | addr), 0, &rs_state);
+    while (*s && chars++ < LCD_I2C_MAX_CHARS)
+        n += pack(&buf[n], (uint8_t)*s++, P_RS, &rs_state);
+    return n;
+}
+
+/**
+ * Backpack and LCD: 4-bit init by nibbles, then 2 lines, display on,
+ * increment, clear
+ */
+void lcd_i2c_init(uint32_t khz)
+{
+    static const uint8_t setup[] = { 0x28, 0x0C, 0x06, 0x01 };
+    uint8_t tmp[5];
+    uint32_t i, k, n;
+
+    running = 0;
+    I2C1_init(khz);
+    I2C1->CR2 &= ~((1U << 9) | (1U << 11));    // ITEVTEN, DMAEN off
+    NVIC_EnableIRQ(I2C1_EV_IRQn);
+
+    delayMs(50);
+    I2C1_byteWrite(LCD_I2C_ADDR, P_BL);         // all low, backlight on
+    rs_state = 0;
+    for (i = 0; i < 4; i++) {
+        uint8_t nib = (uint8_t)((i < 3 ? 0x30U : 0x20U) | P_BL);
+        I2C1_byteWrite(LCD_I2C_ADDR, nib | P_EN);
+        I2C1_byteWrite(LCD_I2C_ADDR, nib);      // 8-bit function set x3, then 4-bit
+        delayMs(i == 0 ? 5 : 1);
+    }
+    for (i = 0; i < sizeof(setup); i++) {
+        n = pack(tmp, setup[i], 0, &rs_state);
+        for (k = 0; k < n; k++)
+            I2C1_byteWrite(LCD_I2C_ADDR, tmp[k]);
+        delayMs(2);
+    }
+}
+
+void lcd_i2c_puts_naive(uint8_t addr, const char *s)
+{
+    uint32_t i, n = compile(addr, s);
+
+    for (i = 0; i < n; i++)
+        I2C1_byteWrite(LCD_I2C_ADDR, buf[i]);
+}
+
+/**
+ * Compile into the buffer and start the burst; the transaction runs from
+ * interrupts and DMA
+ */
+int lcd_i2c_puts(uint8_t addr, const char *s)
+{
+    if (running)
+        return 0;
+    running = 1;
+    len = compile(addr, s);
+
+    TX_STREAM->CR &= ~1U;
+    while (TX_STREAM->CR & 1U) {}
+    DMA1->HIFCR = 0x0F400000U;          // Stream7 flags
+    TX_STREAM->PAR  = (uint32_t)&I2C1->DR;
+    TX_STREAM->M0AR = (uint32_t)buf;
+    TX_STREAM->NDTR = len;
+    TX_STREAM->FCR  = 0;                // direct mode
+    TX_STREAM->CR   = TX_CR | 1U;       // EN
+
+    while (I2C1->SR2 & (1U << 1)) {}    // last STOP still on the bus
+    I2C1->CR2 |= (1U << 9) | (1U << 11);    // ITEVTEN, DMAEN
+    I2C1->CR1 |= (1U << 8);             // START
+    return 1;
+}
+
+int lcd_i2c_busy(void)
+{
+    return running;
+}
+
+/**
+ * SB: address; ADDR: cleared, DMA takes over; BTF with the buffer sent:
+ * STOP
+ */
+void I2C1_EV_IRQHandler(void)
+{
+    uint32_t sr1 = I2C1->SR1;
+    volatile uint32_t tmp;
+
+    if (sr1 & (1U << 0)) {
+        I2C1->DR = (uint8_t)(LCD_I2C_ADDR << 1);
+    } else if (sr1 & (1U << 1)) {
+        tmp = I2C1->SR2;                // clears ADDR; TXE now requests DMA
+        (void)tmp;
+    } else if ((sr1 & (1U << 2)) && TX_STREAM->NDTR == 0) {
+        I2C1->CR1 |= (1U << 9);         // STOP
+        I2C1->CR2 &= ~((1U << 9) | (1U << 11));
+        lcd_i2c_bytes += len;
+        lcd_i2c_transactions++;
+        running = 0;
+    }
+}
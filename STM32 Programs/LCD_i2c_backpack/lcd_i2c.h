@@ -0,0 +1,37 @@
+/**
+ * lcd_i2c.h - HD44780 16x2 through a PCF8574 backpack on I2C1, whole
+ *             strings per I2C burst by DMA
+ *
+ * Only PB8 (SCL) and PB9 (SDA) are used, configured as in Burst_trans_I2c.
+ * The backpack at address 0x27 wires P0 = RS, P1 = R/W, P2 = EN,
+ * P3 = backlight, P4..P7 = D4..D7, so the LCD runs in 4-bit mode and
+ * every EN edge is one byte written to the PCF8574.
+ *
+ * lcd_i2c_puts() packs a set-DDRAM-address command and a string, EN edges
+ * included, into one buffer and sends it as a single I2C write
+ * transaction fed by DMA1 Stream7; it returns at once and the I2C1 event
+ * interrupt ends the transaction. lcd_i2c_puts_naive() sends the same
+ * bytes one transaction per EN edge, as simple backpack drivers do.
+ *
+ *   lcd_i2c_init(400);                   kHz, 100 or 400
+ *   lcd_i2c_puts(0x00, "Hello");
+ *   while (lcd_i2c_busy()) {}
+ */
+
+#ifndef LCD_I2C_H
+#define LCD_I2C_H
+
+#include <stdint.h>
+
+#define LCD_I2C_ADDR        0x27
+#define LCD_I2C_MAX_CHARS   40
+
+void lcd_i2c_init(uint32_t khz);
+int  lcd_i2c_puts(uint8_t addr, const char *s);        // 0 = previous burst still running
+void lcd_i2c_puts_naive(uint8_t addr, const char *s);
+int  lcd_i2c_busy(void);
+
+extern volatile uint32_t lcd_i2c_bytes;         // bytes sent to the PCF8574
+extern volatile uint32_t lcd_i2c_transactions;
+
+#endif /* LCD_I2C_H */
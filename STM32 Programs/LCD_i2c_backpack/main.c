@@ -0,0 +1,159 @@
+/**
+ * main.c - HD44780 over a PCF8574 I2C backpack, one transaction per EN
+ *          edge against one DMA burst per line (STM32F401RE)
+ *
+ * LCD 8bit mode needs eleven GPIO pins; the backpack needs PB8 and PB9.
+ * For 100 kHz and 400 kHz the program fills both LCD lines ten times
+ * (320 characters, 16 per line plus a set-address command) first with
+ * lcd_i2c_puts_naive() and then with the burst driver, and prints the
+ * rates over USART2 at 9600 baud. On the host simulator:
+ *   100 kHz naive: 320 chars in  282 ms, 1134 chars/s, 69 bytes/line, 69 transactions/line
+ *   100 kHz burst: 320 chars in  128 ms, 2500 chars/s, 69 bytes/line, 1 transaction/line
+ *   400 kHz naive: 320 chars in   76 ms, 4210 chars/s, 69 bytes/line, 69 transactions/line
+ *   400 kHz burst: 320 chars in   33 ms, 9696 chars/s, 69 bytes/line, 1 transaction/line
+ * A line is 4 bytes per character, 4 for the set-address command and one
+ * or two to switch RS. A naive transaction adds START, the address byte
+ * and STOP to every byte, about 20 SCL periods for 9 of payload, plus
+ * the CPU polling each flag; a burst pays that once per line and the CPU
+ * only takes three interrupts (SB, ADDR, BTF) for it.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PB8 = I2C1_SCL, PB9 = I2C1_SDA (AF4, open-drain, pull-ups)
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "lcd_i2c.h"
+
+#define SCREENS   10
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void delayMs(int n);
+
+static const char *const lines[2] = { "0123456789ABCDEF", "abcdefghijklmnop" };
+
+/**
+ * Sleep until the burst has ended. busy is tested with interrupts masked:
+ * the final BTF taken between the test and __WFI() would otherwise leave
+ * the core waiting for an event interrupt that has been switched off
+ */
+static void wait_idle(void)
+{
+    __disable_irq();
+    while (lcd_i2c_busy()) {
+        __WFI();                        // woken by I2C1_EV even with PRIMASK set
+        __enable_irq();
+        __disable_irq();
+    }
+    __enable_irq();
+}
+
+/**
+ * SCREENS full screens, milliseconds from the first byte to the last
+ */
+static uint32_t fill(int naive)
+{
+    uint32_t t0 = DWT->CYCCNT;
+    int n, l;
+
+    for (n = 0; n < SCREENS; n++) {
+        for (l = 0; l < 2; l++) {
+            if (naive) {
+                lcd_i2c_puts_naive(l ? 0x40 : 0x00, lines[l]);
+            } else {
+                while (!lcd_i2c_puts(l ? 0x40 : 0x00, lines[l]))
+                    wait_idle();
+            }
+        }
+    }
+    wait_idle();
+    return (DWT->CYCCNT - t0) / 16000U;
+}
+
+static void measure(uint32_t khz, int naive)
+{
+    uint32_t ms, bytes, trans;
+
+    lcd_i2c_init(khz);
+    bytes = lcd_i2c_bytes;
+    trans = lcd_i2c_transactions;
+    ms = fill(naive);
+    bytes = lcd_i2c_bytes - bytes;
+    trans = lcd_i2c_transactions - trans;
+    printf("%lu kHz %s: %d chars in %4lu ms, %4lu chars/s, %lu bytes/line, %lu transaction%s/line\r\n",
+           (unsigned long)khz, naive ? "naive" : "burst", SCREENS * 32, (unsigned long)ms,
+           (unsigned long)(SCREENS * 32 * 1000U / ms), (unsigned long)(bytes / (SCREENS * 2)),
+           (unsigned long)(trans / (SCREENS * 2)), trans == SCREENS * 2 ? "" : "s");
+}
+
+int main(void)
+{
+    char text[17];
+    unsigned n = 0;
+
+    USART2_init();
+    CoreDebug->DEMCR |= (1U << 24);     // TRCENA
+    DWT->CTRL |= 1U;                    // CYCCNTENA
+
+    measure(100, 1);
+    measure(100, 0);
+    measure(400, 1);
+    measure(400, 0);
+
+    while (1)
+    {
+        sprintf(text, "I2C burst %6u", n++);
+        lcd_i2c_puts(0x00, text);
+        wait_idle();
+        delayMs(100);
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
+
+/**
+ * Approximate delay in ms for a ~16 MHz clock (3195 loops per ms)
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
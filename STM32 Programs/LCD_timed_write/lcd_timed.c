@@ -0,0 +1,189 @@
+/**
+ * lcd_timed.c - HD44780 8-bit driver that waits on the busy flag or on a
+ *               table of execution times
+ *
+ * Busy flag:
+ *   Before each write PC0..PC7 become inputs, R/W goes high and EN is
+ *   pulsed until D7 reads 0, then the pins go back to outputs: two MODER
+ *   read-modify-writes, two R/W changes and three accesses per poll on
+ *   top of every character.
+ *
+ * Timed:
+ *   The datasheet execution times at the nominal 270 kHz oscillator, by
+ *   instruction (the highest set bit of the command byte):
+ *
+ *     clear display, return home        1520 us
+ *     every other instruction             37 us
+ *     data write                          41 us (37 + 4 address update)
+ *
+ *   A write sets TIM2->CCR1 to now + time and clears CC1IF; the next one
+ *   waits for CC1IF, which is set already if the caller had other work in
+ *   between. A module with a slower oscillator (down to 190 kHz) needs the
+ *   table scaled by 1.4.
+ *
+ * Both modes use the same write: data and control lines as BSRR words,
+ * RS a store ahead of EN, EN held for four NOPs.
+ */
+
+#include "stm32f4xx.h"
+#include "lcd_timed.h"
+
+#define RS   0x20U                      // PB5
+#define RW   0x40U                      // PB6
+#define EN   0x80U                      // PB7
+
+#define DATA_US   41U
+
+/* Execution time by instruction, index = highest set bit of the command */
+static const uint16_t exec_us[8] = {
+    1520,                               // 0x01 clear display
+    1520,                               // 0x02 return home
+    37,                                 // 0x04 entry mode set
+    37,                                 // 0x08 display on/off control
+    37,                                 // 0x10 cursor or display shift
+    37,                                 // 0x20 function set
+    37,                                 // 0x40 set CGRAM address
+    37                                  // 0x80 set DDRAM address
+};
+
+volatile uint32_t lcd_polls;
+volatile uint32_t lcd_wait_us;
+
+static int lcd_mode;
+
+static void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
+
+uint32_t LCD_us(void)
+{
+    return TIM2->CNT;
+}
+
+int LCD_idle(void)
+{
+    return (TIM2->SR & 2U) != 0;        // CC1IF: the last write has executed
+}
+
+/**
+ * Poll BF with the data pins as inputs, then hand them back as outputs
+ */
+static void wait_busy_flag(void)
+{
+    uint32_t status;
+
+    GPIOC->MODER &= ~0x0000FFFF;        // PC0..PC7 inputs
+    GPIOB->BSRR = (RS << 16) | RW;      // RS = 0 (status), R/W = 1
+    do {
+        GPIOB->BSRR = EN;
+        __NOP(); __NOP(); __NOP(); __NOP();  // tDDR 160 ns, PW_EH >= 230 ns
+        status = GPIOC->IDR;
+        GPIOB->BSRR = EN << 16;
+        __NOP(); __NOP(); __NOP(); __NOP();  // EN low too, tcycE >= 500 ns
+        lcd_polls++;
+    } while (status & 0x80U);
+    GPIOB->BSRR = RW << 16;             // R/W = 0
+    GPIOC->MODER |= 0x00005555;         // PC0..PC7 outputs
+}
+
+/**
+ * Wait for the compare match scheduled by the last write
+ */
+static void wait_timed(void)
+{
+    uint32_t t0;
+
+    if (TIM2->SR & 2U)
+        return;
+    t0 = TIM2->CNT;
+    while (!(TIM2->SR & 2U)) {}
+    lcd_wait_us += TIM2->CNT - t0;
+}
+
+/**
+ * CC1IF once the controller has had us microseconds
+ */
+static void schedule(uint32_t us)
+{
+    /* + 1: the count may tick right after the store */
+    TIM2->CCR1 = TIM2->CNT + us + 1U;
+    TIM2->SR = ~2U;                     // clear CC1IF
+}
+
+/**
+ * One bus write, RS = rs
+ */
+static void pulse(uint32_t rs, uint8_t byte)
+{
+    GPIOC->BSRR = byte | ((uint32_t)(uint8_t)~byte << 16);   // D0..D7
+    GPIOB->BSRR = rs ? RS : RS << 16;
+    GPIOB->BSRR = EN;
+    __NOP(); __NOP(); __NOP(); __NOP();  // PW_EH >= 230 ns
+    GPIOB->BSRR = EN << 16;             // executes from the falling edge
+}
+
+static void write(uint32_t rs, uint8_t byte, uint32_t us)
+{
+    if (lcd_mode == LCD_TIMED)
+        wait_timed();
+    else
+        wait_busy_flag();
+    pulse(rs, byte);
+    schedule(us);
+}
+
+/**
+ * Ports, TIM2 at 1 MHz, the power-on sequence by delays, then the usual
+ * setup through the selected mode
+ */
+void LCD_init(int mode)
+{
+    lcd_mode = mode;
+
+    RCC->AHB1ENR |= (1U << 1) | (1U << 2);  // GPIOB, GPIOC clocks
+    RCC->APB1ENR |= (1U << 0);              // TIM2 clock
+
+    GPIOB->BSRR  = (EN | RW) << 16;         // EN and R/W low
+    GPIOB->MODER = (GPIOB->MODER & ~0x0000FC00) | 0x00005400;    // PB5..PB7 outputs
+    GPIOC->MODER = (GPIOC->MODER & ~0x0000FFFF) | 0x00005555;    // PC0..PC7 outputs
+
+    TIM2->PSC   = 16 - 1;               // 1 MHz
+    TIM2->EGR   = 1;                    // UG: load PSC
+    TIM2->CCMR1 = 0;                    // CC1 output compare, frozen
+    TIM2->CCER  = 1;                    // CC1E (no pin in AF mode)
+    TIM2->CR1   = 1;                    // CEN, counts through all 32 bits
+
+    /* BF cannot be read before the third function set */
+    delayMs(30);
+    pulse(0, 0x30);                     // function set, 8-bit
+    delayMs(10);
+    pulse(0, 0x30);
+    delayMs(1);
+    pulse(0, 0x30);
+    schedule(exec_us[5]);
+
+    LCD_command(0x38);                  // 8-bit, 2 lines, 5x7
+    LCD_command(0x06);                  // increment, no shift
+    LCD_command(0x01);                  // clear, cursor home
+    LCD_command(0x0C);                  // display on, no cursor
+}
+
+void LCD_command(unsigned char cmd)
+{
+    write(0, cmd, cmd ? exec_us[31 - __CLZ(cmd)] : 37U);
+}
+
+void LCD_data(char data)
+{
+    write(1, (uint8_t)data, DATA_US);
+}
+
+void LCD_puts(const char *s)
+{
+    while (*s)
+        LCD_data(*s++);
+}
@@ -0,0 +1,147 @@
+/**
+ * main.c - HD44780 characters per second, busy flag against timed writes
+ *          (STM32F401RE)
+ *
+ * Fills the 16x2 LCD ten times (a set-address command and 16 characters
+ * per line, 320 characters) once with the busy-flag driver of LCD 8bit mode
+ * and once with the write-only timed driver, then prints both rates over
+ * USART2 at 9600 baud and leaves them on the LCD. Repeats every second.
+ * On the host simulator:
+ *   busy flag: 320 chars in 15619 us, 20487 chars/s, 14.8 polls per char
+ *   timed:     320 chars in 14918 us, 21450 chars/s, 14196 us waited
+ * The controller's 41 us per character bounds both; the busy flag also
+ * loses up to one poll per character, which the simulator's NOP cost
+ * stretches to about 3 us (a real module that finishes early favours the
+ * busy flag, one with a slow oscillator needs a scaled table). What the
+ * timed mode saves is the CPU side: instead of 15 polls of three register
+ * accesses and two MODER flips per character, 95% of the time is a wait
+ * for CC1IF that the caller can fill with other work (LCD_idle()). The
+ * simulator's model drops writes that arrive while it is busy, so a table
+ * entry that is too short shows up as missing text and as lost writes in
+ * its report.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PC0..PC7 = LCD D0..D7
+ *   - PB5 = LCD RS, PB6 = LCD R/W (low in timed mode), PB7 = LCD EN
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "lcd_timed.h"
+
+#define SCREENS   10
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void delayMs(int n);
+
+static const char *const lines[2] = { "0123456789ABCDEF", "abcdefghijklmnop" };
+
+/**
+ * SCREENS full screens, time from the first write to the last one done
+ */
+static uint32_t fill(void)
+{
+    uint32_t t0 = LCD_us();
+    int n;
+
+    for (n = 0; n < SCREENS; n++) {
+        LCD_command(0x80);              // line 1
+        LCD_puts(lines[0]);
+        LCD_command(0xC0);              // line 2
+        LCD_puts(lines[1]);
+    }
+    while (!LCD_idle()) {}
+    return LCD_us() - t0;
+}
+
+/* A rate for the 6-digit field of the LCD line, saturated */
+static unsigned long field6(uint64_t v)
+{
+    return v > 999999U ? 999999UL : (unsigned long)v;
+}
+
+int main(void)
+{
+    uint32_t us_busy, us_timed, polls, waited;
+    char text[17];
+
+    USART2_init();
+
+    while (1)
+    {
+        LCD_init(LCD_BUSY_FLAG);
+        lcd_polls = 0;
+        us_busy = fill();
+        polls = lcd_polls;
+
+        LCD_init(LCD_TIMED);
+        lcd_wait_us = 0;
+        us_timed = fill();
+        waited = lcd_wait_us;
+
+        printf("busy flag: %d chars in %lu us, %lu chars/s, %lu.%lu polls per char\r\n",
+               SCREENS * 32, (unsigned long)us_busy, (unsigned long)(SCREENS * 32 * 1000000ULL / us_busy),
+               (unsigned long)(polls / (SCREENS * 32)), (unsigned long)(polls * 10 / (SCREENS * 32) % 10));
+        printf("timed:     %d chars in %lu us, %lu chars/s, %lu us waited\r\n",
+               SCREENS * 32, (unsigned long)us_timed, (unsigned long)(SCREENS * 32 * 1000000ULL / us_timed),
+               (unsigned long)waited);
+
+        LCD_command(0x01);
+        sprintf(text, "BF    %6lu c/s", field6(SCREENS * 32 * 1000000ULL / us_busy));
+        LCD_puts(text);
+        LCD_command(0xC0);
+        sprintf(text, "timed %6lu c/s", field6(SCREENS * 32 * 1000000ULL / us_timed));
+        LCD_puts(text);
+
+        delayMs(1000);
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
+
+/**
+ * Approximate delay in ms for a ~16 MHz clock (3195 loops per ms)
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++)
+            __NOP();
+}
@@ -0,0 +1,285 @@
+/**
+ * logic_analyser.c - DMA capture of a GPIO port's IDR (STM32F401RE)
+ *
+ * Capture:
+ *   TIM1 runs at the sample rate with only its update DMA request enabled.
+ *   DMA2 Stream5 Channel 6 reads port->IDR (16-bit) into ring[] in
+ *   circular mode and raises HT and TC at the two half boundaries.
+ *
+ * Trigger:
+ *   At each boundary the ISR searches the half just filled for the first
+ *   sample whose masked bits equal the pattern after one whose bits did
+ *   not. Samples are numbered from la_arm(), so the trigger position and
+ *   the end of the capture are absolute and survive the ring wrapping. A
+ *   half that went by unsearched (HT and TC both pending) is counted all
+ *   the same and only the latest one searched.
+ *
+ * Stop:
+ *   After the trigger the capture runs to the first half boundary at least
+ *   HALF - pre - LA_MARGIN samples later. TIM1 is stopped first and NDTR
+ *   read, so the samples taken while the ISR ran are counted too, but they
+ *   have overwritten the oldest ones; LA_MARGIN leaves room for them, so
+ *   the oldest sample kept is still at least pre before the trigger. When
+ *   the trigger lies within the first pre + LA_MARGIN samples of a half,
+ *   the stop comes in the same interrupt, after the search up to the
+ *   trigger: the search has to keep pace with the DMA refilling the other
+ *   half, where the history is, which it does up to LA_SEARCH_HZ. Above
+ *   that rate la_arm() lowers pre in proportion.
+ *
+ * Output:
+ *   la_send() walks the ring from the oldest sample, collapses runs of
+ *   equal samples and sends one text line per run through USART2 TX DMA
+ *   (DMA1 Stream6 Channel 4). Two 256-byte buffers alternate, so the next
+ *   lines are formatted while the previous ones go out.
+ *
+ *   LA GPIOC 1000000 Hz, 4096 samples, trigger 1480, mask 00FF value 0048
+ *   0430 17
+ *   0448 52 T          <- the run that starts with the trigger sample
+ *   ...
+ *   END
+ */
+
+#include <stdio.h>
+#include "logic_analyser.h"
+
+#define HALF          (LA_SAMPLES / 2)
+#define LA_SEARCH_HZ  2000000U          // samples searched per second, about 8 cycles each
+#define LA_STREAM     DMA2_Stream5
+
+#define CR_EN         (1U << 0)
+#define HISR_TEIF5    (1U << 9)
+#define HISR_HTIF5    (1U << 10)
+#define HISR_TCIF5    (1U << 11)
+#define HIFCR_ALL5    0x00000F40U       // FEIF5, DMEIF5, TEIF5, HTIF5, TCIF5
+
+enum { LA_IDLE, LA_ARMED, LA_TRIGGERED, LA_DONE };
+
+volatile uint32_t la_overruns;
+
+static uint16_t      ring[LA_SAMPLES];
+static GPIO_TypeDef *la_port;
+static uint32_t      la_rate;
+
+static volatile int  state;
+static uint16_t      trig_mask, trig_value, trig_pre;
+static int           prev_match;
+static uint32_t      halves;            // halves filled since la_arm()
+static uint32_t      trig_at, stop_at, end_at;
+
+static char          txbuf[2][256];
+
+static void USART2_init(void);
+
+/**
+ * Clocks, sample timer and USART2; port is sampled once la_arm() is called
+ */
+void la_init(GPIO_TypeDef *port, uint32_t rate_hz)
+{
+    uint32_t ticks = 16000000U / rate_hz;    // 16 MHz TIM1 clock
+    uint32_t psc = (ticks - 1U) / 65536U;
+
+    la_port = port;
+    la_rate = rate_hz;
+
+    RCC->AHB1ENR |= 1U << (((uint32_t)port - GPIOA_BASE) / 0x400U);   // port clock
+    RCC->AHB1ENR |= (1U << 21) | (1U << 22);  // DMA1, DMA2 clocks
+    RCC->APB2ENR |= (1U << 0);                // TIM1 clock
+
+    TIM1->CR1  = 0;
+    TIM1->PSC  = psc;
+    TIM1->ARR  = ticks / (psc + 1U) - 1U;
+    TIM1->DIER = (1U << 8);                   // UDE: DMA request on update
+
+    USART2_init();
+    NVIC_EnableIRQ(DMA2_Stream5_IRQn);
+}
+
+/**
+ * Start sampling; trigger when (IDR & mask) becomes value, with at least
+ * pre (at most LA_PRE_MAX) samples of history
+ */
+void la_arm(uint16_t mask, uint16_t value, uint16_t pre)
+{
+    uint32_t max = LA_PRE_MAX;
+
+    TIM1->CR1 = 0;
+    LA_STREAM->CR &= ~CR_EN;
+    while (LA_STREAM->CR & CR_EN) {}
+    DMA2->HIFCR = HIFCR_ALL5;
+
+    trig_mask  = mask;
+    trig_value = value & mask;
+    if (la_rate > LA_SEARCH_HZ)               // the search is slower than the DMA
+        max = max * LA_SEARCH_HZ / la_rate;
+    trig_pre   = pre > max ? (uint16_t)max : pre;
+    prev_match = 1;                           // a pattern already present does not trigger
+    halves     = 0;
+    la_overruns = 0;
+    state      = LA_ARMED;
+
+    LA_STREAM->PAR  = (uint32_t)&la_port->IDR;
+    LA_STREAM->M0AR = (uint32_t)ring;
+    LA_STREAM->NDTR = LA_SAMPLES;
+    LA_STREAM->FCR  = 0;                      // direct mode
+    LA_STREAM->CR   = 0x0C000000;             // Channel6: TIM1_UP
+    LA_STREAM->CR  |= 0x00002D00;             // 16-bit memory and peripheral, MINC, CIRC, periph-to-mem
+    LA_STREAM->CR  |= 0x1C;                   // TCIE, HTIE, TEIE
+    LA_STREAM->CR  |= CR_EN;
+
+    TIM1->CNT = 0;
+    TIM1->CR1 = 1;                            // CEN: first sample one period from now
+}
+
+/**
+ * 1 once a triggered capture has stopped
+ */
+int la_done(void)
+{
+    return state == LA_DONE;
+}
+
+/**
+ * Stop sampling and work out how many samples were taken in total
+ */
+static void stop(void)
+{
+    uint32_t ndtr, pos, boundary;
+
+    TIM1->CR1 = 0;
+    ndtr = LA_STREAM->NDTR;
+    LA_STREAM->CR &= ~CR_EN;
+    while (LA_STREAM->CR & CR_EN) {}
+    DMA2->HIFCR = HIFCR_ALL5;
+
+    pos = (LA_SAMPLES - ndtr) % LA_SAMPLES;   // next index the DMA would have written
+    boundary = (halves * HALF) % LA_SAMPLES;
+    end_at = halves * HALF + (pos - boundary + LA_SAMPLES) % LA_SAMPLES;
+    state = LA_DONE;
+}
+
+/**
+ * HT / TC: search the half just filled for the trigger, stop once enough
+ * samples follow it
+ */
+void DMA2_Stream5_IRQHandler(void)
+{
+    uint32_t isr = DMA2->HISR;
+    const uint16_t *p;
+    uint32_t base, i;
+    int match;
+
+    DMA2->HIFCR = isr & HIFCR_ALL5;
+
+    if (isr & HISR_TEIF5) {
+        TIM1->CR1 = 0;
+        state = LA_IDLE;
+        return;
+    }
+    if (!(isr & (HISR_HTIF5 | HISR_TCIF5)) || state == LA_IDLE || state == LA_DONE)
+        return;
+    if ((isr & (HISR_HTIF5 | HISR_TCIF5)) == (HISR_HTIF5 | HISR_TCIF5)) {
+        la_overruns++;                        // a whole half went by unsearched
+        halves++;                             // still counted, it is in the numbering
+        prev_match = 1;                       // no edge across the gap
+    }
+
+    p = &ring[(halves & 1U) * HALF];          // even halves are HT, odd ones TC
+    base = halves * HALF;
+    halves++;
+
+    if (state == LA_ARMED) {
+        for (i = 0; i < HALF; i++) {
+            match = (p[i] & trig_mask) == trig_value;
+            if (match && !prev_match && base + i >= trig_pre) {
+                trig_at = base + i;
+                stop_at = trig_at + HALF - trig_pre - LA_MARGIN;
+                state = LA_TRIGGERED;
+                break;
+            }
+            prev_match = match;
+        }
+    }
+
+    if (state == LA_TRIGGERED && halves * HALF >= stop_at)
+        stop();
+}
+
+/**
+ * Send one buffer through DMA1 Stream6 once the previous one has gone
+ */
+static void send_buffer(const char *buf, int len)
+{
+    while (DMA1_Stream6->CR & CR_EN) {}       // previous buffer handed to USART2
+    DMA1->HIFCR = 0x003F0000;                 // clear all Stream6 flags
+
+    DMA1_Stream6->PAR  = (uint32_t)&USART2->DR;
+    DMA1_Stream6->M0AR = (uint32_t)buf;
+    DMA1_Stream6->NDTR = len;
+    DMA1_Stream6->FCR  = 0;
+    DMA1_Stream6->CR   = 0x08000000;          // Channel4: USART2_TX
+    DMA1_Stream6->CR  |= 0x00000440;          // mem-to-periph, MINC, 8-bit
+    DMA1_Stream6->CR  |= CR_EN;
+}
+
+/**
+ * Dump the capture as run-length text, oldest sample first
+ */
+void la_send(void)
+{
+    uint32_t start, k, run;
+    uint16_t v, prev;
+    int cur = 0, len, marked;
+
+    if (state != LA_DONE)
+        return;
+
+    start = end_at > LA_SAMPLES ? end_at - LA_SAMPLES : 0U;
+    len = sprintf(txbuf[cur], "LA GPIO%c %lu Hz, %lu samples, trigger %lu, mask %04X value %04X\r\n",
+                  'A' + (int)(((uint32_t)la_port - GPIOA_BASE) / 0x400U), (unsigned long)la_rate,
+                  (unsigned long)(end_at - start), (unsigned long)(trig_at - start),
+                  trig_mask, trig_value);
+
+    /* The trigger sample differs from the one before it, so it starts a run */
+    prev = ring[start % LA_SAMPLES];
+    run = 1;
+    marked = (trig_at == start);
+    for (k = start + 1; k <= end_at; k++) {
+        v = ring[k % LA_SAMPLES];
+        if (k < end_at && v == prev) {
+            run++;
+            continue;
+        }
+        len += sprintf(txbuf[cur] + len, marked ? "%04X %lu T\r\n" : "%04X %lu\r\n",
+                       prev, (unsigned long)run);
+        if (len > (int)sizeof(txbuf[0]) - 32) {
+            send_buffer(txbuf[cur], len);
+            cur ^= 1;
+            len = 0;
+        }
+        prev = v;
+        run = 1;
+        marked = (k == trig_at);
+    }
+    len += sprintf(txbuf[cur] + len, "END\r\n");
+    send_buffer(txbuf[cur], len);
+    while (DMA1_Stream6->CR & CR_EN) {}
+    state = LA_IDLE;
+}
+
+/**
+ * Initialize USART2 @ 115200, PA2 as TX with DMA requests
+ */
+static void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] &= ~(0xFU << 8);
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x008B;         // 115200 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+    USART2->CR3 = (1U << 7);      // DMAT: transmit through DMA
+}
@@ -0,0 +1,44 @@
+/**
+ * logic_analyser.h - DMA capture of a GPIO port's IDR (STM32F401RE)
+ *
+ * TIM1 update events pace DMA2 Stream5 Channel 6, which copies the 16 bits
+ * of a port's IDR into a circular RAM buffer at the sample rate. The CPU
+ * is only involved at every half-transfer, where the half just filled is
+ * searched for the trigger pattern.
+ *
+ *   la_init(GPIOC, 1000000);          sample PC0..PC15 at 1 MHz
+ *   la_arm(0x00FF, 0x0048, 1024);     trigger when PC7..PC0 become 0x48,
+ *                                     keep at least 1024 samples before it
+ *   while (!la_done()) {}
+ *   la_send();                        run-length text dump over USART2
+ *
+ * Rates up to about 4 MHz work at a 16 MHz bus clock; above that the DMA
+ * cannot keep up.
+ *
+ * The history is kept in the half the DMA refills while the interrupt
+ * searches, so pre is limited to LA_PRE_MAX, leaving LA_MARGIN samples
+ * for the interrupt to be taken and stop the capture (256 cycles at
+ * 4 MHz; no other interrupt may hold it off for longer). Above 2 MHz the
+ * search falls behind the DMA and the limit drops in proportion: 992 at
+ * 4 MHz. The port must be on AHB1 (GPIOA..GPIOH), which DMA2
+ * reaches and DMA1 does not.
+ */
+
+#ifndef LOGIC_ANALYSER_H
+#define LOGIC_ANALYSER_H
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+#define LA_SAMPLES    4096              // ring buffer, two halves of 2048
+#define LA_MARGIN     64                // samples taken before a stop takes effect
+#define LA_PRE_MAX    (LA_SAMPLES / 2 - LA_MARGIN)
+
+void     la_init(GPIO_TypeDef *port, uint32_t rate_hz);
+void     la_arm(uint16_t mask, uint16_t value, uint16_t pre);
+int      la_done(void);
+void     la_send(void);
+
+extern volatile uint32_t la_overruns;  // halves not searched in time
+
+#endif /* LOGIC_ANALYSER_H */
@@ -0,0 +1,172 @@
+/**
+ * main.c - Capture the HD44780 data bus with the DMA logic analyser
+ *
+ * The LCD 8bit mode program writes "Hello" to the LCD while PC0..PC15
+ * are sampled at 1 MHz. The capture triggers when the data bus becomes
+ * 'H' (0x48), keeps at least 1024 samples before it, and is dumped over
+ * USART2 at 115200 baud as one line per run of equal samples. The dump
+ * shows the init commands, the busy-flag reads (the LCD driving the bus
+ * while PC0..PC7 are inputs) and the five characters.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PC0..PC7 => LCD D0..D7 (sampled)
+ *   - PB5      => LCD RS
+ *   - PB6      => LCD R/W
+ *   - PB7      => LCD EN
+ *   - PA2      => USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include "logic_analyser.h"
+
+void LCD_init(void);
+void PORTS_init(void);
+void LCD_command(unsigned char cmd);
+void LCD_command_noPoll(unsigned char cmd);
+void LCD_data(char data);
+void LCD_ready(void);
+void delayMs(int n);
+
+#define RS 0x20  /* PB5 mask for Register Select (1<<5) */
+#define RW 0x40  /* PB6 mask for Read/Write (1<<6) */
+#define EN 0x80  /* PB7 mask for Enable (1<<7) */
+
+int main(void)
+{
+    la_init(GPIOC, 1000000);
+    la_arm(0x00FF, 'H', 1024);
+
+    LCD_init();
+    LCD_data('H');
+    LCD_data('e');
+    LCD_data('l');
+    LCD_data('l');
+    LCD_data('o');
+
+    while (!la_done()) {}
+    la_send();
+
+    while (1) {}
+}
+
+/**
+ * Initialize the LCD controller: 8-bit mode, 2 lines, 5x7 chars
+ */
+void LCD_init(void)
+{
+    PORTS_init();
+
+    delayMs(30);               // Wait 30ms after power rises
+    LCD_command_noPoll(0x30);  // Function set (8-bit) -- no poll
+    delayMs(10);
+    LCD_command_noPoll(0x30);  // Repeat
+    delayMs(1);
+    LCD_command_noPoll(0x30);  // Now we can poll busy flag
+
+    LCD_command(0x38);  // 8-bit, 2 line, 5x7 font
+    LCD_command(0x06);  // Move cursor right after each char
+    LCD_command(0x01);  // Clear screen, cursor to home
+    LCD_command(0x0F);  // Display on, cursor on, blinking
+}
+
+/**
+ * PB5..PB7 and PC0..PC7 as outputs
+ */
+void PORTS_init(void)
+{
+    RCC->AHB1ENR |= (1 << 1) | (1 << 2);  // bits 1=>GPIOB, 2=>GPIOC
+
+    GPIOB->MODER &= ~0x0000FC00;  // clear PB5..PB7 mode
+    GPIOB->MODER |=  0x00005400;  // set PB5..PB7 as outputs (01)
+
+    GPIOB->BSRR = (EN | RW) << 16;
+
+    GPIOC->MODER &= ~0x0000FFFF;  // clear PC0..PC7
+    GPIOC->MODER |=  0x00005555;  // set PC0..PC7 as outputs
+}
+
+/**
+ * Wait until the LCD controller is not busy (D7=0)
+ */
+void LCD_ready(void)
+{
+    char status;
+
+    GPIOC->MODER &= ~0x0000FFFF;  // set PC0..PC7 to input (00)
+
+    GPIOB->BSRR = RS << 16;  // RS = 0
+    GPIOB->BSRR = RW;        // RW = 1
+
+    do {
+        GPIOB->BSRR = EN;
+        delayMs(0);
+        status = (char)(GPIOC->IDR & 0xFF);
+        GPIOB->BSRR = EN << 16;
+        delayMs(0);
+    }
+    while (status & 0x80);
+
+    GPIOB->BSRR = RW << 16; // R/W=0
+    GPIOC->MODER &= ~0x0000FFFF;
+    GPIOC->MODER |=  0x00005555;
+}
+
+/**
+ * Send a command (8-bit) to the LCD, after polling BF
+ */
+void LCD_command(unsigned char cmd)
+{
+    LCD_ready();
+
+    GPIOB->BSRR = (RS | RW) << 16;
+    GPIOC->ODR = (GPIOC->ODR & ~0xFF) | cmd;
+
+    GPIOB->BSRR = EN;
+    delayMs(0);
+    GPIOB->BSRR = EN << 16;
+}
+
+/**
+ * Send a command (8-bit) to the LCD, without polling BF (for early init)
+ */
+void LCD_command_noPoll(unsigned char cmd)
+{
+    GPIOB->BSRR = (RS | RW) << 16;
+    GPIOC->ODR = (GPIOC->ODR & ~0xFF) | cmd;
+
+    GPIOB->BSRR = EN;
+    delayMs(0);
+    GPIOB->BSRR = EN << 16;
+}
+
+/**
+ * Write a single character (8-bit) to the LCD
+ */
+void LCD_data(char data)
+{
+    LCD_ready();
+
+    GPIOB->BSRR = RS;
+    GPIOB->BSRR = RW << 16;
+    GPIOC->ODR = (GPIOC->ODR & ~0xFF) | data;
+
+    GPIOB->BSRR = EN;
+    delayMs(0);
+    GPIOB->BSRR = EN << 16;
+}
+
+/**
+ * ~1 ms per 'n' at 16 MHz
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+    {
+        for (i = 0; i < 3195; i++) {
+            __NOP();
+        }
+    }
+}
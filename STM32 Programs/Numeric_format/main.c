@@ -0,0 +1,195 @@
+/**
+ * main.c - Formatting kernel against sprintf() (STM32F401RE)
+ *
+ * LM34 interface with STM formats its reading with
+ *   temperature = ((double)result / 4095.0) * 3.3 * 100.0;
+ *   printf("... %.2f ...", temperature);
+ * which pulls in software double arithmetic and the float printf. This
+ * program formats the same conversion, for every ADC code 0..4095, three
+ * ways and prints the DWT cycles per value over USART2 at 9600 baud:
+ *
+ *   double + sprintf("%.2f")     the LM34 program
+ *   integer + sprintf("%ld.%02ld")
+ *   num_scale() + num_symbols() + num_map()
+ *
+ * It then checks that the kernel's text matches sprintf("%6.2f") for all
+ * 4096 codes and shows one value as HD44780 characters, segment codes and
+ * GLCD glyph indices. On the host simulator:
+ *   mismatches: 0 of 4096
+ *   4095 ->  330.00 | chars 20 33 33 30 2E 30 30 | seg7 4F 4F BF 3F 3F | glyphs 99 19 19 16 14 16 16
+ * The simulator does not charge computation, so the cycle counts it
+ * prints are 0; run on the board for the comparison.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include <string.h>
+#include "numfmt.h"
+
+#define CODES     4096
+#define WIDTH     7                     // "-330.00" fits
+
+/* Glyph indices in a GLCD font whose digits start at entry 16 */
+static const uint8_t glyph_map[NUM_SYMBOLS] = {
+    16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 14, 13, 99
+};
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void DWT_init(void);
+void benchmark(void);
+void check(void);
+void show(int32_t raw);
+
+char         text[24];
+volatile int sink;
+
+int main(void)
+{
+    USART2_init();
+    DWT_init();
+
+    benchmark();
+    check();
+    show(4095);
+
+    while (1) {}
+}
+
+/**
+ * Cycles per value for the three ways, averaged over all ADC codes
+ */
+void benchmark(void)
+{
+    uint32_t t0, t_double, t_int, t_num;
+    uint8_t sym[WIDTH];
+    int32_t f100;
+    int raw;
+
+    t0 = DWT->CYCCNT;
+    for (raw = 0; raw < CODES; raw++) {
+        double temperature = ((double)raw / 4095.0) * 3.3 * 100.0;
+        sink += sprintf(text, "%.2f", temperature);
+    }
+    t_double = DWT->CYCCNT - t0;
+
+    t0 = DWT->CYCCNT;
+    for (raw = 0; raw < CODES; raw++) {
+        f100 = (raw * 33000 + 2047) / 4095;
+        sink += sprintf(text, "%ld.%02ld", (long)(f100 / 100), (long)(f100 % 100));
+    }
+    t_int = DWT->CYCCNT - t0;
+
+    t0 = DWT->CYCCNT;
+    for (raw = 0; raw < CODES; raw++) {
+        f100 = num_scale(raw, NUM_Q24(33000.0 / 4095));
+        sink += num_symbols(f100, 2, WIDTH, sym);
+        num_map(sym, WIDTH, num_map_ascii, (uint8_t *)text);
+    }
+    t_num = DWT->CYCCNT - t0;
+
+    printf("cycles per value (%d values)\r\n", CODES);
+    printf("  double + sprintf   : %lu\r\n", (unsigned long)(t_double / CODES));
+    printf("  integer + sprintf  : %lu\r\n", (unsigned long)(t_int / CODES));
+    printf("  numfmt             : %lu\r\n", (unsigned long)(t_num / CODES));
+}
+
+/**
+ * Kernel output against the double reference, code by code
+ */
+void check(void)
+{
+    char ref[24];
+    uint8_t sym[WIDTH];
+    int raw, bad = 0;
+
+    for (raw = 0; raw < CODES; raw++) {
+        sprintf(ref, "%*.2f", WIDTH, (double)raw / 4095.0 * 330.0);
+        num_symbols(num_scale(raw, NUM_Q24(33000.0 / 4095)), 2, WIDTH, sym);
+        num_map(sym, WIDTH, num_map_ascii, (uint8_t *)text);
+        text[WIDTH] = '\0';
+        if (strcmp(ref, text) != 0) {
+            if (bad < 5)
+                printf("  %4d: \"%s\" \"%s\"\r\n", raw, ref, text);
+            bad++;
+        }
+    }
+    printf("mismatches: %d of %d\r\n", bad, CODES);
+}
+
+/**
+ * One value for every output
+ */
+void show(int32_t raw)
+{
+    uint8_t sym[WIDTH], out[WIDTH];
+    int32_t f100 = num_scale(raw, NUM_Q24(33000.0 / 4095));
+    int i;
+
+    num_symbols(f100, 2, WIDTH, sym);
+    num_map(sym, WIDTH, num_map_ascii, (uint8_t *)text);
+    text[WIDTH] = '\0';
+    printf("%ld -> %s | chars", (long)raw, text);
+    for (i = 0; i < WIDTH; i++)
+        printf(" %02X", (unsigned)text[i]);
+
+    num_seg7(f100, 2, 5, out);
+    printf(" | seg7");
+    for (i = 0; i < 5; i++)
+        printf(" %02X", out[i]);
+
+    num_map(sym, WIDTH, glyph_map, out);
+    printf(" | glyphs");
+    for (i = 0; i < WIDTH; i++)
+        printf(" %u", out[i]);
+    printf("\r\n");
+}
+
+/**
+ * Start the DWT cycle counter
+ */
+void DWT_init(void)
+{
+    CoreDebug->DEMCR |= (1U << 24);    // TRCENA
+    DWT->CYCCNT = 0;
+    DWT->CTRL  |= 1U;                  // CYCCNTENA
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
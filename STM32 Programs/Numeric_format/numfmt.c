@@ -0,0 +1,116 @@
+/**
+ * numfmt.c - Division-free number formatting for displays
+ *
+ * Binary to BCD: v / 10 is (v * 0xCCCCCCCD) >> 35 for every 32-bit v,
+ * one UMULL on the Cortex-M4 against 2..12 cycles for UDIV, and the digit
+ * is v - 10 * q. Eight digits cover values below 10^8.
+ *
+ * The number of significant digits comes from the highest non-zero BCD
+ * nibble (CLZ), so no digit loop runs past the last one.
+ */
+
+#include "stm32f4xx.h"
+#include "numfmt.h"
+
+const uint8_t num_map_ascii[NUM_SYMBOLS] = {
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '.', '-', ' '
+};
+
+const uint8_t num_map_seg7[NUM_SYMBOLS] = {
+    0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F,   // 0..9
+    0x80, 0x40, 0x00                                              // dp, g, off
+};
+
+/**
+ * Packed BCD of value, least significant digit in bits 3..0.
+ * value must be below 100000000.
+ */
+uint32_t num_bcd(uint32_t value)
+{
+    uint32_t bcd = 0, q;
+    int shift;
+
+    for (shift = 0; value; shift += 4) {
+        q = (uint32_t)(((uint64_t)value * 0xCCCCCCCDU) >> 35);    // value / 10
+        bcd |= (value - q * 10U) << shift;
+        value = q;
+    }
+    return bcd;
+}
+
+/**
+ * width symbols into sym[], sym[0] leftmost: value with frac digits after
+ * the point, at least one before it, leading blanks and a minus sign if
+ * negative. If it does not fit, all width symbols are NUM_MINUS and -1 is
+ * returned, otherwise the number of symbols that are not leading blanks.
+ */
+int num_symbols(int32_t value, int frac, int width, uint8_t *sym)
+{
+    uint32_t mag = (value < 0) ? 0U - (uint32_t)value : (uint32_t)value;
+    uint32_t bcd;
+    int digits, len, pos, i;
+
+    if (mag >= 100000000U)
+        goto overflow;
+    bcd = num_bcd(mag);
+    digits = bcd ? (35 - __CLZ(bcd)) / 4 : 1;
+    if (digits < frac + 1)
+        digits = frac + 1;
+    len = digits + (frac > 0) + (value < 0);
+    if (len > width)
+        goto overflow;
+
+    pos = width;
+    for (i = 0; i < digits; i++) {
+        if (frac > 0 && i == frac)
+            sym[--pos] = NUM_POINT;
+        sym[--pos] = (uint8_t)(bcd & 0xFU);
+        bcd >>= 4;
+    }
+    if (value < 0)
+        sym[--pos] = NUM_MINUS;
+    while (pos > 0)
+        sym[--pos] = NUM_BLANK;
+    return len;
+
+overflow:
+    for (i = 0; i < width; i++)
+        sym[i] = NUM_MINUS;
+    return -1;
+}
+
+/**
+ * out[i] = map[sym[i]] for n symbols
+ */
+void num_map(const uint8_t *sym, int n, const uint8_t *map, uint8_t *out)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        out[i] = map[sym[i]];
+}
+
+/**
+ * digits segment patterns into seg[], seg[0] leftmost; the point lights
+ * the dp of the digit before it. Returns as num_symbols().
+ */
+int num_seg7(int32_t value, int frac, int digits, uint8_t *seg)
+{
+    uint8_t sym[NUM_MAX_WIDTH];
+    int width = digits + (frac > 0);
+    int i, n = 0, len;
+
+    len = num_symbols(value, frac, width, sym);
+    if (len < 0) {
+        for (i = 0; i < digits; i++)
+            seg[i] = num_map_seg7[NUM_MINUS];
+        return len;
+    }
+    for (i = 0; i < width; i++) {
+        if (sym[i] == NUM_POINT)
+            seg[n - 1] |= num_map_seg7[NUM_POINT];
+        else
+            seg[n++] = num_map_seg7[sym[i]];
+    }
+    return len;
+}
@@ -0,0 +1,53 @@
+/**
+ * numfmt.h - Division-free number formatting for displays
+ *
+ * Turns a fixed-point integer into display symbols without sprintf(),
+ * double arithmetic or a divide instruction:
+ *
+ *   num_scale()    ADC counts to fixed point with one multiply (Q24 factor)
+ *   num_bcd()      binary to packed BCD by multiply-shift, one UMULL per digit
+ *   num_symbols()  right-aligned symbols: digits 0..9, point, minus, blank
+ *   num_map()      symbols to output codes through a 13-entry table:
+ *                  num_map_ascii for HD44780 characters and the UART,
+ *                  num_map_seg7 for segments, or a table of GLCD glyph
+ *                  indices
+ *   num_seg7()     symbols to segments, point folded into the dp bit
+ *
+ * The value is an integer count of 10^-frac units, so 2345 with frac = 2
+ * shows as "23.45":
+ *
+ *   int32_t f100 = num_scale(adc, NUM_Q24(33000.0 / 4095));   // LM34, 0.01 degF
+ *   num_symbols(f100, 2, 6, sym);                              " 79.51"
+ *   num_map(sym, 6, num_map_ascii, text);
+ */
+
+#ifndef NUMFMT_H
+#define NUMFMT_H
+
+#include <stdint.h>
+
+#define NUM_POINT      10
+#define NUM_MINUS      11
+#define NUM_BLANK      12
+#define NUM_SYMBOLS    13
+
+#define NUM_MAX_WIDTH  12               // sign, 8 digits, point, two spare
+
+/* Q24 factor below 256 for num_scale(), folded by the compiler */
+#define NUM_Q24(k)     ((uint32_t)((k) * 16777216.0 + 0.5))
+
+extern const uint8_t num_map_ascii[NUM_SYMBOLS];
+extern const uint8_t num_map_seg7[NUM_SYMBOLS];
+
+/* raw * factor, rounded to nearest */
+static inline int32_t num_scale(int32_t raw, uint32_t q24)
+{
+    return (int32_t)(((int64_t)raw * q24 + 0x800000) >> 24);
+}
+
+uint32_t num_bcd(uint32_t value);
+int      num_symbols(int32_t value, int frac, int width, uint8_t *sym);
+void     num_map(const uint8_t *sym, int n, const uint8_t *map, uint8_t *out);
+int      num_seg7(int32_t value, int frac, int digits, uint8_t *seg);
+
+#endif /* NUMFMT_H */
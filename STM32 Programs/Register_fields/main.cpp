@@ -0,0 +1,52 @@
+/**
+ * main.cpp - Toggle LD2 at 1 Hz with reg_field.hpp register fields
+ *
+ * Same program as Toggling_LED_using_special_func_registers, which defines
+ * RCC_AHB1ENR, GPIOA_MODER and GPIOA_BSRR by raw address and writes
+ * constants like ~0x00000C00 by hand. Here every register and field is a
+ * type derived from the CMSIS base addresses and structures, and each
+ * write is merged into one constant at compile time.
+ *
+ * The static_asserts below check the field-by-field spelling of constants
+ * other programs write by hand against those constants.
+ *
+ * Pins:
+ *   - PA5 = LD2
+ */
+
+#include "stm32f4xx.h"
+#include "reg_field.hpp"
+
+/* ADC_DMA: ADC1->CR2 = 0x13000000 (rising edge of TIM2 CH2) */
+static_assert(adc1::CR2::value<adc1::cr2::EXTEN::Rising, adc1::cr2::EXTSEL::Tim2Cc2> == 0x13000000);
+
+/* GCLD: SPI1->CR1 = 0x31C (master, f/16, software NSS) */
+static_assert(spi1::CR1::value<spi1::cr1::MSTR::Set, spi1::cr1::BR::Div16,
+                               spi1::cr1::SSI::Set, spi1::cr1::SSM::Set> == 0x31C);
+
+/* Uart_DMA: DMA1_Stream6->CR |= 0x00000440 (memory to peripheral, MINC) */
+static_assert(dma1_stream6::CR::value<dma1_stream6::DIR::MemToPeriph, dma1_stream6::MINC::Set> == 0x440);
+
+void delayMs(int n);
+
+int main(void)
+{
+    rcc::AHB1ENR::modify<rcc::ahb1enr::GPIOAEN::Set>();     // enable GPIOA clock
+    gpioa::MODER::modify<gpioa::MODE<5>::Output>();         // PA5 as output
+
+    while (1)
+    {
+        gpioa::BSRR::write<gpioa::BS<5>::Set>();            // turn on LED
+        delayMs(500);
+        gpioa::BSRR::write<gpioa::BR<5>::Set>();            // turn off LED
+        delayMs(500);
+    }
+}
+
+/* 16 MHz SYSCLK */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+        for (i = 0; i < 3195; i++) __NOP();
+}
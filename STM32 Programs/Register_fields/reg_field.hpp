@@ -0,0 +1,310 @@
+/**
+ * reg_field.hpp - Compile-time register and bit field access for STM32F401RE
+ *
+ * A register is a type carrying its address, a field a type carrying its
+ * register, position and width, and a field value a type carrying the
+ * shifted value. Writes name the values they set:
+ *
+ *   adc1::CR2::write<adc1::cr2::EXTEN::Rising, adc1::cr2::EXTSEL::Tim2Cc2>();
+ *
+ * and the register class merges them into one constant at compile time,
+ * so the line above is the single store of 0x13000000 that ADC_DMA writes
+ * by hand. Mistakes that a hand-written constant hides do not compile:
+ *
+ *   - a value wider than its field           static_assert in FieldValue
+ *   - a field of another register            static_assert in Register
+ *   - two values for the same field          static_assert in Register
+ *   - writing a read-only register or
+ *     read-modify-writing a write-only one   static_assert in Register
+ *
+ *   write<V...>()    one store; fields not named are 0
+ *   modify<V...>()   one load and one store; fields not named keep their
+ *                    contents (a register read through volatile `|=` and
+ *                    `&=` twice costs two loads and two stores)
+ *   value<V...>      the merged constant, e.g. for static_assert
+ *   get<F>()         one load, the field shifted down
+ *
+ * Needs C++17 and nothing from the C++ runtime.
+ */
+
+#ifndef REG_FIELD_HPP
+#define REG_FIELD_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include "stm32f4xx.h"
+
+namespace reg {
+
+enum class Access { ReadWrite, ReadOnly, WriteOnly };
+
+template <typename F, uint32_t V>
+struct FieldValue
+{
+    static_assert(V <= F::max, "value does not fit in the field");
+
+    using field = F;
+    static constexpr uint32_t mask  = F::mask;
+    static constexpr uint32_t value = V << F::pos;
+};
+
+template <typename R, unsigned Pos, unsigned Width>
+struct Field
+{
+    static_assert(Width >= 1 && Pos + Width <= 32, "field outside the register");
+
+    using reg = R;
+    static constexpr unsigned pos   = Pos;
+    static constexpr unsigned width = Width;
+    static constexpr uint32_t max   = Width == 32 ? 0xFFFFFFFFU : (1U << Width) - 1U;
+    static constexpr uint32_t mask  = max << Pos;
+};
+
+/* A one-bit field with Set/Clear values */
+template <typename R, unsigned Pos>
+struct Bit : Field<R, Pos, 1>
+{
+    using Set   = FieldValue<Bit, 1>;
+    using Clear = FieldValue<Bit, 0>;
+};
+
+template <uint32_t Addr, Access A = Access::ReadWrite>
+struct Register
+{
+    static constexpr uint32_t address = Addr;
+
+    static volatile uint32_t &ref()
+    {
+        return *reinterpret_cast<volatile uint32_t *>(static_cast<uintptr_t>(Addr));
+    }
+
+    /* Merged value and mask of field values V..., checked for ownership
+       and overlap */
+    template <typename... V>
+    static constexpr uint32_t value = (0U | ... | V::value);
+
+    template <typename... V>
+    static constexpr uint32_t mask_of = (0U | ... | V::mask);
+
+    template <typename... V>
+    static constexpr bool valid()
+    {
+        static_assert((std::is_same_v<typename V::field::reg, Register> && ...),
+                      "field belongs to another register");
+        static_assert((0U + ... + V::mask) == mask_of<V...>, "field given twice");
+        return true;
+    }
+
+    template <typename... V>
+    static void write()
+    {
+        static_assert(A != Access::ReadOnly, "register is read-only");
+        static_assert(valid<V...>());
+        ref() = value<V...>;
+    }
+
+    /* Whole-register write of a run-time value, e.g. a data register */
+    static void write(uint32_t v)
+    {
+        static_assert(A != Access::ReadOnly, "register is read-only");
+        ref() = v;
+    }
+
+    template <typename... V>
+    static void modify()
+    {
+        static_assert(A == Access::ReadWrite, "read-modify-write needs a read/write register");
+        static_assert(valid<V...>());
+        volatile uint32_t &r = ref();
+        r = (r & ~mask_of<V...>) | value<V...>;
+    }
+
+    static uint32_t read()
+    {
+        static_assert(A != Access::WriteOnly, "register is write-only");
+        return ref();
+    }
+
+    template <typename F>
+    static uint32_t get()
+    {
+        static_assert(std::is_same_v<typename F::reg, Register>, "field belongs to another register");
+        return (read() & F::mask) >> F::pos;
+    }
+
+    /* True if every field value V... is currently in the register */
+    template <typename... V>
+    static bool is()
+    {
+        static_assert(valid<V...>());
+        return (read() & mask_of<V...>) == value<V...>;
+    }
+};
+
+} // namespace reg
+
+/* ---------------- Registers used by the programs ---------------- */
+
+#define REG_AT(base, type, member)  ((base) + offsetof(type, member))
+
+namespace rcc {
+using AHB1ENR = reg::Register<REG_AT(RCC_BASE, RCC_TypeDef, AHB1ENR)>;
+using APB1ENR = reg::Register<REG_AT(RCC_BASE, RCC_TypeDef, APB1ENR)>;
+using APB2ENR = reg::Register<REG_AT(RCC_BASE, RCC_TypeDef, APB2ENR)>;
+
+namespace ahb1enr {
+struct GPIOAEN : reg::Bit<AHB1ENR, 0> {};
+struct GPIOBEN : reg::Bit<AHB1ENR, 1> {};
+struct GPIOCEN : reg::Bit<AHB1ENR, 2> {};
+struct DMA1EN  : reg::Bit<AHB1ENR, 21> {};
+struct DMA2EN  : reg::Bit<AHB1ENR, 22> {};
+}
+namespace apb1enr {
+struct TIM2EN   : reg::Bit<APB1ENR, 0> {};
+struct USART2EN : reg::Bit<APB1ENR, 17> {};
+struct I2C1EN   : reg::Bit<APB1ENR, 21> {};
+}
+namespace apb2enr {
+struct TIM1EN : reg::Bit<APB2ENR, 0> {};
+struct ADC1EN : reg::Bit<APB2ENR, 8> {};
+struct SPI1EN : reg::Bit<APB2ENR, 12> {};
+}
+} // namespace rcc
+
+/* GPIO registers of one port; Base is GPIOA_BASE etc. */
+template <uint32_t Base>
+struct GpioPort
+{
+    using MODER = reg::Register<REG_AT(Base, GPIO_TypeDef, MODER)>;
+    using PUPDR = reg::Register<REG_AT(Base, GPIO_TypeDef, PUPDR)>;
+    using IDR   = reg::Register<REG_AT(Base, GPIO_TypeDef, IDR), reg::Access::ReadOnly>;
+    using ODR   = reg::Register<REG_AT(Base, GPIO_TypeDef, ODR)>;
+    using BSRR  = reg::Register<REG_AT(Base, GPIO_TypeDef, BSRR), reg::Access::WriteOnly>;
+
+    template <unsigned N>
+    struct MODE : reg::Field<MODER, 2 * N, 2>
+    {
+        using Input     = ::reg::FieldValue<MODE, 0>;
+        using Output    = ::reg::FieldValue<MODE, 1>;
+        using Alternate = ::reg::FieldValue<MODE, 2>;
+        using Analog    = ::reg::FieldValue<MODE, 3>;
+    };
+    template <unsigned N> struct BS : reg::Bit<BSRR, N> {};
+    template <unsigned N> struct BR : reg::Bit<BSRR, N + 16> {};
+};
+
+using gpioa = GpioPort<GPIOA_BASE>;
+using gpiob = GpioPort<GPIOB_BASE>;
+using gpioc = GpioPort<GPIOC_BASE>;
+
+namespace adc1 {
+using CR1 = reg::Register<REG_AT(ADC1_BASE, ADC_TypeDef, CR1)>;
+using CR2 = reg::Register<REG_AT(ADC1_BASE, ADC_TypeDef, CR2)>;
+using DR  = reg::Register<REG_AT(ADC1_BASE, ADC_TypeDef, DR), reg::Access::ReadOnly>;
+
+namespace cr1 {
+struct RES : reg::Field<CR1, 24, 2>
+{
+    using Bits12 = ::reg::FieldValue<RES, 0>;
+    using Bits10 = ::reg::FieldValue<RES, 1>;
+    using Bits8  = ::reg::FieldValue<RES, 2>;
+    using Bits6  = ::reg::FieldValue<RES, 3>;
+};
+struct SCAN : reg::Bit<CR1, 8> {};
+struct EOCIE : reg::Bit<CR1, 5> {};
+}
+namespace cr2 {
+struct ADON : reg::Bit<CR2, 0> {};
+struct CONT : reg::Bit<CR2, 1> {};
+struct DMA  : reg::Bit<CR2, 8> {};
+struct DDS  : reg::Bit<CR2, 9> {};
+struct EOCS : reg::Bit<CR2, 10> {};
+struct ALIGN : reg::Bit<CR2, 11> {};
+struct EXTSEL : reg::Field<CR2, 24, 4>
+{
+    using Tim1Cc1 = ::reg::FieldValue<EXTSEL, 0>;
+    using Tim1Cc2 = ::reg::FieldValue<EXTSEL, 1>;
+    using Tim1Cc3 = ::reg::FieldValue<EXTSEL, 2>;
+    using Tim2Cc2 = ::reg::FieldValue<EXTSEL, 3>;
+    using Tim2Cc3 = ::reg::FieldValue<EXTSEL, 4>;
+    using Tim2Cc4 = ::reg::FieldValue<EXTSEL, 5>;
+    using Tim2Trgo = ::reg::FieldValue<EXTSEL, 6>;
+};
+struct EXTEN : reg::Field<CR2, 28, 2>
+{
+    using Disabled = ::reg::FieldValue<EXTEN, 0>;
+    using Rising   = ::reg::FieldValue<EXTEN, 1>;
+    using Falling  = ::reg::FieldValue<EXTEN, 2>;
+    using Both     = ::reg::FieldValue<EXTEN, 3>;
+};
+struct SWSTART : reg::Bit<CR2, 30> {};
+}
+} // namespace adc1
+
+namespace spi1 {
+using CR1 = reg::Register<REG_AT(SPI1_BASE, SPI_TypeDef, CR1)>;
+
+namespace cr1 {
+struct CPHA : reg::Bit<CR1, 0> {};
+struct CPOL : reg::Bit<CR1, 1> {};
+struct MSTR : reg::Bit<CR1, 2> {};
+struct BR : reg::Field<CR1, 3, 3>
+{
+    using Div2   = ::reg::FieldValue<BR, 0>;
+    using Div4   = ::reg::FieldValue<BR, 1>;
+    using Div8   = ::reg::FieldValue<BR, 2>;
+    using Div16  = ::reg::FieldValue<BR, 3>;
+    using Div32  = ::reg::FieldValue<BR, 4>;
+    using Div64  = ::reg::FieldValue<BR, 5>;
+    using Div128 = ::reg::FieldValue<BR, 6>;
+    using Div256 = ::reg::FieldValue<BR, 7>;
+};
+struct SPE : reg::Bit<CR1, 6> {};
+struct LSBFIRST : reg::Bit<CR1, 7> {};
+struct SSI : reg::Bit<CR1, 8> {};
+struct SSM : reg::Bit<CR1, 9> {};
+struct DFF : reg::Bit<CR1, 11> {};
+}
+} // namespace spi1
+
+/* Stream configuration register of DMA stream; Base is DMA1_Stream6_BASE etc. */
+template <uint32_t Base>
+struct DmaStream
+{
+    using CR = reg::Register<REG_AT(Base, DMA_Stream_TypeDef, CR)>;
+
+    struct EN   : reg::Bit<CR, 0> {};
+    struct TCIE : reg::Bit<CR, 4> {};
+    struct HTIE : reg::Bit<CR, 3> {};
+    struct TEIE : reg::Bit<CR, 2> {};
+    struct DIR : reg::Field<CR, 6, 2>
+    {
+        using PeriphToMem = ::reg::FieldValue<DIR, 0>;
+        using MemToPeriph = ::reg::FieldValue<DIR, 1>;
+        using MemToMem    = ::reg::FieldValue<DIR, 2>;
+    };
+    struct CIRC : reg::Bit<CR, 8> {};
+    struct PINC : reg::Bit<CR, 9> {};
+    struct MINC : reg::Bit<CR, 10> {};
+    struct PSIZE : reg::Field<CR, 11, 2>
+    {
+        using Byte = ::reg::FieldValue<PSIZE, 0>;
+        using Half = ::reg::FieldValue<PSIZE, 1>;
+        using Word = ::reg::FieldValue<PSIZE, 2>;
+    };
+    struct MSIZE : reg::Field<CR, 13, 2>
+    {
+        using Byte = ::reg::FieldValue<MSIZE, 0>;
+        using Half = ::reg::FieldValue<MSIZE, 1>;
+        using Word = ::reg::FieldValue<MSIZE, 2>;
+    };
+    struct CHSEL : reg::Field<CR, 25, 3>
+    {
+        template <unsigned N> using Channel = ::reg::FieldValue<CHSEL, N>;
+    };
+};
+
+using dma1_stream6 = DmaStream<DMA1_Stream6_BASE>;
+
+#endif /* REG_FIELD_HPP */
@@ -0,0 +1,100 @@
+/**
+ * main.c - "75" and a counter on a DMA-refreshed 7-segment display (STM32F401RE)
+ *
+ * Same display as Displaying_75_on_7_segment_led, but the digits are
+ * refreshed by TIM1 + DMA2 from a word table, so after seg7_init() the
+ * CPU touches no register to keep them lit. main() shows 75 for a second,
+ * then counts on from there every 100 ms; each new value rewrites only
+ * the table words of the digits that changed (1.1 per value).
+ *
+ * Once a second the count of rewritten words is printed over USART2 at
+ * 9600 baud:
+ *   85: 13 words rewritten for 11 values   (2 of them for "75")
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PC0..PC7 = segments a..g, dp
+ *   - PB0, PB1 = ones and tens digit selects
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "seg7_dma.h"
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void delayMs(int n);
+
+int main(void)
+{
+    unsigned value = 75, values = 1;
+
+    USART2_init();
+    seg7_init(2, 100);
+    seg7_dec(value);
+    delayMs(1000);
+
+    while (1)
+    {
+        value = (value + 1) % 100;
+        seg7_dec(value);
+        values++;
+        delayMs(100);
+
+        if (values % 10 == 1)
+            printf("%u: %lu words rewritten for %u values\r\n",
+                   value, (unsigned long)seg7_words_written, values);
+    }
+}
+
+/**
+ * Simple blocking delay:
+ * ~1 ms per 'n' at 16 MHz
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+    {
+        for (i = 0; i < 3195; i++)
+        {
+            __NOP();
+        }
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
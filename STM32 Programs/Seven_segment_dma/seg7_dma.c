@@ -0,0 +1,131 @@
+/**
+ * seg7_dma.c - 7-segment display refreshed by DMA, no CPU in steady state
+ *
+ * TIM1 (the only F401 timer whose requests reach DMA2, which in turn is
+ * the only DMA that can write the GPIO ports) runs at refresh_hz * digits:
+ *
+ *   CNT = 1   CC1 request: DMA2 Stream1 Channel 6, seg[i] -> GPIOC->BSRR
+ *   CNT = 2   CC2 request: DMA2 Stream2 Channel 6, sel[i] -> GPIOB->BSRR
+ *
+ * Between the two the previous digit shows the new segments for one timer
+ * tick (62.5 ns with PSC = 0). Both compare values lie after the counter
+ * start, so the two streams always take their first word in the same
+ * period and stay in step.
+ */
+
+#include "stm32f4xx.h"
+#include "seg7_dma.h"
+
+#define SEG_STREAM   DMA2_Stream1
+#define SEL_STREAM   DMA2_Stream2
+
+#define LIFCR_ALL12  0x003D0F40U   // all Stream1 and Stream2 flags
+
+const uint8_t seg7_font[16] = {
+    0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07,   // 0..7
+    0x7F, 0x6F, 0x77, 0x7C, 0x39, 0x5E, 0x79, 0x71    // 8, 9, A, b, C, d, E, F
+};
+
+uint32_t seg7_words_written;
+
+static volatile uint32_t seg[SEG7_MAX_DIGITS];   // GPIOC->BSRR words, read by DMA
+static volatile uint32_t sel[SEG7_MAX_DIGITS];   // GPIOB->BSRR words, read by DMA
+static uint8_t           shown[SEG7_MAX_DIGITS];
+static int               ndigits;
+
+/**
+ * Circular, 32-bit, memory-to-peripheral on Channel 6
+ */
+static void stream_init(DMA_Stream_TypeDef *s, volatile uint32_t *table, volatile uint32_t *bsrr)
+{
+    s->CR &= ~1U;
+    while (s->CR & 1U) {}
+    s->PAR  = (uint32_t)bsrr;
+    s->M0AR = (uint32_t)table;
+    s->NDTR = (uint32_t)ndigits;
+    s->FCR  = 0;                       // direct mode
+    s->CR   = 0x0C005540U;             // Channel6, 32-bit, MINC, CIRC, mem-to-periph
+    s->CR   = 0x0C005541U;             // EN
+}
+
+/**
+ * Segment pins and the first 'digits' select pins as outputs, digits
+ * blank, both streams running and TIM1 at refresh_hz * digits
+ */
+void seg7_init(int digits, uint32_t refresh_hz)
+{
+    uint32_t all = (1U << digits) - 1U;
+    int i;
+
+    ndigits = digits;
+    for (i = 0; i < digits; i++) {
+        seg[i]   = (uint32_t)0xFFU << 16;                  // all segments off
+        sel[i]   = (1U << i) | ((all & ~(1U << i)) << 16);
+        shown[i] = SEG7_BLANK;
+    }
+
+    RCC->AHB1ENR |= (1U << 1) | (1U << 2) | (1U << 22);   // GPIOB, GPIOC, DMA2 clocks
+    RCC->APB2ENR |= (1U << 0);                            // TIM1 clock
+    GPIOC->MODER &= ~0x0000FFFF;
+    GPIOC->MODER |=  0x00005555;                          // PC7..PC0 outputs
+    GPIOB->BSRR   = all << 16;                            // all digits off
+    GPIOB->MODER &= ~((1U << (2 * digits)) - 1U);
+    GPIOB->MODER |=  0x5555U & ((1U << (2 * digits)) - 1U);
+
+    TIM1->CR1 = 0;
+    DMA2->LIFCR = LIFCR_ALL12;
+    stream_init(SEG_STREAM, seg, &GPIOC->BSRR);
+    stream_init(SEL_STREAM, sel, &GPIOB->BSRR);
+
+    TIM1->CCR1 = 1;
+    TIM1->CCR2 = 2;
+    TIM1->DIER = (1U << 9) | (1U << 10);                  // CC1DE, CC2DE
+    seg7_set_refresh(refresh_hz);
+    TIM1->EGR  = 1;                                       // UG: load PSC now
+    TIM1->CR1  = 1;                                       // CEN
+}
+
+/**
+ * Each digit lit refresh_hz times a second. Both requests come from the
+ * same counter, so the streams stay in step whatever the period.
+ */
+void seg7_set_refresh(uint32_t refresh_hz)
+{
+    uint32_t ticks = 16000000U / (refresh_hz * (uint32_t)ndigits);   // 16 MHz TIM1 clock
+    uint32_t psc = (ticks - 1U) / 65536U;
+
+    TIM1->PSC = psc;                  // preloaded: takes effect at the next update
+    TIM1->ARR = ticks / (psc + 1U) - 1U;
+}
+
+/**
+ * Raw segment pattern (bit 0 = a .. bit 6 = g, bit 7 = dp) at position
+ * pos, 0 = rightmost. Returns 1 if the table word was rewritten.
+ */
+int seg7_put(int pos, uint8_t segments)
+{
+    if (shown[pos] == segments)
+        return 0;
+    shown[pos] = segments;
+    seg[pos] = segments | ((uint32_t)(uint8_t)~segments << 16);
+    seg7_words_written++;
+    return 1;
+}
+
+/**
+ * Decimal value right aligned, leading zeros blank. Returns the number of
+ * table words rewritten.
+ */
+int seg7_dec(unsigned value)
+{
+    int pos, n = 0;
+
+    for (pos = 0; pos < ndigits; pos++) {
+        if (pos > 0 && value == 0)
+            n += seg7_put(pos, SEG7_BLANK);
+        else
+            n += seg7_put(pos, seg7_font[value % 10U]);
+        value /= 10U;
+    }
+    return n;
+}
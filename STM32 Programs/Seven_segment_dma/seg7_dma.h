@@ -0,0 +1,43 @@
+/**
+ * seg7_dma.h - 7-segment display refreshed by DMA, no CPU in steady state
+ *
+ * Same wiring as Displaying_75_on_7_segment_led, common cathode:
+ *   - PC0..PC6 = segments a..g, PC7 = dp (high = lit)
+ *   - PB0..PB7 = digit selects, PB0 = rightmost digit (high = selected)
+ *
+ * One frame is two tables of BSRR words, one word per digit: seg[] for
+ * GPIOC (segments of digit i set, all others reset) and sel[] for GPIOB
+ * (digit i selected, all others deselected). TIM1 ticks once per digit;
+ * its CC1 and CC2 DMA requests make DMA2 Stream1 copy the next seg[] word
+ * and, one timer tick later, DMA2 Stream2 the next sel[] word. Both
+ * streams are circular, so the display refreshes with no interrupt and no
+ * CPU access at all.
+ *
+ * seg7_put() rewrites one word of seg[] only if the pattern changed, so
+ * showing a new value costs one RAM store per digit that differs.
+ *
+ *   seg7_init(2, 100);       2 digits, each refreshed 100 times a second
+ *   seg7_dec(75);            "75"
+ */
+
+#ifndef SEG7_DMA_H
+#define SEG7_DMA_H
+
+#include <stdint.h>
+
+#define SEG7_MAX_DIGITS   8
+
+#define SEG7_DP       0x80U
+#define SEG7_MINUS    0x40U
+#define SEG7_BLANK    0x00U
+
+extern const uint8_t seg7_font[16];     // 0..9, A..F
+
+void seg7_init(int digits, uint32_t refresh_hz);
+void seg7_set_refresh(uint32_t refresh_hz);
+int  seg7_put(int pos, uint8_t segments);
+int  seg7_dec(unsigned value);
+
+extern uint32_t seg7_words_written;     // seg[] words rewritten so far
+
+#endif /* SEG7_DMA_H */
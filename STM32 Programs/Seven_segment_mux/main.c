@@ -0,0 +1,134 @@
+/**
+ * main.c - 4-digit counter on a multiplexed 7-segment display (STM32F401RE)
+ *
+ * Displaying_75_on_7_segment_led multiplexes in the foreground with
+ * delayMs(8) per digit, so the display flickers as soon as main() does
+ * anything else. Here TIM3 refreshes the digits from a framebuffer and
+ * main() only writes the digits it wants shown: a tenths-of-a-second
+ * counter with the decimal point after the seconds.
+ *
+ * Once a second the ISR cost is printed over USART2 at 9600 baud; after
+ * 3 s the refresh rate goes from 200 Hz to 1 kHz per digit. On the host
+ * simulator:
+ *   200 Hz: 800 ticks, ISR 12 cycles avg, 12 max
+ *   1000 Hz: 4071 ticks, ISR 12 cycles avg, 12 max
+ * (a "second" includes the time spent printing). The simulator charges
+ * only the four register accesses; on the board the RAM loads add a few
+ * cycles, and exception entry and exit (about 12 cycles each) come on top.
+ *
+ * System clock assumed 16 MHz.
+ *
+ * Pins:
+ *   - PC0..PC7 = segments a..g, dp
+ *   - PB0..PB3 = digit selects, PB0 = rightmost
+ *   - PA2 = USART2_TX (AF7)
+ */
+
+#include "stm32f4xx.h"
+#include <stdio.h>
+#include "seg7.h"
+
+#define DIGITS   4
+
+void USART2_init(void);
+int  USART2_write(int ch);
+void delayMs(int n);
+void show(unsigned tenths);
+
+int main(void)
+{
+    unsigned tenths = 0;
+    uint32_t hz = 200, ticks, total;
+
+    USART2_init();
+    seg7_init(DIGITS, hz);
+
+    while (1)
+    {
+        show(tenths);
+        delayMs(100);
+        tenths++;
+
+        if (tenths % 10 == 0) {
+            __disable_irq();
+            ticks = seg7_ticks;
+            total = seg7_isr_total;
+            seg7_ticks = seg7_isr_total = 0;
+            __enable_irq();
+            printf("%lu Hz: %lu ticks, ISR %lu cycles avg, %lu max\r\n",
+                   (unsigned long)hz, (unsigned long)ticks,
+                   (unsigned long)(ticks ? total / ticks : 0), (unsigned long)seg7_isr_max);
+        }
+        if (tenths == 30) {
+            hz = 1000;
+            seg7_set_refresh(hz);
+        }
+    }
+}
+
+/**
+ * Tenths as "SSS.T", leading zeros blank
+ */
+void show(unsigned tenths)
+{
+    unsigned v = tenths % 10000;
+    int pos;
+
+    for (pos = 0; pos < DIGITS; pos++) {
+        if (pos > 1 && v == 0)
+            seg7_put(pos, SEG7_BLANK);
+        else
+            seg7_put(pos, seg7_font[v % 10] | (pos == 1 ? SEG7_DP : 0));
+        v /= 10;
+    }
+}
+
+/**
+ * Simple blocking delay:
+ * ~1 ms per 'n' at 16 MHz
+ */
+void delayMs(int n)
+{
+    volatile int i;
+    for (; n > 0; n--)
+    {
+        for (i = 0; i < 3195; i++)
+        {
+            __NOP();
+        }
+    }
+}
+
+/**
+ * Initialize USART2 @ 9600, PA2 as TX
+ */
+void USART2_init(void)
+{
+    RCC->AHB1ENR |= (1U << 0);    // Enable GPIOA clock
+    RCC->APB1ENR |= (1U << 17);   // Enable USART2 clock
+
+    GPIOA->MODER &= ~(3U << 4);   // Clear PA2 mode
+    GPIOA->MODER |= (2U << 4);    // Set PA2 to Alternate Function (AF7)
+    GPIOA->AFR[0] |= (7U << 8);   // Set PA2 to AF7 (USART2_TX)
+
+    USART2->BRR = 0x0683;  // 9600 baud @ 16 MHz
+    USART2->CR1 = (1U << 3) | (1U << 13);  // Enable TX & USART2
+}
+
+/**
+ * Send a character over USART2
+ */
+int USART2_write(int ch)
+{
+    while (!(USART2->SR & (1U << 7))) {}  // Wait until TX buffer is empty
+    USART2->DR = ch;
+    return ch;
+}
+
+/**
+ * Redirect printf() to USART2
+ */
+int fputc(int c, FILE *f)
+{
+    return USART2_write(c);
+}
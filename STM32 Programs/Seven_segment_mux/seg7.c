@@ -0,0 +1,110 @@
+/**
+ * seg7.c - Timer-interrupt multiplexed 7-segment display, 1..8 digits
+ *
+ * TIM3 counts at 1 MHz (PSC = 15) and interrupts once per digit. The ISR
+ * writes the segments first and then the digit selects, one BSRR store
+ * each. Between the two stores the previous digit shows the new segments
+ * for one bus write, far too short to be seen.
+ *
+ * fb[] and sel[] are 32-bit words, so a framebuffer update from main() is
+ * a single store and the ISR never sees half of one.
+ */
+
+#include "stm32f4xx.h"
+#include "seg7.h"
+
+const uint8_t seg7_font[16] = {
+    0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07,   // 0..7
+    0x7F, 0x6F, 0x77, 0x7C, 0x39, 0x5E, 0x79, 0x71    // 8, 9, A, b, C, d, E, F
+};
+
+volatile uint32_t seg7_ticks;
+volatile uint32_t seg7_isr_max;
+volatile uint32_t seg7_isr_total;
+
+static volatile uint32_t fb[SEG7_MAX_DIGITS];    // GPIOC->BSRR words
+static uint32_t          sel[SEG7_MAX_DIGITS];   // GPIOB->BSRR words
+static int               ndigits;
+static int               cur;
+
+/**
+ * Segment pins and the first 'digits' select pins as outputs, digits
+ * blank, TIM3 update interrupt at refresh_hz * digits
+ */
+void seg7_init(int digits, uint32_t refresh_hz)
+{
+    uint32_t all = (1U << digits) - 1U;
+    int i;
+
+    ndigits = digits;
+    for (i = 0; i < digits; i++) {
+        fb[i]  = (uint32_t)0xFFU << 16;                    // all segments off
+        sel[i] = (1U << i) | ((all & ~(1U << i)) << 16);
+    }
+
+    RCC->AHB1ENR |= (1U << 1) | (1U << 2);   // GPIOB, GPIOC clocks
+    RCC->APB1ENR |= (1U << 1);               // TIM3 clock
+    GPIOC->MODER &= ~0x0000FFFF;
+    GPIOC->MODER |=  0x00005555;             // PC7..PC0 outputs
+    GPIOB->BSRR   = all << 16;               // all digits off
+    GPIOB->MODER &= ~((1U << (2 * digits)) - 1U);
+    GPIOB->MODER |=  0x5555U & ((1U << (2 * digits)) - 1U);
+
+    CoreDebug->DEMCR |= (1U << 24);          // TRCENA
+    DWT->CTRL |= 1U;                         // CYCCNTENA
+
+    TIM3->PSC  = 16 - 1;                     // 1 MHz
+    TIM3->DIER = 1;                          // UIE
+    seg7_set_refresh(refresh_hz);
+    TIM3->CR1  = 1;                          // CEN
+    NVIC_EnableIRQ(TIM3_IRQn);
+}
+
+/**
+ * Each digit lit refresh_hz times a second; takes effect at the next
+ * update event (ARR is not preloaded, so the current period may run long
+ * once if CNT is already past the new value)
+ */
+void seg7_set_refresh(uint32_t refresh_hz)
+{
+    TIM3->ARR = 1000000U / (refresh_hz * (uint32_t)ndigits) - 1U;
+    if (TIM3->CNT > TIM3->ARR)
+        TIM3->CNT = 0;
+}
+
+/**
+ * Raw segment pattern (bit 0 = a .. bit 6 = g, bit 7 = dp) at position
+ * pos, 0 = rightmost
+ */
+void seg7_put(int pos, uint8_t segments)
+{
+    fb[pos] = segments | ((uint32_t)(uint8_t)~segments << 16);
+}
+
+/**
+ * Hex digit 0..F at position pos
+ */
+void seg7_hex(int pos, unsigned value)
+{
+    seg7_put(pos, seg7_font[value & 0xFU]);
+}
+
+/**
+ * One digit per update event
+ */
+void TIM3_IRQHandler(void)
+{
+    uint32_t t0 = DWT->CYCCNT, dt;
+    int i = cur;
+
+    TIM3->SR = ~1U;                          // clear UIF
+    GPIOC->BSRR = fb[i];
+    GPIOB->BSRR = sel[i];
+    cur = (i + 1 == ndigits) ? 0 : i + 1;
+
+    dt = DWT->CYCCNT - t0;
+    seg7_ticks++;
+    seg7_isr_total += dt;
+    if (dt > seg7_isr_max)
+        seg7_isr_max = dt;
+}
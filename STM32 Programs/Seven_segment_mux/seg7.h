@@ -0,0 +1,45 @@
+/**
+ * seg7.h - Timer-interrupt multiplexed 7-segment display, 1..8 digits
+ *
+ * Same wiring as Displaying_75_on_7_segment_led, common cathode:
+ *   - PC0..PC6 = segments a..g, PC7 = dp (high = lit)
+ *   - PB0..PB7 = digit selects, PB0 = rightmost digit (high = selected)
+ *
+ * The application writes the framebuffer with seg7_put()/seg7_hex(); each
+ * digit is stored as the finished GPIOC->BSRR word, so the TIM3 update
+ * interrupt only copies two words per tick:
+ *
+ *   GPIOC->BSRR = fb[i];     segments of digit i set, all others reset
+ *   GPIOB->BSRR = sel[i];    digit i selected, all others deselected
+ *
+ * One tick per digit, so the timer runs at refresh_hz * digits.
+ *
+ *   seg7_init(4, 200);       4 digits, each refreshed 200 times a second
+ *   seg7_hex(0, 5);          rightmost digit shows 5
+ *   seg7_put(3, SEG7_MINUS); leftmost digit shows '-'
+ */
+
+#ifndef SEG7_H
+#define SEG7_H
+
+#include <stdint.h>
+
+#define SEG7_MAX_DIGITS   8
+
+#define SEG7_DP       0x80U
+#define SEG7_MINUS    0x40U
+#define SEG7_BLANK    0x00U
+
+extern const uint8_t seg7_font[16];     // 0..9, A..F
+
+void seg7_init(int digits, uint32_t refresh_hz);
+void seg7_set_refresh(uint32_t refresh_hz);
+void seg7_put(int pos, uint8_t segments);
+void seg7_hex(int pos, unsigned value);
+
+/* ISR cost, DWT cycles from handler entry to the last store */
+extern volatile uint32_t seg7_ticks;
+extern volatile uint32_t seg7_isr_max;
+extern volatile uint32_t seg7_isr_total;
+
+#endif /* SEG7_H */
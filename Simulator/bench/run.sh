@@ -0,0 +1,105 @@
+#!/bin/sh
+#
+# run.sh - cost-per-operation regression suite
+#
+#   sh bench/run.sh             compare every scenario with bench/baseline.csv
+#   sh bench/run.sh --update    rewrite bench/baseline.csv from this tree
+#   sh bench/run.sh uart_dma_tx spi_dac    run only the named scenarios
+#
+# Every scenario in bench/scenarios is built against the simulator, run
+# headless for a fixed virtual time and divided by its operation counter
+# (UART bytes, SPI frames, ADC conversions, LCD characters). Three costs are
+# compared per operation:
+#
+#   accesses  CPU reads + writes of peripheral registers
+#   cycles    virtual cycles the CPU was busy (accesses, __NOP(), IRQ entry)
+#   irqs      interrupts taken
+#
+# Virtual time is deterministic, so any change in these numbers comes from
+# the program or from a model. A scenario fails when a cost rises by more
+# than TOLERANCE percent (default 2) over the baseline.
+
+cd "$(dirname "$0")/.." || exit 1
+
+TOLERANCE=${TOLERANCE:-2}
+PROGRAMS="../STM32 Programs"
+BUILD=build/bench
+BASELINE=bench/baseline.csv
+
+update=0
+if [ "$1" = "--update" ]; then
+    update=1
+    shift
+fi
+only=" $* "
+
+mkdir -p "$BUILD"
+results="$BUILD/results.csv"
+echo "scenario,ops,accesses,cycles,irqs" > "$results"
+failed=0
+
+while IFS='|' read -r name dir ms opts counter; do
+    name=$(echo "$name" | sed 's/^ *//; s/ *$//')
+    case "$name" in ''|'#'*) continue ;; esac
+    if [ "$only" != "  " ]; then
+        case "$only" in *" $name "*) ;; *) continue ;; esac
+    fi
+    dir=$(echo "$dir" | sed 's/^ *//; s/ *$//')
+    ms=$(echo "$ms" | tr -d ' ')
+    counter=$(echo "$counter" | tr -d ' ')
+
+    if ! make -s BUILD="$BUILD" PROGRAM="$PROGRAMS/$dir" > "$BUILD/make.log" 2>&1; then
+        echo "$name: build failed" >&2
+        cat "$BUILD/make.log" >&2
+        failed=1
+        continue
+    fi
+    eval "set -- $opts"
+    if ! "$BUILD/sim" -q -t "$ms" -s "$BUILD/$name.csv" "$@" > /dev/null; then
+        echo "$name: simulator failed" >&2
+        failed=1
+        continue
+    fi
+
+    awk -F, -v name="$name" -v counter="$counter" '
+        NR == 1 { next }
+        $1 == counter { ops = $2 }
+        $1 == "core.cpu_cycles" { cycles = $2 }
+        $1 == "core.irqs" { irqs = $2 }
+        $3 != "" && $1 != "virtual_cycles" { accesses += $2 + $3 }
+        END {
+            if (ops == 0) { printf "%s: no %s operations\n", name, counter > "/dev/stderr"; exit 1 }
+            printf "%s,%d,%.2f,%.1f,%.4f\n", name, ops, accesses / ops, cycles / ops, irqs / ops
+        }' "$BUILD/$name.csv" >> "$results" || failed=1
+done < bench/scenarios
+
+if [ $update -eq 1 ]; then
+    cp "$results" "$BASELINE"
+    echo "baseline written to $BASELINE"
+    exit $failed
+fi
+
+awk -F, -v tol="$TOLERANCE" '
+    function check(what, base, now) {
+        if (now > base * (1 + tol / 100) + 1e-9) {
+            printf "  %-14s %-9s %12s -> %-12s +%.1f%%  REGRESSION\n", $1, what, base, now,
+                   (base > 0 ? (now - base) * 100 / base : 100)
+            bad = 1
+        } else if (now < base * (1 - tol / 100) - 1e-9) {
+            printf "  %-14s %-9s %12s -> %-12s %.1f%%\n", $1, what, base, now,
+                   (now - base) * 100 / base
+        }
+    }
+    FNR == 1 { next }
+    NR == FNR { acc[$1] = $3; cyc[$1] = $4; irq[$1] = $5; next }
+    {
+        printf "%-14s %8d ops %10s acc/op %12s cyc/op %8s irq/op\n", $1, $2, $3, $4, $5
+        if (!($1 in acc)) { print "  not in baseline"; next }
+        check("accesses", acc[$1], $3)
+        check("cycles", cyc[$1], $4)
+        check("irqs", irq[$1], $5)
+    }
+    END { exit bad }' "$BASELINE" "$results" || failed=1
+
+[ $failed -eq 0 ] && echo "all scenarios within ${TOLERANCE}% of the baseline"
+exit $failed
@@ -0,0 +1,243 @@
+/**
+ * core_cm4.h - Host replacement for the CMSIS Cortex-M4 core header
+ *
+ * Provides the core peripheral layouts (NVIC, SCB, SysTick, DWT, CoreDebug)
+ * at their architectural addresses and maps the CMSIS intrinsics that the
+ * programs use onto simulator calls, so that main.c files written for the
+ * Nucleo-F401RE compile unmodified with the host compiler.
+ */
+
+#ifndef __CORE_CM4_H_GENERIC
+#define __CORE_CM4_H_GENERIC
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __CM4_CMSIS_VERSION_MAIN  5U
+#define __CM4_CMSIS_VERSION_SUB   6U
+#define __CORTEX_M                4U
+#define __FPU_USED                1U
+
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+#define __IM    volatile const
+#define __OM    volatile
+#define __IOM   volatile
+
+#define __ASM                   __asm__
+#define __INLINE                inline
+#define __STATIC_INLINE         static inline
+#define __STATIC_FORCEINLINE    static inline __attribute__((always_inline))
+#define __NO_RETURN             __attribute__((__noreturn__))
+#define __USED                  __attribute__((used))
+#define __WEAK                  __attribute__((weak))
+#define __PACKED                __attribute__((packed))
+#define __ALIGNED(x)            __attribute__((aligned(x)))
+#define __RESTRICT              __restrict
+
+/* ---------------- Core peripheral register layouts ---------------- */
+
+typedef struct
+{
+    __IOM uint32_t ISER[8U];
+          uint32_t RESERVED0[24U];
+    __IOM uint32_t ICER[8U];
+          uint32_t RESERVED1[24U];
+    __IOM uint32_t ISPR[8U];
+          uint32_t RESERVED2[24U];
+    __IOM uint32_t ICPR[8U];
+          uint32_t RESERVED3[24U];
+    __IOM uint32_t IABR[8U];
+          uint32_t RESERVED4[56U];
+    __IOM uint8_t  IP[240U];
+          uint32_t RESERVED5[644U];
+    __OM  uint32_t STIR;
+} NVIC_Type;
+
+typedef struct
+{
+    __IM  uint32_t CPUID;
+    __IOM uint32_t ICSR;
+    __IOM uint32_t VTOR;
+    __IOM uint32_t AIRCR;
+    __IOM uint32_t SCR;
+    __IOM uint32_t CCR;
+    __IOM uint8_t  SHP[12U];
+    __IOM uint32_t SHCSR;
+    __IOM uint32_t CFSR;
+    __IOM uint32_t HFSR;
+    __IOM uint32_t DFSR;
+    __IOM uint32_t MMFAR;
+    __IOM uint32_t BFAR;
+    __IOM uint32_t AFSR;
+    __IM  uint32_t PFR[2U];
+    __IM  uint32_t DFR;
+    __IM  uint32_t ADR;
+    __IM  uint32_t MMFR[4U];
+    __IM  uint32_t ISAR[5U];
+          uint32_t RESERVED0[5U];
+    __IOM uint32_t CPACR;
+} SCB_Type;
+
+typedef struct
+{
+    __IOM uint32_t CTRL;
+    __IOM uint32_t LOAD;
+    __IOM uint32_t VAL;
+    __IM  uint32_t CALIB;
+} SysTick_Type;
+
+typedef struct
+{
+    __IOM uint32_t CTRL;
+    __IOM uint32_t CYCCNT;
+    __IOM uint32_t CPICNT;
+    __IOM uint32_t EXCCNT;
+    __IOM uint32_t SLEEPCNT;
+    __IOM uint32_t LSUCNT;
+    __IOM uint32_t FOLDCNT;
+    __IM  uint32_t PCSR;
+} DWT_Type;
+
+typedef struct
+{
+    __IOM uint32_t DHCSR;
+    __OM  uint32_t DCRSR;
+    __IOM uint32_t DCRDR;
+    __IOM uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define SCS_BASE            (0xE000E000UL)
+#define DWT_BASE            (0xE0001000UL)
+#define CoreDebug_BASE      (0xE000EDF0UL)
+#define SysTick_BASE        (SCS_BASE +  0x0010UL)
+#define NVIC_BASE           (SCS_BASE +  0x0100UL)
+#define SCB_BASE            (SCS_BASE +  0x0D00UL)
+
+#define SCB                 ((SCB_Type       *)     SCB_BASE      )
+#define SysTick             ((SysTick_Type   *)     SysTick_BASE  )
+#define NVIC                ((NVIC_Type      *)     NVIC_BASE     )
+#define DWT                 ((DWT_Type       *)     DWT_BASE      )
+#define CoreDebug           ((CoreDebug_Type *)     CoreDebug_BASE)
+
+#define SysTick_CTRL_COUNTFLAG_Msk   (1UL << 16U)
+#define SysTick_CTRL_CLKSOURCE_Msk   (1UL << 2U)
+#define SysTick_CTRL_TICKINT_Msk     (1UL << 1U)
+#define SysTick_CTRL_ENABLE_Msk      (1UL << 0U)
+#define SysTick_LOAD_RELOAD_Msk      (0xFFFFFFUL)
+#define SCB_SCR_SEVONPEND_Msk        (1UL << 4U)
+#define SCB_SCR_SLEEPDEEP_Msk        (1UL << 2U)
+#define SCB_SCR_SLEEPONEXIT_Msk      (1UL << 1U)
+#define DWT_CTRL_CYCCNTENA_Msk       (1UL << 0U)
+#define CoreDebug_DEMCR_TRCENA_Msk   (1UL << 24U)
+
+/* ---------------- Intrinsics, routed to the simulator ---------------- */
+
+void     sim_nop(void);
+void     sim_wfi(void);
+uint32_t sim_get_primask(void);
+void     sim_set_primask(uint32_t pm);
+uint32_t sim_ldrex(volatile uint32_t *addr);
+uint32_t sim_strex(uint32_t val, volatile uint32_t *addr);
+void     sim_clrex(void);
+void     sim_system_reset(void) __attribute__((__noreturn__));
+
+#define __NOP()             sim_nop()
+#define __WFI()             sim_wfi()
+#define __WFE()             sim_wfi()
+#define __SEV()             ((void)0)
+#define __ISB()             __sync_synchronize()
+#define __DSB()             __sync_synchronize()
+#define __DMB()             __sync_synchronize()
+#define __BKPT(value)       __builtin_trap()
+#define __enable_irq()      sim_set_primask(0U)
+#define __disable_irq()     sim_set_primask(1U)
+#define __get_PRIMASK()     sim_get_primask()
+#define __set_PRIMASK(pm)   sim_set_primask(pm)
+#define __LDREXW(ptr)       sim_ldrex((volatile uint32_t *)(ptr))
+#define __STREXW(val, ptr)  sim_strex((val), (volatile uint32_t *)(ptr))
+#define __CLREX()           sim_clrex()
+
+__STATIC_FORCEINLINE uint32_t __REV(uint32_t value)   { return __builtin_bswap32(value); }
+__STATIC_FORCEINLINE uint32_t __REV16(uint32_t value)
+{
+    return ((value & 0xFF00FF00UL) >> 8) | ((value & 0x00FF00FFUL) << 8);
+}
+__STATIC_FORCEINLINE uint8_t  __CLZ(uint32_t value)   { return value ? (uint8_t)__builtin_clz(value) : 32U; }
+__STATIC_FORCEINLINE uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0U;
+    int i;
+    for (i = 0; i < 32; i++) {
+        result = (result << 1) | (value & 1U);
+        value >>= 1;
+    }
+    return result;
+}
+
+/* ---------------- NVIC / SysTick helpers ---------------- */
+
+__STATIC_INLINE void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    if ((int32_t)IRQn >= 0)
+        NVIC->ISER[((uint32_t)IRQn) >> 5UL] = (1UL << (((uint32_t)IRQn) & 0x1FUL));
+}
+
+__STATIC_INLINE void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    if ((int32_t)IRQn >= 0)
+        NVIC->ICER[((uint32_t)IRQn) >> 5UL] = (1UL << (((uint32_t)IRQn) & 0x1FUL));
+}
+
+__STATIC_INLINE uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn)
+{
+    if ((int32_t)IRQn < 0)
+        return 0U;
+    return (NVIC->ISPR[((uint32_t)IRQn) >> 5UL] >> (((uint32_t)IRQn) & 0x1FUL)) & 1UL;
+}
+
+__STATIC_INLINE void NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+    if ((int32_t)IRQn >= 0)
+        NVIC->ISPR[((uint32_t)IRQn) >> 5UL] = (1UL << (((uint32_t)IRQn) & 0x1FUL));
+}
+
+__STATIC_INLINE void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+    if ((int32_t)IRQn >= 0)
+        NVIC->ICPR[((uint32_t)IRQn) >> 5UL] = (1UL << (((uint32_t)IRQn) & 0x1FUL));
+}
+
+__STATIC_INLINE void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+    if ((int32_t)IRQn >= 0)
+        NVIC->IP[(uint32_t)IRQn] = (uint8_t)((priority << 4U) & 0xFFUL);
+    else
+        SCB->SHP[(((uint32_t)IRQn) & 0xFUL) - 4UL] = (uint8_t)((priority << 4U) & 0xFFUL);
+}
+
+__STATIC_INLINE void NVIC_SystemReset(void)
+{
+    sim_system_reset();
+}
+
+__STATIC_INLINE uint32_t SysTick_Config(uint32_t ticks)
+{
+    if ((ticks - 1UL) > SysTick_LOAD_RELOAD_Msk)
+        return 1UL;
+    SysTick->LOAD = (uint32_t)(ticks - 1UL);
+    NVIC_SetPriority(SysTick_IRQn, (1UL << 4U) - 1UL);
+    SysTick->VAL  = 0UL;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    return 0UL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CORE_CM4_H_GENERIC */
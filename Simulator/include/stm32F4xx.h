@@ -0,0 +1,3 @@
+/* Some programs include the device header with this spelling; Linux file
+   names are case sensitive. */
+#include "stm32f4xx.h"
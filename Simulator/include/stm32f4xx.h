@@ -0,0 +1,30 @@
+/**
+ * stm32f4xx.h - Host build entry point for the STM32F4 device header
+ *
+ * Selects the STM32F401xE register map (taken unchanged from the CMSIS
+ * device pack shipped with the projects) on top of the simulator's
+ * core_cm4.h.
+ */
+
+#ifndef __STM32F4xx_H
+#define __STM32F4xx_H
+
+#ifndef STM32F401xE
+#define STM32F401xE
+#endif
+
+#include "stm32f401xe.h"
+
+typedef enum { RESET = 0U, SET = !RESET } FlagStatus, ITStatus;
+typedef enum { DISABLE = 0U, ENABLE = !DISABLE } FunctionalState;
+typedef enum { SUCCESS = 0U, ERROR = !SUCCESS } ErrorStatus;
+
+#define SET_BIT(REG, BIT)     ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)   ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)    ((REG) & (BIT))
+#define CLEAR_REG(REG)        ((REG) = (0x0))
+#define WRITE_REG(REG, VAL)   ((REG) = (VAL))
+#define READ_REG(REG)         ((REG))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK)  WRITE_REG((REG), (((READ_REG(REG)) & (~(CLEARMASK))) | (SETMASK)))
+
+#endif /* __STM32F4xx_H */
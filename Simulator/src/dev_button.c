@@ -0,0 +1,88 @@
+/**
+ * dev_button.c - Nucleo user button B1 on PC13
+ *
+ * B1 pulls PC13 low while pressed; the board's pull-up holds it high
+ * otherwise. Presses are scripted with --button MS[:HOLD_MS], repeatable,
+ * held for 100 ms unless HOLD_MS is given. Contact bounce is not
+ * modelled.
+ */
+
+#include <stdlib.h>
+#include "sim.h"
+
+#define B1_PIN       (1U << 13)
+#define MAX_PRESSES  32
+
+static struct
+{
+    sim_time_t down, up;
+} presses[MAX_PRESSES];
+static int      num_presses, next_press, pressed;
+static uint64_t press_count;
+
+int sim_button_option(const char *arg)
+{
+    char *end;
+    unsigned long long at = strtoull(arg, &end, 0), hold = 100;
+    int i;
+
+    if (end == arg || (*end && *end != ':')) {
+        fprintf(stderr, "sim: --button wants MS[:HOLD_MS], not '%s'\n", arg);
+        return 1;
+    }
+    if (*end == ':')
+        hold = strtoull(end + 1, NULL, 0);
+    if (num_presses == MAX_PRESSES) {
+        fprintf(stderr, "sim: at most %d button presses\n", MAX_PRESSES);
+        return 1;
+    }
+    /* Keep the list in time order */
+    for (i = num_presses; i > 0 && presses[i - 1].down > SIM_MS(at); i--)
+        presses[i] = presses[i - 1];
+    presses[i].down = SIM_MS(at);
+    presses[i].up = SIM_MS(at + hold);
+    num_presses++;
+    return 0;
+}
+
+static sim_time_t button_next_event(struct sim_periph *p)
+{
+    (void)p;
+    if (next_press >= num_presses)
+        return SIM_NEVER;
+    return pressed ? presses[next_press].up : presses[next_press].down;
+}
+
+static void button_advance(struct sim_periph *p)
+{
+    (void)p;
+    while (next_press < num_presses) {
+        if (!pressed && presses[next_press].down <= sim_now) {
+            pressed = 1;
+            press_count++;
+            sim_gpio_drive(SIM_PORTC, B1_PIN, 0);
+            if (sim_verbose)
+                sim_log("B1 pressed");
+        } else if (pressed && presses[next_press].up <= sim_now) {
+            pressed = 0;
+            next_press++;
+            sim_gpio_drive(SIM_PORTC, B1_PIN, B1_PIN);
+            if (sim_verbose)
+                sim_log("B1 released");
+        } else {
+            break;
+        }
+    }
+}
+
+static struct sim_periph button = {
+    .name = "B1", .base = 0, .size = 0,
+    .next_event = button_next_event, .advance = button_advance,
+};
+
+void sim_button_init(void)
+{
+    sim_gpio_drive(SIM_PORTC, B1_PIN, B1_PIN);
+    sim_register(&button);
+    sim_add_counter("b1.presses", &press_count);
+}
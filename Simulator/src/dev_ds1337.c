@@ -0,0 +1,183 @@
+/**
+ * dev_ds1337.c - DS1337 real-time clock on I2C1, address 0x68
+ *
+ * Sixteen registers with the usual auto-incrementing register pointer. The
+ * time registers count in BCD once per virtual second, starting from a fixed
+ * date so runs are reproducible.
+ *
+ * SQW/INTA drives PB4. With INTCN = 0 it is a square wave at the rate
+ * selected by RS2:RS1 (1 Hz, 4.096, 8.192 or 32.768 kHz), the 1 Hz wave
+ * falling as the seconds register counts; with INTCN = 1 (alarms are not
+ * modelled) or the oscillator stopped it stays high through the pull-up.
+ * Faster waves are only stepped edge by edge while EXTI4 listens to PB4;
+ * otherwise PB4 catches up once a second, which keeps the 32.768 kHz
+ * reset default from splitting every poll loop into 15 us pieces.
+ */
+
+#include "sim.h"
+
+#define NUM_REGS 16
+#define SQW_PIN  (1U << 4)              /* PB4 */
+
+static struct
+{
+    uint8_t    regs[NUM_REGS];
+    uint8_t    ptr;
+    int        first;           /* next written byte sets the pointer */
+    sim_time_t next_tick;
+    sim_time_t sqw_base;        /* last seconds boundary, a falling edge */
+    uint64_t   sqw_edges;       /* edges since sqw_base */
+    uint32_t   sqw_hz;          /* 0 while no square wave is output */
+    uint64_t   reads, writes;
+} rtc = {
+    /* 12:00:00, Monday 01/01/24, oscillator running, SQW 1 Hz */
+    .regs = { 0x00, 0x00, 0x12, 0x01, 0x01, 0x01, 0x24, 0, 0, 0, 0, 0, 0, 0, 0x18, 0x00 },
+};
+
+static uint8_t bcd_inc(uint8_t v, uint8_t wrap, uint8_t start, int *carry)
+{
+    uint8_t bin = (uint8_t)((v >> 4) * 10U + (v & 0xFU)) + 1U;
+
+    *carry = bin >= wrap;
+    if (*carry)
+        bin = start;
+    return (uint8_t)(((bin / 10U) << 4) | (bin % 10U));
+}
+
+static void tick(void)
+{
+    static const uint8_t days[12] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    uint8_t *r = rtc.regs;
+    int carry, month;
+
+    r[0] = bcd_inc(r[0] & 0x7FU, 60, 0, &carry);
+    if (!carry) return;
+    r[1] = bcd_inc(r[1] & 0x7FU, 60, 0, &carry);
+    if (!carry) return;
+    r[2] = (uint8_t)((r[2] & 0x40U) | bcd_inc(r[2] & 0x3FU, 24, 0, &carry));
+    if (!carry) return;
+    r[3] = bcd_inc(r[3] & 7U, 8, 1, &carry);
+    month = ((r[5] >> 4) & 1) * 10 + (r[5] & 0xF);
+    r[4] = bcd_inc(r[4] & 0x3FU, (uint8_t)(days[(month + 11) % 12] + 1), 1, &carry);
+    if (!carry) return;
+    r[5] = (uint8_t)((r[5] & 0x80U) | bcd_inc(r[5] & 0x1FU, 13, 1, &carry));
+    if (!carry) return;
+    r[6] = bcd_inc(r[6], 100, 0, &carry);
+}
+
+static sim_time_t sqw_edge_time(uint64_t k)
+{
+    return rtc.sqw_base + k * SIM_HZ / (2U * rtc.sqw_hz);
+}
+
+static void sqw_output(void)
+{
+    sim_gpio_drive(SIM_PORTB, SQW_PIN, (!rtc.sqw_hz || (rtc.sqw_edges & 1U)) ? SQW_PIN : 0U);
+}
+
+/* Follow the control register; the wave stays in phase with the seconds */
+static void sqw_config(void)
+{
+    static const uint32_t rates[4] = { 1, 4096, 8192, 32768 };
+    uint8_t ctl = rtc.regs[14];
+
+    rtc.sqw_hz = ((ctl & 0x84U) == 0) ? rates[(ctl >> 3) & 3U] : 0U;
+    rtc.sqw_base = rtc.next_tick - SIM_HZ;
+    rtc.sqw_edges = 0;
+    if (rtc.sqw_hz)
+        while (sqw_edge_time(rtc.sqw_edges + 1U) <= sim_now)
+            rtc.sqw_edges++;
+    sqw_output();
+    sim_reschedule();
+}
+
+static void start(int read)
+{
+    if (!read)
+        rtc.first = 1;
+}
+
+static void ds_write(uint8_t v)
+{
+    rtc.writes++;
+    if (rtc.first) {
+        rtc.first = 0;
+        rtc.ptr = v % NUM_REGS;
+        return;
+    }
+    rtc.regs[rtc.ptr] = v;
+    if (rtc.ptr == 14)
+        sqw_config();
+    rtc.ptr = (uint8_t)((rtc.ptr + 1U) % NUM_REGS);
+}
+
+static uint8_t ds_read(void)
+{
+    uint8_t v = rtc.regs[rtc.ptr];
+
+    rtc.reads++;
+    rtc.ptr = (uint8_t)((rtc.ptr + 1U) % NUM_REGS);
+    return v;
+}
+
+static void ds1337_report(FILE *f)
+{
+    uint8_t *r = rtc.regs;
+
+    fprintf(f, "  DS1337: %llu register writes, %llu reads, time %02X:%02X:%02X %02X/%02X/%02X, "
+               "oscillator %s\n", (unsigned long long)rtc.writes, (unsigned long long)rtc.reads,
+            r[2] & 0x3FU, r[1], r[0], r[4], r[5] & 0x1FU, r[6], (r[14] & 0x80U) ? "stopped" : "running");
+}
+
+/* The clock is not on any bus address, it only ticks */
+static sim_time_t ds1337_next_event(struct sim_periph *p)
+{
+    sim_time_t sqw;
+
+    (void)p;
+    if (!rtc.sqw_hz || (rtc.sqw_hz > 1U && !sim_exti_listening(SIM_PORTB, 4)))
+        return rtc.next_tick;
+    sqw = sqw_edge_time(rtc.sqw_edges + 1U);
+    return sqw < rtc.next_tick ? sqw : rtc.next_tick;
+}
+
+static void ds1337_advance(struct sim_periph *p)
+{
+    uint64_t k = rtc.sqw_edges;
+
+    (void)p;
+    while (rtc.sqw_hz && sqw_edge_time(k + 1U) <= sim_now)
+        k++;
+    if (k != rtc.sqw_edges) {
+        rtc.sqw_edges = k;
+        sqw_output();
+    }
+    while (rtc.next_tick <= sim_now) {
+        if (!(rtc.regs[14] & 0x80U))      /* EOSC */
+            tick();
+        rtc.next_tick += SIM_HZ;
+        if (rtc.sqw_hz) {                 /* keep the edge arithmetic small */
+            rtc.sqw_base += SIM_HZ;
+            rtc.sqw_edges -= 2U * rtc.sqw_hz;
+        }
+    }
+}
+
+static struct sim_periph ds1337_clock = {
+    .name = "DS1337", .base = 0, .size = 0,
+    .next_event = ds1337_next_event, .advance = ds1337_advance,
+};
+
+static struct sim_i2c_device ds1337 = {
+    .name = "DS1337", .addr = 0x68, .start = start, .write = ds_write, .read = ds_read,
+    .report = ds1337_report,
+};
+
+void sim_ds1337_init(void)
+{
+    rtc.next_tick = SIM_HZ;
+    sqw_config();
+    sim_register(&ds1337_clock);
+    sim_i2c_attach(&ds1337);
+    sim_add_counter("ds1337.reads", &rtc.reads);
+}
@@ -0,0 +1,264 @@
+/**
+ * dev_hd44780.c - HD44780 character LCD on the 8-bit bus of the LCD programs
+ *
+ * Wiring as in "LCD 8bit mode": D0..D7 on PC0..PC7, RS on PB5, R/W on PB6,
+ * EN on PB7. A write is latched on the falling edge of EN; with R/W high the
+ * controller drives BF and the address counter onto PC0..PC7 for as long as
+ * EN is high. Every instruction keeps the controller busy for its datasheet
+ * execution time (37 us, 1.52 ms for clear/home at 270 kHz), and anything
+ * written while busy is counted and ignored, exactly where a real module
+ * would lose characters.
+ *
+ * The module is 16x2 unless --lcd COLSxROWS says otherwise (20x4, 16x4,
+ * 20x2, ...); rows 3 and 4 continue lines 1 and 2 of DDRAM after COLS
+ * characters, as on the real 4-line modules. The same controller also
+ * sits behind the PCF8574 backpack (dev_pcf8574.c), which feeds it
+ * 4-bit write cycles through sim_hd44780_write(). Custom characters (codes
+ * 0..15) are drawn by how many of their 40 pixels are lit: ' ' . : + #.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+#define PIN_RS   (1U << 5)
+#define PIN_RW   (1U << 6)
+#define PIN_EN   (1U << 7)
+
+static struct
+{
+    uint8_t    ddram[80];
+    uint8_t    cgram[64];
+    uint8_t    ac;
+    int        cgram_mode;
+    int        increment, shift_display;
+    int        display_on, cursor_on, blink_on;
+    int        two_lines, eight_bit;
+    int        nibble_pending;    /* 4-bit mode: high half received */
+    uint8_t    nibble;
+    int        offset;            /* display shift */
+    sim_time_t busy_until;
+    int        driving;
+    int        used;
+
+    uint64_t   commands, data, cgram_writes, polls, while_busy;
+} lcd = { .increment = 1, .eight_bit = 1 };
+
+static int cols = 16, rows = 2;
+
+int sim_hd44780_option(const char *arg)
+{
+    char *end;
+    long c = strtol(arg, &end, 10), r = 0;
+
+    if (*end == 'x')
+        r = strtol(end + 1, &end, 10);
+    if (*end || c < 8 || c > 40 || (r != 1 && r != 2 && r != 4) || c * (r == 4 ? 2 : 1) > 40) {
+        fprintf(stderr, "sim: --lcd wants COLSxROWS with 1, 2 or 4 rows, not '%s'\n", arg);
+        return 1;
+    }
+    cols = (int)c;
+    rows = (int)r;
+    return 0;
+}
+
+static uint8_t status(void)
+{
+    return (uint8_t)((sim_now < lcd.busy_until ? 0x80U : 0U) | (lcd.ac & 0x7FU));
+}
+
+static void move_ac(int dir)
+{
+    if (lcd.cgram_mode) {
+        lcd.ac = (uint8_t)((lcd.ac + dir) & 0x3FU);
+        return;
+    }
+    if (lcd.two_lines) {
+        /* 0x00..0x27 and 0x40..0x67, wrapping from one line into the other */
+        int a = lcd.ac + dir;
+        if (a == 0x28) a = 0x40;
+        else if (a == 0x68) a = 0x00;
+        else if (a == 0x3F) a = 0x27;
+        else if (a < 0) a = 0x67;
+        lcd.ac = (uint8_t)a;
+    } else {
+        lcd.ac = (uint8_t)((lcd.ac + 80 + dir) % 80);
+    }
+}
+
+static int ddram_index(uint8_t addr)
+{
+    if (lcd.two_lines)
+        return addr >= 0x40 ? 40 + (addr - 0x40) % 40 : addr % 40;
+    return addr % 80;
+}
+
+static void command(uint8_t c)
+{
+    sim_time_t t = SIM_US(37);
+
+    lcd.commands++;
+    if (c & 0x80) {
+        lcd.cgram_mode = 0;
+        lcd.ac = c & 0x7FU;
+    } else if (c & 0x40) {
+        lcd.cgram_mode = 1;
+        lcd.ac = c & 0x3FU;
+    } else if (c & 0x20) {
+        lcd.eight_bit = (c & 0x10) != 0;
+        lcd.nibble_pending = 0;
+        lcd.two_lines = (c & 0x08) != 0;
+    } else if (c & 0x10) {
+        int right = (c & 0x04) != 0;
+        if (c & 0x08)
+            lcd.offset += right ? -1 : 1;
+        else
+            move_ac(right ? 1 : -1);
+    } else if (c & 0x08) {
+        lcd.display_on = (c & 0x04) != 0;
+        lcd.cursor_on = (c & 0x02) != 0;
+        lcd.blink_on = (c & 0x01) != 0;
+    } else if (c & 0x04) {
+        lcd.increment = (c & 0x02) != 0;
+        lcd.shift_display = (c & 0x01) != 0;
+    } else if (c & 0x02) {
+        lcd.ac = 0;
+        lcd.cgram_mode = 0;
+        lcd.offset = 0;
+        t = SIM_US(1520);
+    } else if (c & 0x01) {
+        memset(lcd.ddram, ' ', sizeof(lcd.ddram));
+        lcd.ac = 0;
+        lcd.cgram_mode = 0;
+        lcd.increment = 1;
+        lcd.offset = 0;
+        t = SIM_US(1520);
+    }
+    lcd.busy_until = sim_now + t;
+}
+
+static void data(uint8_t d)
+{
+    lcd.data++;
+    if (lcd.cgram_mode) {
+        lcd.cgram[lcd.ac & 0x3FU] = d & 0x1FU;
+        lcd.cgram_writes++;
+    } else
+        lcd.ddram[ddram_index(lcd.ac)] = d;
+    move_ac(lcd.increment ? 1 : -1);
+    if (lcd.shift_display && !lcd.cgram_mode)
+        lcd.offset += lcd.increment ? 1 : -1;
+    lcd.busy_until = sim_now + SIM_US(41);
+}
+
+static void on_portb(int port, uint32_t old, uint32_t now)
+{
+    uint32_t outs = sim_gpio_outputs(SIM_PORTB);
+
+    (void)port;
+    if (!(outs & PIN_EN))
+        return;
+
+    if (!(old & PIN_EN) && (now & PIN_EN) && (now & PIN_RW)) {
+        /* Read cycle: drive the bus while EN is high */
+        lcd.used = 1;
+        if (now & PIN_RS) {
+            uint8_t v = lcd.cgram_mode ? lcd.cgram[lcd.ac & 0x3FU] : lcd.ddram[ddram_index(lcd.ac)];
+            sim_gpio_drive(SIM_PORTC, 0xFFU, v);
+            move_ac(lcd.increment ? 1 : -1);
+        } else {
+            lcd.polls++;
+            sim_gpio_drive(SIM_PORTC, 0xFFU, status());
+        }
+        lcd.driving = 1;
+    } else if ((old & PIN_EN) && !(now & PIN_EN)) {
+        if (lcd.driving) {
+            sim_gpio_release(SIM_PORTC, 0xFFU);
+            lcd.driving = 0;
+        } else if (!(now & PIN_RW)) {
+            sim_hd44780_write((now & PIN_RS) != 0, (uint8_t)sim_gpio_odr(SIM_PORTC));
+        }
+    }
+}
+
+/*
+ * A write cycle (EN falling with R/W low). In 4-bit mode only D7..D4
+ * count and two cycles, high half first, make one byte.
+ */
+void sim_hd44780_write(int rs, uint8_t bus)
+{
+    lcd.used = 1;
+    if (sim_now < lcd.busy_until) {
+        lcd.while_busy++;
+        if (sim_verbose)
+            sim_log("HD44780: 0x%02X written while busy, ignored", bus);
+        return;
+    }
+    if (!lcd.eight_bit) {
+        if (!lcd.nibble_pending) {
+            lcd.nibble = bus & 0xF0U;
+            lcd.nibble_pending = 1;
+            return;
+        }
+        bus = (uint8_t)(lcd.nibble | (bus >> 4));
+        lcd.nibble_pending = 0;
+    }
+    if (rs)
+        data(bus);
+    else
+        command(bus);
+}
+
+/* Density of custom character code & 7 */
+static char shade(uint8_t code)
+{
+    int lit = 0, r;
+
+    for (r = 0; r < 8; r++)
+        lit += __builtin_popcount(lcd.cgram[(code & 7U) * 8U + r]);
+    return " .:+#"[(lit * 4 + 39) / 40];
+}
+
+static void render(FILE *f)
+{
+    int shown = lcd.two_lines ? rows : 1, r, c;
+
+    fprintf(f, "  +%.*s+\n", cols, "----------------------------------------");
+    for (r = 0; r < shown; r++) {
+        fputs("  |", f);
+        for (c = 0; c < cols; c++) {
+            /* Rows 3 and 4 continue DDRAM lines 1 and 2 */
+            int pos = (r >> 1) * cols + c + lcd.offset;
+            uint8_t ch = lcd.two_lines ? lcd.ddram[(r & 1) * 40 + (pos % 40 + 40) % 40]
+                                       : lcd.ddram[(pos % 80 + 80) % 80];
+            fputc(!lcd.display_on ? ' ' : (ch >= 0x20 && ch < 0x7F) ? ch : ch < 16 ? shade(ch)
+                  : ch == 0xFF ? '#' : '?', f);
+        }
+        fputs("|\n", f);
+    }
+    fprintf(f, "  +%.*s+\n", cols, "----------------------------------------");
+}
+
+static void hd44780_report(FILE *f)
+{
+    if (!lcd.used)
+        return;
+    fprintf(f, "\nHD44780: %llu commands, %llu characters, %llu busy-flag polls, "
+               "%llu writes lost while busy\n",
+            (unsigned long long)lcd.commands, (unsigned long long)lcd.data,
+            (unsigned long long)lcd.polls, (unsigned long long)lcd.while_busy);
+    if (lcd.cgram_writes)
+        fprintf(f, "  %llu of the characters to CGRAM\n", (unsigned long long)lcd.cgram_writes);
+    render(f);
+}
+
+void sim_hd44780_init(void)
+{
+    memset(lcd.ddram, ' ', sizeof(lcd.ddram));
+    sim_gpio_watch(SIM_PORTB, on_portb);
+    sim_add_report(hd44780_report);
+    sim_add_counter("hd44780.commands", &lcd.commands);
+    sim_add_counter("hd44780.data", &lcd.data);
+    sim_add_counter("hd44780.cgram", &lcd.cgram_writes);
+    sim_add_counter("hd44780.polls", &lcd.polls);
+}
@@ -0,0 +1,193 @@
+/**
+ * dev_keypad.c - 4x4 matrix keypad on PC0..PC7
+ *
+ * Wiring as in Interacting with keyboard: columns on PC0..PC3, rows on
+ * PC4..PC7, key n (1..16, as keypad_getkey() numbers them) joins row
+ * (n - 1) / 4 and column (n - 1) % 4. Presses are scripted with
+ * --key MS:KEY[:HOLD_MS[:BOUNCE_MS]], repeatable and free to overlap, held
+ * for 100 ms unless HOLD_MS is given. With BOUNCE_MS the contact chatters
+ * after both edges: it flips back at a quarter and three quarters of
+ * BOUNCE_MS and forth at half of it and at BOUNCE_MS, where it settles.
+ *
+ * Pressed keys join pins into nets, so several keys held at once show the
+ * same ghost paths as a real matrix without diodes. A net is low if any
+ * of its pins drives low, high if one drives high (open-drain highs do
+ * not drive), else it follows the pull resistors; every input pin in a
+ * net of two or more pins reads that level. The model stays off PC0..PC7
+ * until the first key goes down, so the LCD programs on the same pins are
+ * not disturbed.
+ */
+
+#include <stdlib.h>
+#include "sim.h"
+
+#define MAX_EVENTS  256
+
+static struct
+{
+    sim_time_t at;
+    int        key;                /* 0..15 */
+    int        down;
+    int        bounce;             /* contact chatter, not a press */
+} events[MAX_EVENTS];
+static int      num_events, next_event;
+static uint32_t pressed;           /* bit per key */
+static uint32_t driven;            /* PC pins the model drives */
+static int      active;
+static uint64_t press_count;
+
+static int add_event(sim_time_t at, int key, int down, int bounce)
+{
+    int i;
+
+    if (num_events == MAX_EVENTS) {
+        fprintf(stderr, "sim: at most %d key edges\n", MAX_EVENTS);
+        return 1;
+    }
+    /* Keep the list in time order, releases before presses at equal times */
+    for (i = num_events; i > 0 && (events[i - 1].at > at || (events[i - 1].at == at && events[i - 1].down > down)); i--)
+        events[i] = events[i - 1];
+    events[i].at = at;
+    events[i].key = key;
+    events[i].down = down;
+    events[i].bounce = bounce;
+    num_events++;
+    return 0;
+}
+
+/* An edge at 'at' followed by chatter for 'bounce' */
+static int add_edge(sim_time_t at, int key, int down, sim_time_t bounce)
+{
+    int i;
+
+    if (add_event(at, key, down, 0))
+        return 1;
+    for (i = 1; bounce && i <= 4; i++)
+        if (add_event(at + bounce * (sim_time_t)i / 4U, key, (i & 1) ? !down : down, 1))
+            return 1;
+    return 0;
+}
+
+int sim_keypad_option(const char *arg)
+{
+    char *end;
+    unsigned long long at = strtoull(arg, &end, 0), hold = 100, bounce = 0;
+    long key;
+
+    if (end == arg || *end != ':')
+        goto bad;
+    key = strtol(end + 1, &end, 0);
+    if (key < 1 || key > 16 || (*end && *end != ':'))
+        goto bad;
+    if (*end == ':')
+        hold = strtoull(end + 1, &end, 0);
+    if (*end == ':')
+        bounce = strtoull(end + 1, &end, 0);
+    if (*end)
+        goto bad;
+    return add_edge(SIM_MS(at), (int)key - 1, 1, SIM_MS(bounce)) ||
+           add_edge(SIM_MS(at + hold), (int)key - 1, 0, SIM_MS(bounce));
+
+bad:
+    fprintf(stderr, "sim: --key wants MS:KEY[:HOLD_MS[:BOUNCE_MS]] with KEY 1..16, not '%s'\n", arg);
+    return 1;
+}
+
+static int find(int *parent, int pin)
+{
+    while (parent[pin] != pin)
+        pin = parent[pin] = parent[parent[pin]];
+    return pin;
+}
+
+/* Recompute the level of every net and drive the input pins in it */
+static void resolve(void)
+{
+    GPIO_TypeDef *g = SIM_REGS(GPIO_TypeDef, GPIOC_BASE);
+    uint32_t drives = sim_gpio_driving(SIM_PORTC), odr = sim_gpio_odr(SIM_PORTC);
+    uint32_t mask = 0, value = 0, pins;
+    int parent[8], lo[8] = { 0 }, hi[8] = { 0 }, up[8] = { 0 }, size[8] = { 0 };
+    int k, pin, root;
+
+    if (!active)
+        return;
+    for (pin = 0; pin < 8; pin++)
+        parent[pin] = pin;
+    for (k = 0; k < 16; k++)
+        if ((pressed >> k) & 1U)
+            parent[find(parent, k % 4)] = find(parent, 4 + k / 4);
+
+    for (pin = 0; pin < 8; pin++) {
+        uint32_t pull = (g->PUPDR >> (pin * 2)) & 3U;
+        root = find(parent, pin);
+        size[root]++;
+        if ((drives >> pin) & 1U) {
+            if ((odr >> pin) & 1U)
+                hi[root] = 1;
+            else
+                lo[root] = 1;
+        }
+        up[root] |= (pull == 1U);
+    }
+
+    for (pin = 0; pin < 8; pin++) {
+        root = find(parent, pin);
+        if (size[root] < 2 || ((drives >> pin) & 1U))
+            continue;
+        mask |= 1U << pin;
+        if (!lo[root] && (hi[root] || up[root]))
+            value |= 1U << pin;
+    }
+
+    pins = driven & ~mask;
+    driven = mask;
+    if (pins)
+        sim_gpio_release(SIM_PORTC, pins);
+    if (mask)
+        sim_gpio_drive(SIM_PORTC, mask, value);
+}
+
+static void on_portc(int port, uint32_t old_odr, uint32_t new_odr)
+{
+    (void)port;
+    (void)old_odr;
+    (void)new_odr;
+    resolve();
+}
+
+static sim_time_t keypad_next_event(struct sim_periph *p)
+{
+    (void)p;
+    return next_event < num_events ? events[next_event].at : SIM_NEVER;
+}
+
+static void keypad_advance(struct sim_periph *p)
+{
+    (void)p;
+    while (next_event < num_events && events[next_event].at <= sim_now) {
+        int key = events[next_event].key;
+        if (events[next_event].down) {
+            pressed |= 1U << key;
+            press_count += !events[next_event].bounce;
+            active = 1;
+        } else {
+            pressed &= ~(1U << key);
+        }
+        if (sim_verbose && !events[next_event].bounce)
+            sim_log("keypad: key %d %s", key + 1, events[next_event].down ? "pressed" : "released");
+        next_event++;
+        resolve();
+    }
+}
+
+static struct sim_periph keypad = {
+    .name = "keypad", .base = 0, .size = 0,
+    .next_event = keypad_next_event, .advance = keypad_advance,
+};
+
+void sim_keypad_init(void)
+{
+    sim_gpio_watch(SIM_PORTC, on_portc);
+    sim_register(&keypad);
+    sim_add_counter("keypad.presses", &press_count);
+}
@@ -0,0 +1,113 @@
+/**
+ * dev_ltc1661.c - LTC1661 dual 10-bit DAC on SPI1
+ *
+ * Wiring as in "SPI and DAC interface": CS/LD on PA4. The 16-bit word
+ * shifted in while CS/LD is low (control nibble, 10 data bits, two don't
+ * care bits) is executed on the rising edge of CS/LD. The report gives the
+ * update count and rate and the range each output swept through.
+ */
+
+#include "sim.h"
+
+#define PIN_CS  (1U << 4)    /* PA4 */
+#define VREF_MV 3300U
+
+static struct
+{
+    uint16_t   shift;
+    int        bits;
+    uint16_t   input[2], output[2];
+    uint16_t   min[2], max[2];
+    int        awake;
+    uint64_t   updates[2], words;
+    sim_time_t first, last;
+} d = { .min = { 0x3FF, 0x3FF } };
+
+static int selected(void)
+{
+    return (sim_gpio_outputs(SIM_PORTA) & PIN_CS) && !(sim_gpio_odr(SIM_PORTA) & PIN_CS);
+}
+
+static uint8_t transfer(uint8_t mosi)
+{
+    d.shift = (uint16_t)((d.shift << 8) | mosi);
+    d.bits += 8;
+    return 0xFF;
+}
+
+static void load(int ch)
+{
+    d.output[ch] = d.input[ch];
+    d.updates[ch]++;
+    if (d.output[ch] < d.min[ch]) d.min[ch] = d.output[ch];
+    if (d.output[ch] > d.max[ch]) d.max[ch] = d.output[ch];
+}
+
+static void execute(uint16_t w)
+{
+    uint16_t code = (w >> 2) & 0x3FFU;
+    int i;
+
+    d.words++;
+    if (!d.first)
+        d.first = sim_now;
+    d.last = sim_now;
+    switch (w >> 12) {
+    case 0x1: d.input[0] = code; break;
+    case 0x2: d.input[1] = code; break;
+    case 0x8: d.awake = 1; for (i = 0; i < 2; i++) load(i); break;
+    case 0x9: d.input[0] = code; d.awake = 1; for (i = 0; i < 2; i++) load(i); break;
+    case 0xA: d.input[1] = code; d.awake = 1; for (i = 0; i < 2; i++) load(i); break;
+    case 0xD: d.awake = 1; break;
+    case 0xE: d.awake = 0; break;
+    case 0xF: d.input[0] = d.input[1] = code; d.awake = 1; for (i = 0; i < 2; i++) load(i); break;
+    default:  break;
+    }
+    if (sim_verbose)
+        sim_log("LTC1661: word 0x%04X, VOUTA %u mV, VOUTB %u mV", w,
+                d.output[0] * VREF_MV / 1024U, d.output[1] * VREF_MV / 1024U);
+}
+
+static void on_porta(int port, uint32_t old, uint32_t now)
+{
+    (void)port;
+    if (!(sim_gpio_outputs(SIM_PORTA) & PIN_CS))
+        return;
+    if (!(old & PIN_CS) && (now & PIN_CS)) {
+        if (d.bits >= 16)
+            execute(d.shift);
+        d.bits = 0;
+    } else if ((old & PIN_CS) && !(now & PIN_CS)) {
+        d.bits = 0;
+    }
+}
+
+static void ltc1661_report(FILE *f)
+{
+    double span;
+    int i;
+
+    if (!d.words)
+        return;
+    span = (double)(d.last - d.first) / (double)SIM_HZ;
+    fprintf(f, "\nLTC1661: %llu words, %s\n", (unsigned long long)d.words, d.awake ? "awake" : "asleep");
+    for (i = 0; i < 2; i++) {
+        if (!d.updates[i])
+            continue;
+        fprintf(f, "  VOUT%c: %llu updates (%.1f/s), code %u..%u (%u..%u mV), now %u\n", 'A' + i,
+                (unsigned long long)d.updates[i], span > 0 ? (double)d.updates[i] / span : 0.0,
+                d.min[i], d.max[i], d.min[i] * VREF_MV / 1024U, d.max[i] * VREF_MV / 1024U,
+                d.output[i]);
+    }
+}
+
+static struct sim_spi_device ltc1661 = {
+    .name = "LTC1661", .transfer = transfer, .selected = selected, .report = ltc1661_report,
+};
+
+void sim_ltc1661_init(void)
+{
+    sim_spi_attach(&ltc1661);
+    sim_gpio_watch(SIM_PORTA, on_porta);
+    sim_add_counter("ltc1661.words", &d.words);
+}
@@ -0,0 +1,152 @@
+/**
+ * dev_pcd8544.c - Nokia 5110 (PCD8544) graphic LCD on SPI1
+ *
+ * Wiring as in "GCLD": SCE on PA8, D/C on PB6, RST on PB10. Bytes are taken
+ * from SPI1 while SCE is low; D/C is sampled at the end of each byte like
+ * the controller does on the eighth SCLK edge. The 84x48 RAM is printed at
+ * exit using half-block characters, two pixel rows per text line.
+ */
+
+#include "sim.h"
+
+#define PIN_SCE  (1U << 8)    /* PA8 */
+#define PIN_DC   (1U << 6)    /* PB6 */
+#define PIN_RST  (1U << 10)   /* PB10 */
+
+#define WIDTH    84
+#define BANKS    6
+
+static struct
+{
+    uint8_t  ram[BANKS][WIDTH];
+    int      x, y;
+    int      extended, vertical, power_down;
+    int      mode;               /* D,E: 0 blank, 1 all on, 2 normal, 3 inverse */
+    uint8_t  vop, bias, tc;
+    uint64_t commands, data, resets;
+} g;
+
+static int selected(void)
+{
+    return (sim_gpio_outputs(SIM_PORTA) & PIN_SCE) && !(sim_gpio_odr(SIM_PORTA) & PIN_SCE);
+}
+
+static void reset(void)
+{
+    g.x = g.y = 0;
+    g.extended = g.vertical = 0;
+    g.power_down = 1;
+    g.mode = 0;
+    g.vop = g.bias = g.tc = 0;
+}
+
+static void command(uint8_t c)
+{
+    g.commands++;
+    if ((c & 0xF8U) == 0x20U) {                 /* function set, both sets */
+        g.power_down = (c & 4U) != 0;
+        g.vertical = (c & 2U) != 0;
+        g.extended = (c & 1U) != 0;
+    } else if (!g.extended) {
+        if ((c & 0xFAU) == 0x08U)               /* display control D,E */
+            g.mode = (int)(((c >> 1) & 2U) | (c & 1U));
+        else if ((c & 0xF8U) == 0x40U)
+            g.y = (c & 7U) % BANKS;
+        else if (c & 0x80U)
+            g.x = (c & 0x7FU) % WIDTH;
+    } else {
+        if (c & 0x80U)
+            g.vop = c & 0x7FU;
+        else if ((c & 0xF8U) == 0x10U)
+            g.bias = c & 7U;
+        else if ((c & 0xFCU) == 0x04U)
+            g.tc = c & 3U;
+    }
+}
+
+static void data(uint8_t d)
+{
+    g.data++;
+    g.ram[g.y][g.x] = d;
+    if (g.vertical) {
+        if (++g.y == BANKS) {
+            g.y = 0;
+            g.x = (g.x + 1) % WIDTH;
+        }
+    } else if (++g.x == WIDTH) {
+        g.x = 0;
+        g.y = (g.y + 1) % BANKS;
+    }
+}
+
+static uint8_t transfer(uint8_t mosi)
+{
+    if (!(sim_gpio_odr(SIM_PORTB) & PIN_RST))
+        return 0xFF;
+    if (sim_gpio_odr(SIM_PORTB) & PIN_DC)
+        data(mosi);
+    else
+        command(mosi);
+    return 0xFF;
+}
+
+static void on_portb(int port, uint32_t old, uint32_t now)
+{
+    (void)port;
+    if (!(sim_gpio_outputs(SIM_PORTB) & PIN_RST) || !((old ^ now) & PIN_RST))
+        return;
+    reset();
+    if (now & PIN_RST)
+        g.resets++;
+}
+
+static int pixel(int x, int y)
+{
+    int on = (g.ram[y / 8][x] >> (y % 8)) & 1;
+
+    switch (g.mode) {
+    case 0: return 0;
+    case 1: return 1;
+    case 3: return !on;
+    default: return on;
+    }
+}
+
+static void pcd8544_report(FILE *f)
+{
+    int x, y;
+
+    if (!g.commands && !g.data)
+        return;
+    fprintf(f, "\nPCD8544: %llu commands, %llu data bytes, %llu resets, Vop 0x%02X, bias %u%s\n",
+            (unsigned long long)g.commands, (unsigned long long)g.data,
+            (unsigned long long)g.resets, g.vop, g.bias, g.power_down ? ", powered down" : "");
+    fprintf(f, "  +");
+    for (x = 0; x < WIDTH; x++)
+        fputc('-', f);
+    fprintf(f, "+\n");
+    for (y = 0; y < BANKS * 8; y += 2) {
+        fprintf(f, "  |");
+        for (x = 0; x < WIDTH; x++) {
+            int top = pixel(x, y), bottom = pixel(x, y + 1);
+            fputs(top && bottom ? "█" : top ? "▀" : bottom ? "▄" : " ", f);
+        }
+        fprintf(f, "|\n");
+    }
+    fprintf(f, "  +");
+    for (x = 0; x < WIDTH; x++)
+        fputc('-', f);
+    fprintf(f, "+\n");
+}
+
+static struct sim_spi_device pcd8544 = {
+    .name = "PCD8544", .transfer = transfer, .selected = selected, .report = pcd8544_report,
+};
+
+void sim_pcd8544_init(void)
+{
+    reset();
+    sim_spi_attach(&pcd8544);
+    sim_gpio_watch(SIM_PORTB, on_portb);
+    sim_add_counter("pcd8544.data", &g.data);
+}
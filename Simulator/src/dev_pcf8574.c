@@ -0,0 +1,64 @@
+/**
+ * dev_pcf8574.c - PCF8574 LCD backpack on I2C1, address 0x27
+ *
+ * The usual HD44780 backpack wiring: P0 RS, P1 R/W, P2 EN, P3 backlight,
+ * P4..P7 D4..D7. Every byte written sets the eight outputs at the end of
+ * its ACK; a falling edge of P2 with P1 low is a write cycle of the
+ * HD44780 model, which runs in 4-bit mode once told to by function set.
+ * Reads return the output latch (the LCD is never read through it).
+ */
+
+#include "sim.h"
+
+#define P_RS   0x01U
+#define P_RW   0x02U
+#define P_EN   0x04U
+#define P_BL   0x08U
+
+static struct
+{
+    uint8_t  port;
+    uint64_t writes, strobes;
+} pcf = { .port = 0xFF };                /* quasi-bidirectional, high at reset */
+
+static void pcf_start(int read)
+{
+    (void)read;
+}
+
+static void pcf_write(uint8_t v)
+{
+    uint8_t old = pcf.port;
+
+    pcf.writes++;
+    pcf.port = v;
+    if ((old & P_EN) && !(v & P_EN) && !(v & P_RW)) {
+        pcf.strobes++;
+        sim_hd44780_write((v & P_RS) != 0, (uint8_t)(v & 0xF0U));
+    }
+}
+
+static uint8_t pcf_read(void)
+{
+    return pcf.port;
+}
+
+static void pcf8574_report(FILE *f)
+{
+    if (!pcf.writes)
+        return;
+    fprintf(f, "  PCF8574: %llu bytes written, %llu EN strobes, backlight %s\n",
+            (unsigned long long)pcf.writes, (unsigned long long)pcf.strobes,
+            (pcf.port & P_BL) ? "on" : "off");
+}
+
+static struct sim_i2c_device pcf8574 = {
+    .name = "PCF8574", .addr = 0x27, .start = pcf_start, .write = pcf_write, .read = pcf_read,
+    .report = pcf8574_report,
+};
+
+void sim_pcf8574_init(void)
+{
+    sim_i2c_attach(&pcf8574);
+    sim_add_counter("pcf8574.writes", &pcf.writes);
+}
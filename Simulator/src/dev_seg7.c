@@ -0,0 +1,114 @@
+/**
+ * dev_seg7.c - Multiplexed common-cathode 7-segment display, up to 8 digits
+ *
+ * Wiring as in Displaying_75_on_7_segment_led: segments a..g and dp on
+ * PC0..PC7, digit n selected while PBn is high (PB0 = rightmost digit).
+ * The model only counts as connected once PB0 has selected a digit, so the
+ * LCD programs sharing PC0..PC7 are not reported as a display.
+ *
+ * For every digit it accumulates the time it was selected, counts its
+ * selections, and remembers the last pattern it showed for at least 20 us;
+ * shorter patterns are the switching moments between two digits (ghosts).
+ */
+
+#include "sim.h"
+
+#define GHOST_TIME  SIM_US(20)
+
+static struct
+{
+    int        used;
+    uint32_t   sel;                /* PB0..PB7 levels */
+    uint8_t    seg;                /* PC0..PC7 levels */
+    sim_time_t since, first;
+    sim_time_t on[8];
+    uint8_t    shown[8];
+    uint64_t   selects[8];
+    uint64_t   refreshes;
+    int        digits;
+} d;
+
+static uint32_t level(int port, uint32_t mask)
+{
+    return sim_gpio_odr(port) & sim_gpio_outputs(port) & mask;
+}
+
+static void on_change(int port, uint32_t old_odr, uint32_t new_odr)
+{
+    sim_time_t dt = sim_now - d.since;
+    uint32_t sel = level(SIM_PORTB, 0xFFU), rise;
+    int n;
+
+    (void)port;
+    (void)old_odr;
+    (void)new_odr;
+    if (!d.used && !(sel & 1U))
+        return;
+    if (!d.used) {
+        d.used = 1;
+        d.first = sim_now;
+    }
+
+    for (n = 0; n < 8; n++) {
+        if (!((d.sel >> n) & 1U))
+            continue;
+        d.on[n] += dt;
+        if (dt >= GHOST_TIME)
+            d.shown[n] = d.seg;
+    }
+
+    rise = sel & ~d.sel;
+    for (n = 0; n < 8; n++) {
+        if ((rise >> n) & 1U) {
+            d.selects[n]++;
+            d.refreshes++;
+            if (n + 1 > d.digits)
+                d.digits = n + 1;
+        }
+    }
+    d.sel = sel;
+    d.seg = (uint8_t)level(SIM_PORTC, 0xFFU);
+    d.since = sim_now;
+}
+
+static void seg7_report(FILE *f)
+{
+    sim_time_t elapsed;
+    int n, row;
+
+    if (!d.used)
+        return;
+    on_change(SIM_PORTB, 0, 0);           /* account up to now */
+    elapsed = sim_now - d.first;
+    if (!elapsed || !d.digits)
+        return;
+
+    fprintf(f, "\n7-segment: %d digits, refresh per digit (Hz) / lit (%%):", d.digits);
+    for (n = d.digits - 1; n >= 0; n--)
+        fprintf(f, " %.0f/%.1f", (double)d.selects[n] * (double)SIM_HZ / (double)elapsed,
+                (double)d.on[n] * 100.0 / (double)elapsed);
+    fputc('\n', f);
+
+    for (row = 0; row < 3; row++) {
+        fprintf(f, "  ");
+        for (n = d.digits - 1; n >= 0; n--) {
+            uint8_t s = d.shown[n];
+            if (row == 0)
+                fprintf(f, " %c  ", (s & 0x01) ? '_' : ' ');
+            else if (row == 1)
+                fprintf(f, "%c%c%c ", (s & 0x20) ? '|' : ' ', (s & 0x40) ? '_' : ' ', (s & 0x02) ? '|' : ' ');
+            else
+                fprintf(f, "%c%c%c%c", (s & 0x10) ? '|' : ' ', (s & 0x08) ? '_' : ' ', (s & 0x04) ? '|' : ' ',
+                        (s & 0x80) ? '.' : ' ');
+        }
+        fputc('\n', f);
+    }
+}
+
+void sim_seg7_init(void)
+{
+    sim_gpio_watch(SIM_PORTB, on_change);
+    sim_gpio_watch(SIM_PORTC, on_change);
+    sim_add_report(seg7_report);
+    sim_add_counter("seg7.refreshes", &d.refreshes);
+}
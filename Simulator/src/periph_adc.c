@@ -0,0 +1,269 @@
+/**
+ * periph_adc.c - ADC1 and the ADC common registers
+ *
+ * Conversions are started by SWSTART or by the timer trigger selected with
+ * EXTSEL/EXTEN, walk the regular sequence (SQR1..3, SCAN, CONT) and take
+ * sampling time + resolution ADC clock cycles at PCLK2/ADCPRE. The analog
+ * inputs are functions of virtual time: a DC level, optionally with a sine
+ * on top (--adc), plus the internal temperature sensor and VREFINT.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+#define SR_EOC      (1U << 1)
+#define SR_STRT     (1U << 4)
+#define SR_OVR      (1U << 5)
+#define CR1_EOCIE   (1U << 5)
+#define CR1_SCAN    (1U << 8)
+#define CR1_OVRIE   (1U << 26)
+#define CR2_ADON    (1U << 0)
+#define CR2_CONT    (1U << 1)
+#define CR2_DMA     (1U << 8)
+#define CR2_DDS     (1U << 9)
+#define CR2_EOCS    (1U << 10)
+#define CR2_SWSTART (1U << 30)
+
+#define VREF_MV     3300.0
+#define NUM_CHANNELS 19
+
+static struct
+{
+    double dc_mv[NUM_CHANNELS];
+    double amp_mv[NUM_CHANNELS];
+    double hz[NUM_CHANNELS];
+
+    int        converting;
+    sim_time_t done;
+    int        seq_pos;
+    int        dma_stopped;      /* DMA mode without DDS after the last item */
+    uint64_t   conversions, overruns;
+} a;
+
+static const uint16_t smp_cycles[8] = { 3, 15, 28, 56, 84, 112, 144, 480 };
+
+static ADC_TypeDef *regs(void)
+{
+    return SIM_REGS(ADC_TypeDef, ADC1_BASE);
+}
+
+static ADC_Common_TypeDef *common(void)
+{
+    return SIM_REGS(ADC_Common_TypeDef, ADC1_COMMON_BASE);
+}
+
+static int seq_length(void)
+{
+    return (int)((regs()->SQR1 >> 20) & 0xFU) + 1;
+}
+
+static int seq_channel(int pos)
+{
+    ADC_TypeDef *r = regs();
+
+    if (pos < 6)
+        return (int)((r->SQR3 >> (5 * pos)) & 0x1FU);
+    if (pos < 12)
+        return (int)((r->SQR2 >> (5 * (pos - 6))) & 0x1FU);
+    return (int)((r->SQR1 >> (5 * (pos - 12))) & 0x1FU);
+}
+
+static sim_time_t conversion_time(int ch)
+{
+    ADC_TypeDef *r = regs();
+    uint32_t smp = ch < 10 ? (r->SMPR2 >> (3 * ch)) & 7U : (r->SMPR1 >> (3 * (ch - 10))) & 7U;
+    uint32_t res = (r->CR1 >> 24) & 3U;
+    uint32_t div = 2U * (((common()->CCR >> 16) & 3U) + 1U);
+
+    return (sim_time_t)(smp_cycles[smp] + 12U - 2U * res) * div;
+}
+
+static double input_mv(int ch)
+{
+    double t = (double)sim_now / (double)SIM_HZ;
+    double v;
+
+    if (ch >= NUM_CHANNELS)
+        return 0.0;
+    v = a.dc_mv[ch];
+    if (a.amp_mv[ch] != 0.0)
+        v += a.amp_mv[ch] * sin(2.0 * M_PI * a.hz[ch] * t);
+    if (v < 0.0)
+        v = 0.0;
+    if (v > VREF_MV)
+        v = VREF_MV;
+    return v;
+}
+
+static uint32_t sample(int ch)
+{
+    static const int bits[4] = { 12, 10, 8, 6 };
+    int res = bits[(regs()->CR1 >> 24) & 3U];
+    uint32_t full = (1U << res) - 1U;
+    uint32_t code = (uint32_t)(input_mv(ch) / VREF_MV * (double)full + 0.5);
+
+    if (regs()->CR2 & (1U << 11))          /* ALIGN left */
+        return res == 6 ? code << 2 : code << (16 - res);
+    return code;
+}
+
+static void update_irq(void)
+{
+    uint32_t sr = regs()->SR, cr1 = regs()->CR1;
+    sim_irq_level(ADC_IRQn, ((sr & SR_EOC) && (cr1 & CR1_EOCIE)) || ((sr & SR_OVR) && (cr1 & CR1_OVRIE)));
+}
+
+static void start_conversion(void)
+{
+    if (!(regs()->CR2 & CR2_ADON) || a.converting)
+        return;
+    a.converting = 1;
+    a.done = sim_now + conversion_time(seq_channel(a.seq_pos));
+    regs()->SR |= SR_STRT;
+}
+
+void sim_adc_trigger(int source)
+{
+    uint32_t cr2 = regs()->CR2;
+
+    if (!((cr2 >> 28) & 3U) || (int)((cr2 >> 24) & 0xFU) != source)
+        return;
+    if (a.dma_stopped)
+        return;
+    start_conversion();
+}
+
+static void adc_after_read(struct sim_periph *p, uint32_t off)
+{
+    (void)p;
+    if (off == offsetof(ADC_TypeDef, DR)) {
+        regs()->SR &= ~SR_EOC;
+        update_irq();
+    }
+}
+
+static void adc_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    ADC_TypeDef *r = regs();
+
+    (void)p;
+    switch (off) {
+    case offsetof(ADC_TypeDef, SR):
+        r->SR = old & val;                  /* rc_w0 */
+        break;
+    case offsetof(ADC_TypeDef, DR):
+        r->DR = old;
+        break;
+    case offsetof(ADC_TypeDef, CR2):
+        if (!(val & CR2_ADON)) {
+            a.converting = 0;
+            a.seq_pos = 0;
+        }
+        if ((old & CR2_DMA) && !(val & CR2_DMA))
+            a.dma_stopped = 0;
+        if (val & CR2_SWSTART) {
+            r->CR2 &= ~CR2_SWSTART;
+            a.dma_stopped = 0;
+            start_conversion();
+        }
+        break;
+    default:
+        break;
+    }
+    update_irq();
+}
+
+static sim_time_t adc_next_event(struct sim_periph *p)
+{
+    (void)p;
+    return a.converting ? a.done : SIM_NEVER;
+}
+
+static void adc_advance(struct sim_periph *p)
+{
+    ADC_TypeDef *r = regs();
+    int ch, last, eoc;
+
+    (void)p;
+    if (!a.converting || a.done > sim_now)
+        return;
+
+    a.converting = 0;
+    a.conversions++;
+    ch = seq_channel(a.seq_pos);
+    if (r->SR & SR_EOC) {
+        if (r->CR2 & CR2_DMA) {
+            a.overruns++;
+            r->SR |= SR_OVR;
+        }
+    }
+    r->DR = sample(ch);
+
+    last = !(r->CR1 & CR1_SCAN) || a.seq_pos + 1 >= seq_length();
+    eoc = last || (r->CR2 & CR2_EOCS);
+    if (eoc)
+        r->SR |= SR_EOC;
+    if (r->CR2 & CR2_DMA) {
+        if (!sim_dma_pulse(2, 0, 0))
+            sim_dma_pulse(2, 4, 0);
+        if (last && !(r->CR2 & CR2_DDS))
+            a.dma_stopped = 1;
+    }
+    if (sim_verbose)
+        sim_log("ADC1 ch%d = %u", ch, (unsigned)r->DR);
+
+    a.seq_pos = last ? 0 : a.seq_pos + 1;
+    if (!last || ((r->CR2 & CR2_CONT) && !a.dma_stopped))
+        start_conversion();
+    else
+        r->SR &= ~SR_STRT;
+    update_irq();
+}
+
+/* --adc CH=MV[:AMPLITUDE_MV:HZ] */
+int sim_adc_option(const char *arg)
+{
+    char *end;
+    long ch = strtol(arg, &end, 10);
+
+    if (*end != '=' || ch < 0 || ch >= NUM_CHANNELS) {
+        fprintf(stderr, "sim: bad --adc '%s'\n", arg);
+        return 1;
+    }
+    a.dc_mv[ch] = strtod(end + 1, &end);
+    a.amp_mv[ch] = 0.0;
+    if (*end == ':') {
+        a.amp_mv[ch] = strtod(end + 1, &end);
+        a.hz[ch] = *end == ':' ? strtod(end + 1, &end) : 50.0;
+    }
+    return 0;
+}
+
+static void adc_report(FILE *f)
+{
+    if (a.conversions)
+        fprintf(f, "\nADC1: %llu conversions, %llu overruns\n",
+                (unsigned long long)a.conversions, (unsigned long long)a.overruns);
+}
+
+static struct sim_periph adc_periph = {
+    .name = "ADC1", .base = ADC1_BASE, .size = 0x400,
+    .after_read = adc_after_read, .write = adc_write,
+    .next_event = adc_next_event, .advance = adc_advance,
+};
+
+void sim_adc_init(void)
+{
+    /* PA0 sees a 50 Hz sine around mid-scale, PC0 (channel 10) a pot at 750 mV */
+    a.dc_mv[0] = 1650.0;
+    a.amp_mv[0] = 1000.0;
+    a.hz[0] = 50.0;
+    a.dc_mv[10] = 750.0;
+    a.dc_mv[17] = 1210.0;          /* VREFINT */
+    a.dc_mv[18] = 772.5;           /* temperature sensor at 30 degC */
+    sim_register(&adc_periph);
+    sim_add_report(adc_report);
+    sim_add_counter("adc1.conversions", &a.conversions);
+}
@@ -0,0 +1,270 @@
+/**
+ * periph_dma.c - DMA1 and DMA2, 8 streams each
+ *
+ * Supports peripheral-to-memory, memory-to-peripheral and memory-to-memory
+ * transfers in direct mode, with PINC/MINC, circular and double-buffer
+ * modes and the HT/TC/TE interrupt flags. A transfer moves one item per
+ * request and takes no virtual time; the pacing comes from the requesting
+ * peripheral (USART bit time, timer period, ADC conversion time).
+ */
+
+#include <string.h>
+#include "sim.h"
+
+#define DMA_CR_EN      (1U << 0)
+#define DMA_CR_DMEIE   (1U << 1)
+#define DMA_CR_TEIE    (1U << 2)
+#define DMA_CR_HTIE    (1U << 3)
+#define DMA_CR_TCIE    (1U << 4)
+#define DMA_CR_CIRC    (1U << 8)
+#define DMA_CR_PINC    (1U << 9)
+#define DMA_CR_MINC    (1U << 10)
+#define DMA_CR_DBM     (1U << 18)
+#define DMA_CR_CT      (1U << 19)
+
+#define FLAG_DMEIF     (1U << 2)
+#define FLAG_TEIF      (1U << 3)
+#define FLAG_HTIF      (1U << 4)
+#define FLAG_TCIF      (1U << 5)
+
+struct stream
+{
+    uint32_t total;      /* NDTR latched at enable */
+    uint32_t pidx;       /* items moved since the last (re)load */
+    uint64_t items;      /* for the report */
+};
+
+struct dma
+{
+    struct sim_periph periph;
+    uint32_t          base;
+    struct stream     streams[8];
+    sim_dma_level_fn  level[8][8];
+};
+
+static struct dma dmas[2];
+static uint64_t   total_items;
+static const uint8_t flag_shift[4] = { 0, 6, 16, 22 };
+static const int irqs[2][8] = {
+    { DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn,
+      DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn },
+    { DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn,
+      DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn },
+};
+
+static DMA_TypeDef *ctl(int d)
+{
+    return SIM_REGS(DMA_TypeDef, dmas[d].base);
+}
+
+static DMA_Stream_TypeDef *str(int d, int s)
+{
+    return SIM_REGS(DMA_Stream_TypeDef, dmas[d].base + 0x10U + 0x18U * (uint32_t)s);
+}
+
+static uint32_t flags(int d, int s)
+{
+    uint32_t isr = s < 4 ? ctl(d)->LISR : ctl(d)->HISR;
+    return (isr >> flag_shift[s & 3]) & 0x3DU;
+}
+
+static void set_flags(int d, int s, uint32_t f)
+{
+    if (s < 4)
+        ctl(d)->LISR |= f << flag_shift[s & 3];
+    else
+        ctl(d)->HISR |= f << flag_shift[s & 3];
+}
+
+static void update_irq(int d, int s)
+{
+    uint32_t cr = str(d, s)->CR, f = flags(d, s);
+    int level = ((f & FLAG_TCIF) && (cr & DMA_CR_TCIE))
+             || ((f & FLAG_HTIF) && (cr & DMA_CR_HTIE))
+             || ((f & FLAG_TEIF) && (cr & DMA_CR_TEIE))
+             || ((f & FLAG_DMEIF) && (cr & DMA_CR_DMEIE));
+    sim_irq_level(irqs[d][s], level);
+}
+
+static int item_size(uint32_t cr, int shift)
+{
+    return 1 << ((cr >> shift) & 3U);
+}
+
+/* Move one item; returns 0 once the stream has stopped */
+static int transfer(int d, int s)
+{
+    DMA_Stream_TypeDef *st = str(d, s);
+    struct stream *ss = &dmas[d].streams[s];
+    uint32_t cr = st->CR, dir = (cr >> 6) & 3U;
+    int psize = item_size(cr, 11);
+    int msize = (st->FCR & (1U << 2)) ? item_size(cr, 13) : psize;   /* direct mode: PSIZE */
+    uint32_t mbase = ((cr & DMA_CR_DBM) && (cr & DMA_CR_CT)) ? st->M1AR : st->M0AR;
+    uint32_t paddr = st->PAR + ((cr & DMA_CR_PINC) ? ss->pidx * (uint32_t)psize : 0U);
+    uint32_t maddr = mbase + ((cr & DMA_CR_MINC) ? ss->pidx * (uint32_t)msize : 0U);
+    uint32_t v;
+
+    if (!(cr & DMA_CR_EN) || st->NDTR == 0)
+        return 0;
+
+    if (dir == 0U) {                 /* peripheral to memory */
+        v = sim_bus_read(paddr, psize);
+        sim_bus_write(maddr, v, msize);
+    } else if (dir == 1U) {          /* memory to peripheral */
+        v = sim_bus_read(maddr, msize);
+        sim_bus_write(paddr, v, psize);
+    } else {                         /* memory to memory: PAR is the source */
+        v = sim_bus_read(paddr, psize);
+        sim_bus_write(maddr, v, msize);
+    }
+
+    ss->pidx++;
+    ss->items++;
+    total_items++;
+    st->NDTR--;
+
+    if (ss->total > 1U && ss->pidx == ss->total / 2U)
+        set_flags(d, s, FLAG_HTIF);
+    if (st->NDTR == 0) {
+        set_flags(d, s, FLAG_TCIF);
+        if (cr & (DMA_CR_CIRC | DMA_CR_DBM)) {
+            st->NDTR = ss->total;
+            ss->pidx = 0;
+            if (cr & DMA_CR_DBM)
+                st->CR ^= DMA_CR_CT;
+        } else {
+            st->CR &= ~DMA_CR_EN;
+        }
+    }
+    update_irq(d, s);
+    return (st->CR & DMA_CR_EN) != 0;
+}
+
+static void start(int d, int s)
+{
+    DMA_Stream_TypeDef *st = str(d, s);
+    struct stream *ss = &dmas[d].streams[s];
+
+    ss->total = st->NDTR & 0xFFFFU;
+    ss->pidx = 0;
+    if (ss->total == 0) {
+        st->CR &= ~DMA_CR_EN;
+        return;
+    }
+    if (((st->CR >> 6) & 3U) == 2U) {
+        while (transfer(d, s)) {}
+    }
+}
+
+void sim_dma_level_source(int dma, int stream, int channel, sim_dma_level_fn fn)
+{
+    dmas[dma - 1].level[stream][channel] = fn;
+}
+
+void sim_dma_kick(void)
+{
+    static int kicking, again;
+    int d, s, guard;
+
+    if (kicking) {
+        again = 1;
+        return;
+    }
+    kicking = 1;
+    do {
+        again = 0;
+        for (d = 0; d < 2; d++) {
+            for (s = 0; s < 8; s++) {
+                uint32_t cr = str(d, s)->CR;
+                sim_dma_level_fn fn = dmas[d].level[s][(cr >> 25) & 7U];
+                if (!(cr & DMA_CR_EN) || !fn)
+                    continue;
+                for (guard = 0; guard < 65536 && fn() && transfer(d, s); guard++) {}
+            }
+        }
+    } while (again);
+    kicking = 0;
+}
+
+int sim_dma_pulse(int dma, int stream, int channel)
+{
+    uint32_t cr = str(dma - 1, stream)->CR;
+
+    if (!(cr & DMA_CR_EN) || ((cr >> 25) & 7U) != (uint32_t)channel)
+        return 0;
+    transfer(dma - 1, stream);
+    return 1;
+}
+
+static void dma_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    int d = (int)((struct dma *)p - dmas);
+    int s;
+
+    if (off == offsetof(DMA_TypeDef, LISR) || off == offsetof(DMA_TypeDef, HISR)) {
+        *(uint32_t *)sim_reg(dmas[d].base + off) = old;   /* read-only */
+        return;
+    }
+    if (off == offsetof(DMA_TypeDef, LIFCR) || off == offsetof(DMA_TypeDef, HIFCR)) {
+        if (off == offsetof(DMA_TypeDef, LIFCR))
+            ctl(d)->LISR &= ~val;
+        else
+            ctl(d)->HISR &= ~val;
+        ctl(d)->LIFCR = 0;
+        ctl(d)->HIFCR = 0;
+        for (s = 0; s < 8; s++)
+            update_irq(d, s);
+        return;
+    }
+
+    s = (int)((off - 0x10U) / 0x18U);
+    off = (off - 0x10U) % 0x18U;
+    if (s < 0 || s > 7)
+        return;
+
+    if (off == offsetof(DMA_Stream_TypeDef, CR)) {
+        if (!(old & DMA_CR_EN) && (val & DMA_CR_EN))
+            start(d, s);
+        else if ((old & DMA_CR_EN) && !(val & DMA_CR_EN) && str(d, s)->NDTR)
+            set_flags(d, s, FLAG_TCIF);     /* disabling mid-transfer completes it */
+        update_irq(d, s);
+        sim_dma_kick();
+    } else if (old != val && (str(d, s)->CR & DMA_CR_EN) &&
+               off != offsetof(DMA_Stream_TypeDef, M0AR) && off != offsetof(DMA_Stream_TypeDef, M1AR)) {
+        /* Only the memory addresses may change while a stream runs */
+        *(uint32_t *)sim_reg(dmas[d].base + 0x10U + 0x18U * (uint32_t)s + off) = old;
+    }
+}
+
+static void dma_report(FILE *f)
+{
+    int d, s;
+    int header = 0;
+
+    for (d = 0; d < 2; d++) {
+        for (s = 0; s < 8; s++) {
+            if (!dmas[d].streams[s].items)
+                continue;
+            if (!header++)
+                fprintf(f, "\nDMA items moved:\n");
+            fprintf(f, "  DMA%d_Stream%d  %llu\n", d + 1, s, (unsigned long long)dmas[d].streams[s].items);
+        }
+    }
+}
+
+void sim_dma_init(void)
+{
+    int d;
+
+    dmas[0].base = DMA1_BASE;
+    dmas[1].base = DMA2_BASE;
+    for (d = 0; d < 2; d++) {
+        dmas[d].periph.name = d ? "DMA2" : "DMA1";
+        dmas[d].periph.base = dmas[d].base;
+        dmas[d].periph.size = 0x400;
+        dmas[d].periph.write = dma_write;
+        sim_register(&dmas[d].periph);
+    }
+    sim_add_report(dma_report);
+    sim_add_counter("dma.items", &total_items);
+}
@@ -0,0 +1,108 @@
+/**
+ * periph_exti.c - EXTI lines 0..15 and the SYSCFG EXTI port selection
+ *
+ * GPIO reports every change of a port's input levels; a line whose
+ * SYSCFG_EXTICR selects that port and whose RTSR/FTSR matches the edge
+ * sets its PR bit if IMR allows it and raises EXTI0..EXTI4, EXTI9_5 or
+ * EXTI15_10. PR is rc_w1, SWIER sets PR for unmasked lines. Lines 16..22
+ * (PVD, RTC, USB) and event mode (EMR) are not modelled.
+ */
+
+#include "sim.h"
+
+#define LINES_MASK  0xFFFFU
+
+static uint64_t events;
+
+static EXTI_TypeDef *exti(void)
+{
+    return SIM_REGS(EXTI_TypeDef, EXTI_BASE);
+}
+
+/* Port selected for line n by SYSCFG_EXTICR */
+static int line_port(int n)
+{
+    SYSCFG_TypeDef *s = SIM_REGS(SYSCFG_TypeDef, SYSCFG_BASE);
+    int sel = (int)((s->EXTICR[n >> 2] >> ((n & 3) * 4)) & 0xFU);
+
+    return sel == 7 ? SIM_PORTH : sel;    /* PH is 0111, PF/PG do not exist */
+}
+
+static void update_irqs(void)
+{
+    uint32_t pr = exti()->PR & LINES_MASK;
+    int n;
+
+    for (n = 0; n < 5; n++)
+        sim_irq_level(EXTI0_IRQn + n, (pr >> n) & 1U);
+    sim_irq_level(EXTI9_5_IRQn, (pr & 0x03E0U) != 0);
+    sim_irq_level(EXTI15_10_IRQn, (pr & 0xFC00U) != 0);
+}
+
+int sim_exti_listening(int port, int pin)
+{
+    EXTI_TypeDef *e = exti();
+    uint32_t bit = 1U << pin;
+
+    return line_port(pin) == port && (e->IMR & bit) && ((e->RTSR | e->FTSR) & bit);
+}
+
+void sim_exti_input(int port, uint32_t old_idr, uint32_t new_idr)
+{
+    EXTI_TypeDef *e = exti();
+    uint32_t rise = ~old_idr & new_idr, fall = old_idr & ~new_idr, hit = 0;
+    int n;
+
+    for (n = 0; n < 16; n++) {
+        uint32_t bit = 1U << n;
+        if (!((rise | fall) & bit) || line_port(n) != port)
+            continue;
+        if (((rise & bit) && (e->RTSR & bit)) || ((fall & bit) && (e->FTSR & bit)))
+            hit |= bit;
+    }
+    hit &= e->IMR;
+    if (!hit)
+        return;
+    for (n = 0; n < 16; n++)
+        events += (hit >> n) & 1U;
+    e->PR |= hit;
+    update_irqs();
+}
+
+static void exti_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    EXTI_TypeDef *e = exti();
+
+    (void)p;
+    switch (off) {
+    case offsetof(EXTI_TypeDef, PR):
+        e->PR = old & ~val;                /* rc_w1 */
+        update_irqs();
+        break;
+    case offsetof(EXTI_TypeDef, SWIER):
+        e->PR |= val & ~old & e->IMR & LINES_MASK;
+        e->SWIER = val & ~e->PR;           /* cleared with the PR bit */
+        update_irqs();
+        break;
+    case offsetof(EXTI_TypeDef, IMR):
+        update_irqs();
+        break;
+    default:
+        break;
+    }
+}
+
+static struct sim_periph exti_periph = {
+    .name = "EXTI", .base = EXTI_BASE, .size = 0x400, .write = exti_write,
+};
+
+static struct sim_periph syscfg_periph = {
+    .name = "SYSCFG", .base = SYSCFG_BASE, .size = 0x400,
+};
+
+void sim_exti_init(void)
+{
+    sim_register(&syscfg_periph);
+    sim_register(&exti_periph);
+    sim_add_counter("exti.events", &events);
+}
@@ -0,0 +1,248 @@
+/**
+ * periph_gpio.c - RCC and GPIOA..GPIOH
+ *
+ * RCC is plain storage with the ready flags following their enables, so
+ * clock setup loops terminate. GPIO applies BSRR to ODR, recomputes IDR from
+ * the pin modes, output types, pull resistors and whatever the device
+ * models drive, and tells the device models about every ODR change and
+ * every MODER, OTYPER or PUPDR write (with old_odr == new_odr). Changes of
+ * the input levels, whether driven from outside or by the port's own
+ * outputs, go to EXTI.
+ */
+
+#include <string.h>
+#include "sim.h"
+
+#define MAX_WATCHERS 8
+
+struct gpio_port
+{
+    struct sim_periph periph;
+    uint32_t          ext_mask;   /* pins driven by an external device */
+    uint32_t          ext_val;
+    sim_gpio_watch_fn watchers[MAX_WATCHERS];
+    int               num_watchers;
+    uint64_t          edges[16];  /* output transitions per pin */
+    uint32_t          level;      /* IDR as EXTI last saw it */
+};
+
+static struct gpio_port ports[SIM_NPORTS];
+
+static const struct
+{
+    const char *name;
+    uint32_t    base;
+    uint32_t    moder;
+    uint32_t    pupdr;
+} port_info[SIM_NPORTS] = {
+    { "GPIOA", GPIOA_BASE, 0xA8000000U, 0x64000000U },
+    { "GPIOB", GPIOB_BASE, 0x00000280U, 0x00000100U },
+    { "GPIOC", GPIOC_BASE, 0x00000000U, 0x00000000U },
+    { "GPIOD", GPIOD_BASE, 0x00000000U, 0x00000000U },
+    { "GPIOE", GPIOE_BASE, 0x00000000U, 0x00000000U },
+    { "GPIOH", GPIOH_BASE, 0x00000000U, 0x00000000U },
+};
+
+static GPIO_TypeDef *regs(int port)
+{
+    return SIM_REGS(GPIO_TypeDef, port_info[port].base);
+}
+
+static int port_of(struct sim_periph *p)
+{
+    return (int)((struct gpio_port *)p - ports);
+}
+
+uint32_t sim_gpio_outputs(int port)
+{
+    uint32_t moder = regs(port)->MODER, mask = 0;
+    int pin;
+
+    for (pin = 0; pin < 16; pin++)
+        if (((moder >> (pin * 2)) & 3U) == 1U)
+            mask |= 1U << pin;
+    return mask;
+}
+
+uint32_t sim_gpio_odr(int port)
+{
+    return regs(port)->ODR & 0xFFFFU;
+}
+
+uint32_t sim_gpio_driving(int port)
+{
+    GPIO_TypeDef *g = regs(port);
+
+    /* An open-drain output only drives its low level */
+    return sim_gpio_outputs(port) & ~(g->OTYPER & g->ODR);
+}
+
+static uint32_t compute_idr(int port)
+{
+    GPIO_TypeDef *g = regs(port);
+    struct gpio_port *gp = &ports[port];
+    uint32_t out = sim_gpio_driving(port), idr = 0;
+    int pin;
+
+    for (pin = 0; pin < 16; pin++) {
+        uint32_t bit = 1U << pin;
+        uint32_t pull = (g->PUPDR >> (pin * 2)) & 3U;
+
+        if (out & bit)
+            idr |= g->ODR & bit;
+        else if (gp->ext_mask & bit)
+            idr |= gp->ext_val & bit;
+        else if (pull == 1U)
+            idr |= bit;
+    }
+    return idr;
+}
+
+static void inputs_changed(int port)
+{
+    struct gpio_port *gp = &ports[port];
+    uint32_t idr = compute_idr(port), old = gp->level;
+
+    if (idr != old) {
+        gp->level = idr;
+        sim_exti_input(port, old, idr);
+    }
+}
+
+void sim_gpio_drive(int port, uint32_t mask, uint32_t value)
+{
+    struct gpio_port *gp = &ports[port];
+
+    gp->ext_val = (gp->ext_val & ~mask) | (value & mask);
+    gp->ext_mask |= mask;
+    inputs_changed(port);
+}
+
+void sim_gpio_release(int port, uint32_t mask)
+{
+    ports[port].ext_mask &= ~mask;
+    inputs_changed(port);
+}
+
+void sim_gpio_watch(int port, sim_gpio_watch_fn fn)
+{
+    struct gpio_port *gp = &ports[port];
+
+    if (gp->num_watchers < MAX_WATCHERS)
+        gp->watchers[gp->num_watchers++] = fn;
+}
+
+static void notify(int port, uint32_t old_odr, uint32_t new_odr)
+{
+    struct gpio_port *gp = &ports[port];
+    uint32_t changed = (old_odr ^ new_odr) & sim_gpio_outputs(port);
+    int i;
+
+    for (i = 0; changed; i++, changed >>= 1)
+        gp->edges[i] += changed & 1U;
+    for (i = 0; i < gp->num_watchers; i++)
+        gp->watchers[i](port, old_odr, new_odr);
+}
+
+static void gpio_read(struct sim_periph *p, uint32_t off)
+{
+    int port = port_of(p);
+
+    if (off == offsetof(GPIO_TypeDef, IDR))
+        regs(port)->IDR = compute_idr(port);
+}
+
+static void gpio_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    int port = port_of(p);
+    GPIO_TypeDef *g = regs(port);
+    uint32_t odr = g->ODR;
+
+    switch (off) {
+    case offsetof(GPIO_TypeDef, BSRR):
+        /* Set wins over reset; BSRR always reads as zero */
+        g->ODR = ((odr & ~(val >> 16)) | (val & 0xFFFFU)) & 0xFFFFU;
+        g->BSRR = 0;
+        notify(port, odr, g->ODR);
+        break;
+    case offsetof(GPIO_TypeDef, ODR):
+        g->ODR = val & 0xFFFFU;
+        notify(port, old & 0xFFFFU, g->ODR);
+        break;
+    case offsetof(GPIO_TypeDef, IDR):
+        g->IDR = old;
+        return;
+    case offsetof(GPIO_TypeDef, MODER):
+    case offsetof(GPIO_TypeDef, OTYPER):
+    case offsetof(GPIO_TypeDef, PUPDR):
+        /* Pins that start or stop driving ODR, or change their pulls */
+        notify(port, odr, odr);
+        break;
+    default:
+        break;
+    }
+    inputs_changed(port);
+}
+
+static void gpio_report(FILE *f)
+{
+    int port, pin, header = 0;
+
+    for (port = 0; port < SIM_NPORTS; port++) {
+        for (pin = 0; pin < 16; pin++) {
+            if (!ports[port].edges[pin])
+                continue;
+            if (!header++)
+                fprintf(f, "\nGPIO output transitions:\n ");
+            fprintf(f, " P%c%d:%llu", port_info[port].name[4], pin,
+                    (unsigned long long)ports[port].edges[pin]);
+        }
+    }
+    if (header)
+        fputc('\n', f);
+}
+
+/* ---------------- RCC ---------------- */
+
+static void rcc_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    RCC_TypeDef *rcc = SIM_REGS(RCC_TypeDef, RCC_BASE);
+
+    (void)p;
+    (void)old;
+    if (off == offsetof(RCC_TypeDef, CR)) {
+        /* HSIRDY, HSERDY and PLLRDY follow HSION, HSEON and PLLON at once */
+        rcc->CR = (val & ~((1U << 1) | (1U << 17) | (1U << 25)))
+                | ((val & (1U << 0)) << 1) | ((val & (1U << 16)) << 1) | ((val & (1U << 24)) << 1);
+    } else if (off == offsetof(RCC_TypeDef, CFGR)) {
+        rcc->CFGR = (val & ~(3U << 2)) | ((val & 3U) << 2);   /* SWS = SW */
+    }
+}
+
+static struct sim_periph rcc_periph = {
+    .name = "RCC", .base = RCC_BASE, .size = 0x400, .write = rcc_write,
+};
+
+void sim_gpio_init(void)
+{
+    RCC_TypeDef *rcc = SIM_REGS(RCC_TypeDef, RCC_BASE);
+    int i;
+
+    rcc->CR = 0x00000083U;
+    rcc->PLLCFGR = 0x24003010U;
+    sim_register(&rcc_periph);
+
+    for (i = 0; i < SIM_NPORTS; i++) {
+        struct gpio_port *gp = &ports[i];
+        gp->periph.name = port_info[i].name;
+        gp->periph.base = port_info[i].base;
+        gp->periph.size = 0x400;
+        gp->periph.read = gpio_read;
+        gp->periph.write = gpio_write;
+        regs(i)->MODER = port_info[i].moder;
+        regs(i)->PUPDR = port_info[i].pupdr;
+        gp->level = compute_idr(i);
+        sim_register(&gp->periph);
+    }
+    sim_add_report(gpio_report);
+}
@@ -0,0 +1,343 @@
+/**
+ * periph_i2c.c - I2C1 master (STM32F4 "v1" I2C)
+ *
+ * Follows the event sequence of the reference manual closely enough for the
+ * polling drivers in the tree: START -> SB, address -> ADDR (or AF when no
+ * device answers), SR1+SR2 read clears ADDR, TXE/BTF while transmitting,
+ * RXNE with ACK/NACK while receiving, and STOP/repeated START deferred to
+ * the end of the byte in progress. Each byte takes nine SCL periods.
+ */
+
+#include <string.h>
+#include "sim.h"
+
+#define SR1_SB    (1U << 0)
+#define SR1_ADDR  (1U << 1)
+#define SR1_BTF   (1U << 2)
+#define SR1_RXNE  (1U << 6)
+#define SR1_TXE   (1U << 7)
+#define SR1_AF    (1U << 10)
+#define SR2_MSL   (1U << 0)
+#define SR2_BUSY  (1U << 1)
+#define SR2_TRA   (1U << 2)
+#define CR1_PE    (1U << 0)
+#define CR1_START (1U << 8)
+#define CR1_STOP  (1U << 9)
+#define CR1_ACK   (1U << 10)
+#define CR1_SWRST (1U << 15)
+#define CR2_ITERREN (1U << 8)
+#define CR2_ITEVTEN (1U << 9)
+#define CR2_ITBUFEN (1U << 10)
+#define CR2_DMAEN (1U << 11)
+
+#define MAX_DEVICES 4
+
+enum phase { IDLE, STARTING, ADDRESSING, ADDRESSED, TRANSMIT, RECEIVE, STOPPING };
+
+static struct
+{
+    enum phase phase;
+    sim_time_t event;          /* completion of the current bus action */
+    int        busy_byte;      /* a data byte is on the wire */
+    uint8_t    shift;
+    int        tdr_full;
+    uint8_t    tdr;
+    int        rx_held;        /* received while RXNE was still set */
+    uint8_t    rx_hold;
+    int        stop_pending, start_pending, read;
+    uint8_t    addr_byte;
+    struct sim_i2c_device *dev;
+
+    struct sim_i2c_device *devices[MAX_DEVICES];
+    int        num_devices;
+    uint64_t   bytes, transactions, nacks;
+} b;
+
+static I2C_TypeDef *regs(void)
+{
+    return SIM_REGS(I2C_TypeDef, I2C1_BASE);
+}
+
+static sim_time_t bit_time(void)
+{
+    uint32_t ccr = regs()->CCR;
+    sim_time_t t;
+
+    if (ccr & (1U << 15))                          /* fast mode */
+        t = (ccr & (1U << 14)) ? 25U * (ccr & 0xFFFU) : 3U * (ccr & 0xFFFU);
+    else
+        t = 2U * (ccr & 0xFFFU);
+    return t ? t : 160U;
+}
+
+static void update_irq(void)
+{
+    uint32_t sr1 = regs()->SR1, cr2 = regs()->CR2;
+    sim_irq_level(I2C1_EV_IRQn, (cr2 & CR2_ITEVTEN) &&
+                  ((sr1 & (SR1_SB | SR1_ADDR | SR1_BTF)) ||
+                   ((cr2 & CR2_ITBUFEN) && (sr1 & (SR1_TXE | SR1_RXNE)))));
+    sim_irq_level(I2C1_ER_IRQn, (cr2 & CR2_ITERREN) && (sr1 & (SR1_AF | 0x0B00U)));
+}
+
+static int tx_dma_level(void)
+{
+    return (regs()->CR2 & CR2_DMAEN) && (regs()->SR1 & SR1_TXE) && b.phase == TRANSMIT;
+}
+
+static int rx_dma_level(void)
+{
+    return (regs()->CR2 & CR2_DMAEN) && (regs()->SR1 & SR1_RXNE);
+}
+
+void sim_i2c_attach(struct sim_i2c_device *d)
+{
+    if (b.num_devices < MAX_DEVICES)
+        b.devices[b.num_devices++] = d;
+}
+
+static void schedule(sim_time_t cycles)
+{
+    b.event = sim_now + cycles;
+}
+
+static void send_byte(uint8_t v)
+{
+    b.busy_byte = 1;
+    b.shift = v;
+    schedule(9U * bit_time());
+}
+
+static void do_stop(void)
+{
+    I2C_TypeDef *r = regs();
+
+    if (b.dev && b.dev->stop)
+        b.dev->stop();
+    b.dev = NULL;
+    b.stop_pending = 0;
+    b.phase = STOPPING;
+    r->CR1 &= ~CR1_STOP;
+    r->SR1 &= ~(SR1_TXE | SR1_BTF);
+    schedule(bit_time());
+}
+
+static void do_start(void)
+{
+    b.start_pending = 0;
+    b.phase = STARTING;
+    b.tdr_full = 0;
+    regs()->SR1 &= ~(SR1_TXE | SR1_BTF | SR1_RXNE);
+    regs()->SR2 |= SR2_BUSY;
+    schedule(bit_time());
+}
+
+static void receive_next(void)
+{
+    b.busy_byte = 1;
+    schedule(9U * bit_time());
+}
+
+static void i2c_after_read(struct sim_periph *p, uint32_t off)
+{
+    I2C_TypeDef *r = regs();
+
+    (void)p;
+    if (off == offsetof(I2C_TypeDef, SR2) && (r->SR1 & SR1_ADDR)) {
+        r->SR1 &= ~SR1_ADDR;
+        if (b.read) {
+            b.phase = RECEIVE;
+            receive_next();
+        } else {
+            b.phase = TRANSMIT;
+            r->SR1 |= SR1_TXE;
+        }
+    } else if (off == offsetof(I2C_TypeDef, DR) && (r->SR1 & SR1_RXNE)) {
+        r->SR1 &= ~(SR1_RXNE | SR1_BTF);
+        if (b.rx_held) {
+            b.rx_held = 0;
+            r->DR = b.rx_hold;
+            r->SR1 |= SR1_RXNE;
+            if ((r->CR1 & CR1_ACK) && !b.stop_pending)
+                receive_next();
+        }
+    }
+    update_irq();
+    sim_dma_kick();
+}
+
+static void i2c_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    I2C_TypeDef *r = regs();
+
+    (void)p;
+    switch (off) {
+    case offsetof(I2C_TypeDef, CR1):
+        if (val & CR1_SWRST) {
+            r->SR1 = 0;
+            r->SR2 = 0;
+            memset(&b.phase, 0, offsetof(__typeof__(b), devices));
+            break;
+        }
+        if (!(old & CR1_START) && (val & CR1_START)) {
+            if (b.busy_byte)
+                b.start_pending = 1;
+            else
+                do_start();
+        }
+        if (!(old & CR1_STOP) && (val & CR1_STOP)) {
+            if (b.busy_byte || b.tdr_full || (b.phase == RECEIVE && !(r->SR1 & SR1_RXNE)))
+                b.stop_pending = 1;
+            else
+                do_stop();
+        }
+        break;
+    case offsetof(I2C_TypeDef, SR1):
+        r->SR1 = old & (val | 0x00FFU);        /* error flags are rc_w0 */
+        break;
+    case offsetof(I2C_TypeDef, SR2):
+        r->SR2 = old;
+        break;
+    case offsetof(I2C_TypeDef, DR):
+        if (r->SR1 & SR1_SB) {
+            r->SR1 &= ~SR1_SB;
+            b.addr_byte = (uint8_t)val;
+            b.read = val & 1U;
+            b.phase = ADDRESSING;
+            send_byte((uint8_t)val);
+        } else if (b.phase == TRANSMIT) {
+            r->SR1 &= ~SR1_BTF;
+            if (!b.busy_byte) {
+                send_byte((uint8_t)val);
+            } else {
+                b.tdr = (uint8_t)val;
+                b.tdr_full = 1;
+                r->SR1 &= ~SR1_TXE;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    update_irq();
+    sim_dma_kick();
+}
+
+static sim_time_t i2c_next_event(struct sim_periph *p)
+{
+    (void)p;
+    return (b.phase == STARTING || b.phase == STOPPING || b.busy_byte) ? b.event : SIM_NEVER;
+}
+
+static void byte_done(void)
+{
+    I2C_TypeDef *r = regs();
+    int i;
+
+    b.busy_byte = 0;
+    switch (b.phase) {
+    case ADDRESSING:
+        b.dev = NULL;
+        for (i = 0; i < b.num_devices; i++)
+            if (b.devices[i]->addr == (b.addr_byte >> 1))
+                b.dev = b.devices[i];
+        if (!b.dev) {
+            b.nacks++;
+            r->SR1 |= SR1_AF;
+            b.phase = ADDRESSED;
+            break;
+        }
+        b.transactions++;
+        b.dev->start(b.read);
+        r->SR1 |= SR1_ADDR;
+        r->SR2 = (r->SR2 & ~SR2_TRA) | (b.read ? 0U : SR2_TRA) | SR2_MSL | SR2_BUSY;
+        b.phase = ADDRESSED;
+        break;
+    case TRANSMIT:
+        b.bytes++;
+        b.dev->write(b.shift);
+        if (b.tdr_full) {
+            b.tdr_full = 0;
+            send_byte(b.tdr);
+            r->SR1 |= SR1_TXE;
+        } else {
+            r->SR1 |= SR1_TXE | SR1_BTF;
+        }
+        break;
+    case RECEIVE:
+        b.bytes++;
+        if (r->SR1 & SR1_RXNE) {
+            b.rx_held = 1;
+            b.rx_hold = b.dev->read();
+            r->SR1 |= SR1_BTF;
+            break;
+        }
+        r->DR = b.dev->read();
+        r->SR1 |= SR1_RXNE;
+        if ((r->CR1 & CR1_ACK) && !b.stop_pending && !b.start_pending)
+            receive_next();
+        break;
+    default:
+        break;
+    }
+
+    if (!b.busy_byte && !b.tdr_full) {
+        if (b.start_pending)
+            do_start();
+        else if (b.stop_pending)
+            do_stop();
+    }
+}
+
+static void i2c_advance(struct sim_periph *p)
+{
+    I2C_TypeDef *r = regs();
+
+    (void)p;
+    if (b.event > sim_now)
+        return;
+    if (b.phase == STARTING) {
+        b.phase = IDLE;
+        r->CR1 &= ~CR1_START;
+        r->SR1 |= SR1_SB;
+        r->SR2 |= SR2_MSL | SR2_BUSY;
+    } else if (b.phase == STOPPING) {
+        b.phase = IDLE;
+        r->SR2 &= ~(SR2_MSL | SR2_BUSY | SR2_TRA);
+    } else if (b.busy_byte) {
+        byte_done();
+    }
+    update_irq();
+    sim_dma_kick();
+}
+
+static void i2c_report(FILE *f)
+{
+    int i;
+
+    if (!b.transactions && !b.nacks)
+        return;
+    fprintf(f, "\nI2C1: %llu transactions, %llu data bytes, %llu unanswered addresses\n",
+            (unsigned long long)b.transactions, (unsigned long long)b.bytes,
+            (unsigned long long)b.nacks);
+    for (i = 0; i < b.num_devices; i++)
+        if (b.devices[i]->report)
+            b.devices[i]->report(f);
+}
+
+static struct sim_periph i2c_periph = {
+    .name = "I2C1", .base = I2C1_BASE, .size = 0x400,
+    .after_read = i2c_after_read, .write = i2c_write,
+    .next_event = i2c_next_event, .advance = i2c_advance,
+};
+
+void sim_i2c_init(void)
+{
+    sim_register(&i2c_periph);
+    sim_dma_level_source(1, 6, 1, tx_dma_level);
+    sim_dma_level_source(1, 7, 1, tx_dma_level);
+    sim_dma_level_source(1, 0, 1, rx_dma_level);
+    sim_dma_level_source(1, 5, 1, rx_dma_level);
+    sim_add_report(i2c_report);
+    sim_add_counter("i2c1.transactions", &b.transactions);
+    sim_add_counter("i2c1.bytes", &b.bytes);
+}
@@ -0,0 +1,255 @@
+/**
+ * periph_scs.c - Cortex-M4 system control space: SysTick, NVIC, SCB, DWT
+ *
+ * SysTick and DWT->CYCCNT are computed from virtual time on read, so a
+ * program polling COUNTFLAG or timing code with CYCCNT sees exact cycles.
+ */
+
+#include <string.h>
+#include "sim.h"
+
+#define NVIC_WORDS 8
+
+static uint32_t   nvic_enabled[NVIC_WORDS];
+
+static sim_time_t st_base;        /* time at which VAL last reloaded */
+static uint64_t   st_wraps;       /* reloads already signalled */
+static int        st_pending;
+
+static sim_time_t cyc_base;
+static uint32_t   cyc_offset;
+
+/* ---------------- SysTick ---------------- */
+
+static SysTick_Type *st(void)
+{
+    return SIM_REGS(SysTick_Type, SysTick_BASE);
+}
+
+static sim_time_t st_period(void)
+{
+    sim_time_t reload = (st()->LOAD & SysTick_LOAD_RELOAD_Msk) + 1U;
+    return (st()->CTRL & SysTick_CTRL_CLKSOURCE_Msk) ? reload : reload * 8U;
+}
+
+static int st_running(void)
+{
+    return (st()->CTRL & SysTick_CTRL_ENABLE_Msk) && (st()->LOAD & SysTick_LOAD_RELOAD_Msk);
+}
+
+static void systick_read(struct sim_periph *p, uint32_t off)
+{
+    sim_time_t period, elapsed;
+
+    (void)p;
+    if (off == offsetof(SysTick_Type, VAL) && st_running()) {
+        period = st_period();
+        elapsed = (sim_now - st_base) % period;
+        if (!(st()->CTRL & SysTick_CTRL_CLKSOURCE_Msk))
+            elapsed /= 8U;
+        st()->VAL = (st()->LOAD & SysTick_LOAD_RELOAD_Msk) - (uint32_t)elapsed;
+    }
+}
+
+static void systick_after_read(struct sim_periph *p, uint32_t off)
+{
+    (void)p;
+    if (off == offsetof(SysTick_Type, CTRL))
+        st()->CTRL &= ~SysTick_CTRL_COUNTFLAG_Msk;   /* cleared by reading */
+}
+
+static void systick_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    (void)p;
+    switch (off) {
+    case offsetof(SysTick_Type, CTRL):
+        /* COUNTFLAG is read-only */
+        st()->CTRL = (val & 0x7U) | (old & SysTick_CTRL_COUNTFLAG_Msk);
+        if (!(old & SysTick_CTRL_ENABLE_Msk) && (val & SysTick_CTRL_ENABLE_Msk)) {
+            st_base = sim_now;
+            st_wraps = 0;
+        }
+        if (!(val & SysTick_CTRL_TICKINT_Msk))
+            st_pending = 0;
+        break;
+    case offsetof(SysTick_Type, VAL):
+        /* Any write clears the counter and COUNTFLAG */
+        st()->VAL = 0;
+        st()->CTRL &= ~SysTick_CTRL_COUNTFLAG_Msk;
+        st_base = sim_now;
+        st_wraps = 0;
+        break;
+    case offsetof(SysTick_Type, CALIB):
+        *(uint32_t *)&st()->CALIB = old;
+        break;
+    default:
+        break;
+    }
+}
+
+static sim_time_t systick_next_event(struct sim_periph *p)
+{
+    (void)p;
+    if (!st_running())
+        return SIM_NEVER;
+    return st_base + (st_wraps + 1U) * st_period();
+}
+
+static void systick_advance(struct sim_periph *p)
+{
+    sim_time_t period = st_period();
+
+    (void)p;
+    while (st_base + (st_wraps + 1U) * period <= sim_now) {
+        st_wraps++;
+        st()->CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+        if (st()->CTRL & SysTick_CTRL_TICKINT_Msk)
+            st_pending = 1;
+    }
+}
+
+void sim_systick_pend(void)    { st_pending = 1; }
+int  sim_systick_pending(void) { return st_pending; }
+void sim_systick_clear(void)   { st_pending = 0; }
+
+/* ---------------- NVIC ---------------- */
+
+int sim_irq_enabled(int irqn)
+{
+    if (irqn < 0 || irqn >= NVIC_WORDS * 32)
+        return 0;
+    return (nvic_enabled[irqn >> 5] >> (irqn & 31)) & 1U;
+}
+
+static NVIC_Type *nvic(void)
+{
+    return SIM_REGS(NVIC_Type, NVIC_BASE);
+}
+
+static void nvic_read(struct sim_periph *p, uint32_t off)
+{
+    uint32_t word, bits = 0;
+    int i;
+
+    (void)p;
+    if (off >= offsetof(NVIC_Type, ISPR) && off < offsetof(NVIC_Type, RESERVED2)) {
+        word = (off - offsetof(NVIC_Type, ISPR)) / 4U;
+        for (i = 0; i < 32; i++)
+            if (sim_irq_pending((int)(word * 32U) + i))
+                bits |= 1U << i;
+        nvic()->ISPR[word] = bits;
+    } else if (off >= offsetof(NVIC_Type, ICPR) && off < offsetof(NVIC_Type, RESERVED3)) {
+        word = (off - offsetof(NVIC_Type, ICPR)) / 4U;
+        for (i = 0; i < 32; i++)
+            if (sim_irq_pending((int)(word * 32U) + i))
+                bits |= 1U << i;
+        nvic()->ICPR[word] = bits;
+    }
+}
+
+static void nvic_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    uint32_t word;
+    int i;
+
+    (void)p;
+    (void)old;
+    if (off < offsetof(NVIC_Type, RESERVED0)) {
+        word = off / 4U;
+        nvic_enabled[word] |= val;
+    } else if (off >= offsetof(NVIC_Type, ICER) && off < offsetof(NVIC_Type, RESERVED1)) {
+        word = (off - offsetof(NVIC_Type, ICER)) / 4U;
+        nvic_enabled[word] &= ~val;
+    } else if (off >= offsetof(NVIC_Type, ISPR) && off < offsetof(NVIC_Type, RESERVED2)) {
+        word = (off - offsetof(NVIC_Type, ISPR)) / 4U;
+        for (i = 0; i < 32; i++)
+            if (val & (1U << i))
+                sim_irq_pend((int)(word * 32U) + i);
+        return;
+    } else if (off >= offsetof(NVIC_Type, ICPR) && off < offsetof(NVIC_Type, RESERVED3)) {
+        word = (off - offsetof(NVIC_Type, ICPR)) / 4U;
+        for (i = 0; i < 32; i++)
+            if (val & (1U << i))
+                sim_irq_unpend((int)(word * 32U) + i);
+        return;
+    } else {
+        return;   /* priorities are stored but not used */
+    }
+    nvic()->ISER[word] = nvic_enabled[word];
+    nvic()->ICER[word] = nvic_enabled[word];
+}
+
+/* ---------------- SCB ---------------- */
+
+static void scb_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    SCB_Type *scb = SIM_REGS(SCB_Type, SCB_BASE);
+
+    (void)p;
+    if (off == offsetof(SCB_Type, ICSR)) {
+        if (val & (1UL << 26))          /* PENDSTSET */
+            sim_systick_pend();
+        if (val & (1UL << 25))          /* PENDSTCLR */
+            sim_systick_clear();
+        scb->ICSR = 0;
+    } else if (off == offsetof(SCB_Type, CPUID)) {
+        *(uint32_t *)&scb->CPUID = old;
+    }
+}
+
+/* ---------------- DWT ---------------- */
+
+static void dwt_read(struct sim_periph *p, uint32_t off)
+{
+    DWT_Type *dwt = SIM_REGS(DWT_Type, DWT_BASE);
+
+    (void)p;
+    if (off == offsetof(DWT_Type, CYCCNT) && (dwt->CTRL & DWT_CTRL_CYCCNTENA_Msk))
+        dwt->CYCCNT = cyc_offset + (uint32_t)(sim_now - cyc_base);
+}
+
+static void dwt_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    DWT_Type *dwt = SIM_REGS(DWT_Type, DWT_BASE);
+
+    (void)p;
+    if (off == offsetof(DWT_Type, CYCCNT)) {
+        cyc_offset = val;
+        cyc_base = sim_now;
+    } else if (off == offsetof(DWT_Type, CTRL) && !(old & 1U) && (val & 1U)) {
+        cyc_offset = dwt->CYCCNT;
+        cyc_base = sim_now;
+    }
+}
+
+static struct sim_periph systick_periph = {
+    .name = "SysTick", .base = SysTick_BASE, .size = 0x10,
+    .read = systick_read, .after_read = systick_after_read, .write = systick_write,
+    .next_event = systick_next_event, .advance = systick_advance,
+};
+static struct sim_periph nvic_periph = {
+    .name = "NVIC", .base = NVIC_BASE, .size = 0x400,
+    .read = nvic_read, .write = nvic_write,
+};
+static struct sim_periph scb_periph = {
+    .name = "SCB", .base = SCB_BASE, .size = 0x90, .write = scb_write,
+};
+static struct sim_periph dwt_periph = {
+    .name = "DWT", .base = DWT_BASE, .size = 0x1000,
+    .read = dwt_read, .write = dwt_write,
+};
+static struct sim_periph coredebug_periph = {
+    .name = "CoreDebug", .base = CoreDebug_BASE, .size = 0x10,
+};
+
+void sim_scs_init(void)
+{
+    *(uint32_t *)&SIM_REGS(SCB_Type, SCB_BASE)->CPUID = 0x410FC241U;   /* Cortex-M4 r0p1 */
+    *(uint32_t *)&st()->CALIB = 0x40003E80U;                          /* 1 ms at 16 MHz / 8 */
+
+    sim_register(&systick_periph);
+    sim_register(&nvic_periph);
+    sim_register(&scb_periph);
+    sim_register(&dwt_periph);
+    sim_register(&coredebug_periph);
+}
@@ -0,0 +1,200 @@
+/**
+ * periph_spi.c - SPI1 master
+ *
+ * A frame takes 8 or 16 SCK periods of fPCLK/2^(BR+1). BSY is set from the
+ * DR write until the last frame has shifted out, and at the end of each
+ * frame every attached device whose chip select is asserted sees the bytes
+ * (MSB first). Slave mode, CRC and I2S are not modelled.
+ */
+
+#include <string.h>
+#include "sim.h"
+
+#define SR_RXNE   (1U << 0)
+#define SR_TXE    (1U << 1)
+#define SR_OVR    (1U << 6)
+#define SR_BSY    (1U << 7)
+#define CR1_MSTR  (1U << 2)
+#define CR1_SPE   (1U << 6)
+#define CR1_DFF   (1U << 11)
+#define CR2_RXDMAEN (1U << 0)
+#define CR2_TXDMAEN (1U << 1)
+#define CR2_ERRIE (1U << 5)
+#define CR2_RXNEIE (1U << 6)
+#define CR2_TXEIE (1U << 7)
+
+#define MAX_DEVICES 4
+
+static struct
+{
+    int        shifting;
+    uint16_t   shift;
+    sim_time_t shift_done;
+    int        tdr_full;
+    uint16_t   tdr;
+    uint64_t   frames;
+
+    struct sim_spi_device *devices[MAX_DEVICES];
+    int        num_devices;
+} s;
+
+static SPI_TypeDef *regs(void)
+{
+    return SIM_REGS(SPI_TypeDef, SPI1_BASE);
+}
+
+static sim_time_t frame_time(void)
+{
+    uint32_t cr1 = regs()->CR1;
+    sim_time_t bits = (cr1 & CR1_DFF) ? 16U : 8U;
+    return bits << (((cr1 >> 3) & 7U) + 1U);
+}
+
+static void update_irq(void)
+{
+    uint32_t sr = regs()->SR, cr2 = regs()->CR2;
+    sim_irq_level(SPI1_IRQn, ((sr & SR_TXE) && (cr2 & CR2_TXEIE))
+                          || ((sr & SR_RXNE) && (cr2 & CR2_RXNEIE))
+                          || ((sr & SR_OVR) && (cr2 & CR2_ERRIE)));
+}
+
+static int tx_dma_level(void)
+{
+    return (regs()->CR2 & CR2_TXDMAEN) && (regs()->SR & SR_TXE) && (regs()->CR1 & CR1_SPE);
+}
+
+static int rx_dma_level(void)
+{
+    return (regs()->CR2 & CR2_RXDMAEN) && (regs()->SR & SR_RXNE);
+}
+
+void sim_spi_attach(struct sim_spi_device *d)
+{
+    if (s.num_devices < MAX_DEVICES)
+        s.devices[s.num_devices++] = d;
+}
+
+static uint8_t exchange(uint8_t mosi)
+{
+    uint8_t miso = 0xFF;
+    int i;
+
+    for (i = 0; i < s.num_devices; i++)
+        if (s.devices[i]->selected())
+            miso = s.devices[i]->transfer(mosi);
+    return miso;
+}
+
+static void start_shift(uint16_t w)
+{
+    s.shifting = 1;
+    s.shift = w;
+    s.shift_done = sim_now + frame_time();
+    regs()->SR |= SR_BSY;
+}
+
+static void spi_after_read(struct sim_periph *p, uint32_t off)
+{
+    (void)p;
+    if (off == offsetof(SPI_TypeDef, DR)) {
+        regs()->SR &= ~(SR_RXNE | SR_OVR);
+        update_irq();
+    }
+}
+
+static void spi_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    SPI_TypeDef *r = regs();
+
+    (void)p;
+    switch (off) {
+    case offsetof(SPI_TypeDef, SR):
+        r->SR = old;          /* flags are read-only (CRCERR aside) */
+        break;
+    case offsetof(SPI_TypeDef, DR):
+        r->DR = old;
+        if (!(r->CR1 & CR1_SPE) || !(r->CR1 & CR1_MSTR))
+            break;
+        if (!s.shifting) {
+            start_shift((uint16_t)val);
+        } else {
+            s.tdr = (uint16_t)val;
+            s.tdr_full = 1;
+            r->SR &= ~SR_TXE;
+        }
+        break;
+    default:
+        break;
+    }
+    update_irq();
+    sim_dma_kick();
+}
+
+static sim_time_t spi_next_event(struct sim_periph *p)
+{
+    (void)p;
+    return s.shifting ? s.shift_done : SIM_NEVER;
+}
+
+static void spi_advance(struct sim_periph *p)
+{
+    SPI_TypeDef *r = regs();
+    uint16_t rx;
+
+    (void)p;
+    if (!s.shifting || s.shift_done > sim_now)
+        return;
+
+    s.frames++;
+    if (r->CR1 & CR1_DFF) {
+        rx = (uint16_t)(exchange((uint8_t)(s.shift >> 8)) << 8);
+        rx |= exchange((uint8_t)s.shift);
+    } else {
+        rx = exchange((uint8_t)s.shift);
+    }
+    if (r->SR & SR_RXNE)
+        r->SR |= SR_OVR;
+    r->DR = rx;
+    r->SR |= SR_RXNE;
+
+    if (s.tdr_full) {
+        s.tdr_full = 0;
+        start_shift(s.tdr);
+        r->SR |= SR_TXE;
+    } else {
+        s.shifting = 0;
+        r->SR &= ~SR_BSY;
+    }
+    update_irq();
+    sim_dma_kick();
+}
+
+static void spi_report(FILE *f)
+{
+    int i;
+
+    if (!s.frames)
+        return;
+    fprintf(f, "\nSPI1: %llu frames\n", (unsigned long long)s.frames);
+    for (i = 0; i < s.num_devices; i++)
+        if (s.devices[i]->report)
+            s.devices[i]->report(f);
+}
+
+static struct sim_periph spi_periph = {
+    .name = "SPI1", .base = SPI1_BASE, .size = 0x400,
+    .after_read = spi_after_read, .write = spi_write,
+    .next_event = spi_next_event, .advance = spi_advance,
+};
+
+void sim_spi_init(void)
+{
+    regs()->SR = SR_TXE;
+    sim_register(&spi_periph);
+    sim_dma_level_source(2, 3, 3, tx_dma_level);
+    sim_dma_level_source(2, 5, 3, tx_dma_level);
+    sim_dma_level_source(2, 0, 3, rx_dma_level);
+    sim_dma_level_source(2, 2, 3, rx_dma_level);
+    sim_add_report(spi_report);
+    sim_add_counter("spi1.frames", &s.frames);
+}
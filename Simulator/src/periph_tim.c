@@ -0,0 +1,314 @@
+/**
+ * periph_tim.c - TIM1..TIM5 time base and compare channels
+ *
+ * The counter is never stepped: CNT is derived from virtual time on read and
+ * the model only schedules its next update or compare-match event. Events
+ * set the status flags, raise the update/compare interrupts, issue the
+ * timer DMA requests and fire TRGO / CCx as ADC external triggers.
+ * Counting is always upwards; input capture and output pins are not modelled.
+ */
+
+#include <string.h>
+#include "sim.h"
+
+enum { REQ_UP = 0, REQ_CC1, REQ_CC2, REQ_CC3, REQ_CC4, NUM_REQ };
+
+struct dma_route
+{
+    int8_t dma, stream, channel;
+};
+
+struct tim
+{
+    struct sim_periph periph;
+    int               wide;           /* 32-bit counter (TIM2, TIM5) */
+    int               irq_up, irq_cc;
+    int               trgo;           /* ADC trigger id of TRGO, -1 if none */
+    int               cc_trigger[4];  /* ADC trigger id of CCx, -1 if none */
+    struct dma_route  routes[NUM_REQ][3];
+
+    sim_time_t        base;           /* virtual time at which CNT was 0 */
+    uint64_t          updates;        /* update events since base */
+    uint64_t          cc_periods[4];  /* compare events since base, per channel */
+    uint64_t          update_events;  /* all update events, for --stats */
+    const char       *counter;
+};
+
+#define NO_ROUTE { -1, -1, -1 }
+#define NO_ROUTES { NO_ROUTE, NO_ROUTE, NO_ROUTE }
+
+static struct tim tims[] = {
+    { .periph = { .name = "TIM1", .base = TIM1_BASE, .size = 0x400 }, .counter = "tim1.updates",
+      .irq_up = TIM1_UP_TIM10_IRQn, .irq_cc = TIM1_CC_IRQn, .trgo = -1,
+      .cc_trigger = { SIM_TRG_TIM1_CC1, SIM_TRG_TIM1_CC2, SIM_TRG_TIM1_CC3, -1 },
+      .routes = { { { 2, 5, 6 }, NO_ROUTE, NO_ROUTE },
+                  { { 2, 1, 6 }, { 2, 3, 6 }, { 2, 6, 0 } },
+                  { { 2, 2, 6 }, { 2, 6, 0 }, NO_ROUTE },
+                  { { 2, 6, 6 }, NO_ROUTE, NO_ROUTE },
+                  { { 2, 4, 6 }, NO_ROUTE, NO_ROUTE } } },
+    { .periph = { .name = "TIM2", .base = TIM2_BASE, .size = 0x400 }, .counter = "tim2.updates", .wide = 1,
+      .irq_up = TIM2_IRQn, .irq_cc = TIM2_IRQn, .trgo = SIM_TRG_TIM2_TRGO,
+      .cc_trigger = { -1, SIM_TRG_TIM2_CC2, SIM_TRG_TIM2_CC3, SIM_TRG_TIM2_CC4 },
+      .routes = { { { 1, 1, 3 }, { 1, 7, 3 }, NO_ROUTE },
+                  { { 1, 5, 3 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 6, 3 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 1, 3 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 6, 3 }, { 1, 7, 3 }, NO_ROUTE } } },
+    { .periph = { .name = "TIM3", .base = TIM3_BASE, .size = 0x400 }, .counter = "tim3.updates",
+      .irq_up = TIM3_IRQn, .irq_cc = TIM3_IRQn, .trgo = SIM_TRG_TIM3_TRGO,
+      .cc_trigger = { SIM_TRG_TIM3_CC1, -1, -1, -1 },
+      .routes = { { { 1, 2, 5 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 4, 5 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 5, 5 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 7, 5 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 2, 5 }, NO_ROUTE, NO_ROUTE } } },
+    { .periph = { .name = "TIM4", .base = TIM4_BASE, .size = 0x400 }, .counter = "tim4.updates",
+      .irq_up = TIM4_IRQn, .irq_cc = TIM4_IRQn, .trgo = -1,
+      .cc_trigger = { -1, -1, -1, -1 },
+      .routes = { { { 1, 6, 2 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 0, 2 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 3, 2 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 7, 2 }, NO_ROUTE, NO_ROUTE },
+                  NO_ROUTES } },
+    { .periph = { .name = "TIM5", .base = TIM5_BASE, .size = 0x400 }, .counter = "tim5.updates", .wide = 1,
+      .irq_up = TIM5_IRQn, .irq_cc = TIM5_IRQn, .trgo = -1,
+      .cc_trigger = { -1, -1, -1, -1 },
+      .routes = { { { 1, 0, 6 }, { 1, 6, 6 }, NO_ROUTE },
+                  { { 1, 2, 6 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 4, 6 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 0, 6 }, NO_ROUTE, NO_ROUTE },
+                  { { 1, 1, 6 }, { 1, 3, 6 }, NO_ROUTE } } },
+};
+#define NUM_TIMS (int)(sizeof(tims) / sizeof(tims[0]))
+
+static TIM_TypeDef *regs(struct tim *t)
+{
+    return SIM_REGS(TIM_TypeDef, t->periph.base);
+}
+
+static uint32_t mask(struct tim *t)
+{
+    return t->wide ? 0xFFFFFFFFU : 0xFFFFU;
+}
+
+static sim_time_t tick(struct tim *t)
+{
+    return (sim_time_t)(regs(t)->PSC & 0xFFFFU) + 1U;
+}
+
+static sim_time_t period(struct tim *t)
+{
+    return ((sim_time_t)(regs(t)->ARR & mask(t)) + 1U) * tick(t);
+}
+
+static uint32_t ccr(struct tim *t, int ch)
+{
+    return (&regs(t)->CCR1)[ch] & mask(t);
+}
+
+static int running(struct tim *t)
+{
+    return (regs(t)->CR1 & TIM_CR1_CEN) && (regs(t)->ARR & mask(t));
+}
+
+static uint32_t count_now(struct tim *t)
+{
+    if (!running(t))
+        return regs(t)->CNT & mask(t);
+    return (uint32_t)(((sim_now - t->base) % period(t)) / tick(t));
+}
+
+/* A compare channel produces events if anything can observe them */
+static int cc_active(struct tim *t, int ch)
+{
+    TIM_TypeDef *r = regs(t);
+    return ((r->CCER >> (ch * 4)) & 1U) || ((r->DIER >> (ch + 1)) & 1U) || ((r->DIER >> (ch + 9)) & 1U);
+}
+
+static void rebase(struct tim *t, uint32_t cnt)
+{
+    int ch;
+
+    t->base = sim_now - (sim_time_t)cnt * tick(t);
+    t->updates = 0;
+    for (ch = 0; ch < 4; ch++)
+        t->cc_periods[ch] = (cnt > ccr(t, ch)) ? 1U : 0U;
+}
+
+static sim_time_t cc_time(struct tim *t, int ch)
+{
+    return t->base + t->cc_periods[ch] * period(t) + (sim_time_t)ccr(t, ch) * tick(t);
+}
+
+static void update_irq(struct tim *t)
+{
+    TIM_TypeDef *r = regs(t);
+    uint32_t pending = r->SR & r->DIER & 0x1FU;
+
+    if (t->irq_up == t->irq_cc) {
+        sim_irq_level(t->irq_up, pending != 0);
+    } else {
+        sim_irq_level(t->irq_up, (pending & TIM_SR_UIF) != 0);
+        sim_irq_level(t->irq_cc, (pending & 0x1EU) != 0);
+    }
+}
+
+static void dma_request(struct tim *t, int req)
+{
+    int i;
+
+    for (i = 0; i < 3 && t->routes[req][i].dma > 0; i++)
+        sim_dma_pulse(t->routes[req][i].dma, t->routes[req][i].stream, t->routes[req][i].channel);
+}
+
+static void on_update(struct tim *t)
+{
+    TIM_TypeDef *r = regs(t);
+
+    t->update_events++;
+    r->SR |= TIM_SR_UIF;
+    if (r->DIER & TIM_DIER_UDE)
+        dma_request(t, REQ_UP);
+    if (t->trgo >= 0 && ((r->CR2 >> 4) & 7U) == 2U)
+        sim_adc_trigger(t->trgo);
+    if (r->CR1 & TIM_CR1_OPM)
+        r->CR1 &= ~TIM_CR1_CEN;
+    update_irq(t);
+}
+
+static void on_compare(struct tim *t, int ch)
+{
+    TIM_TypeDef *r = regs(t);
+
+    r->SR |= 1U << (ch + 1);
+    if ((r->DIER >> (ch + 9)) & 1U)
+        dma_request(t, REQ_CC1 + ch);
+    if (t->cc_trigger[ch] >= 0)
+        sim_adc_trigger(t->cc_trigger[ch]);
+    if (t->trgo >= 0 && ((r->CR2 >> 4) & 7U) == 3U && ch == 0)
+        sim_adc_trigger(t->trgo);     /* MMS = compare pulse */
+    update_irq(t);
+}
+
+static sim_time_t tim_next_event(struct sim_periph *p)
+{
+    struct tim *t = (struct tim *)p;
+    sim_time_t next;
+    int ch;
+
+    if (!running(t))
+        return SIM_NEVER;
+    next = t->base + (t->updates + 1U) * period(t);
+    for (ch = 0; ch < 4; ch++) {
+        if (cc_active(t, ch) && ccr(t, ch) <= (regs(t)->ARR & mask(t))) {
+            sim_time_t c = cc_time(t, ch);
+            if (c < next)
+                next = c;
+        }
+    }
+    return next;
+}
+
+static void tim_advance(struct sim_periph *p)
+{
+    struct tim *t = (struct tim *)p;
+    int ch;
+
+    for (ch = 0; ch < 4; ch++) {
+        if (cc_active(t, ch) && cc_time(t, ch) <= sim_now) {
+            t->cc_periods[ch]++;
+            on_compare(t, ch);
+        }
+    }
+    if (running(t) && t->base + (t->updates + 1U) * period(t) <= sim_now) {
+        t->updates++;
+        on_update(t);
+    }
+}
+
+static void tim_read(struct sim_periph *p, uint32_t off)
+{
+    struct tim *t = (struct tim *)p;
+
+    if (off == offsetof(TIM_TypeDef, CNT))
+        regs(t)->CNT = count_now(t);
+}
+
+static void tim_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    struct tim *t = (struct tim *)p;
+    TIM_TypeDef *r = regs(t);
+    uint32_t cnt;
+
+    switch (off) {
+    case offsetof(TIM_TypeDef, CR1):
+        if (!(old & TIM_CR1_CEN) && (val & TIM_CR1_CEN)) {
+            rebase(t, r->CNT & mask(t));
+        } else if ((old & TIM_CR1_CEN) && !(val & TIM_CR1_CEN)) {
+            r->CR1 = old;
+            r->CNT = count_now(t);      /* freeze the counter */
+            r->CR1 = val;
+        }
+        break;
+    case offsetof(TIM_TypeDef, SR):
+        r->SR = old & val;              /* rc_w0 */
+        update_irq(t);
+        break;
+    case offsetof(TIM_TypeDef, EGR):
+        r->EGR = 0;
+        if (val & 1U) {                 /* UG: reinitialise the counter */
+            r->CNT = 0;
+            if (running(t))
+                rebase(t, 0);
+            if (!(r->CR1 & TIM_CR1_URS))
+                r->SR |= TIM_SR_UIF;
+            update_irq(t);
+        }
+        break;
+    case offsetof(TIM_TypeDef, CNT):
+        if (running(t))
+            rebase(t, val & mask(t));
+        break;
+    case offsetof(TIM_TypeDef, PSC):
+    case offsetof(TIM_TypeDef, ARR):
+        if (running(t)) {
+            /* Keep the current count; the new period starts from here */
+            uint32_t saved = val;
+            *(uint32_t *)sim_reg(p->base + off) = old;
+            cnt = count_now(t);
+            *(uint32_t *)sim_reg(p->base + off) = saved;
+            rebase(t, cnt <= (r->ARR & mask(t)) ? cnt : 0U);
+        }
+        break;
+    case offsetof(TIM_TypeDef, CCR1):
+    case offsetof(TIM_TypeDef, CCR2):
+    case offsetof(TIM_TypeDef, CCR3):
+    case offsetof(TIM_TypeDef, CCR4):
+    case offsetof(TIM_TypeDef, CCER):
+        if (running(t))
+            rebase(t, count_now(t));
+        break;
+    case offsetof(TIM_TypeDef, DIER):
+        if (running(t))
+            rebase(t, count_now(t));
+        update_irq(t);
+        break;
+    default:
+        break;
+    }
+}
+
+void sim_tim_init(void)
+{
+    int i;
+
+    for (i = 0; i < NUM_TIMS; i++) {
+        tims[i].periph.read = tim_read;
+        tims[i].periph.write = tim_write;
+        tims[i].periph.next_event = tim_next_event;
+        tims[i].periph.advance = tim_advance;
+        regs(&tims[i])->ARR = tims[i].wide ? 0xFFFFFFFFU : 0xFFFFU;
+        sim_register(&tims[i].periph);
+        sim_add_counter(tims[i].counter, &tims[i].update_events);
+    }
+}
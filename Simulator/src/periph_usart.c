@@ -0,0 +1,293 @@
+/**
+ * periph_usart.c - USART2 with a pty- or stdout-backed line
+ *
+ * TX is double buffered like the real TDR/shift register pair, so TXE and TC
+ * behave as the polling and DMA programs expect, and each frame takes ten
+ * bit times of BRR cycles. Received bytes come from --uart-rx or, with
+ * --pty, from whatever is typed into the pseudo terminal; they are handed
+ * over one frame time apart and only while RXNE is clear.
+ */
+
+#define _GNU_SOURCE
+#include "sim.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* <termios.h> defines CR0..CR3 as output delay flags */
+#undef CR1
+#undef CR2
+#undef CR3
+
+#define SR_RXNE   (1U << 5)
+#define SR_TC     (1U << 6)
+#define SR_TXE    (1U << 7)
+#define CR1_RE    (1U << 2)
+#define CR1_TE    (1U << 3)
+#define CR1_RXNEIE (1U << 5)
+#define CR1_TCIE  (1U << 6)
+#define CR1_TXEIE (1U << 7)
+#define CR1_UE    (1U << 13)
+#define CR3_DMAR  (1U << 6)
+#define CR3_DMAT  (1U << 7)
+
+static struct
+{
+    int        shifting;
+    uint8_t    shift;
+    sim_time_t shift_done;
+    int        tdr_full;
+    uint8_t    tdr;
+
+    char      *rx_script;
+    size_t     rx_len, rx_pos;
+    sim_time_t rx_next;
+
+    int        pty_master, pty_slave;
+    uint64_t   tx_bytes, rx_bytes;
+} u = { .pty_master = -1, .pty_slave = -1 };
+
+static USART_TypeDef *regs(void)
+{
+    return SIM_REGS(USART_TypeDef, USART2_BASE);
+}
+
+static sim_time_t frame_time(void)
+{
+    uint32_t brr = regs()->BRR & 0xFFFFU;
+    if (regs()->CR1 & (1U << 15))          /* OVER8 */
+        brr = ((brr & 0xFFF0U) | ((brr & 7U) << 1));
+    return (sim_time_t)(brr ? brr : 16U) * 10U;
+}
+
+static void update_irq(void)
+{
+    uint32_t sr = regs()->SR, cr1 = regs()->CR1;
+    sim_irq_level(USART2_IRQn, ((sr & SR_TXE) && (cr1 & CR1_TXEIE))
+                            || ((sr & SR_TC) && (cr1 & CR1_TCIE))
+                            || ((sr & (SR_RXNE | (1U << 3))) && (cr1 & CR1_RXNEIE)));
+}
+
+static void emit(uint8_t c)
+{
+    ssize_t r;
+
+    u.tx_bytes++;
+    if (u.pty_master >= 0)
+        r = write(u.pty_master, &c, 1);
+    else
+        r = write(STDOUT_FILENO, &c, 1);
+    (void)r;
+}
+
+static void start_shift(uint8_t c)
+{
+    u.shifting = 1;
+    u.shift = c;
+    u.shift_done = sim_now + frame_time();
+}
+
+static int tx_dma_level(void)
+{
+    return (regs()->CR3 & CR3_DMAT) && (regs()->SR & SR_TXE);
+}
+
+static int rx_dma_level(void)
+{
+    return (regs()->CR3 & CR3_DMAR) && (regs()->SR & SR_RXNE);
+}
+
+static int rx_available(void)
+{
+    return u.rx_pos < u.rx_len || u.pty_master >= 0;
+}
+
+static void usart_after_read(struct sim_periph *p, uint32_t off)
+{
+    (void)p;
+    if (off == offsetof(USART_TypeDef, DR)) {
+        regs()->SR &= ~(SR_RXNE | (1U << 3));
+        if (rx_available() && u.rx_next < sim_now + frame_time())
+            u.rx_next = sim_now + frame_time();
+        update_irq();
+    }
+}
+
+static void usart_write(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val)
+{
+    USART_TypeDef *r = regs();
+
+    (void)p;
+    switch (off) {
+    case offsetof(USART_TypeDef, SR):
+        /* RXNE and TC are rc_w0, the rest is read-only */
+        r->SR = old & (val | ~(SR_RXNE | SR_TC));
+        break;
+    case offsetof(USART_TypeDef, DR):
+        r->DR = old;
+        if (!(r->CR1 & CR1_UE) || !(r->CR1 & CR1_TE))
+            break;
+        r->SR &= ~SR_TC;
+        if (!u.shifting) {
+            start_shift((uint8_t)val);
+        } else {
+            u.tdr = (uint8_t)val;
+            u.tdr_full = 1;
+            r->SR &= ~SR_TXE;
+        }
+        break;
+    case offsetof(USART_TypeDef, CR1):
+        if (!(old & CR1_RE) && (val & CR1_RE))
+            u.rx_next = sim_now + frame_time();
+        break;
+    default:
+        break;
+    }
+    update_irq();
+    sim_dma_kick();
+}
+
+static sim_time_t usart_next_event(struct sim_periph *p)
+{
+    sim_time_t t = SIM_NEVER;
+
+    (void)p;
+    if (u.shifting)
+        t = u.shift_done;
+    if ((regs()->CR1 & CR1_UE) && (regs()->CR1 & CR1_RE) && !(regs()->SR & SR_RXNE)
+        && rx_available() && u.rx_next < t)
+        t = u.rx_next;
+    return t;
+}
+
+static int rx_fetch(uint8_t *c)
+{
+    struct pollfd pfd;
+
+    if (u.rx_pos < u.rx_len) {
+        *c = (uint8_t)u.rx_script[u.rx_pos++];
+        return 1;
+    }
+    if (u.pty_master < 0)
+        return 0;
+    /* Waiting for a human: throttle to real time for one frame */
+    pfd.fd = u.pty_master;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, (int)(frame_time() * 1000U / SIM_HZ) + 1) > 0 && read(u.pty_master, c, 1) == 1)
+        return 1;
+    return 0;
+}
+
+static void usart_advance(struct sim_periph *p)
+{
+    USART_TypeDef *r = regs();
+    uint8_t c;
+
+    (void)p;
+    if (u.shifting && u.shift_done <= sim_now) {
+        emit(u.shift);
+        if (u.tdr_full) {
+            u.tdr_full = 0;
+            start_shift(u.tdr);
+            r->SR |= SR_TXE;
+        } else {
+            u.shifting = 0;
+            r->SR |= SR_TC;
+        }
+    }
+    if ((r->CR1 & CR1_RE) && !(r->SR & SR_RXNE) && rx_available() && u.rx_next <= sim_now) {
+        u.rx_next = sim_now + frame_time();
+        if (rx_fetch(&c)) {
+            u.rx_bytes++;
+            r->DR = c;
+            r->SR |= SR_RXNE;
+        }
+    }
+    update_irq();
+    sim_dma_kick();
+}
+
+/* Accepts C escapes so scripted input can contain \r */
+static char *unescape(const char *s, size_t *len)
+{
+    char *out = malloc(strlen(s) + 1), *o = out;
+
+    while (*s) {
+        if (*s == '\\' && s[1]) {
+            s++;
+            switch (*s) {
+            case 'r': *o++ = '\r'; break;
+            case 'n': *o++ = '\n'; break;
+            case 't': *o++ = '\t'; break;
+            case 'x': *o++ = (char)strtol(s + 1, (char **)&s, 16); s--; break;
+            default:  *o++ = *s; break;
+            }
+            s++;
+        } else {
+            *o++ = *s++;
+        }
+    }
+    *len = (size_t)(o - out);
+    return out;
+}
+
+int sim_usart_option(const char *opt, const char *arg)
+{
+    struct termios tio;
+    const char *name;
+
+    if (!strcmp(opt, "rx")) {
+        u.rx_script = unescape(arg, &u.rx_len);
+        return 0;
+    }
+
+    u.pty_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (u.pty_master < 0 || grantpt(u.pty_master) || unlockpt(u.pty_master) || !(name = ptsname(u.pty_master))) {
+        perror("sim: pty");
+        return 1;
+    }
+    /* Hold the slave open so writes never fail while no terminal is attached */
+    u.pty_slave = open(name, O_RDWR | O_NOCTTY);
+    if (u.pty_slave >= 0 && tcgetattr(u.pty_slave, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(u.pty_slave, TCSANOW, &tio);
+    }
+    fprintf(stderr, "sim: USART2 is on %s\n", name);
+    return 0;
+}
+
+void sim_usart_close(void)
+{
+    if (u.pty_slave >= 0)
+        close(u.pty_slave);
+    if (u.pty_master >= 0)
+        close(u.pty_master);
+    u.pty_slave = u.pty_master = -1;
+}
+
+static void usart_report(FILE *f)
+{
+    if (u.tx_bytes || u.rx_bytes)
+        fprintf(f, "\nUSART2: %llu bytes sent, %llu received\n",
+                (unsigned long long)u.tx_bytes, (unsigned long long)u.rx_bytes);
+}
+
+static struct sim_periph usart_periph = {
+    .name = "USART2", .base = USART2_BASE, .size = 0x400,
+    .after_read = usart_after_read, .write = usart_write,
+    .next_event = usart_next_event, .advance = usart_advance,
+};
+
+void sim_usart_init(void)
+{
+    regs()->SR = SR_TXE | SR_TC;
+    sim_register(&usart_periph);
+    sim_dma_level_source(1, 6, 4, tx_dma_level);
+    sim_dma_level_source(1, 5, 4, rx_dma_level);
+    sim_add_report(usart_report);
+    sim_add_counter("usart2.tx_bytes", &u.tx_bytes);
+    sim_add_counter("usart2.rx_bytes", &u.rx_bytes);
+}
@@ -0,0 +1,180 @@
+/**
+ * sim.h - Internal interface of the Nucleo-F401RE host simulator
+ *
+ * The peripheral register space is mapped twice from one memfd:
+ *   - at the real STM32 addresses with PROT_NONE (the "app view"), so every
+ *     register access made by an unmodified main.c faults into the simulator
+ *   - at an arbitrary host address read/write (the "sim view"), which is what
+ *     the peripheral models below use to read and update register contents
+ *
+ * Virtual time is counted in 16 MHz SYSCLK cycles.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "stm32f4xx.h"
+
+typedef uint64_t sim_time_t;
+
+#define SIM_HZ             16000000ULL
+#define SIM_NEVER          UINT64_MAX
+#define SIM_US(n)          ((sim_time_t)(n) * (SIM_HZ / 1000000ULL))
+#define SIM_MS(n)          ((sim_time_t)(n) * (SIM_HZ / 1000ULL))
+
+/* Cost charged per CPU register access and per __NOP() (one iteration of
+   the 3195-loops-per-ms delay used throughout the programs) */
+#define SIM_ACCESS_CYCLES  3
+#define SIM_NOP_CYCLES     5
+
+struct sim_periph
+{
+    const char *name;
+    uint32_t    base;
+    uint32_t    size;
+
+    /* Called before the CPU reads a register so it holds the current value */
+    void (*read)(struct sim_periph *p, uint32_t off);
+    /* Called after the CPU read completed (read-to-clear side effects) */
+    void (*after_read)(struct sim_periph *p, uint32_t off);
+    /* Called after the CPU or DMA wrote 'val'; 'old' is the previous content */
+    void (*write)(struct sim_periph *p, uint32_t off, uint32_t old, uint32_t val);
+    /* Earliest future time at which the model changes state on its own */
+    sim_time_t (*next_event)(struct sim_periph *p);
+    /* Process everything due at or before sim_now */
+    void (*advance)(struct sim_periph *p);
+
+    /* Per-peripheral access counters, reported at exit */
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t dma_reads;
+    uint64_t dma_writes;
+};
+
+/* ---- core (sim_core.c) ---- */
+extern sim_time_t sim_now;
+extern int        sim_verbose;
+
+void     *sim_reg(uint32_t addr);
+#define   SIM_REGS(type, base)  ((type *)sim_reg(base))
+
+void      sim_register(struct sim_periph *p);
+struct sim_periph *sim_periph_at(uint32_t addr);
+void      sim_reschedule(void);
+void      sim_run_until(sim_time_t t);
+
+uint32_t  sim_bus_read(uint32_t addr, int size);
+void      sim_bus_write(uint32_t addr, uint32_t val, int size);
+
+void      sim_irq_level(int irqn, int level);
+void      sim_irq_pend(int irqn);
+void      sim_irq_unpend(int irqn);
+int       sim_irq_pending(int irqn);
+void      sim_irq_dispatch(void);
+
+void      sim_log(const char *fmt, ...);
+
+/* ---- core peripherals (periph_scs.c) ---- */
+int       sim_irq_enabled(int irqn);
+void      sim_systick_pend(void);
+int       sim_systick_pending(void);
+void      sim_systick_clear(void);
+
+/* ---- option parsing hooks ---- */
+int       sim_adc_option(const char *arg);
+int       sim_usart_option(const char *opt, const char *arg);
+void      sim_usart_close(void);
+int       sim_button_option(const char *arg);
+int       sim_keypad_option(const char *arg);
+int       sim_hd44780_option(const char *arg);
+void      sim_hd44780_write(int rs, uint8_t bus);
+
+/* ---- GPIO (periph_gpio.c) ---- */
+enum { SIM_PORTA, SIM_PORTB, SIM_PORTC, SIM_PORTD, SIM_PORTE, SIM_PORTH, SIM_NPORTS };
+
+typedef void (*sim_gpio_watch_fn)(int port, uint32_t old_odr, uint32_t new_odr);
+
+uint32_t  sim_gpio_odr(int port);
+uint32_t  sim_gpio_outputs(int port);
+uint32_t  sim_gpio_driving(int port);      /* outputs minus open-drain highs */
+void      sim_gpio_drive(int port, uint32_t mask, uint32_t value);
+void      sim_gpio_release(int port, uint32_t mask);
+void      sim_gpio_watch(int port, sim_gpio_watch_fn fn);
+
+/* ---- EXTI (periph_exti.c), told by GPIO about input level changes ---- */
+void      sim_exti_input(int port, uint32_t old_idr, uint32_t new_idr);
+int       sim_exti_listening(int port, int pin);
+
+/* ---- DMA (periph_dma.c) ---- */
+/* A peripheral with a level request (TXE, RXNE) calls sim_dma_kick() when the
+   level may have changed; an edge request (timer update, ADC EOC) calls
+   sim_dma_pulse() once per event. */
+typedef int (*sim_dma_level_fn)(void);
+
+void      sim_dma_level_source(int dma, int stream, int channel, sim_dma_level_fn fn);
+void      sim_dma_kick(void);
+int       sim_dma_pulse(int dma, int stream, int channel);
+
+/* ---- SPI and I2C buses as seen by the device models ---- */
+struct sim_spi_device
+{
+    const char *name;
+    uint8_t   (*transfer)(uint8_t mosi);   /* called only while selected */
+    int       (*selected)(void);
+    void      (*report)(FILE *f);
+};
+
+struct sim_i2c_device
+{
+    const char *name;
+    uint8_t     addr;
+    void      (*start)(int read);
+    void      (*write)(uint8_t data);
+    uint8_t   (*read)(void);
+    void      (*stop)(void);
+    void      (*report)(FILE *f);
+};
+
+void      sim_spi_attach(struct sim_spi_device *d);
+void      sim_i2c_attach(struct sim_i2c_device *d);
+
+/* ---- ADC analog inputs and timer trigger outputs ---- */
+enum
+{
+    SIM_TRG_TIM1_CC1 = 0, SIM_TRG_TIM1_CC2, SIM_TRG_TIM1_CC3, SIM_TRG_TIM2_CC2,
+    SIM_TRG_TIM2_CC3, SIM_TRG_TIM2_CC4, SIM_TRG_TIM2_TRGO, SIM_TRG_TIM3_CC1,
+    SIM_TRG_TIM3_TRGO
+};
+void      sim_adc_trigger(int source);
+
+/* ---- models with something to say at exit ---- */
+typedef void (*sim_report_fn)(FILE *f);
+void      sim_add_report(sim_report_fn fn);
+
+/* Named event counters ("usart2.tx_bytes"), written to the --stats CSV so
+   benchmarks can divide access counts by the work done */
+void      sim_add_counter(const char *name, const uint64_t *value);
+
+/* Module initialisers, called in this order from main() */
+void      sim_scs_init(void);
+void      sim_gpio_init(void);
+void      sim_exti_init(void);
+void      sim_dma_init(void);
+void      sim_tim_init(void);
+void      sim_usart_init(void);
+void      sim_spi_init(void);
+void      sim_i2c_init(void);
+void      sim_adc_init(void);
+void      sim_hd44780_init(void);
+void      sim_pcd8544_init(void);
+void      sim_ltc1661_init(void);
+void      sim_ds1337_init(void);
+void      sim_pcf8574_init(void);
+void      sim_button_init(void);
+void      sim_seg7_init(void);
+void      sim_keypad_init(void);
+
+#endif /* SIM_H */
@@ -0,0 +1,1128 @@
+/**
+ * sim_core.c - Register trapping, virtual time and interrupts
+ *
+ * Every CPU access to the app view of the register space raises SIGSEGV.
+ * The handler lets the owning model refresh the register, opens the page
+ * and single-steps the faulting instruction (x86 trap flag). The following
+ * SIGTRAP closes the page again, hands writes to the model, charges the
+ * access to virtual time and, if an enabled interrupt is pending, redirects
+ * the program into sim_irq_entry (sim_irq.S), which calls the handler the
+ * program defined exactly like the NVIC would.
+ *
+ * Virtual time only advances through register accesses, __NOP() and
+ * interrupt entry. When the program is spinning (the same status register
+ * read repeatedly, or no register access at all while the idle timer keeps
+ * sampling the same few instructions) time jumps straight to the next
+ * scheduled peripheral event, which is what makes simulated seconds cost
+ * milliseconds.
+ *
+ * The Cortex-M4 bit-band aliases of the peripheral space and of SRAM are
+ * reserved without access rights as well. A load or store there is
+ * emulated on a one-word scratch value and turned into a single-bit read
+ * or read-modify-write of the target word. The program's data and bss are
+ * linked at SRAM1_BASE (Makefile) so that SRAM aliases of its variables
+ * resolve.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+#define PAGE_SIZE_HOST   4096UL
+#define MAX_PERIPHS      48
+#define MAX_REPORTS      16
+#define MAX_COUNTERS     48
+#define NUM_IRQS         96
+#define IRQ_SYSTICK      (-1)
+#define IRQ_NONE         (-100)
+#define IRQ_ENTRY_CYCLES 24
+#define APP_STACK_SIZE   (1024UL * 1024UL)
+#define IDLE_TICK_NS     250000L
+#define SPIN_RIPS        8               /* distinct sampled addresses a RAM spin loop shows */
+#define SPIN_TICKS       16              /* idle ticks that must all land on them */
+#define COMPUTE_TICKS    400             /* idle ticks before any code counts as a spin */
+#define BB_ALIAS_SIZE    0x02000000UL    /* 32 MB alias for 1 MB */
+
+/* The program's main(), renamed by the Makefile */
+extern int sim_app_main(void);
+extern void sim_irq_entry(void);
+
+uint32_t SystemCoreClock = 16000000U;
+void SystemInit(void) {}
+void SystemCoreClockUpdate(void) {}
+
+sim_time_t sim_now;
+int        sim_verbose;
+
+static struct window
+{
+    uint32_t base;
+    uint32_t size;
+    uint8_t *view;
+} windows[] = {
+    { 0x40000000UL, 0x00030000UL, NULL },   /* APB1, APB2, AHB1 */
+    { 0xE0000000UL, 0x00010000UL, NULL },   /* private peripheral bus */
+};
+#define NUM_WINDOWS (sizeof(windows) / sizeof(windows[0]))
+
+static struct sim_periph *periphs[MAX_PERIPHS];
+static int                num_periphs;
+static struct sim_periph  other = { .name = "other" };
+
+static sim_report_fn reports[MAX_REPORTS];
+static int           num_reports;
+
+static struct
+{
+    const char     *name;
+    const uint64_t *value;
+} counters[MAX_COUNTERS];
+static int num_counters;
+
+/* Access currently being single-stepped */
+static struct
+{
+    int                active;
+    int                write;
+    uint32_t           addr;
+    uint32_t           old;
+    uintptr_t          page;
+    struct sim_periph *p;
+} pend;
+
+static sim_time_t next_due = SIM_NEVER;
+static sim_time_t deadline = SIM_MS(2000);
+static volatile sig_atomic_t exit_requested;
+static volatile sig_atomic_t entry_pending;
+static volatile sig_atomic_t sim_busy;
+
+static uint8_t  irq_level[NUM_IRQS];
+static uint8_t  irq_pended[NUM_IRQS];
+static int      in_isr;
+static uint32_t primask;
+static int      exclusive;
+
+static uint64_t activity, last_activity;
+static int      idle_ticks;
+static greg_t   idle_rip[SPIN_RIPS];
+static int      idle_rips, idle_spin;
+static uint32_t last_rd_addr, last_rd_val;
+static int      spin;
+static int      dma_wrote_ram;
+
+static uint64_t total_traps, total_skips, total_irqs, total_bitband;
+static uint64_t skipped_cycles, cpu_cycles;
+static struct timespec t_start;
+static int   opt_quiet, opt_trace;
+static char *opt_stats;
+static ucontext_t main_ctx, app_ctx;
+static timer_t    idle_timer;
+
+/* ------------------------------------------------------------------ */
+/* Register space                                                      */
+/* ------------------------------------------------------------------ */
+
+void *sim_reg(uint32_t addr)
+{
+    unsigned i;
+    for (i = 0; i < NUM_WINDOWS; i++) {
+        if (addr - windows[i].base < windows[i].size)
+            return windows[i].view + (addr - windows[i].base);
+    }
+    return NULL;
+}
+
+void sim_register(struct sim_periph *p)
+{
+    if (num_periphs == MAX_PERIPHS) {
+        fprintf(stderr, "sim: too many peripherals\n");
+        exit(2);
+    }
+    periphs[num_periphs++] = p;
+}
+
+struct sim_periph *sim_periph_at(uint32_t addr)
+{
+    static struct sim_periph *last;
+    int i;
+
+    if (last && addr - last->base < last->size)
+        return last;
+    for (i = 0; i < num_periphs; i++) {
+        if (addr - periphs[i]->base < periphs[i]->size)
+            return last = periphs[i];
+    }
+    return &other;
+}
+
+void sim_add_report(sim_report_fn fn)
+{
+    if (num_reports < MAX_REPORTS)
+        reports[num_reports++] = fn;
+}
+
+void sim_add_counter(const char *name, const uint64_t *value)
+{
+    if (num_counters < MAX_COUNTERS) {
+        counters[num_counters].name = name;
+        counters[num_counters].value = value;
+        num_counters++;
+    }
+}
+
+static void map_windows(void)
+{
+    size_t total = 0, off = 0;
+    unsigned i;
+    int fd;
+
+    for (i = 0; i < NUM_WINDOWS; i++)
+        total += windows[i].size;
+
+    fd = memfd_create("stm32-registers", 0);
+    if (fd < 0 || ftruncate(fd, (off_t)total) < 0) {
+        perror("sim: memfd");
+        exit(2);
+    }
+
+    for (i = 0; i < NUM_WINDOWS; i++) {
+        void *app = mmap((void *)(uintptr_t)windows[i].base, windows[i].size, PROT_NONE,
+                         MAP_SHARED | MAP_FIXED_NOREPLACE, fd, (off_t)off);
+        void *view = mmap(NULL, windows[i].size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)off);
+        if (app != (void *)(uintptr_t)windows[i].base || view == MAP_FAILED) {
+            fprintf(stderr, "sim: cannot map registers at 0x%08X: %s\n",
+                    (unsigned)windows[i].base, strerror(errno));
+            exit(2);
+        }
+        windows[i].view = view;
+        off += windows[i].size;
+    }
+    close(fd);
+
+    /* Bit-band aliases: nothing behind them, every access traps */
+    if (mmap((void *)PERIPH_BB_BASE, BB_ALIAS_SIZE, PROT_NONE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0)
+            != (void *)PERIPH_BB_BASE ||
+        mmap((void *)SRAM1_BB_BASE, BB_ALIAS_SIZE, PROT_NONE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0)
+            != (void *)SRAM1_BB_BASE) {
+        fprintf(stderr, "sim: cannot map the bit-band aliases: %s\n", strerror(errno));
+        exit(2);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Virtual time                                                        */
+/* ------------------------------------------------------------------ */
+
+void sim_reschedule(void)
+{
+    sim_time_t t = SIM_NEVER, n;
+    int i;
+
+    for (i = 0; i < num_periphs; i++) {
+        if (periphs[i]->next_event) {
+            n = periphs[i]->next_event(periphs[i]);
+            if (n < t)
+                t = n;
+        }
+    }
+    next_due = t;
+}
+
+void sim_run_until(sim_time_t t)
+{
+    long guard = 0;
+    int i;
+
+    for (;;) {
+        sim_reschedule();
+        if (next_due > t)
+            break;
+        if (next_due > sim_now)
+            sim_now = next_due;
+        for (i = 0; i < num_periphs; i++) {
+            struct sim_periph *p = periphs[i];
+            if (p->next_event && p->next_event(p) <= sim_now)
+                p->advance(p);
+        }
+        if (++guard > 100000000L) {
+            fprintf(stderr, "sim: event loop does not make progress\n");
+            abort();
+        }
+    }
+    if (t > sim_now && t != SIM_NEVER)
+        sim_now = t;
+    if (sim_now >= deadline)
+        exit_requested = 1;
+}
+
+/* Returns nonzero if peripheral events were processed */
+static int charge(sim_time_t cycles)
+{
+    sim_time_t t = sim_now + cycles;
+    if (t >= next_due || t >= deadline) {
+        sim_run_until(t);
+        return 1;
+    }
+    sim_now = t;
+    return 0;
+}
+
+/* Nothing the program does can change state before the next event */
+static void skip_ahead(void)
+{
+    sim_time_t t;
+
+    sim_reschedule();
+    t = next_due;
+    if (t == SIM_NEVER || t > deadline)
+        t = deadline;
+    if (t < sim_now)
+        t = sim_now;
+    total_skips++;
+    skipped_cycles += t - sim_now;
+    sim_run_until(t);
+    spin = 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Interrupts                                                          */
+/* ------------------------------------------------------------------ */
+
+#define WEAK_HANDLER(name) extern void name(void) __attribute__((weak));
+#define SIM_HANDLERS(X) \
+    X(EXTI0_IRQHandler) X(EXTI1_IRQHandler) X(EXTI2_IRQHandler) X(EXTI3_IRQHandler) \
+    X(EXTI4_IRQHandler) X(EXTI9_5_IRQHandler) X(EXTI15_10_IRQHandler) \
+    X(DMA1_Stream0_IRQHandler) X(DMA1_Stream1_IRQHandler) X(DMA1_Stream2_IRQHandler) \
+    X(DMA1_Stream3_IRQHandler) X(DMA1_Stream4_IRQHandler) X(DMA1_Stream5_IRQHandler) \
+    X(DMA1_Stream6_IRQHandler) X(DMA1_Stream7_IRQHandler) \
+    X(DMA2_Stream0_IRQHandler) X(DMA2_Stream1_IRQHandler) X(DMA2_Stream2_IRQHandler) \
+    X(DMA2_Stream3_IRQHandler) X(DMA2_Stream4_IRQHandler) X(DMA2_Stream5_IRQHandler) \
+    X(DMA2_Stream6_IRQHandler) X(DMA2_Stream7_IRQHandler) \
+    X(ADC_IRQHandler) X(TIM1_BRK_TIM9_IRQHandler) X(TIM1_UP_TIM10_IRQHandler) \
+    X(TIM1_TRG_COM_TIM11_IRQHandler) X(TIM1_CC_IRQHandler) X(TIM2_IRQHandler) \
+    X(TIM3_IRQHandler) X(TIM4_IRQHandler) X(TIM5_IRQHandler) X(I2C1_EV_IRQHandler) X(I2C1_ER_IRQHandler) X(SPI1_IRQHandler) \
+    X(USART2_IRQHandler) X(SysTick_Handler)
+SIM_HANDLERS(WEAK_HANDLER)
+
+static const struct
+{
+    int         irqn;
+    void      (*fn)(void);
+    const char *name;
+} *vectors, vector_table[] = {
+#define VEC(irqn, name) { irqn, name, #name },
+    VEC(EXTI0_IRQn, EXTI0_IRQHandler)             VEC(EXTI1_IRQn, EXTI1_IRQHandler)
+    VEC(EXTI2_IRQn, EXTI2_IRQHandler)             VEC(EXTI3_IRQn, EXTI3_IRQHandler)
+    VEC(EXTI4_IRQn, EXTI4_IRQHandler)             VEC(EXTI9_5_IRQn, EXTI9_5_IRQHandler)
+    VEC(EXTI15_10_IRQn, EXTI15_10_IRQHandler)
+    VEC(DMA1_Stream0_IRQn, DMA1_Stream0_IRQHandler) VEC(DMA1_Stream1_IRQn, DMA1_Stream1_IRQHandler)
+    VEC(DMA1_Stream2_IRQn, DMA1_Stream2_IRQHandler) VEC(DMA1_Stream3_IRQn, DMA1_Stream3_IRQHandler)
+    VEC(DMA1_Stream4_IRQn, DMA1_Stream4_IRQHandler) VEC(DMA1_Stream5_IRQn, DMA1_Stream5_IRQHandler)
+    VEC(DMA1_Stream6_IRQn, DMA1_Stream6_IRQHandler) VEC(DMA1_Stream7_IRQn, DMA1_Stream7_IRQHandler)
+    VEC(DMA2_Stream0_IRQn, DMA2_Stream0_IRQHandler) VEC(DMA2_Stream1_IRQn, DMA2_Stream1_IRQHandler)
+    VEC(DMA2_Stream2_IRQn, DMA2_Stream2_IRQHandler) VEC(DMA2_Stream3_IRQn, DMA2_Stream3_IRQHandler)
+    VEC(DMA2_Stream4_IRQn, DMA2_Stream4_IRQHandler) VEC(DMA2_Stream5_IRQn, DMA2_Stream5_IRQHandler)
+    VEC(DMA2_Stream6_IRQn, DMA2_Stream6_IRQHandler) VEC(DMA2_Stream7_IRQn, DMA2_Stream7_IRQHandler)
+    VEC(ADC_IRQn, ADC_IRQHandler)                 VEC(TIM1_BRK_TIM9_IRQn, TIM1_BRK_TIM9_IRQHandler)
+    VEC(TIM1_UP_TIM10_IRQn, TIM1_UP_TIM10_IRQHandler)
+    VEC(TIM1_TRG_COM_TIM11_IRQn, TIM1_TRG_COM_TIM11_IRQHandler)
+    VEC(TIM1_CC_IRQn, TIM1_CC_IRQHandler)         VEC(TIM2_IRQn, TIM2_IRQHandler)
+    VEC(TIM3_IRQn, TIM3_IRQHandler)               VEC(TIM4_IRQn, TIM4_IRQHandler)
+    VEC(TIM5_IRQn, TIM5_IRQHandler)               VEC(I2C1_EV_IRQn, I2C1_EV_IRQHandler)
+    VEC(I2C1_ER_IRQn, I2C1_ER_IRQHandler)         VEC(SPI1_IRQn, SPI1_IRQHandler)
+    VEC(USART2_IRQn, USART2_IRQHandler)           VEC(SysTick_IRQn, SysTick_Handler)
+#undef VEC
+    { IRQ_NONE, NULL, NULL }
+};
+
+void sim_irq_level(int irqn, int level)
+{
+    if (irqn >= 0 && irqn < NUM_IRQS)
+        irq_level[irqn] = (uint8_t)(level != 0);
+}
+
+void sim_irq_pend(int irqn)
+{
+    if (irqn >= 0 && irqn < NUM_IRQS)
+        irq_pended[irqn] = 1;
+}
+
+void sim_irq_unpend(int irqn)
+{
+    if (irqn >= 0 && irqn < NUM_IRQS)
+        irq_pended[irqn] = 0;
+}
+
+int sim_irq_pending(int irqn)
+{
+    return irqn >= 0 && irqn < NUM_IRQS && (irq_pended[irqn] || irq_level[irqn]);
+}
+
+/* Lowest numbered enabled pending interrupt, whether or not it can be taken */
+static int irq_waiting(void)
+{
+    int n;
+
+    if (sim_systick_pending())
+        return IRQ_SYSTICK;
+    for (n = 0; n < NUM_IRQS; n++) {
+        if ((irq_level[n] || irq_pended[n]) && sim_irq_enabled(n))
+            return n;
+    }
+    return IRQ_NONE;
+}
+
+/* The one to take now; no preemption between ISRs */
+static int irq_next(void)
+{
+    return in_isr || primask ? IRQ_NONE : irq_waiting();
+}
+
+static void (*irq_handler(int irqn, const char **name))(void)
+{
+    for (vectors = vector_table; vectors->irqn != IRQ_NONE; vectors++) {
+        if (vectors->irqn == irqn) {
+            *name = vectors->name;
+            return vectors->fn;
+        }
+    }
+    *name = "?";
+    return NULL;
+}
+
+static void sim_finish(void) __attribute__((noreturn));
+
+/* Called in normal (non-signal) context, either directly or via sim_irq_entry */
+void sim_irq_dispatch(void)
+{
+    const char *name;
+    void (*fn)(void);
+    int n;
+
+    entry_pending = 0;
+    for (;;) {
+        if (exit_requested)
+            sim_finish();
+        n = irq_next();
+        if (n == IRQ_NONE)
+            break;
+
+        fn = irq_handler(n, &name);
+        if (!fn) {
+            fprintf(stderr, "sim: IRQ %d enabled and pending but the program has no handler "
+                            "(Default_Handler would hang here)\n", n);
+            exit_requested = 1;
+            continue;
+        }
+        if (n == IRQ_SYSTICK)
+            sim_systick_clear();
+        else
+            irq_pended[n] = 0;
+
+        total_irqs++;
+        if (opt_trace)
+            sim_log("-> %s", name);
+        in_isr++;
+        exclusive = 0;
+        /* Reads on either side of an exception entry are not a poll loop */
+        spin = 0;
+        last_rd_addr = 0;
+        charge(IRQ_ENTRY_CYCLES / 2);
+        fn();
+        charge(IRQ_ENTRY_CYCLES / 2);
+        spin = 0;
+        last_rd_addr = 0;
+        in_isr--;
+    }
+}
+
+/* Redirect the interrupted program into sim_irq_entry */
+static void inject(ucontext_t *uc)
+{
+    greg_t *g = uc->uc_mcontext.gregs;
+    uint64_t sp;
+
+    if (entry_pending)
+        return;
+    if (!exit_requested && irq_next() == IRQ_NONE)
+        return;
+
+    /* Skip the 128-byte red zone, push the return address; sim_irq_entry
+       returns with "ret $128" */
+    sp = (uint64_t)g[REG_RSP] - 128 - 8;
+    *(uint64_t *)(uintptr_t)sp = (uint64_t)g[REG_RIP];
+    g[REG_RSP] = (greg_t)sp;
+    g[REG_RIP] = (greg_t)(uintptr_t)sim_irq_entry;
+    entry_pending = 1;
+}
+
+/* ------------------------------------------------------------------ */
+/* Intrinsics                                                          */
+/* ------------------------------------------------------------------ */
+
+void sim_nop(void)
+{
+    int events;
+
+    sim_busy = 1;
+    activity++;
+    events = charge(SIM_NOP_CYCLES);
+    sim_busy = 0;
+    /* Interrupt state only changes when a peripheral event ran; register
+       writes that pend or enable one are handled in on_trap() */
+    if (events && (exit_requested || irq_next() != IRQ_NONE))
+        sim_irq_dispatch();
+}
+
+void sim_wfi(void)
+{
+    sim_busy = 1;
+    activity++;
+    /* Sleep through events that raise no interrupt (DMA items, timer
+       compares without an IRQ); PRIMASK does not keep a pending one from
+       waking the core, it only holds off the handler */
+    if (irq_waiting() == IRQ_NONE) {
+        do
+            skip_ahead();
+        while (!in_isr && !exit_requested && irq_waiting() == IRQ_NONE);
+    }
+    sim_busy = 0;
+    sim_irq_dispatch();
+}
+
+uint32_t sim_get_primask(void)
+{
+    return primask;
+}
+
+void sim_set_primask(uint32_t pm)
+{
+    primask = pm & 1U;
+    if (!primask)
+        sim_irq_dispatch();
+}
+
+uint32_t sim_ldrex(volatile uint32_t *addr)
+{
+    exclusive = 1;
+    return *addr;
+}
+
+uint32_t sim_strex(uint32_t val, volatile uint32_t *addr)
+{
+    if (!exclusive)
+        return 1U;
+    exclusive = 0;
+    *addr = val;
+    return 0U;
+}
+
+void sim_clrex(void)
+{
+    exclusive = 0;
+}
+
+void sim_system_reset(void)
+{
+    fprintf(stderr, "sim: NVIC_SystemReset() called\n");
+    exit_requested = 1;
+    sim_finish();
+}
+
+/* ------------------------------------------------------------------ */
+/* Bus accesses made by DMA                                            */
+/* ------------------------------------------------------------------ */
+
+static int in_register_space(uint32_t addr)
+{
+    return sim_reg(addr) != NULL;
+}
+
+uint32_t sim_bus_read(uint32_t addr, int size)
+{
+    struct sim_periph *p;
+    uint32_t word, v;
+
+    if (!in_register_space(addr)) {
+        void *host = (void *)(uintptr_t)addr;
+        if (size == 1) return *(uint8_t *)host;
+        if (size == 2) return *(uint16_t *)host;
+        return *(uint32_t *)host;
+    }
+
+    p = sim_periph_at(addr);
+    p->dma_reads++;
+    if (p->read)
+        p->read(p, (addr & ~3U) - p->base);
+    word = *(uint32_t *)sim_reg(addr & ~3U);
+    v = word >> ((addr & 3U) * 8U);
+    if (size == 1) v &= 0xFFU;
+    if (size == 2) v &= 0xFFFFU;
+    if (p->after_read)
+        p->after_read(p, (addr & ~3U) - p->base);
+    return v;
+}
+
+void sim_bus_write(uint32_t addr, uint32_t val, int size)
+{
+    struct sim_periph *p;
+    uint32_t *reg, old, shift, mask;
+
+    if (!in_register_space(addr)) {
+        void *host = (void *)(uintptr_t)addr;
+        dma_wrote_ram = 1;
+        if (size == 1)      *(uint8_t *)host = (uint8_t)val;
+        else if (size == 2) *(uint16_t *)host = (uint16_t)val;
+        else                *(uint32_t *)host = val;
+        return;
+    }
+
+    p = sim_periph_at(addr);
+    p->dma_writes++;
+    reg = sim_reg(addr & ~3U);
+    old = *reg;
+    shift = (addr & 3U) * 8U;
+    mask = size == 1 ? 0xFFU : size == 2 ? 0xFFFFU : 0xFFFFFFFFU;
+    *reg = (old & ~(mask << shift)) | ((val & mask) << shift);
+    if (p->write)
+        p->write(p, (addr & ~3U) - p->base, old, *reg);
+}
+
+/* ------------------------------------------------------------------ */
+/* Signal handlers                                                     */
+/* ------------------------------------------------------------------ */
+
+/* Bookkeeping shared by emulated and single-stepped accesses */
+static void access_done(ucontext_t *uc)
+{
+    struct sim_periph *p = pend.p;
+    uint32_t now_val = *(uint32_t *)sim_reg(pend.addr);
+    uint32_t off = pend.addr - p->base;
+
+    pend.active = 0;
+    total_traps++;
+    activity++;
+
+    if (pend.write || now_val != pend.old) {
+        p->writes++;
+        if (opt_trace)
+            sim_log("W %-8s +0x%03X = 0x%08X", p->name, off, now_val);
+        if (p->write) {
+            p->write(p, off, pend.old, now_val);
+            sim_reschedule();       /* the write may have moved the next event */
+        }
+        spin = 0;
+        last_rd_addr = 0;
+    } else {
+        p->reads++;
+        if (opt_trace)
+            sim_log("R %-8s +0x%03X : 0x%08X", p->name, off, now_val);
+        if (p->after_read) {
+            p->after_read(p, off);
+            sim_reschedule();
+        }
+        if (pend.addr == last_rd_addr && now_val == last_rd_val) {
+            if (++spin >= 2)
+                skip_ahead();
+        } else {
+            spin = 0;
+            last_rd_addr = pend.addr;
+            last_rd_val = now_val;
+        }
+    }
+
+    charge(SIM_ACCESS_CYCLES);
+    inject(uc);
+}
+
+static const int gpr[16] = {
+    REG_RAX, REG_RCX, REG_RDX, REG_RBX, REG_RSP, REG_RBP, REG_RSI, REG_RDI,
+    REG_R8, REG_R9, REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15,
+};
+
+/*
+ * Emulate the plain loads and stores compilers emit for volatile register
+ * accesses (mov, movzx, mov-immediate) so most accesses cost one signal
+ * instead of SIGSEGV + two mprotect() + SIGTRAP. Returns 0 for anything
+ * else, which is then single-stepped.
+ */
+static int emulate(ucontext_t *uc, uint8_t *reg)
+{
+    greg_t *g = uc->uc_mcontext.gregs;
+    const uint8_t *ip = (const uint8_t *)g[REG_RIP];
+    int opsize = 4, rex = 0, op, modrm, mod, rm, len, r, imm_len = 0, zx = 0, store;
+    uint32_t v;
+
+    if (*ip == 0x66) {
+        opsize = 2;
+        ip++;
+    }
+    if ((*ip & 0xF0) == 0x40)
+        rex = *ip++;
+    if (rex & 8)
+        return 0;                                  /* 64-bit operand */
+
+    op = *ip++;
+    if (op == 0x0F) {
+        op = 0x0F00 | *ip++;
+        if (op != 0x0FB6 && op != 0x0FB7)
+            return 0;
+        zx = op == 0x0FB6 ? 1 : 2;
+    }
+    switch (op) {
+    case 0x88: store = 1; opsize = 1; break;
+    case 0x89: store = 1; break;
+    case 0x8A: store = 0; opsize = 1; break;
+    case 0x8B: store = 0; break;
+    case 0xC6: store = 1; opsize = 1; imm_len = 1; break;
+    case 0xC7: store = 1; imm_len = opsize; break;
+    case 0x0FB6: case 0x0FB7: store = 0; break;
+    default: return 0;
+    }
+
+    modrm = *ip++;
+    mod = modrm >> 6;
+    rm = modrm & 7;
+    r = ((modrm >> 3) & 7) | ((rex & 4) ? 8 : 0);
+    if (mod == 3 || (imm_len && (modrm & 0x38)))
+        return 0;
+    if (opsize == 1 && !imm_len && !zx && !rex && r >= 4)
+        return 0;                                  /* AH..BH */
+
+    len = 0;
+    if (rm == 4) {
+        int sib = *ip++;
+        if (mod == 0 && (sib & 7) == 5)
+            len = 4;
+    } else if (mod == 0 && rm == 5) {
+        return 0;                                  /* RIP-relative */
+    }
+    if (mod == 1)
+        len = 1;
+    else if (mod == 2)
+        len = 4;
+    ip += len;
+
+    if (store) {
+        if (imm_len == 1)      v = *ip;
+        else if (imm_len == 2) v = *(const uint16_t *)ip;
+        else if (imm_len == 4) v = *(const uint32_t *)ip;
+        else                   v = (uint32_t)g[gpr[r]];
+        ip += imm_len;
+        if (opsize == 1)      *reg = (uint8_t)v;
+        else if (opsize == 2) memcpy(reg, &v, 2);
+        else                  memcpy(reg, &v, 4);
+    } else {
+        int size = zx ? zx : opsize;
+        v = 0;
+        memcpy(&v, reg, (size_t)size);
+        if (size == 4 || zx)
+            g[gpr[r]] = (greg_t)(uint64_t)v;       /* 32-bit writes zero-extend */
+        else if (size == 2)
+            g[gpr[r]] = (greg_t)(((uint64_t)g[gpr[r]] & ~0xFFFFULL) | v);
+        else
+            g[gpr[r]] = (greg_t)(((uint64_t)g[gpr[r]] & ~0xFFULL) | v);
+    }
+    g[REG_RIP] = (greg_t)(uintptr_t)ip;
+    return 1;
+}
+
+/*
+ * Access to a bit-band alias word: bit (offset / 4) % 8 of byte
+ * offset / 32 in the target region. A load returns 0 or 1, a store writes
+ * bit 0 of the value into the target bit with one read-modify-write of the
+ * containing word, which for a register goes to the model as a write.
+ */
+static void bitband(ucontext_t *uc, uint32_t alias)
+{
+    int periph = alias >= PERIPH_BB_BASE;
+    uint32_t off = alias - (periph ? PERIPH_BB_BASE : SRAM1_BB_BASE);
+    uint32_t byte = (periph ? PERIPH_BASE : SRAM1_BASE) + (off >> 5);
+    uint32_t addr = byte & ~3U;
+    uint32_t mask = 1U << ((byte & 3U) * 8U + ((off >> 2) & 7U));
+    int write = (uc->uc_mcontext.gregs[REG_ERR] & 2) != 0;
+    uint32_t scratch, *word;
+
+    total_bitband++;
+    if (periph) {
+        struct sim_periph *p;
+
+        word = sim_reg(addr);
+        if (!word) {
+            fprintf(stderr, "sim: bit-band access to unmapped register 0x%08X\n", (unsigned)addr);
+            abort();
+        }
+        p = sim_periph_at(addr);
+        pend.active = 1;
+        pend.addr = addr;
+        pend.p = p;
+        pend.write = write;
+        if (!write && p->read)
+            p->read(p, addr - p->base);
+        pend.old = *word;
+    } else {
+        word = (uint32_t *)(uintptr_t)addr;
+    }
+
+    scratch = (*word & mask) ? 1U : 0U;
+    if (!emulate(uc, (uint8_t *)&scratch)) {
+        fprintf(stderr, "sim: unsupported instruction on bit-band alias 0x%08X\n", (unsigned)alias);
+        abort();
+    }
+    if (write)
+        *word = (scratch & 1U) ? (*word | mask) : (*word & ~mask);
+
+    if (periph) {
+        access_done(uc);
+    } else {
+        /* A store is progress; a load may be a flag being polled */
+        if (write)
+            activity++;
+        inject(uc);
+    }
+}
+
+static void on_segv(int sig, siginfo_t *si, void *ctx)
+{
+    ucontext_t *uc = ctx;
+    uint32_t byte_addr = (uint32_t)(uintptr_t)si->si_addr;
+    uint32_t addr = byte_addr & ~3U;
+    struct sim_periph *p;
+
+    (void)sig;
+    if (!pend.active && byte_addr == (uintptr_t)si->si_addr &&
+        (byte_addr - PERIPH_BB_BASE < BB_ALIAS_SIZE || byte_addr - SRAM1_BB_BASE < BB_ALIAS_SIZE)) {
+        bitband(uc, byte_addr);
+        return;
+    }
+    if ((uintptr_t)si->si_addr > 0xFFFFFFFFUL || !in_register_space(addr) || pend.active) {
+        /* A genuine crash in the program: let it happen */
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+
+    p = sim_periph_at(addr);
+    pend.active = 1;
+    pend.addr = addr;
+    pend.p = p;
+    pend.write = (uc->uc_mcontext.gregs[REG_ERR] & 2) != 0;
+    pend.page = (uintptr_t)si->si_addr & ~(PAGE_SIZE_HOST - 1);
+
+    if (!pend.write && p->read)
+        p->read(p, addr - p->base);
+    pend.old = *(uint32_t *)sim_reg(addr);
+
+    if (emulate(uc, sim_reg(byte_addr))) {
+        access_done(uc);
+        return;
+    }
+    mprotect((void *)pend.page, PAGE_SIZE_HOST, PROT_READ | PROT_WRITE);
+    uc->uc_mcontext.gregs[REG_EFL] |= 0x100;   /* single-step */
+}
+
+static void on_trap(int sig, siginfo_t *si, void *ctx)
+{
+    ucontext_t *uc = ctx;
+
+    (void)sig;
+    (void)si;
+    if (!pend.active) {
+        signal(SIGTRAP, SIG_DFL);
+        return;
+    }
+    uc->uc_mcontext.gregs[REG_EFL] &= ~0x100;
+    mprotect((void *)pend.page, PAGE_SIZE_HOST, PROT_NONE);
+    access_done(uc);
+}
+
+/* Note a sampled address; returns 1 when it was sampled before */
+static int idle_seen(greg_t rip)
+{
+    int i;
+
+    for (i = 0; i < idle_rips; i++)
+        if (idle_rip[i] == rip)
+            return 1;
+    if (idle_rips < SPIN_RIPS)
+        idle_rip[idle_rips] = rip;
+    idle_rips++;                        /* past SPIN_RIPS: not a spin loop */
+    return 0;
+}
+
+static void on_prof(int sig, siginfo_t *si, void *ctx)
+{
+    greg_t rip = ((ucontext_t *)ctx)->uc_mcontext.gregs[REG_RIP];
+
+    (void)sig;
+    (void)si;
+    if (sim_busy || pend.active || entry_pending)
+        return;
+    if (activity != last_activity) {
+        last_activity = activity;
+        idle_ticks = 0;
+        idle_rips = idle_spin = 0;
+        return;
+    }
+    if (!idle_seen(rip) && idle_spin) {     /* out of the loop: look again */
+        idle_spin = 0;
+        idle_ticks = 0;
+    }
+    /* Spinning on RAM (e.g. "while (!done) {}") or parked in while (1):
+       only an interrupt or a DMA write to memory can end that. Such a loop
+       keeps coming back to the same few instructions, wherever they are
+       (while (!la_done()) {} runs in two functions), so SPIN_TICKS samples
+       that all land on at most SPIN_RIPS addresses mark it. A single
+       repeat does not: sprintf() has hot spots that two samples hit in a
+       row. Code that shows more addresses is taken for a stretch of pure
+       computation and only skipped after COMPUTE_TICKS. The addresses are
+       kept across a skip, so a program still in the same loop after it is
+       skipped again at once. */
+    if (++idle_ticks >= SPIN_TICKS && idle_rips <= SPIN_RIPS)
+        idle_spin = 1;
+    if (idle_spin || idle_ticks >= COMPUTE_TICKS) {
+        idle_ticks = 1;
+        dma_wrote_ram = 0;
+        while (!exit_requested && irq_next() == IRQ_NONE && !dma_wrote_ram)
+            skip_ahead();
+        inject(ctx);
+    }
+}
+
+static void install_handlers(void)
+{
+    struct sigaction sa;
+    struct sigevent sev;
+    struct itimerspec it;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    sigaddset(&sa.sa_mask, SIGPROF);
+
+    sa.sa_sigaction = on_segv;
+    sigaction(SIGSEGV, &sa, NULL);
+    sa.sa_sigaction = on_trap;
+    sigaction(SIGTRAP, &sa, NULL);
+    sa.sa_sigaction = on_prof;
+    sa.sa_flags |= SA_RESTART;
+    sigaction(SIGPROF, &sa, NULL);
+
+    /* A high-resolution timer; ITIMER_PROF only ticks with the scheduler */
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = SIGPROF;
+    it.it_interval.tv_sec = 0;
+    it.it_interval.tv_nsec = IDLE_TICK_NS;
+    it.it_value = it.it_interval;
+    if (timer_create(CLOCK_MONOTONIC, &sev, &idle_timer) == 0)
+        timer_settime(idle_timer, 0, &it, NULL);
+}
+
+/* ------------------------------------------------------------------ */
+/* Reporting                                                           */
+/* ------------------------------------------------------------------ */
+
+void sim_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    fprintf(stderr, "[%12.6f ms] ", (double)sim_now * 1000.0 / (double)SIM_HZ);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+static void write_stats(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    int i;
+
+    if (!f) {
+        perror(path);
+        return;
+    }
+    fprintf(f, "peripheral,cpu_reads,cpu_writes,dma_reads,dma_writes\n");
+    for (i = 0; i < num_periphs; i++) {
+        struct sim_periph *p = periphs[i];
+        fprintf(f, "%s,%llu,%llu,%llu,%llu\n", p->name,
+                (unsigned long long)p->reads, (unsigned long long)p->writes,
+                (unsigned long long)p->dma_reads, (unsigned long long)p->dma_writes);
+    }
+    fprintf(f, "%s,%llu,%llu,0,0\n", other.name,
+            (unsigned long long)other.reads, (unsigned long long)other.writes);
+    fprintf(f, "virtual_cycles,%llu,,,\n", (unsigned long long)sim_now);
+    /* Cycles the CPU was busy (accesses, __NOP(), interrupt entry) as
+       opposed to skipped while waiting */
+    cpu_cycles = sim_now - skipped_cycles;
+    fprintf(f, "core.cpu_cycles,%llu,,,\n", (unsigned long long)cpu_cycles);
+    fprintf(f, "core.irqs,%llu,,,\n", (unsigned long long)total_irqs);
+    fprintf(f, "core.bitband,%llu,,,\n", (unsigned long long)total_bitband);
+    for (i = 0; i < num_counters; i++)
+        fprintf(f, "%s,%llu,,,\n", counters[i].name, (unsigned long long)*counters[i].value);
+    fclose(f);
+}
+
+static void sim_finish(void)
+{
+    struct timespec t_end;
+    double real_s, virt_s;
+    int i;
+
+    timer_delete(idle_timer);
+    fflush(stdout);
+    sim_usart_close();
+
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    real_s = (double)(t_end.tv_sec - t_start.tv_sec) + (double)(t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+    virt_s = (double)sim_now / (double)SIM_HZ;
+
+    if (!opt_quiet) {
+        fprintf(stderr, "\n==== simulation finished ====\n");
+        fprintf(stderr, "virtual time : %.6f s (%llu cycles @16 MHz)\n", virt_s, (unsigned long long)sim_now);
+        fprintf(stderr, "host time    : %.6f s (%.0fx real time)\n", real_s, real_s > 0 ? virt_s / real_s : 0.0);
+        fprintf(stderr, "traps %llu, idle skips %llu, interrupts %llu\n\n",
+                (unsigned long long)total_traps, (unsigned long long)total_skips,
+                (unsigned long long)total_irqs);
+        fprintf(stderr, "%-10s %12s %12s %12s %12s\n", "periph", "cpu reads", "cpu writes", "dma reads", "dma writes");
+        for (i = 0; i < num_periphs; i++) {
+            struct sim_periph *p = periphs[i];
+            if (p->reads + p->writes + p->dma_reads + p->dma_writes == 0)
+                continue;
+            fprintf(stderr, "%-10s %12llu %12llu %12llu %12llu\n", p->name,
+                    (unsigned long long)p->reads, (unsigned long long)p->writes,
+                    (unsigned long long)p->dma_reads, (unsigned long long)p->dma_writes);
+        }
+        if (other.reads + other.writes)
+            fprintf(stderr, "%-10s %12llu %12llu\n", other.name,
+                    (unsigned long long)other.reads, (unsigned long long)other.writes);
+        for (i = 0; i < num_reports; i++)
+            reports[i](stderr);
+    }
+    if (opt_stats)
+        write_stats(opt_stats);
+    fflush(stderr);
+    _exit(0);
+}
+
+/* ------------------------------------------------------------------ */
+/* Entry point                                                         */
+/* ------------------------------------------------------------------ */
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -t, --time MS          virtual run time in ms (default 2000)\n"
+        "  -p, --pty              connect USART2 to a pseudo terminal\n"
+        "  -r, --uart-rx TEXT     bytes to feed into USART2 RX\n"
+        "  -a, --adc CH=MV[:AMPLITUDE_MV:HZ]\n"
+        "                         analog input on ADC channel CH (DC or sine)\n"
+        "  -b, --button MS[:HOLD_MS]\n"
+        "                         press B1 (PC13) at MS for HOLD_MS (100), repeatable\n"
+        "  -k, --key MS:KEY[:HOLD_MS[:BOUNCE_MS]]\n"
+        "                         press keypad key 1..16 at MS for HOLD_MS (100), contacts\n"
+        "                         chattering for BOUNCE_MS after each edge, repeatable\n"
+        "  -l, --lcd COLSxROWS    HD44780 module size (default 16x2)\n"
+        "  -s, --stats FILE       write per-peripheral access counters as CSV\n"
+        "  -T, --trace            log every register access\n"
+        "  -v, --verbose          log model activity\n"
+        "  -q, --quiet            no report at exit\n", prog);
+}
+
+static void run_app(void)
+{
+    sim_app_main();
+    sim_log("main() returned");
+    exit_requested = 1;
+    sim_finish();
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option longopts[] = {
+        { "time",    required_argument, NULL, 't' },
+        { "pty",     no_argument,       NULL, 'p' },
+        { "uart-rx", required_argument, NULL, 'r' },
+        { "adc",     required_argument, NULL, 'a' },
+        { "button",  required_argument, NULL, 'b' },
+        { "key",     required_argument, NULL, 'k' },
+        { "lcd",     required_argument, NULL, 'l' },
+        { "stats",   required_argument, NULL, 's' },
+        { "trace",   no_argument,       NULL, 'T' },
+        { "verbose", no_argument,       NULL, 'v' },
+        { "quiet",   no_argument,       NULL, 'q' },
+        { "help",    no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    void *stack;
+    int c;
+
+    map_windows();
+    sim_scs_init();
+    sim_gpio_init();
+    sim_exti_init();
+    sim_dma_init();
+    sim_tim_init();
+    sim_usart_init();
+    sim_spi_init();
+    sim_i2c_init();
+    sim_adc_init();
+    sim_hd44780_init();
+    sim_pcd8544_init();
+    sim_ltc1661_init();
+    sim_ds1337_init();
+    sim_pcf8574_init();
+    sim_button_init();
+    sim_seg7_init();
+    sim_keypad_init();
+
+    while ((c = getopt_long(argc, argv, "t:pr:a:b:k:l:s:Tvqh", longopts, NULL)) != -1) {
+        switch (c) {
+        case 't': deadline = SIM_MS(strtoull(optarg, NULL, 0)); break;
+        case 'p': if (sim_usart_option("pty", NULL)) return 2; break;
+        case 'r': if (sim_usart_option("rx", optarg)) return 2; break;
+        case 'a': if (sim_adc_option(optarg)) return 2; break;
+        case 'b': if (sim_button_option(optarg)) return 2; break;
+        case 'k': if (sim_keypad_option(optarg)) return 2; break;
+        case 'l': if (sim_hd44780_option(optarg)) return 2; break;
+        case 's': opt_stats = optarg; break;
+        case 'T': opt_trace = 1; break;
+        case 'v': sim_verbose = 1; break;
+        case 'q': opt_quiet = 1; break;
+        default:  usage(argv[0]); return c == 'h' ? 0 : 2;
+        }
+    }
+
+    /* DMA addresses are 32-bit, so the program's stack must live below 4 GiB
+       just like its .data/.bss in a non-PIE executable */
+    stack = mmap(NULL, APP_STACK_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED) {
+        perror("sim: stack");
+        return 2;
+    }
+    getcontext(&app_ctx);
+    app_ctx.uc_stack.ss_sp = stack;
+    app_ctx.uc_stack.ss_size = APP_STACK_SIZE;
+    app_ctx.uc_link = &main_ctx;
+    makecontext(&app_ctx, run_app, 0);
+
+    setvbuf(stdout, NULL, _IONBF, 0);
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    install_handlers();
+    swapcontext(&main_ctx, &app_ctx);
+    return 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * sim_stdio.c - printf() retargeting as the Keil C library does it
+ *
+ * On the board, printf(), puts() and putchar() end in the program's own
+ * fputc(), which most programs point at USART2. The Makefile renames those
+ * symbols in the program's objects to sim_app_*, so the program's fputc()
+ * neither replaces the C library's for the simulator nor is bypassed by
+ * glibc's printf(): formatted output is handed to it one character at a
+ * time, exactly like on the target. Without an fputc() of its own the
+ * program's output goes to stdout.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+int sim_app_fputc(int c, FILE *f) __attribute__((weak));
+
+static int emit(const char *s, size_t n)
+{
+    size_t i;
+
+    if (!sim_app_fputc)
+        return (int)fwrite(s, 1, n, stdout);
+    for (i = 0; i < n; i++)
+        sim_app_fputc((unsigned char)s[i], stdout);
+    return (int)n;
+}
+
+int sim_app_vprintf(const char *fmt, va_list ap)
+{
+    char buf[256], *p = buf;
+    va_list ap2;
+    int n;
+
+    va_copy(ap2, ap);
+    n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    if (n >= (int)sizeof(buf)) {
+        p = malloc((size_t)n + 1);
+        if (!p) {
+            va_end(ap2);
+            return -1;
+        }
+        vsnprintf(p, (size_t)n + 1, fmt, ap2);
+    }
+    va_end(ap2);
+    if (n > 0)
+        emit(p, (size_t)n);
+    if (p != buf)
+        free(p);
+    return n;
+}
+
+int sim_app_printf(const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = sim_app_vprintf(fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+int sim_app_puts(const char *s)
+{
+    emit(s, strlen(s));
+    emit("\n", 1);
+    return 1;
+}
+
+int sim_app_putchar(int c)
+{
+    char ch = (char)c;
+
+    emit(&ch, 1);
+    return (unsigned char)c;
+}